@@ -0,0 +1,569 @@
+/*
+ * A benchmark based on scalability-demo.c and mv-scalability-demo.c.
+ *
+ * It builds the same grid of groups of rectangles and text items, but with
+ * the size and mix of items set on the command line, and times the main
+ * canvas operations without showing a window. The results are output as a
+ * single line of JSON, or as "name value" lines with --format=text, so they
+ * can be compared between releases.
+ *
+ * GTK+ still needs to be initialized, so a display is needed, though it
+ * can be a virtual one, e.g. "xvfb-run ./scalability-bench".
+ */
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <goocanvas.h>
+
+#define PADDING 10
+
+/* The exit status used by automake to mean the test was skipped. */
+#define EXIT_SKIPPED 77
+
+/* The directory holding toroid.png, set by the Makefile so the benchmark
+   also works in builds outside the source tree. */
+#ifndef SRCDIR
+#define SRCDIR "."
+#endif
+
+static gint n_group_cols = 25;
+static gint n_group_rows = 200;
+static gint n_cols = 10;
+static gint n_rows = 10;
+static gint item_width = 400;
+static gint iterations = 10;
+static gint n_hit_tests = 10000;
+static gint view_width = 640;
+static gint view_height = 600;
+static gboolean no_text = FALSE;
+static gboolean no_style = FALSE;
+static gboolean no_rotate = FALSE;
+static gboolean use_pixmap = FALSE;
+static gboolean use_model = FALSE;
+static gchar *format = NULL;
+
+static GOptionEntry entries[] =
+{
+  { "group-cols", 0, 0, G_OPTION_ARG_INT, &n_group_cols,
+    "Number of columns of groups", "N" },
+  { "group-rows", 0, 0, G_OPTION_ARG_INT, &n_group_rows,
+    "Number of rows of groups", "N" },
+  { "cols", 0, 0, G_OPTION_ARG_INT, &n_cols,
+    "Number of columns of items in each group", "N" },
+  { "rows", 0, 0, G_OPTION_ARG_INT, &n_rows,
+    "Number of rows of items in each group", "N" },
+  { "item-width", 0, 0, G_OPTION_ARG_INT, &item_width,
+    "Width of each item", "WIDTH" },
+  { "iterations", 0, 0, G_OPTION_ARG_INT, &iterations,
+    "Number of times to repeat each render", "N" },
+  { "hit-tests", 0, 0, G_OPTION_ARG_INT, &n_hit_tests,
+    "Number of hit tests", "N" },
+  { "view-width", 0, 0, G_OPTION_ARG_INT, &view_width,
+    "Width of the rendered view, in pixels", "WIDTH" },
+  { "view-height", 0, 0, G_OPTION_ARG_INT, &view_height,
+    "Height of the rendered view, in pixels", "HEIGHT" },
+  { "no-text", 0, 0, G_OPTION_ARG_NONE, &no_text,
+    "Use rectangles instead of text items", NULL },
+  { "no-style", 0, 0, G_OPTION_ARG_NONE, &no_style,
+    "Don't set a style on the rectangles", NULL },
+  { "no-rotate", 0, 0, G_OPTION_ARG_NONE, &no_rotate,
+    "Don't rotate the items", NULL },
+  { "pixmap", 0, 0, G_OPTION_ARG_NONE, &use_pixmap,
+    "Use images of toroid.png instead of rectangles", NULL },
+  { "model", 0, 0, G_OPTION_ARG_NONE, &use_model,
+    "Create item models, viewed by the canvas", NULL },
+  { "format", 0, 0, G_OPTION_ARG_STRING, &format,
+    "Output format: json or text", "FORMAT" },
+  { NULL }
+};
+
+static gdouble item_height;
+static gdouble cell_width, cell_height;
+static gdouble group_width, group_height;
+static gdouble total_width, total_height;
+static gdouble left_offset, top_offset;
+
+static cairo_pattern_t *image_pattern = NULL;
+static GooCanvasStyle *style = NULL, *style2 = NULL;
+static gint total_items = 0;
+
+
+static gdouble
+elapsed_ms (gint64 start)
+{
+  return (g_get_monotonic_time () - start) / 1000.0;
+}
+
+
+/* Returns the resident size of the process in bytes, or 0 if it can't be
+   found. This only works on Linux. */
+static gsize
+get_resident_size (void)
+{
+  gchar *contents = NULL;
+  gulong size = 0, resident = 0;
+
+  if (g_file_get_contents ("/proc/self/statm", &contents, NULL, NULL))
+    {
+      if (sscanf (contents, "%lu %lu", &size, &resident) != 2)
+	resident = 0;
+      g_free (contents);
+    }
+
+  return (gsize) resident * sysconf (_SC_PAGESIZE);
+}
+
+
+static GooCanvasStyle*
+create_fill_style (const gchar *color_name)
+{
+  GooCanvasStyle *new_style;
+  GdkRGBA color = { 0, 0, 0, 0 };
+  GValue tmpval = { 0 };
+
+  new_style = goo_canvas_style_new ();
+  gdk_rgba_parse (&color, color_name);
+  g_value_init (&tmpval, GOO_TYPE_CAIRO_PATTERN);
+  g_value_take_boxed (&tmpval, cairo_pattern_create_rgb (color.red,
+							 color.green,
+							 color.blue));
+  goo_canvas_style_set_property (new_style, goo_canvas_style_fill_pattern_id,
+				 &tmpval);
+  g_value_unset (&tmpval);
+
+  return new_style;
+}
+
+
+/* Creates one pattern, shared by all the images, as the demo does. */
+static cairo_pattern_t*
+create_image_pattern (GdkPixbuf *pixbuf)
+{
+  cairo_surface_t *surface;
+  cairo_pattern_t *pattern;
+  cairo_t *cr;
+
+  surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32,
+					gdk_pixbuf_get_width (pixbuf),
+					gdk_pixbuf_get_height (pixbuf));
+  cr = cairo_create (surface);
+  gdk_cairo_set_source_pixbuf (cr, pixbuf, 0, 0);
+  cairo_paint (cr);
+  cairo_destroy (cr);
+
+  pattern = cairo_pattern_create_for_surface (surface);
+  cairo_surface_destroy (surface);
+
+  return pattern;
+}
+
+
+static void
+get_item_matrix (gint            i,
+		 gdouble         item_x,
+		 gdouble         item_y,
+		 cairo_matrix_t *matrix)
+{
+  gdouble rotation = (i % 10 * 2) * M_PI / 180;
+  gdouble rotation_x = item_x + item_width / 2;
+  gdouble rotation_y = item_y + item_height / 2;
+
+  cairo_matrix_init_identity (matrix);
+  cairo_matrix_translate (matrix, rotation_x, rotation_y);
+  cairo_matrix_rotate (matrix, rotation);
+  cairo_matrix_translate (matrix, -rotation_x, -rotation_y);
+}
+
+
+static void
+setup_items (GooCanvas *canvas)
+{
+  GooCanvasItem *root, *group, *item;
+  cairo_matrix_t item_matrix;
+  gint group_i, group_j, i, j;
+  gchar id[64];
+
+  root = goo_canvas_get_root_item (canvas);
+  g_object_set (G_OBJECT (root), "font", "Sans 8", NULL);
+
+  for (group_i = 0; group_i < n_group_cols; group_i++)
+    {
+      for (group_j = 0; group_j < n_group_rows; group_j++)
+	{
+	  gdouble group_x = left_offset + (group_i * group_width);
+	  gdouble group_y = top_offset + (group_j * group_height);
+
+	  group = goo_canvas_group_new (root, NULL);
+	  goo_canvas_item_translate (group, group_x, group_y);
+	  total_items++;
+
+	  for (i = 0; i < n_cols; i++)
+	    {
+	      for (j = 0; j < n_rows; j++)
+		{
+		  gdouble item_x = (i * cell_width) + PADDING;
+		  gdouble item_y = (j * cell_height) + PADDING;
+
+		  get_item_matrix (i, item_x, item_y, &item_matrix);
+
+		  if (use_pixmap)
+		    {
+		      item = goo_canvas_image_new (group, NULL, item_x, item_y,
+						   "pattern", image_pattern,
+						   "width", (gdouble) item_width,
+						   "height", item_height,
+						   NULL);
+		    }
+		  else
+		    {
+		      item = goo_canvas_rect_new (group, item_x, item_y,
+						  item_width, item_height,
+						  NULL);
+		      if (!no_style)
+			goo_canvas_item_set_style (item, (j % 2) ? style : style2);
+		    }
+		  if (!no_rotate)
+		    goo_canvas_item_set_transform (item, &item_matrix);
+
+		  if (no_text)
+		    {
+		      item = goo_canvas_rect_new (group, item_x + 20, item_y + 4,
+						  item_width - 40, item_height - 8,
+						  NULL);
+		    }
+		  else
+		    {
+		      g_snprintf (id, sizeof (id), "%.10g, %.10g",
+				  group_x + item_x, group_y + item_y);
+		      item = goo_canvas_text_new (group, id,
+						  item_x + item_width / 2,
+						  item_y + item_height / 2,
+						  item_width,
+						  GOO_CANVAS_ANCHOR_CENTER,
+						  "height", item_height,
+						  "alignment", PANGO_ALIGN_CENTER,
+						  NULL);
+		    }
+		  if (!no_rotate)
+		    goo_canvas_item_set_transform (item, &item_matrix);
+
+		  total_items += 2;
+		}
+	    }
+	}
+    }
+}
+
+
+static GooCanvasItemModel*
+setup_item_models (void)
+{
+  GooCanvasItemModel *root, *group, *model;
+  cairo_matrix_t item_matrix;
+  gint group_i, group_j, i, j;
+  gchar id[64];
+
+  root = goo_canvas_group_model_new (NULL, "font", "Sans 8", NULL);
+
+  for (group_i = 0; group_i < n_group_cols; group_i++)
+    {
+      for (group_j = 0; group_j < n_group_rows; group_j++)
+	{
+	  gdouble group_x = left_offset + (group_i * group_width);
+	  gdouble group_y = top_offset + (group_j * group_height);
+
+	  group = goo_canvas_group_model_new (root, NULL);
+	  goo_canvas_item_model_translate (group, group_x, group_y);
+	  total_items++;
+
+	  for (i = 0; i < n_cols; i++)
+	    {
+	      for (j = 0; j < n_rows; j++)
+		{
+		  gdouble item_x = (i * cell_width) + PADDING;
+		  gdouble item_y = (j * cell_height) + PADDING;
+
+		  get_item_matrix (i, item_x, item_y, &item_matrix);
+
+		  if (use_pixmap)
+		    {
+		      model = goo_canvas_image_model_new (group, NULL,
+							  item_x, item_y,
+							  "pattern", image_pattern,
+							  "width", (gdouble) item_width,
+							  "height", item_height,
+							  NULL);
+		    }
+		  else
+		    {
+		      model = goo_canvas_rect_model_new (group, item_x, item_y,
+							 item_width, item_height,
+							 NULL);
+		      if (!no_style)
+			goo_canvas_item_model_set_style (model, (j % 2) ? style : style2);
+		    }
+		  if (!no_rotate)
+		    goo_canvas_item_model_set_transform (model, &item_matrix);
+
+		  if (no_text)
+		    {
+		      model = goo_canvas_rect_model_new (group,
+							 item_x + 20, item_y + 4,
+							 item_width - 40,
+							 item_height - 8,
+							 NULL);
+		    }
+		  else
+		    {
+		      g_snprintf (id, sizeof (id), "%.10g, %.10g",
+				  group_x + item_x, group_y + item_y);
+		      model = goo_canvas_text_model_new (group, id,
+							 item_x + item_width / 2,
+							 item_y + item_height / 2,
+							 item_width,
+							 GOO_CANVAS_ANCHOR_CENTER,
+							 "height", item_height,
+							 "alignment", PANGO_ALIGN_CENTER,
+							 NULL);
+		    }
+		  if (!no_rotate)
+		    goo_canvas_item_model_set_transform (model, &item_matrix);
+
+		  total_items += 2;
+		}
+	    }
+	}
+    }
+
+  return root;
+}
+
+
+/* Renders the area of the canvas with the given top-left corner, at the
+   canvas's current scale, as a window of the view size would show it. */
+static void
+render_view (GooCanvas       *canvas,
+	     cairo_surface_t *surface,
+	     gdouble          left,
+	     gdouble          top)
+{
+  GooCanvasBounds bounds;
+  gdouble scale = goo_canvas_get_scale (canvas);
+  cairo_t *cr;
+
+  bounds.x1 = left;
+  bounds.y1 = top;
+  bounds.x2 = left + view_width / scale;
+  bounds.y2 = top + view_height / scale;
+
+  cr = cairo_create (surface);
+  cairo_set_source_rgb (cr, 1.0, 1.0, 1.0);
+  cairo_paint (cr);
+  cairo_set_source_rgb (cr, 0.0, 0.0, 0.0);
+  cairo_scale (cr, scale, scale);
+  cairo_translate (cr, -left, -top);
+  goo_canvas_render (canvas, cr, &bounds, scale);
+  cairo_destroy (cr);
+}
+
+
+/* Renders the entire canvas, scaled down to fit the view size. */
+static void
+render_all (GooCanvas       *canvas,
+	    cairo_surface_t *surface)
+{
+  gdouble scale = MIN (view_width / total_width, view_height / total_height);
+  cairo_t *cr;
+
+  cr = cairo_create (surface);
+  cairo_set_source_rgb (cr, 1.0, 1.0, 1.0);
+  cairo_paint (cr);
+  cairo_set_source_rgb (cr, 0.0, 0.0, 0.0);
+  cairo_scale (cr, scale, scale);
+  cairo_translate (cr, -left_offset, -top_offset);
+  goo_canvas_render (canvas, cr, NULL, scale);
+  cairo_destroy (cr);
+}
+
+
+static void
+output_result (const gchar *name,
+	       gdouble      value,
+	       gboolean     last)
+{
+  if (format && !strcmp (format, "text"))
+    printf ("%s %.3f\n", name, value);
+  else
+    printf ("\"%s\": %.3f%s", name, value, last ? "}\n" : ", ");
+}
+
+
+int
+main (int argc, char *argv[])
+{
+  GOptionContext *context;
+  GError *error = NULL;
+  GooCanvas *canvas;
+  GooCanvasItemModel *root_model = NULL;
+  cairo_surface_t *surface;
+  GdkPixbuf *pixbuf;
+  GRand *rand;
+  gsize resident_before, resident_after;
+  gdouble create_ms, create_views_ms = 0.0, update_ms, render_ms;
+  gdouble scroll_ms, zoom_ms, hit_test_ms, bytes_per_item;
+  gint64 start;
+  gint i, n_hits = 0;
+
+  context = g_option_context_new ("- benchmark GooCanvas");
+  g_option_context_add_main_entries (context, entries, NULL);
+  if (!g_option_context_parse (context, &argc, &argv, &error))
+    {
+      g_printerr ("%s\n", error->message);
+      return EXIT_FAILURE;
+    }
+  g_option_context_free (context);
+
+  if (!gtk_init_check ())
+    {
+      g_printerr ("Can't initialize GTK+, try running with xvfb-run\n");
+      return EXIT_SKIPPED;
+    }
+
+  if (use_pixmap)
+    {
+      pixbuf = gdk_pixbuf_new_from_file (SRCDIR "/toroid.png", &error);
+      if (!pixbuf)
+	{
+	  g_printerr ("%s\n", error->message);
+	  return EXIT_FAILURE;
+	}
+      item_width = gdk_pixbuf_get_width (pixbuf);
+      item_height = gdk_pixbuf_get_height (pixbuf);
+      image_pattern = create_image_pattern (pixbuf);
+      g_object_unref (pixbuf);
+    }
+  else
+    {
+      item_height = 19;
+    }
+
+  cell_width = item_width + PADDING * 2;
+  cell_height = item_height + PADDING * 2;
+  group_width = n_cols * cell_width;
+  group_height = n_rows * cell_height;
+  total_width = n_group_cols * group_width;
+  total_height = n_group_rows * group_height;
+
+  /* We use -ve offsets to test if -ve coords are handled correctly. */
+  left_offset = -total_width / 2;
+  top_offset = -total_height / 2;
+
+  style = create_fill_style ("mediumseagreen");
+  style2 = create_fill_style ("steelblue");
+
+  canvas = (GooCanvas*) g_object_ref_sink (goo_canvas_new ());
+  goo_canvas_set_bounds (canvas, left_offset, top_offset,
+			 left_offset + total_width, top_offset + total_height);
+
+  /* Creation. */
+  resident_before = get_resident_size ();
+  start = g_get_monotonic_time ();
+  if (use_model)
+    {
+      root_model = setup_item_models ();
+      create_ms = elapsed_ms (start);
+
+      start = g_get_monotonic_time ();
+      goo_canvas_set_root_item_model (canvas, root_model);
+      create_views_ms = elapsed_ms (start);
+    }
+  else
+    {
+      setup_items (canvas);
+      create_ms = elapsed_ms (start);
+    }
+
+  /* The first update, which calculates the bounds of every item. */
+  start = g_get_monotonic_time ();
+  goo_canvas_update (canvas);
+  update_ms = elapsed_ms (start);
+  resident_after = get_resident_size ();
+  bytes_per_item = resident_after > resident_before
+    ? (gdouble) (resident_after - resident_before) / total_items : 0.0;
+
+  surface = cairo_image_surface_create (CAIRO_FORMAT_ARGB32,
+					view_width, view_height);
+
+  /* Rendering the whole canvas. */
+  start = g_get_monotonic_time ();
+  for (i = 0; i < iterations; i++)
+    render_all (canvas, surface);
+  render_ms = elapsed_ms (start) / iterations;
+
+  /* Scrolling, rendering views from the top-left to the bottom-right. */
+  start = g_get_monotonic_time ();
+  for (i = 0; i < iterations; i++)
+    render_view (canvas, surface,
+		 left_offset + (total_width - view_width) * i / iterations,
+		 top_offset + (total_height - view_height) * i / iterations);
+  scroll_ms = elapsed_ms (start) / iterations;
+
+  /* Zooming, which needs all the items to be updated for each scale. */
+  start = g_get_monotonic_time ();
+  for (i = 0; i < iterations; i++)
+    {
+      goo_canvas_set_scale (canvas, (i % 2) ? 1.0 : 0.5);
+      goo_canvas_update (canvas);
+      render_view (canvas, surface, -view_width / 2, -view_height / 2);
+    }
+  zoom_ms = elapsed_ms (start) / iterations;
+  goo_canvas_set_scale (canvas, 1.0);
+  goo_canvas_update (canvas);
+
+  /* Hit testing random points, always using the same points. */
+  rand = g_rand_new_with_seed (42);
+  start = g_get_monotonic_time ();
+  for (i = 0; i < n_hit_tests; i++)
+    {
+      gdouble x = g_rand_double_range (rand, left_offset,
+				       left_offset + total_width);
+      gdouble y = g_rand_double_range (rand, top_offset,
+				       top_offset + total_height);
+
+      if (goo_canvas_get_item_at (canvas, x, y, TRUE))
+	n_hits++;
+    }
+  hit_test_ms = elapsed_ms (start);
+  g_rand_free (rand);
+
+  if (!format || strcmp (format, "text"))
+    printf ("{\"benchmark\": \"scalability\", \"mode\": \"%s\", ",
+	    use_model ? "model" : "item");
+  output_result ("items", total_items, FALSE);
+  output_result ("create_ms", create_ms, FALSE);
+  output_result ("create_views_ms", create_views_ms, FALSE);
+  output_result ("first_update_ms", update_ms, FALSE);
+  output_result ("render_ms", render_ms, FALSE);
+  output_result ("scroll_ms", scroll_ms, FALSE);
+  output_result ("zoom_ms", zoom_ms, FALSE);
+  output_result ("hit_tests_per_sec",
+		 hit_test_ms > 0.0 ? n_hit_tests * 1000.0 / hit_test_ms : 0.0,
+		 FALSE);
+  output_result ("hit_ratio",
+		 n_hit_tests > 0 ? (gdouble) n_hits / n_hit_tests : 0.0,
+		 FALSE);
+  output_result ("bytes_per_item", bytes_per_item, TRUE);
+
+  cairo_surface_destroy (surface);
+  g_object_unref (canvas);
+  if (root_model)
+    g_object_unref (root_model);
+  g_object_unref (style);
+  g_object_unref (style2);
+  if (image_pattern)
+    cairo_pattern_destroy (image_pattern);
+
+  return EXIT_SUCCESS;
+}
@@ -101,9 +101,11 @@
  */
 #include <config.h>
 #include <math.h>
+#include <string.h>
 #include <glib/gi18n-lib.h>
 #include <gtk/gtk.h>
 #include "goocanvasatk.h"
+#include "goocanvasprivate.h"
 #include "goocanvas.h"
 #include "goocanvasitemmodel.h"
 #include "goocanvasitem.h"
@@ -123,6 +125,32 @@ struct _GooCanvasPrivate {
   GdkRGBA background_color;
   guint background_color_set : 1;
   guint pointer_grab_is_implicit : 1;
+  guint lazy_views : 1;
+  guint collect_stats : 1;
+  guint show_profile : 1;
+
+  /* The canvas whose items this canvas displays, if set, and the canvases
+     which display this canvas's items. */
+  GooCanvas *view_source;
+  GSList *mirrors;
+
+  /* If set, this is called instead of scheduling updates and redraws. It is
+     used for the hidden canvases holding the source items of GooCanvasUse
+     items. */
+  GooCanvasChangeFunc change_func;
+  gpointer change_data;
+
+  /* The stats of the frame being collected, and of the last frame drawn. */
+  GooCanvasFrameStats frame_stats;
+  GooCanvasFrameStats last_frame_stats;
+
+  /* The costs of the items, if the profile-items property is set. */
+  GooCanvasProfile *profile;
+
+  /* The root item and visible area last checked for lazy groups coming into
+     view, so only the newly exposed area is checked when scrolling. */
+  GooCanvasItem *lazy_checked_root;
+  GooCanvasBounds lazy_checked_bounds;
 };
 
 
@@ -149,6 +177,11 @@ enum {
   PROP_INTEGER_LAYOUT,
   PROP_CLEAR_BACKGROUND,
   PROP_REDRAW_WHEN_SCROLLED,
+  PROP_LAZY_VIEWS,
+  PROP_VIEW_SOURCE,
+  PROP_COLLECT_STATS,
+  PROP_PROFILE_ITEMS,
+  PROP_SHOW_PROFILE,
   PROP_HADJUSTMENT,
   PROP_VADJUSTMENT,
   PROP_HSCROLL_POLICY,
@@ -157,6 +190,7 @@ enum {
 
 enum {
   ITEM_CREATED,
+  FRAME_STATS,
 
   LAST_SIGNAL
 };
@@ -164,6 +198,10 @@ enum {
 
 static guint canvas_signals[LAST_SIGNAL] = { 0 };
 
+GooCanvasFrameStats *_goo_canvas_frame_stats = NULL;
+
+static const cairo_user_data_key_t hit_test_scale_key;
+
 static const double GOO_CANVAS_MM_PER_INCH =  25.4;
 static const double GOO_CANVAS_POINTS_PER_INCH = 72.0;
 
@@ -241,6 +279,7 @@ static void     update_pointer_item        (GooCanvas        *canvas,
 					    GdkEvent         *event);
 static void     reconfigure_canvas	   (GooCanvas        *canvas,
 					    gboolean          redraw_if_needed);
+static void	goo_canvas_reset_lazy_checked_bounds (GooCanvas     *canvas);
 static void	goo_canvas_update_automatic_bounds (GooCanvas       *canvas);
 
 static void	goo_canvas_convert_from_window_pixels (GooCanvas     *canvas,
@@ -249,6 +288,11 @@ static void	goo_canvas_convert_from_window_pixels (GooCanvas     *canvas,
 static void     goo_canvas_convert_to_static_item_space (GooCanvas     *canvas,
 							 gdouble       *x,
 							 gdouble       *y);
+static gint64	goo_canvas_begin_stats	   (GooCanvas            *canvas,
+					    GooCanvasFrameStats **previous_stats);
+static void	goo_canvas_end_stats	   (GooCanvasFrameStats  *previous_stats,
+					    gint64                start_time,
+					    gint64               *total_time);
 
 G_DEFINE_TYPE_WITH_CODE (GooCanvas, goo_canvas, GTK_TYPE_CONTAINER,
   G_IMPLEMENT_INTERFACE (GTK_TYPE_SCROLLABLE, NULL))
@@ -463,6 +507,95 @@ goo_canvas_class_init (GooCanvasClass *klass)
 							 FALSE,
 							 G_PARAM_READWRITE));
 
+  /**
+   * GooCanvas:lazy-views:
+   *
+   * If views of group models are only created when they are needed. This
+   * only affects #GooCanvasGroupModel objects whose bounds are known in
+   * advance, see goo_canvas_item_model_get_bounds(). Items for their
+   * children are not created until the group is scrolled into view, or the
+   * item for one of its descendants is requested with goo_canvas_get_item().
+   * Until then, the children of groups outside the visible area aren't
+   * found by hit-testing functions such as goo_canvas_get_items_at().
+   *
+   * It must be set before the root item model is set.
+   *
+   * Since: 3.0
+   */
+  g_object_class_install_property (gobject_class, PROP_LAZY_VIEWS,
+                                   g_param_spec_boolean ("lazy-views",
+							 _("Lazy Views"),
+							 _("If the items to view group models are only created when they are visible"),
+							 FALSE,
+							 G_PARAM_READWRITE));
+
+  /**
+   * GooCanvas:view-source:
+   *
+   * Another canvas whose items are displayed in this canvas, instead of
+   * this canvas's own root item. See goo_canvas_set_view_source().
+   *
+   * Since: 3.0
+   */
+  g_object_class_install_property (gobject_class, PROP_VIEW_SOURCE,
+                                   g_param_spec_object ("view-source",
+							_("View Source"),
+							_("The canvas whose items are displayed in this canvas"),
+							GOO_TYPE_CANVAS,
+							G_PARAM_READWRITE));
+
+  /**
+   * GooCanvas:collect-stats:
+   *
+   * If the canvas counts the items it updates, paints and hit tests, and
+   * times its updates, drawing and event handling. The stats of each frame
+   * are available with goo_canvas_get_frame_stats() and are passed to the
+   * #GooCanvas::frame-stats signal. When this is not set, the only cost is
+   * a test of a global pointer at each counter.
+   *
+   * Since: 3.0
+   */
+  g_object_class_install_property (gobject_class, PROP_COLLECT_STATS,
+                                   g_param_spec_boolean ("collect-stats",
+							 _("Collect Stats"),
+							 _("If the canvas collects performance statistics for each frame"),
+							 FALSE,
+							 G_PARAM_READWRITE));
+
+  /**
+   * GooCanvas:profile-items:
+   *
+   * If the canvas measures the time spent updating and painting each item.
+   * The costs are totalled by item and by type of item, and are available
+   * with goo_canvas_get_item_costs(). This is intended for finding which
+   * items make the canvas slow, and it slows the canvas down a little.
+   *
+   * Since: 3.0
+   */
+  g_object_class_install_property (gobject_class, PROP_PROFILE_ITEMS,
+                                   g_param_spec_boolean ("profile-items",
+							 _("Profile Items"),
+							 _("If the canvas measures the time spent updating and painting each item"),
+							 FALSE,
+							 G_PARAM_READWRITE));
+
+  /**
+   * GooCanvas:show-profile:
+   *
+   * If the canvas paints a heat map over the items, with the items that
+   * have taken the most time to update and paint in the strongest red.
+   * This only has an effect if the #GooCanvas:profile-items property is
+   * set.
+   *
+   * Since: 3.0
+   */
+  g_object_class_install_property (gobject_class, PROP_SHOW_PROFILE,
+                                   g_param_spec_boolean ("show-profile",
+							 _("Show Profile"),
+							 _("If the canvas paints a heat map of the time spent on each item"),
+							 FALSE,
+							 G_PARAM_READWRITE));
+
   /* GtkScrollable interface */
   g_object_class_override_property (gobject_class, PROP_HADJUSTMENT, "hadjustment");
   g_object_class_override_property (gobject_class, PROP_VADJUSTMENT, "vadjustment");
@@ -491,6 +624,27 @@ goo_canvas_class_init (GooCanvasClass *klass)
 		  G_TYPE_NONE, 2,
 		  GOO_TYPE_CANVAS_ITEM,
 		  GOO_TYPE_CANVAS_ITEM_MODEL);
+
+  /**
+   * GooCanvas::frame-stats:
+   * @canvas: the canvas.
+   * @stats: the #GooCanvasFrameStats of the frame.
+   *
+   * This is emitted after each frame is drawn, if the
+   * #GooCanvas:collect-stats property is set. The stats include any
+   * updates and events handled since the previous frame.
+   *
+   * Since: 3.0
+   */
+  canvas_signals[FRAME_STATS] =
+    g_signal_new ("frame-stats",
+		  G_TYPE_FROM_CLASS (gobject_class),
+		  G_SIGNAL_RUN_LAST,
+		  G_STRUCT_OFFSET (GooCanvasClass, frame_stats),
+		  NULL, NULL,
+		  goo_canvas_marshal_VOID__BOXED,
+		  G_TYPE_NONE, 1,
+		  GOO_TYPE_CANVAS_FRAME_STATS | G_SIGNAL_TYPE_STATIC_SCOPE);
 }
 
 
@@ -552,6 +706,7 @@ goo_canvas_init (GooCanvas *canvas)
   priv->window_x = priv->static_window_x = 0;
   priv->window_y = priv->static_window_y = 0;
   priv->background_color_set = FALSE;
+  priv->lazy_views = FALSE;
 }
 
 
@@ -578,6 +733,12 @@ goo_canvas_dispose (GObject *object)
   GooCanvas *canvas = (GooCanvas*) object;
   GooCanvasPrivate *priv = GOO_CANVAS_GET_PRIVATE (canvas);
 
+  /* Stop any canvases displaying our items, and stop displaying the items of
+     our view source. */
+  while (priv->mirrors)
+    goo_canvas_set_view_source (priv->mirrors->data, NULL);
+  goo_canvas_set_view_source (canvas, NULL);
+
   if (canvas->model_to_item)
     {
       g_hash_table_destroy (canvas->model_to_item);
@@ -633,6 +794,12 @@ goo_canvas_dispose (GObject *object)
       canvas->vadjustment = NULL;
     }
 
+  if (priv->profile)
+    {
+      goo_canvas_profile_free (priv->profile);
+      priv->profile = NULL;
+    }
+
   G_OBJECT_CLASS (goo_canvas_parent_class)->dispose (object);
 }
 
@@ -731,6 +898,7 @@ goo_canvas_get_property    (GObject            *object,
 			    GParamSpec         *pspec)
 {
   GooCanvas *canvas = (GooCanvas*) object;
+  GooCanvasPrivate *priv = GOO_CANVAS_GET_PRIVATE (canvas);
 
   switch (prop_id)
     {
@@ -785,6 +953,21 @@ goo_canvas_get_property    (GObject            *object,
     case PROP_REDRAW_WHEN_SCROLLED:
       g_value_set_boolean (value, canvas->redraw_when_scrolled);
       break;
+    case PROP_LAZY_VIEWS:
+      g_value_set_boolean (value, priv->lazy_views);
+      break;
+    case PROP_VIEW_SOURCE:
+      g_value_set_object (value, priv->view_source);
+      break;
+    case PROP_COLLECT_STATS:
+      g_value_set_boolean (value, priv->collect_stats);
+      break;
+    case PROP_PROFILE_ITEMS:
+      g_value_set_boolean (value, priv->profile != NULL);
+      break;
+    case PROP_SHOW_PROFILE:
+      g_value_set_boolean (value, priv->show_profile);
+      break;
     case PROP_HADJUSTMENT:
       g_value_set_object (value, canvas->hadjustment);
       break;
@@ -917,6 +1100,38 @@ goo_canvas_set_property    (GObject            *object,
     case PROP_REDRAW_WHEN_SCROLLED:
       canvas->redraw_when_scrolled = g_value_get_boolean (value);
       break;
+    case PROP_LAZY_VIEWS:
+      if (canvas->root_item_model
+	  && priv->lazy_views != g_value_get_boolean (value))
+	g_warning ("The GooCanvas:lazy-views property must be set before the root item model.");
+      priv->lazy_views = g_value_get_boolean (value);
+      break;
+    case PROP_VIEW_SOURCE:
+      goo_canvas_set_view_source (canvas, g_value_get_object (value));
+      break;
+    case PROP_COLLECT_STATS:
+      priv->collect_stats = g_value_get_boolean (value);
+      memset (&priv->frame_stats, 0, sizeof (GooCanvasFrameStats));
+      memset (&priv->last_frame_stats, 0, sizeof (GooCanvasFrameStats));
+      break;
+    case PROP_PROFILE_ITEMS:
+      if (g_value_get_boolean (value))
+	{
+	  if (!priv->profile)
+	    priv->profile = goo_canvas_profile_new ();
+	}
+      else if (priv->profile)
+	{
+	  goo_canvas_profile_free (priv->profile);
+	  priv->profile = NULL;
+	}
+      if (priv->show_profile)
+	gtk_widget_queue_draw (GTK_WIDGET (canvas));
+      break;
+    case PROP_SHOW_PROFILE:
+      priv->show_profile = g_value_get_boolean (value);
+      gtk_widget_queue_draw (GTK_WIDGET (canvas));
+      break;
     case PROP_HADJUSTMENT:
       goo_canvas_set_hadjustment (canvas, g_value_get_object (value));
       break;
@@ -1014,6 +1229,7 @@ goo_canvas_set_root_item_model (GooCanvas          *canvas,
     }
 
   goo_canvas_item_set_canvas (canvas->root_item, canvas);
+  goo_canvas_reset_lazy_checked_bounds (canvas);
   canvas->need_update = TRUE;
 
   if (gtk_widget_get_realized (GTK_WIDGET (canvas)))
@@ -1069,6 +1285,7 @@ goo_canvas_set_root_item    (GooCanvas		*canvas,
 
   canvas->root_item = g_object_ref (item);
   goo_canvas_item_set_canvas (canvas->root_item, canvas);
+  goo_canvas_reset_lazy_checked_bounds (canvas);
 
   canvas->need_update = TRUE;
 
@@ -1264,6 +1481,9 @@ goo_canvas_set_static_root_item_model (GooCanvas	  *canvas,
  * More complex applications may want to use the #GooCanvas::item-created
  * signal to hook up their signal handlers.
  *
+ * If the #GooCanvas:lazy-views property is set, the canvas items for the
+ * model's ancestors' children are created if they haven't been yet.
+ *
  * Returns: (transfer none): the canvas item corresponding to the given
  *  #GooCanvasItemModel, or %NULL if no canvas item has been created for it yet.
  **/
@@ -1271,7 +1491,9 @@ GooCanvasItem*
 goo_canvas_get_item (GooCanvas          *canvas,
 		     GooCanvasItemModel *model)
 {
-  GooCanvasItem *item = NULL;
+  GooCanvasPrivate *priv;
+  GooCanvasItemModel *parent_model;
+  GooCanvasItem *item = NULL, *parent;
 
   g_return_val_if_fail (GOO_IS_CANVAS (canvas), NULL);
   g_return_val_if_fail (GOO_IS_CANVAS_ITEM_MODEL (model), NULL);
@@ -1279,6 +1501,19 @@ goo_canvas_get_item (GooCanvas          *canvas,
   if (canvas->model_to_item)
     item = g_hash_table_lookup (canvas->model_to_item, model);
 
+  /* If the parent's item hasn't created its children yet, do it now. */
+  priv = GOO_CANVAS_GET_PRIVATE (canvas);
+  if (!item && canvas->model_to_item && priv->lazy_views)
+    {
+      parent_model = goo_canvas_item_model_get_parent (model);
+      parent = parent_model ? goo_canvas_get_item (canvas, parent_model) : NULL;
+      if (parent && GOO_IS_CANVAS_GROUP (parent))
+	{
+	  goo_canvas_group_create_pending_children ((GooCanvasGroup*) parent);
+	  item = g_hash_table_lookup (canvas->model_to_item, model);
+	}
+    }
+
   /* If the item model has a canvas item check it is valid. */
   g_return_val_if_fail (!item || GOO_IS_CANVAS_ITEM (item), NULL);
 
@@ -1286,6 +1521,237 @@ goo_canvas_get_item (GooCanvas          *canvas,
 }
 
 
+/**
+ * goo_canvas_release_hidden_items:
+ * @canvas: a #GooCanvas.
+ *
+ * Frees the canvas items which were created lazily to view the children of
+ * group models that are no longer visible. They will be created again when
+ * they are needed.
+ *
+ * This only has an effect if the #GooCanvas:lazy-views property is set.
+ * Applications may want to call it when memory is low, or after scrolling
+ * a large distance.
+ *
+ * Since: 3.0
+ **/
+void
+goo_canvas_release_hidden_items (GooCanvas *canvas)
+{
+  GooCanvasPrivate *priv;
+  GooCanvasBounds visible_bounds;
+
+  g_return_if_fail (GOO_IS_CANVAS (canvas));
+
+  priv = GOO_CANVAS_GET_PRIVATE (canvas);
+  if (!priv->lazy_views || !canvas->root_item
+      || !GOO_IS_CANVAS_GROUP (canvas->root_item))
+    return;
+
+  /* Make sure the items' bounds are up to date. */
+  goo_canvas_update (canvas);
+
+  goo_canvas_get_visible_bounds (canvas, &visible_bounds);
+  goo_canvas_group_release_hidden_children ((GooCanvasGroup*) canvas->root_item,
+					    &visible_bounds);
+
+  /* Canvases displaying this canvas's items may have other visible areas,
+     in which items have just been released. */
+  goo_canvas_reset_lazy_checked_bounds (canvas);
+}
+
+
+/* Returns TRUE if the canvas items to view group models are created lazily.
+   See the "lazy-views" property. */
+gboolean
+goo_canvas_get_lazy_views (GooCanvas *canvas)
+{
+  GooCanvasPrivate *priv = GOO_CANVAS_GET_PRIVATE (canvas);
+
+  return priv->lazy_views;
+}
+
+
+/* Gets the area of the canvas which is currently visible in the window, in
+   the canvas coordinate space. */
+void
+goo_canvas_get_visible_bounds (GooCanvas       *canvas,
+			       GooCanvasBounds *bounds)
+{
+  GtkWidget *widget = GTK_WIDGET (canvas);
+
+  bounds->x1 = bounds->y1 = 0.0;
+  bounds->x2 = gtk_widget_get_allocated_width (widget);
+  bounds->y2 = gtk_widget_get_allocated_height (widget);
+
+  if (canvas->hadjustment)
+    {
+      bounds->x1 += gtk_adjustment_get_value (canvas->hadjustment);
+      bounds->x2 += gtk_adjustment_get_value (canvas->hadjustment);
+    }
+  if (canvas->vadjustment)
+    {
+      bounds->y1 += gtk_adjustment_get_value (canvas->vadjustment);
+      bounds->y2 += gtk_adjustment_get_value (canvas->vadjustment);
+    }
+
+  goo_canvas_convert_from_pixels (canvas, &bounds->x1, &bounds->y1);
+  goo_canvas_convert_from_pixels (canvas, &bounds->x2, &bounds->y2);
+}
+
+
+/**
+ * goo_canvas_get_view_source:
+ * @canvas: a #GooCanvas.
+ *
+ * Gets the canvas whose items are displayed in @canvas, as set with
+ * goo_canvas_set_view_source().
+ *
+ * Returns: (transfer none): the view source canvas, or %NULL.
+ *
+ * Since: 3.0
+ **/
+GooCanvas*
+goo_canvas_get_view_source (GooCanvas *canvas)
+{
+  g_return_val_if_fail (GOO_IS_CANVAS (canvas), NULL);
+
+  return GOO_CANVAS_GET_PRIVATE (canvas)->view_source;
+}
+
+
+/**
+ * goo_canvas_set_view_source:
+ * @canvas: a #GooCanvas.
+ * @source: (allow-none): the canvas whose items should be displayed, or %NULL
+ *  to display the canvas's own root item again.
+ *
+ * Makes @canvas display the items of @source, instead of its own root item.
+ *
+ * This is useful to show the same item or model tree in several views, such
+ * as an overview and a detail view. No items are created for @canvas, so
+ * the items are only updated once, by @source, and their bounds, cached
+ * paths and text layouts are shared. Only the scale, scroll position and
+ * bounds of @canvas are its own. Both canvases should use the same units
+ * and resolution.
+ *
+ * Whenever an item in @source needs to be redrawn, the same area is redrawn
+ * in @canvas. Hit-testing and pointer events in @canvas use the items of
+ * @source, so goo_canvas_item_get_canvas() returns @source for them.
+ * Static items are not shared.
+ *
+ * Hit-testing in @canvas uses the scale of @canvas for the items'
+ * #GooCanvasItem:visibility-threshold, as painting does. However,
+ * goo_canvas_item_is_visible() always uses the scale of @source.
+ *
+ * Since: 3.0
+ **/
+void
+goo_canvas_set_view_source (GooCanvas *canvas,
+			    GooCanvas *source)
+{
+  GooCanvasPrivate *priv, *source_priv;
+
+  g_return_if_fail (GOO_IS_CANVAS (canvas));
+  g_return_if_fail (source == NULL || GOO_IS_CANVAS (source));
+  g_return_if_fail (source != canvas);
+
+  priv = GOO_CANVAS_GET_PRIVATE (canvas);
+  if (priv->view_source == source)
+    return;
+
+  /* Chains of view sources aren't supported, as redraws are only passed on
+     to the canvases displaying the source directly. */
+  g_return_if_fail (source == NULL
+		    || GOO_CANVAS_GET_PRIVATE (source)->view_source == NULL);
+
+  if (priv->view_source)
+    {
+      source_priv = GOO_CANVAS_GET_PRIVATE (priv->view_source);
+      source_priv->mirrors = g_slist_remove (source_priv->mirrors, canvas);
+      g_object_unref (priv->view_source);
+      priv->view_source = NULL;
+    }
+
+  if (source)
+    {
+      source_priv = GOO_CANVAS_GET_PRIVATE (source);
+      source_priv->mirrors = g_slist_prepend (source_priv->mirrors, canvas);
+      priv->view_source = g_object_ref (source);
+    }
+  goo_canvas_reset_lazy_checked_bounds (canvas);
+
+  /* The items under the pointer have changed, and we may need to recompute
+     the automatic bounds. */
+  set_item_pointer (&canvas->pointer_item, NULL);
+  goo_canvas_request_update (canvas);
+  gtk_widget_queue_draw (GTK_WIDGET (canvas));
+
+  g_object_notify (G_OBJECT (canvas), "view-source");
+}
+
+
+/* Sets a function to call instead of scheduling updates and redraws. The
+   bounds passed to it are NULL when an update is requested. */
+void
+goo_canvas_set_change_func (GooCanvas           *canvas,
+			    GooCanvasChangeFunc  change_func,
+			    gpointer             change_data)
+{
+  GooCanvasPrivate *priv = GOO_CANVAS_GET_PRIVATE (canvas);
+
+  priv->change_func = change_func;
+  priv->change_data = change_data;
+}
+
+
+/* Sets the scale to use for the items' visibility thresholds while hit
+   testing with the given cairo context, which is the scale of the canvas
+   doing the hit testing. It differs from the scale of the items' own canvas
+   if the canvas displays another canvas's items, see
+   goo_canvas_set_view_source(). It is kept with the context so nested hit
+   tests on other canvases don't affect it. */
+static void
+goo_canvas_set_hit_test_scale (GooCanvas *canvas,
+			       cairo_t   *cr)
+{
+  cairo_set_user_data (cr, &hit_test_scale_key, &canvas->scale, NULL);
+}
+
+
+/* Returns the scale to use for the visibility thresholds of the canvas's
+   items while hit testing with the given cairo context. If the context
+   wasn't created to hit test another canvas, this is the canvas's own
+   scale. */
+gdouble
+goo_canvas_get_hit_test_scale (GooCanvas *canvas,
+			       cairo_t   *cr)
+{
+  gdouble *scale = cairo_get_user_data (cr, &hit_test_scale_key);
+
+  return scale ? *scale : canvas->scale;
+}
+
+
+/* Returns the root item which the canvas paints and hit-tests, which is the
+   root item of the view source canvas if one is set. */
+static GooCanvasItem*
+goo_canvas_get_display_root (GooCanvas *canvas)
+{
+  GooCanvasPrivate *priv = GOO_CANVAS_GET_PRIVATE (canvas);
+
+  if (priv->view_source)
+    {
+      /* Make sure the shared items are up to date before they are used. */
+      if (priv->view_source->need_update)
+	goo_canvas_update (priv->view_source);
+      return priv->view_source->root_item;
+    }
+
+  return canvas->root_item;
+}
+
+
 /**
  * goo_canvas_get_item_at:
  * @canvas: a #GooCanvas.
@@ -1306,17 +1772,25 @@ goo_canvas_get_item_at (GooCanvas     *canvas,
 			gboolean       is_pointer_event)
 {
   GooCanvasPrivate *priv;
+  GooCanvasFrameStats *previous_stats;
   cairo_t *cr;
-  GooCanvasItem *result = NULL;
+  GooCanvasItem *root, *result = NULL;
   GList *list = NULL;
+  gint64 start_time, trace_time;
+  guint hit_tests G_GNUC_UNUSED;
 
   g_return_val_if_fail (GOO_IS_CANVAS (canvas), NULL);
 
   priv = GOO_CANVAS_GET_PRIVATE (canvas);
+  root = goo_canvas_get_display_root (canvas);
   cr = goo_canvas_create_cairo_context (canvas);
+  start_time = goo_canvas_begin_stats (canvas, &previous_stats);
+  trace_time = GOO_CANVAS_TRACE_TIME ();
+  hit_tests = priv->frame_stats.hit_tests;
+  goo_canvas_set_hit_test_scale (canvas, cr);
 
-  if (canvas->root_item)
-    list = goo_canvas_item_get_items_at (canvas->root_item, x, y, cr,
+  if (root)
+    list = goo_canvas_item_get_items_at (root, x, y, cr,
 					 is_pointer_event, TRUE, NULL);
 
   if (!list && priv->static_root_item)
@@ -1329,6 +1803,9 @@ goo_canvas_get_item_at (GooCanvas     *canvas,
 					   is_pointer_event, TRUE, NULL);
     }
 
+  goo_canvas_end_stats (previous_stats, start_time, NULL);
+  GOO_CANVAS_TRACE_MARK (trace_time, "Hit test", "%u items tested",
+			 priv->frame_stats.hit_tests - hit_tests);
   cairo_destroy (cr);
 
   /* We just return the top item in the list. */
@@ -1362,16 +1839,25 @@ goo_canvas_get_items_at (GooCanvas     *canvas,
 			 gboolean       is_pointer_event)
 {
   GooCanvasPrivate *priv;
+  GooCanvasFrameStats *previous_stats;
   cairo_t *cr;
+  GooCanvasItem *root;
   GList *result = NULL;
+  gint64 start_time, trace_time;
+  guint hit_tests G_GNUC_UNUSED;
 
   g_return_val_if_fail (GOO_IS_CANVAS (canvas), NULL);
 
   priv = GOO_CANVAS_GET_PRIVATE (canvas);
+  root = goo_canvas_get_display_root (canvas);
   cr = goo_canvas_create_cairo_context (canvas);
+  start_time = goo_canvas_begin_stats (canvas, &previous_stats);
+  trace_time = GOO_CANVAS_TRACE_TIME ();
+  hit_tests = priv->frame_stats.hit_tests;
+  goo_canvas_set_hit_test_scale (canvas, cr);
 
-  if (canvas->root_item)
-    result = goo_canvas_item_get_items_at (canvas->root_item, x, y, cr,
+  if (root)
+    result = goo_canvas_item_get_items_at (root, x, y, cr,
 					   is_pointer_event, TRUE, NULL);
 
   if (priv->static_root_item)
@@ -1384,6 +1870,9 @@ goo_canvas_get_items_at (GooCanvas     *canvas,
 					     is_pointer_event, TRUE, result);
     }
 
+  goo_canvas_end_stats (previous_stats, start_time, NULL);
+  GOO_CANVAS_TRACE_MARK (trace_time, "Hit test", "%u items tested",
+			 priv->frame_stats.hit_tests - hit_tests);
   cairo_destroy (cr);
 
   return result;
@@ -1478,13 +1967,16 @@ goo_canvas_get_items_in_area (GooCanvas		    *canvas,
 			      gboolean               allow_overlaps,
 			      gboolean               include_containers)
 {
+  GooCanvasItem *root;
+
   g_return_val_if_fail (GOO_IS_CANVAS (canvas), NULL);
 
   /* If no root item is set, just return NULL. */
-  if (!canvas->root_item)
+  root = goo_canvas_get_display_root (canvas);
+  if (!root)
     return NULL;
 
-  return goo_canvas_get_items_in_area_recurse (canvas, canvas->root_item,
+  return goo_canvas_get_items_in_area_recurse (canvas, root,
 					       area, inside_area,
 					       allow_overlaps,
 					       include_containers, NULL);
@@ -1782,6 +2274,9 @@ request_static_redraw (GooCanvas             *canvas,
   g_print ("Invalidating rect: %i,%i %ix%i\n",
 	   rect.x, rect.y, rect.width, rect.height);
 #endif
+  if (priv->collect_stats)
+    priv->frame_stats.redraw_rects++;
+
   gdk_window_invalidate_rect (canvas->canvas_window, &rect, FALSE);
 }
 
@@ -1835,6 +2330,53 @@ redraw_static_items_at_position (GooCanvas *canvas,
 #endif
 
 
+/* If the canvas creates items lazily, this requests an update of the groups
+   which have been scrolled into view but haven't created their children yet.
+   The children are then created in the update, before the groups are
+   painted or hit-tested. If the canvas displays the items of another canvas
+   it is that canvas's items and "lazy-views" setting which are used. */
+static void
+goo_canvas_request_visible_updates (GooCanvas *canvas)
+{
+  GooCanvasPrivate *priv = GOO_CANVAS_GET_PRIVATE (canvas);
+  GooCanvas *items_canvas = priv->view_source ? priv->view_source : canvas;
+  GooCanvasItem *root;
+  GooCanvasBounds visible_bounds;
+
+  if (!goo_canvas_get_lazy_views (items_canvas))
+    return;
+
+  root = goo_canvas_get_display_root (canvas);
+  if (!root || !GOO_IS_CANVAS_GROUP (root))
+    return;
+
+  goo_canvas_get_visible_bounds (canvas, &visible_bounds);
+  goo_canvas_group_request_visible_updates ((GooCanvasGroup*) root,
+					    &visible_bounds,
+					    priv->lazy_checked_root == root
+					    ? &priv->lazy_checked_bounds : NULL);
+
+  /* The root isn't referenced, it is only compared with the next root. */
+  priv->lazy_checked_root = root;
+  priv->lazy_checked_bounds = visible_bounds;
+}
+
+
+/* Forgets the area last checked for lazy groups, so that the whole visible
+   area is checked next time. This must be called when items in the area
+   may have been released. */
+static void
+goo_canvas_reset_lazy_checked_bounds (GooCanvas *canvas)
+{
+  GooCanvasPrivate *priv = GOO_CANVAS_GET_PRIVATE (canvas);
+  GSList *l;
+
+  priv->lazy_checked_root = NULL;
+  for (l = priv->mirrors; l; l = l->next)
+    goo_canvas_reset_lazy_checked_bounds (l->data);
+}
+
+
 /* This makes sure the canvas is all set up correctly, i.e. the scrollbar
    adjustments are set, the canvas x & y offsets are calculated, and the
    canvas window is sized. */
@@ -1947,6 +2489,8 @@ reconfigure_canvas (GooCanvas *canvas,
       if (redraw_if_needed)
 	gtk_widget_queue_draw (GTK_WIDGET (canvas));
     }
+
+  goo_canvas_request_visible_updates (canvas);
 }
 
 
@@ -2040,6 +2584,8 @@ goo_canvas_adjustment_value_changed (GtkAdjustment *adjustment,
   AtkObject *accessible;
   int new_window_x, new_window_y;
 
+  goo_canvas_request_visible_updates (canvas);
+
   if (!canvas->freeze_count && gtk_widget_get_realized (GTK_WIDGET(canvas)))
     {
       /* These get truncated to ints. */
@@ -2488,9 +3034,10 @@ goo_canvas_update_automatic_bounds (GooCanvas       *canvas)
 {
   GooCanvasBounds bounds = { 0.0, 0.0, GOO_CANVAS_DEFAULT_WIDTH,
 			     GOO_CANVAS_DEFAULT_HEIGHT };
+  GooCanvasItem *root = goo_canvas_get_display_root (canvas);
 
-  if (canvas->root_item)
-    goo_canvas_item_get_bounds (canvas->root_item, &bounds);
+  if (root)
+    goo_canvas_item_get_bounds (root, &bounds);
 
   /* Calculate the new automatic bounds, which is the bounds of all the items
      in the canvas plus any specified padding. If bounds_from_origin is set
@@ -2529,12 +3076,62 @@ goo_canvas_update_automatic_bounds (GooCanvas       *canvas)
 }
 
 
+/* Makes the canvas's stats the current ones while it is updated, drawn or
+   hit tested, so items can update the counters. The counters are also
+   used for the sysprof marks while sysprof is recording. It returns the
+   start time, or 0 if the canvas isn't collecting stats. */
+static gint64
+goo_canvas_begin_stats (GooCanvas            *canvas,
+			GooCanvasFrameStats **previous_stats)
+{
+  GooCanvasPrivate *priv = GOO_CANVAS_GET_PRIVATE (canvas);
+
+  *previous_stats = _goo_canvas_frame_stats;
+
+  if (!priv->collect_stats && !GOO_CANVAS_TRACE_ACTIVE ())
+    {
+      _goo_canvas_frame_stats = NULL;
+      return 0;
+    }
+
+  _goo_canvas_frame_stats = &priv->frame_stats;
+  return g_get_monotonic_time ();
+}
+
+
+/* Restores the previous stats, and adds the time taken to total_time if it
+   isn't NULL. */
+static void
+goo_canvas_end_stats (GooCanvasFrameStats *previous_stats,
+		      gint64               start_time,
+		      gint64              *total_time)
+{
+  if (start_time && total_time)
+    *total_time += g_get_monotonic_time () - start_time;
+
+  _goo_canvas_frame_stats = previous_stats;
+}
+
+
 static void
 goo_canvas_update_internal (GooCanvas *canvas,
 			    cairo_t   *cr)
 {
   GooCanvasPrivate *priv = GOO_CANVAS_GET_PRIVATE (canvas);
   GooCanvasBounds bounds, static_bounds;
+  GooCanvasFrameStats *previous_stats;
+  GooCanvasProfile *previous_profile;
+  gint64 start_time, trace_time;
+  guint items_updated G_GNUC_UNUSED;
+
+  /* If we display the items of another canvas, that canvas updates them. */
+  if (priv->view_source && priv->view_source->need_update)
+    goo_canvas_update (priv->view_source);
+
+  start_time = goo_canvas_begin_stats (canvas, &previous_stats);
+  trace_time = GOO_CANVAS_TRACE_TIME ();
+  items_updated = priv->frame_stats.items_updated;
+  previous_profile = _goo_canvas_profile;
 
   /* It is possible that processing the first set of updates causes other
      updates to be scheduled, so we loop round until all are done. Items
@@ -2545,8 +3142,12 @@ goo_canvas_update_internal (GooCanvas *canvas,
 
       canvas->need_update = FALSE;
       canvas->need_entire_subtree_update = FALSE;
+      /* Only the root item's items are profiled, as the static items are
+	 in a different coordinate space, so can't be shown in the heat map. */
+      _goo_canvas_profile = priv->profile;
       if (canvas->root_item)
 	goo_canvas_item_update (canvas->root_item, entire_tree, cr, &bounds);
+      _goo_canvas_profile = NULL;
 
       if (priv->static_root_item)
 	goo_canvas_item_update (priv->static_root_item, entire_tree, cr,
@@ -2554,9 +3155,15 @@ goo_canvas_update_internal (GooCanvas *canvas,
     }
 
   /* If the bounds are automatically-calculated, update them now. */
-  if (canvas->root_item && canvas->automatic_bounds)
+  if ((canvas->root_item || priv->view_source) && canvas->automatic_bounds)
     goo_canvas_update_automatic_bounds (canvas);
 
+  _goo_canvas_profile = previous_profile;
+  goo_canvas_end_stats (previous_stats, start_time,
+			&priv->frame_stats.update_time);
+  GOO_CANVAS_TRACE_MARK (trace_time, "Update", "%u items updated",
+			 priv->frame_stats.items_updated - items_updated);
+
   /* Check which item is under the pointer. */
   update_pointer_item (canvas, NULL);
 }
@@ -2611,8 +3218,22 @@ goo_canvas_idle_handler (GooCanvas *canvas)
 void
 goo_canvas_request_update (GooCanvas   *canvas)
 {
+  GooCanvasPrivate *priv = GOO_CANVAS_GET_PRIVATE (canvas);
+  GSList *elem;
+
   canvas->need_update = TRUE;
 
+  /* Canvases displaying our items update them if we can't, e.g. if we
+     aren't realized. */
+  for (elem = priv->mirrors; elem; elem = elem->next)
+    goo_canvas_request_update (elem->data);
+
+  if (priv->change_func)
+    {
+      priv->change_func (canvas, NULL, priv->change_data);
+      return;
+    }
+
   /* We have to wait until we are realized. We'll do a full update then. */
   if (!gtk_widget_get_realized (GTK_WIDGET (canvas)))
     return;
@@ -2640,7 +3261,19 @@ void
 goo_canvas_request_redraw (GooCanvas             *canvas,
 			   const GooCanvasBounds *bounds)
 {
+  GooCanvasPrivate *priv = GOO_CANVAS_GET_PRIVATE (canvas);
   GdkRectangle rect;
+  GSList *elem;
+
+  /* Redraw the same area in any canvases displaying our items. */
+  for (elem = priv->mirrors; elem; elem = elem->next)
+    goo_canvas_request_redraw (elem->data, bounds);
+
+  if (priv->change_func)
+    {
+      priv->change_func (canvas, bounds, priv->change_data);
+      return;
+    }
 
   if (!gtk_widget_is_drawable (GTK_WIDGET (canvas)) || (bounds->x1 == bounds->x2))
     return;
@@ -2660,6 +3293,9 @@ goo_canvas_request_redraw (GooCanvas             *canvas,
   rect.x += canvas->canvas_x_offset;
   rect.y += canvas->canvas_y_offset;
 
+  if (priv->collect_stats)
+    priv->frame_stats.redraw_rects++;
+
   gdk_window_invalidate_rect (canvas->canvas_window, &rect, FALSE);
 }
 
@@ -2685,10 +3321,25 @@ goo_canvas_request_item_redraw (GooCanvas             *canvas,
 				const GooCanvasBounds *bounds,
 				gboolean               is_static)
 {
+  GooCanvasPrivate *priv = GOO_CANVAS_GET_PRIVATE (canvas);
+  GSList *elem;
+
+  if (priv->change_func && !is_static)
+    {
+      priv->change_func (canvas, bounds, priv->change_data);
+      return;
+    }
+
   /* If the canvas hasn't been painted yet, we can just return as it all needs
-     a redraw. This can save a lot of time if there are lots of items. */
+     a redraw. This can save a lot of time if there are lots of items. But
+     canvases displaying our items may still need to redraw. */
   if (canvas->before_initial_draw)
-    return;
+    {
+      if (!is_static)
+	for (elem = priv->mirrors; elem; elem = elem->next)
+	  goo_canvas_request_item_redraw (elem->data, bounds, FALSE);
+      return;
+    }
 
   if (is_static)
     request_static_redraw (canvas, bounds);
@@ -2718,14 +3369,22 @@ goo_canvas_draw (GtkWidget      *widget,
   GooCanvas *canvas = GOO_CANVAS (widget);
   GooCanvasPrivate *priv = GOO_CANVAS_GET_PRIVATE (canvas);
   GooCanvasBounds clip_bounds, bounds, root_item_bounds;
+  GooCanvasFrameStats *previous_stats;
+  GooCanvasProfile *previous_profile;
+  GooCanvasItem *root;
   double x1, y1, x2, y2;
+  gint64 start_time, trace_time;
 
-  if (!canvas->root_item)
+  root = goo_canvas_get_display_root (canvas);
+  if (!root)
     {
       canvas->before_initial_draw = FALSE;
       return FALSE;
     }
 
+  start_time = goo_canvas_begin_stats (canvas, &previous_stats);
+  trace_time = GOO_CANVAS_TRACE_TIME ();
+
   /* The clip extents tell us which parts of the window need to be drawn,
      in pixels, where (0,0) is the top-left of the widget window (not the
      entire canvas window as was the case with the expose_event signal). */
@@ -2784,7 +3443,7 @@ goo_canvas_draw (GtkWidget      *widget,
   /* Clip to the canvas bounds, if necessary. We only need to clip if the
      items in the canvas extend outside the canvas bounds and the canvas
      bounds is less than the area being painted. */
-  goo_canvas_item_get_bounds (canvas->root_item, &root_item_bounds);
+  goo_canvas_item_get_bounds (root, &root_item_bounds);
   if ((root_item_bounds.x1 < canvas->bounds.x1
        && canvas->bounds.x1 > bounds.x1)
       || (root_item_bounds.x2 > canvas->bounds.x2
@@ -2814,7 +3473,14 @@ goo_canvas_draw (GtkWidget      *widget,
   g_print ("Painting bounds: %g, %g - %g, %g\n", bounds.x1, bounds.y1,
 	   bounds.x2, bounds.y2);
 #endif
-  goo_canvas_item_paint (canvas->root_item, cr, &bounds, canvas->scale);
+  previous_profile = _goo_canvas_profile;
+  _goo_canvas_profile = priv->profile;
+  goo_canvas_item_paint (root, cr, &bounds, canvas->scale);
+  _goo_canvas_profile = previous_profile;
+
+  if (priv->profile && priv->show_profile)
+    goo_canvas_profile_paint (priv->profile, canvas, priv->view_source,
+			      cr, &bounds);
 
   cairo_restore (cr);
 
@@ -2824,10 +3490,499 @@ goo_canvas_draw (GtkWidget      *widget,
 
   canvas->before_initial_draw = FALSE;
 
+  goo_canvas_end_stats (previous_stats, start_time,
+			&priv->frame_stats.draw_time);
+  GOO_CANVAS_TRACE_MARK (trace_time, "Draw", "%u items painted, %u culled",
+			 priv->frame_stats.items_painted,
+			 priv->frame_stats.items_culled);
+
+  /* The frame is complete, so make its stats available and start again. */
+  if (priv->collect_stats)
+    {
+      priv->last_frame_stats = priv->frame_stats;
+      g_signal_emit (canvas, canvas_signals[FRAME_STATS], 0,
+		     &priv->last_frame_stats);
+    }
+  memset (&priv->frame_stats, 0, sizeof (GooCanvasFrameStats));
+
   return FALSE;
 }
 
 
+static GooCanvasFrameStats *
+goo_canvas_frame_stats_copy (const GooCanvasFrameStats *stats)
+{
+  GooCanvasFrameStats *result = g_new (GooCanvasFrameStats, 1);
+  *result = *stats;
+
+  return result;
+}
+
+GType
+goo_canvas_frame_stats_get_type (void)
+{
+  static GType our_type = 0;
+
+  if (our_type == 0)
+    our_type = g_boxed_type_register_static
+      ("GooCanvasFrameStats",
+       (GBoxedCopyFunc) goo_canvas_frame_stats_copy,
+       (GBoxedFreeFunc) g_free);
+
+  return our_type;
+}
+
+
+/**
+ * goo_canvas_get_frame_stats:
+ * @canvas: a #GooCanvas.
+ * @stats: (out caller-allocates): a #GooCanvasFrameStats to fill in.
+ *
+ * Gets the stats of the last frame drawn by the canvas. The
+ * #GooCanvas:collect-stats property must be set for the stats to be
+ * collected, otherwise they are all 0.
+ *
+ * Since: 3.0
+ **/
+void
+goo_canvas_get_frame_stats (GooCanvas           *canvas,
+			    GooCanvasFrameStats *stats)
+{
+  GooCanvasPrivate *priv;
+
+  g_return_if_fail (GOO_IS_CANVAS (canvas));
+  g_return_if_fail (stats != NULL);
+
+  priv = GOO_CANVAS_GET_PRIVATE (canvas);
+  *stats = priv->last_frame_stats;
+}
+
+
+/**
+ * goo_canvas_get_item_costs:
+ * @canvas: a #GooCanvas.
+ * @by_type: %TRUE to get the total costs of each type of item, or %FALSE to
+ *  get the costs of each item.
+ * @max_entries: the maximum number of costs to return, or 0 to return all
+ *  of them.
+ *
+ * Gets the time spent updating and painting each item, or each type of
+ * item, since the #GooCanvas:profile-items property was set or
+ * goo_canvas_reset_item_costs() was called. The most costly items are
+ * first. The costs of items that have been destroyed are only included in
+ * the costs of their type.
+ *
+ * The items are not referenced, so they should be used before any items
+ * are destroyed.
+ *
+ * Returns: (transfer full) (element-type GooCanvasItemCost): a new
+ *  array of #GooCanvasItemCost, or %NULL if the #GooCanvas:profile-items
+ *  property isn't set. Free it with g_array_unref().
+ *
+ * Since: 3.0
+ **/
+GArray*
+goo_canvas_get_item_costs (GooCanvas *canvas,
+			   gboolean   by_type,
+			   guint      max_entries)
+{
+  GooCanvasPrivate *priv;
+
+  g_return_val_if_fail (GOO_IS_CANVAS (canvas), NULL);
+
+  priv = GOO_CANVAS_GET_PRIVATE (canvas);
+  if (!priv->profile)
+    return NULL;
+
+  return goo_canvas_profile_get_costs (priv->profile, by_type, max_entries);
+}
+
+
+/**
+ * goo_canvas_reset_item_costs:
+ * @canvas: a #GooCanvas.
+ *
+ * Resets the costs of the items measured while the
+ * #GooCanvas:profile-items property is set, e.g. to only measure the costs
+ * of the following frames.
+ *
+ * Since: 3.0
+ **/
+void
+goo_canvas_reset_item_costs (GooCanvas *canvas)
+{
+  GooCanvasPrivate *priv;
+
+  g_return_if_fail (GOO_IS_CANVAS (canvas));
+
+  priv = GOO_CANVAS_GET_PRIVATE (canvas);
+  if (priv->profile)
+    {
+      goo_canvas_profile_reset (priv->profile);
+      if (priv->show_profile)
+	gtk_widget_queue_draw (GTK_WIDGET (canvas));
+    }
+}
+
+
+/*
+ * Memory accounting.
+ */
+typedef struct _GooCanvasMemoryWalk GooCanvasMemoryWalk;
+struct _GooCanvasMemoryWalk
+{
+  GooCanvasMemoryStats *stats;
+
+  /* The shared objects already counted - surfaces, packed paths, and the
+     sources of GooCanvasUse items. */
+  GHashTable *seen;
+
+  /* The number of items, models and styles using each style. */
+  GHashTable *styles;
+};
+
+
+/* Returns TRUE the first time it is called for each shared object. */
+static gboolean
+goo_canvas_memory_first_use (GooCanvasMemoryWalk *walk,
+			     gpointer             object)
+{
+  if (!object || g_hash_table_lookup (walk->seen, object))
+    return FALSE;
+
+  g_hash_table_insert (walk->seen, object, object);
+  return TRUE;
+}
+
+
+static void
+goo_canvas_memory_add_instance (GooCanvasMemoryWalk *walk,
+				gpointer             object)
+{
+  GTypeQuery query;
+
+  g_type_query (G_OBJECT_TYPE (object), &query);
+  walk->stats->instance_bytes += query.instance_size;
+}
+
+
+static void
+goo_canvas_memory_add_pattern (GooCanvasMemoryWalk *walk,
+			       cairo_pattern_t     *pattern)
+{
+  cairo_surface_t *surface;
+
+  if (!pattern
+      || cairo_pattern_get_surface (pattern, &surface) != CAIRO_STATUS_SUCCESS
+      || cairo_surface_get_type (surface) != CAIRO_SURFACE_TYPE_IMAGE
+      || !goo_canvas_memory_first_use (walk, surface))
+    return;
+
+  walk->stats->image_bytes += (gsize) cairo_image_surface_get_stride (surface)
+    * cairo_image_surface_get_height (surface);
+
+  /* The reduced-size copies used to paint images at small scales are kept
+     with the surface, so they are counted once per surface too. */
+  walk->stats->cache_bytes += goo_canvas_image_get_mip_chain_memory_used (surface);
+}
+
+
+static void
+goo_canvas_memory_add_style (GooCanvasMemoryWalk *walk,
+			     GooCanvasStyle      *style)
+{
+  GooCanvasStyleProperty *property;
+  guint n_uses, i;
+
+  /* The parent styles are only followed the first time a style is seen, so
+     their counts are the number of child styles using them. */
+  while (style)
+    {
+      n_uses = GPOINTER_TO_UINT (g_hash_table_lookup (walk->styles, style));
+      g_hash_table_insert (walk->styles, style, GUINT_TO_POINTER (n_uses + 1));
+      if (n_uses > 0)
+	break;
+
+      walk->stats->style_bytes += sizeof (GooCanvasStyle)
+	+ style->properties->len * sizeof (GooCanvasStyleProperty);
+
+      for (i = 0; i < style->properties->len; i++)
+	{
+	  property = &g_array_index (style->properties,
+				     GooCanvasStyleProperty, i);
+	  if (G_VALUE_HOLDS (&property->value, GOO_TYPE_CAIRO_PATTERN))
+	    goo_canvas_memory_add_pattern (walk,
+					   g_value_get_boxed (&property->value));
+	}
+
+      style = style->parent;
+    }
+}
+
+
+/* The data structs are only counted if they are allocated separately, i.e.
+   for items without models. The structs of models are part of the model
+   instances. */
+static void
+goo_canvas_memory_add_simple_data (GooCanvasMemoryWalk     *walk,
+				   GooCanvasItemSimpleData *simple_data,
+				   gboolean                 allocated)
+{
+  GooCanvasMemoryStats *stats = walk->stats;
+
+  if (allocated)
+    stats->simple_data_bytes += sizeof (GooCanvasItemSimpleData);
+  if (simple_data->transform)
+    stats->simple_data_bytes += sizeof (cairo_matrix_t);
+  if (simple_data->clip_path_commands)
+    stats->simple_data_bytes += simple_data->clip_path_commands->len
+      * sizeof (GooCanvasPathCommand);
+  if (simple_data->tooltip)
+    stats->simple_data_bytes += strlen (simple_data->tooltip) + 1;
+
+  goo_canvas_memory_add_style (walk, simple_data->style);
+}
+
+
+static void
+goo_canvas_memory_add_path_data (GooCanvasMemoryWalk *walk,
+				 GooCanvasPathData   *path_data,
+				 gboolean             allocated)
+{
+  GooCanvasMemoryStats *stats = walk->stats;
+
+  if (allocated)
+    stats->path_bytes += sizeof (GooCanvasPathData);
+  if (path_data->path_commands)
+    stats->path_bytes += path_data->path_commands->len
+      * sizeof (GooCanvasPathCommand);
+  if (path_data->packed_path
+      && goo_canvas_memory_first_use (walk, path_data->packed_path))
+    stats->path_bytes += goo_canvas_packed_path_get_size (path_data->packed_path);
+}
+
+
+static void
+goo_canvas_memory_add_polyline_data (GooCanvasMemoryWalk   *walk,
+				     GooCanvasPolylineData *polyline_data,
+				     gboolean               allocated)
+{
+  GooCanvasMemoryStats *stats = walk->stats;
+
+  if (allocated)
+    stats->polyline_bytes += sizeof (GooCanvasPolylineData);
+  if (polyline_data->coords)
+    stats->polyline_bytes += polyline_data->num_points * 2 * sizeof (gdouble);
+  if (polyline_data->arrow_data)
+    stats->polyline_bytes += sizeof (GooCanvasPolylineArrowData);
+}
+
+
+static void
+goo_canvas_memory_add_text_data (GooCanvasMemoryWalk *walk,
+				 GooCanvasTextData   *text_data,
+				 gboolean             allocated)
+{
+  GooCanvasMemoryStats *stats = walk->stats;
+
+  if (allocated)
+    stats->text_bytes += sizeof (GooCanvasTextData);
+  if (text_data->text)
+    stats->text_bytes += strlen (text_data->text) + 1;
+}
+
+
+static void
+goo_canvas_memory_add_image_data (GooCanvasMemoryWalk *walk,
+				  GooCanvasImageData  *image_data,
+				  gboolean             allocated)
+{
+  if (allocated)
+    walk->stats->image_bytes += sizeof (GooCanvasImageData);
+  goo_canvas_memory_add_pattern (walk, image_data->pattern);
+}
+
+
+static void goo_canvas_memory_add_canvas (GooCanvasMemoryWalk *walk,
+					  GooCanvas           *canvas);
+
+static void
+goo_canvas_memory_add_item (GooCanvasMemoryWalk *walk,
+			    GooCanvasItem       *item)
+{
+  GooCanvasMemoryStats *stats = walk->stats;
+  GooCanvasItemSimple *simple;
+  GooCanvas *source_canvas;
+  GPtrArray *batch_styles;
+  gpointer source;
+  gsize cache_bytes;
+  gint n_children, i;
+
+  stats->n_items++;
+  goo_canvas_memory_add_instance (walk, item);
+
+  if (GOO_IS_CANVAS_GROUP (item))
+    stats->instance_bytes += GOO_CANVAS_GROUP (item)->items->len
+      * sizeof (gpointer);
+
+  /* If the item has a model, its data is part of the model. */
+  if (GOO_IS_CANVAS_ITEM_SIMPLE (item)
+      && !GOO_CANVAS_ITEM_SIMPLE (item)->model)
+    {
+      simple = (GooCanvasItemSimple*) item;
+      goo_canvas_memory_add_simple_data (walk, simple->simple_data, TRUE);
+
+      if (GOO_IS_CANVAS_PATH (item))
+	goo_canvas_memory_add_path_data (walk, GOO_CANVAS_PATH (item)->path_data,
+					 TRUE);
+      else if (GOO_IS_CANVAS_POLYLINE (item))
+	goo_canvas_memory_add_polyline_data (walk, GOO_CANVAS_POLYLINE (item)->polyline_data, TRUE);
+      else if (GOO_IS_CANVAS_TEXT (item))
+	goo_canvas_memory_add_text_data (walk, GOO_CANVAS_TEXT (item)->text_data,
+					 TRUE);
+      else if (GOO_IS_CANVAS_IMAGE (item))
+	goo_canvas_memory_add_image_data (walk, GOO_CANVAS_IMAGE (item)->image_data, TRUE);
+    }
+
+  /* The shared styles of batches are counted like the items' styles. */
+  if (GOO_IS_CANVAS_BATCH (item))
+    {
+      stats->batch_bytes += goo_canvas_batch_get_memory_used (GOO_CANVAS_BATCH (item), &batch_styles);
+      for (i = 0; i < batch_styles->len; i++)
+	goo_canvas_memory_add_style (walk, batch_styles->pdata[i]);
+    }
+
+  if (GOO_IS_CANVAS_TILED_IMAGE (item))
+    stats->cache_bytes += goo_canvas_tiled_image_get_memory_used (GOO_CANVAS_TILED_IMAGE (item));
+
+  /* The sources of GooCanvasUse items are held in hidden canvases, which
+     are shared by all the items using the same source. */
+  if (GOO_IS_CANVAS_USE (item))
+    {
+      source = goo_canvas_use_get_memory_source (GOO_CANVAS_USE (item),
+						 &source_canvas, &cache_bytes);
+      if (goo_canvas_memory_first_use (walk, source))
+	{
+	  stats->cache_bytes += cache_bytes;
+	  if (source_canvas)
+	    goo_canvas_memory_add_canvas (walk, source_canvas);
+	}
+    }
+
+  n_children = goo_canvas_item_get_n_children (item);
+  for (i = 0; i < n_children; i++)
+    {
+      GooCanvasItem *child = goo_canvas_item_get_child (item, i);
+
+      /* Children of groups viewing models may not have been created yet. */
+      if (child)
+	goo_canvas_memory_add_item (walk, child);
+    }
+}
+
+
+static void
+goo_canvas_memory_add_model (GooCanvasMemoryWalk *walk,
+			     GooCanvasItemModel  *model)
+{
+  GooCanvasMemoryStats *stats = walk->stats;
+  gint n_children, i;
+
+  stats->n_models++;
+  goo_canvas_memory_add_instance (walk, model);
+
+  if (GOO_IS_CANVAS_GROUP_MODEL (model))
+    stats->instance_bytes += GOO_CANVAS_GROUP_MODEL (model)->children->len
+      * sizeof (gpointer);
+
+  if (GOO_IS_CANVAS_ITEM_MODEL_SIMPLE (model))
+    goo_canvas_memory_add_simple_data (walk, &GOO_CANVAS_ITEM_MODEL_SIMPLE (model)->simple_data, FALSE);
+
+  if (GOO_IS_CANVAS_PATH_MODEL (model))
+    goo_canvas_memory_add_path_data (walk, &GOO_CANVAS_PATH_MODEL (model)->path_data, FALSE);
+  else if (GOO_IS_CANVAS_POLYLINE_MODEL (model))
+    goo_canvas_memory_add_polyline_data (walk, &GOO_CANVAS_POLYLINE_MODEL (model)->polyline_data, FALSE);
+  else if (GOO_IS_CANVAS_TEXT_MODEL (model))
+    goo_canvas_memory_add_text_data (walk, &GOO_CANVAS_TEXT_MODEL (model)->text_data, FALSE);
+  else if (GOO_IS_CANVAS_IMAGE_MODEL (model))
+    goo_canvas_memory_add_image_data (walk, &GOO_CANVAS_IMAGE_MODEL (model)->image_data, FALSE);
+
+  n_children = goo_canvas_item_model_get_n_children (model);
+  for (i = 0; i < n_children; i++)
+    goo_canvas_memory_add_model (walk,
+				 goo_canvas_item_model_get_child (model, i));
+}
+
+
+static void
+goo_canvas_memory_add_canvas (GooCanvasMemoryWalk *walk,
+			      GooCanvas           *canvas)
+{
+  GooCanvasPrivate *priv = GOO_CANVAS_GET_PRIVATE (canvas);
+
+  if (canvas->root_item)
+    goo_canvas_memory_add_item (walk, canvas->root_item);
+  if (priv->static_root_item)
+    goo_canvas_memory_add_item (walk, priv->static_root_item);
+  if (canvas->root_item_model)
+    goo_canvas_memory_add_model (walk, canvas->root_item_model);
+  if (priv->static_root_item_model)
+    goo_canvas_memory_add_model (walk, priv->static_root_item_model);
+}
+
+
+/**
+ * goo_canvas_get_memory_stats:
+ * @canvas: a #GooCanvas.
+ * @stats: (out caller-allocates): a #GooCanvasMemoryStats to fill in.
+ *
+ * Estimates the memory used by the items and item models of the canvas,
+ * including the static items and the sources of #GooCanvasUse items, by
+ * walking the item and model trees. If the canvas displays the items of
+ * another canvas (see goo_canvas_set_view_source()), those items are not
+ * included, as they belong to the other canvas.
+ *
+ * This takes time proportional to the number of items, so it shouldn't be
+ * called for every frame.
+ *
+ * Since: 3.0
+ **/
+void
+goo_canvas_get_memory_stats (GooCanvas            *canvas,
+			     GooCanvasMemoryStats *stats)
+{
+  GooCanvasMemoryWalk walk;
+  GHashTableIter iter;
+  gpointer n_uses;
+
+  g_return_if_fail (GOO_IS_CANVAS (canvas));
+  g_return_if_fail (stats != NULL);
+
+  memset (stats, 0, sizeof (GooCanvasMemoryStats));
+  walk.stats = stats;
+  walk.seen = g_hash_table_new (g_direct_hash, g_direct_equal);
+  walk.styles = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+  goo_canvas_memory_add_canvas (&walk, canvas);
+
+  g_hash_table_iter_init (&iter, walk.styles);
+  while (g_hash_table_iter_next (&iter, NULL, &n_uses))
+    {
+      stats->n_styles++;
+      if (GPOINTER_TO_UINT (n_uses) > 1)
+	stats->n_shared_styles++;
+    }
+
+  stats->total_bytes = stats->instance_bytes + stats->simple_data_bytes
+    + stats->style_bytes + stats->path_bytes + stats->polyline_bytes
+    + stats->text_bytes + stats->image_bytes + stats->batch_bytes
+    + stats->cache_bytes;
+
+  g_hash_table_destroy (walk.seen);
+  g_hash_table_destroy (walk.styles);
+}
+
+
 /**
  * goo_canvas_render:
  * @canvas: a #GooCanvas.
@@ -2863,9 +4018,15 @@ goo_canvas_render (GooCanvas             *canvas,
 		   const GooCanvasBounds *bounds,
 		   gdouble                scale)
 {
+  GooCanvasItem *root;
+
   if (canvas->need_update)
     goo_canvas_update (canvas);
 
+  root = goo_canvas_get_display_root (canvas);
+  if (!root)
+    return;
+
   /* Set the default line width based on the current units setting. */
   cairo_set_line_width (cr, goo_canvas_get_default_line_width (canvas));
 
@@ -2880,11 +4041,11 @@ goo_canvas_render (GooCanvas             *canvas,
       cairo_close_path (cr);
       cairo_clip (cr);
 
-      goo_canvas_item_paint (canvas->root_item, cr, bounds, scale);
+      goo_canvas_item_paint (root, cr, bounds, scale);
     }
   else
     {
-      goo_canvas_item_paint (canvas->root_item, cr, &canvas->bounds, scale);
+      goo_canvas_item_paint (root, cr, &canvas->bounds, scale);
     }
 }
 
@@ -2961,8 +4122,12 @@ propagate_event (GooCanvas     *canvas,
 		 gchar         *signal_name,
 		 GdkEvent      *event)
 {
+  GooCanvasPrivate *priv = GOO_CANVAS_GET_PRIVATE (canvas);
+  GooCanvasFrameStats *previous_stats;
   GooCanvasItem *ancestor;
   gboolean stop_emission = FALSE, valid;
+  const gchar *type_name G_GNUC_UNUSED = "none";
+  gint64 start_time, trace_time;
 
   /* Don't emit any events if the canvas is not realized. */
   if (!gtk_widget_get_realized (GTK_WIDGET (canvas)))
@@ -2982,9 +4147,16 @@ propagate_event (GooCanvas     *canvas,
       ancestor = canvas->root_item;
     }
 
+  start_time = goo_canvas_begin_stats (canvas, &previous_stats);
+  trace_time = GOO_CANVAS_TRACE_TIME ();
+
   /* Make sure the item pointer remains valid throughout the emission. */
   if (item)
-    g_object_ref (item);
+    {
+      g_object_ref (item);
+      if (trace_time)
+	type_name = G_OBJECT_TYPE_NAME (item);
+    }
 
   while (ancestor)
     {
@@ -3007,6 +4179,11 @@ propagate_event (GooCanvas     *canvas,
   if (item)
     g_object_unref (item);
 
+  goo_canvas_end_stats (previous_stats, start_time,
+			&priv->frame_stats.event_time);
+  GOO_CANVAS_TRACE_MARK (trace_time, "Event", "%s to %s", signal_name,
+			 type_name);
+
   return stop_emission;
 }
 
@@ -3116,7 +4293,8 @@ update_pointer_item (GooCanvas *canvas,
      so we leave new_item as NULL, otherwise we find which item is
      underneath the mouse. Note that we initialize the type to GDK_LEAVE_NOTIFY
      in goo_canvas_init() to indicate the mouse isn't in the canvas. */
-  if (canvas->crossing_event.type != GDK_LEAVE_NOTIFY && canvas->root_item)
+  if (canvas->crossing_event.type != GDK_LEAVE_NOTIFY
+      && goo_canvas_get_display_root (canvas))
     {
       double x = canvas->crossing_event.x;
       double y = canvas->crossing_event.y;
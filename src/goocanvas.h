@@ -9,6 +9,7 @@
 
 #include <gtk/gtk.h>
 #include <goocanvasenumtypes.h>
+#include <goocanvasbatch.h>
 #include <goocanvasellipse.h>
 #include <goocanvasgrid.h>
 #include <goocanvasgroup.h>
@@ -18,6 +19,9 @@
 #include <goocanvasrect.h>
 #include <goocanvastable.h>
 #include <goocanvastext.h>
+#include <goocanvastiledimage.h>
+#include <goocanvasuse.h>
+#include <goocanvasvirtualtable.h>
 #include <goocanvaswidget.h>
 
 G_BEGIN_DECLS
@@ -32,6 +36,9 @@ G_BEGIN_DECLS
 
 
 typedef struct _GooCanvasClass  GooCanvasClass;
+typedef struct _GooCanvasFrameStats GooCanvasFrameStats;
+typedef struct _GooCanvasItemCost GooCanvasItemCost;
+typedef struct _GooCanvasMemoryStats GooCanvasMemoryStats;
 
 /**
  * GooCanvas:
@@ -167,6 +174,8 @@ struct _GooCanvas
  *  canvas items for item models.
  * @item_created: signal emitted when a new canvas item has been created.
  *  Applications can connect to this to setup signal handlers for the new item.
+ * @frame_stats: signal emitted after each frame is drawn, if the
+ *  #GooCanvas:collect-stats property is set. Since 3.0.
  *
  * The #GooCanvasClass-struct struct contains one virtual method that
  * subclasses may override.
@@ -185,11 +194,12 @@ struct _GooCanvasClass
   void           (* item_created)	    (GooCanvas          *canvas,
 					     GooCanvasItem      *item,
 					     GooCanvasItemModel *model);
+  void           (* frame_stats)	    (GooCanvas          *canvas,
+					     GooCanvasFrameStats *stats);
 
   /*< private >*/
 
   /* Padding for future expansion */
-  void (*_goo_canvas_reserved1) (void);
   void (*_goo_canvas_reserved2) (void);
   void (*_goo_canvas_reserved3) (void);
   void (*_goo_canvas_reserved4) (void);
@@ -200,6 +210,138 @@ struct _GooCanvasClass
 };
 
 
+/**
+ * GooCanvasFrameStats:
+ * @items_updated: the number of items whose bounds were recalculated.
+ * @items_painted: the number of items painted. Batches, tiled images and
+ *  #GooCanvasUse items count as one item each. The source items of
+ *  #GooCanvasUse items are counted too, unless a cached rendering is used.
+ * @items_culled: the number of items skipped when painting, because they
+ *  were outside the area being painted.
+ * @hit_tests: the number of items tested to see if they were at a point.
+ * @paths_created: the number of cairo paths created for items and clip
+ *  paths.
+ * @layouts_created: the number of #PangoLayout objects created.
+ * @redraw_rects: the number of areas of the window invalidated.
+ * @update_time: the time spent updating items, in microseconds.
+ * @draw_time: the time spent drawing the canvas, in microseconds.
+ * @event_time: the time spent dispatching events to items, in microseconds.
+ *
+ * #GooCanvasFrameStats contains counters and timings for one frame drawn
+ * by the canvas, including the updates and events handled since the
+ * previous frame. See goo_canvas_get_frame_stats().
+ *
+ * Since: 3.0
+ */
+struct _GooCanvasFrameStats
+{
+  guint items_updated;
+  guint items_painted;
+  guint items_culled;
+  guint hit_tests;
+  guint paths_created;
+  guint layouts_created;
+  guint redraw_rects;
+  gint64 update_time;
+  gint64 draw_time;
+  gint64 event_time;
+
+  /*< private >*/
+  /* Padding for future expansion */
+  gint64 _goo_canvas_reserved1;
+  gint64 _goo_canvas_reserved2;
+  gint64 _goo_canvas_reserved3;
+  gint64 _goo_canvas_reserved4;
+};
+
+GType goo_canvas_frame_stats_get_type (void) G_GNUC_CONST;
+#define GOO_TYPE_CANVAS_FRAME_STATS (goo_canvas_frame_stats_get_type ())
+
+
+/**
+ * GooCanvasItemCost:
+ * @item: the item, or %NULL for the total costs of a type of item.
+ * @type: the type of the item.
+ * @n_updates: the number of times the item was updated.
+ * @n_paints: the number of times the item was painted, including the times
+ *  it was skipped because it was outside the area being painted.
+ * @update_time: the time spent updating the item, in nanoseconds.
+ * @paint_time: the time spent painting the item, in nanoseconds.
+ *
+ * #GooCanvasItemCost contains the time spent updating and painting an item,
+ * or all the items of one type, while the #GooCanvas:profile-items property
+ * is set. The times don't include the time spent in child items. See
+ * goo_canvas_get_item_costs().
+ *
+ * Since: 3.0
+ */
+struct _GooCanvasItemCost
+{
+  GooCanvasItem *item;
+  GType type;
+  guint n_updates;
+  guint n_paints;
+  gint64 update_time;
+  gint64 paint_time;
+};
+
+
+/**
+ * GooCanvasMemoryStats:
+ * @n_items: the number of items.
+ * @n_models: the number of item models.
+ * @n_styles: the number of different styles used by the items and models,
+ *  including their parent styles.
+ * @n_shared_styles: the number of styles used by more than one item, model
+ *  or style.
+ * @instance_bytes: the size of the item and model objects, including the
+ *  arrays of children of groups. Private data isn't included.
+ * @simple_data_bytes: the size of the #GooCanvasItemSimpleData of items
+ *  without models, and the transforms, clip paths and tooltips of all
+ *  items and models.
+ * @style_bytes: the size of the styles and their property arrays.
+ * @path_bytes: the size of the path commands of paths.
+ * @polyline_bytes: the size of the coordinates and arrows of polylines.
+ * @text_bytes: the size of the strings of text items.
+ * @image_bytes: the size of the image surfaces of images and fill and
+ *  stroke patterns. Surfaces shared by several items are only counted once.
+ * @batch_bytes: the size of the shape and style arrays of #GooCanvasBatch
+ *  items. Their shared styles are included in @style_bytes.
+ * @cache_bytes: the size of the cached renderings of #GooCanvasUse items,
+ *  the loaded tiles of #GooCanvasTiledImage items, and the reduced-size
+ *  copies of image surfaces used to paint them at small scales.
+ * @total_bytes: the total of all the sizes above.
+ *
+ * #GooCanvasMemoryStats contains an estimate of the memory used by the
+ * items and models of a canvas, as returned by
+ * goo_canvas_get_memory_stats(). The sizes are in bytes, and don't include
+ * the overhead of the memory allocator or space reserved in arrays.
+ *
+ * Note that text layouts aren't kept between updates and paints, so they
+ * don't use any memory, and that the shared image surface cache is
+ * reported by goo_canvas_image_cache_get_stats().
+ *
+ * Since: 3.0
+ */
+struct _GooCanvasMemoryStats
+{
+  guint n_items;
+  guint n_models;
+  guint n_styles;
+  guint n_shared_styles;
+  gsize instance_bytes;
+  gsize simple_data_bytes;
+  gsize style_bytes;
+  gsize path_bytes;
+  gsize polyline_bytes;
+  gsize text_bytes;
+  gsize image_bytes;
+  gsize batch_bytes;
+  gsize cache_bytes;
+  gsize total_bytes;
+};
+
+
 GType           goo_canvas_get_type	    (void) G_GNUC_CONST;
 GtkWidget*      goo_canvas_new		    (void);
 
@@ -219,8 +361,13 @@ GooCanvasItemModel* goo_canvas_get_static_root_item_model (GooCanvas	       *can
 void                goo_canvas_set_static_root_item_model (GooCanvas	       *canvas,
 							   GooCanvasItemModel *model);
 
+GooCanvas*      goo_canvas_get_view_source  (GooCanvas		*canvas);
+void            goo_canvas_set_view_source  (GooCanvas		*canvas,
+					     GooCanvas		*source);
+
 GooCanvasItem*  goo_canvas_get_item	    (GooCanvas		*canvas,
 					     GooCanvasItemModel *model);
+void            goo_canvas_release_hidden_items (GooCanvas	*canvas);
 GooCanvasItem*  goo_canvas_get_item_at	    (GooCanvas		*canvas,
 					     gdouble             x,
 					     gdouble             y,
@@ -262,6 +409,15 @@ void            goo_canvas_render	    (GooCanvas		   *canvas,
 					     const GooCanvasBounds *bounds,
 					     gdouble                scale);
 
+void            goo_canvas_get_frame_stats  (GooCanvas		 *canvas,
+					     GooCanvasFrameStats *stats);
+GArray*         goo_canvas_get_item_costs   (GooCanvas		 *canvas,
+					     gboolean             by_type,
+					     guint                max_entries);
+void            goo_canvas_reset_item_costs (GooCanvas		 *canvas);
+void            goo_canvas_get_memory_stats (GooCanvas		  *canvas,
+					     GooCanvasMemoryStats *stats);
+
 /*
  * Coordinate conversion.
  */
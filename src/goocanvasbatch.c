@@ -0,0 +1,1085 @@
+/*
+ * GooCanvas. Copyright (C) 2005 Damon Chaplin.
+ * Released under the GNU LGPL license. See COPYING for details.
+ *
+ * goocanvasbatch.c - item holding many simple shapes.
+ */
+
+/**
+ * SECTION:goocanvasbatch
+ * @Title: GooCanvasBatch
+ * @Short_Description: an item holding many simple shapes.
+ *
+ * GooCanvasBatch is a single canvas item which displays a large number of
+ * simple shapes - rectangles, ellipses, lines and markers. It is intended
+ * for things like scatter plots and maps, where creating a separate
+ * #GooCanvasRect or #GooCanvasEllipse for each shape would use too much
+ * memory.
+ *
+ * The shapes are not objects. Each shape is stored as a type, a position
+ * and size, and the index of a shared style, in arrays holding that field
+ * for all the shapes. Shapes are identified by their index in the batch,
+ * which is returned by goo_canvas_batch_add_shape(). Later shapes are drawn
+ * on top of earlier ones.
+ *
+ * Styles are added to the batch with goo_canvas_batch_add_style(), and
+ * shapes refer to them by the returned style ID. Shapes with a style ID of
+ * -1 use the item's own style. Shared styles are used as they are, so use
+ * goo_canvas_style_set_parent() if they should inherit settings from another
+ * style.
+ *
+ * The whole batch is updated and painted at once, and consecutive shapes
+ * with the same style are painted with a single fill and stroke. Since the
+ * batch is a single item it receives the events for all of its shapes. Use
+ * goo_canvas_batch_get_shape_at() with the coordinates of an event to find
+ * which shape the event is for.
+ *
+ * It is a subclass of #GooCanvasItemSimple and so inherits all of the style
+ * properties such as "fill-color" and "line-width", which are used by
+ * shapes with a style ID of -1.
+ *
+ * Note that #GooCanvasBatch doesn't have a model/view variant like the
+ * other standard items, so it can only be used in a simple canvas without
+ * a model.
+ *
+ * To create a #GooCanvasBatch use goo_canvas_batch_new().
+ */
+#include <config.h>
+#include <string.h>
+#include <math.h>
+#include <glib/gi18n-lib.h>
+#include <gtk/gtk.h>
+#include "goocanvasprivate.h"
+#include "goocanvasbatch.h"
+#include "goocanvas.h"
+
+
+typedef struct _GooCanvasBatchPrivate GooCanvasBatchPrivate;
+struct _GooCanvasBatchPrivate {
+  /* The fields of the shapes, each in its own array. The types are guint8,
+     the style IDs are gint and the others are gdouble. */
+  GArray *types;
+  GArray *x, *y, *width, *height;
+  GArray *style_ids;
+
+  /* The shared styles, and the line width of each one, with the line width
+     of the item's own style in line_width. These are set in update(). */
+  GPtrArray *styles;
+  GArray *line_widths;
+  gdouble line_width;
+
+  /* A grid over the extents of the shapes, including their line widths,
+     used to find the shapes at a point without testing all of them.
+     grid_starts holds the index in grid_shapes of the first shape in each
+     cell, plus one more entry for the end of the last cell, and the shapes
+     in each cell are in increasing order. The grid is rebuilt in update(),
+     and is not used if the shapes have changed since then. */
+  GooCanvasBounds grid_bounds;
+  gint grid_columns, grid_rows;
+  gdouble grid_cell_width, grid_cell_height;
+  GArray *grid_starts;
+  GArray *grid_shapes;
+  gboolean grid_valid;
+};
+
+/* Batches with fewer shapes than this are hit-tested without a grid. The
+   grid has about GOO_CANVAS_BATCH_GRID_SHAPES_PER_CELL shapes per cell, up
+   to GOO_CANVAS_BATCH_GRID_MAX_CELLS cells. */
+#define GOO_CANVAS_BATCH_GRID_MIN_SHAPES	64
+#define GOO_CANVAS_BATCH_GRID_SHAPES_PER_CELL	4
+#define GOO_CANVAS_BATCH_GRID_MAX_CELLS		16384
+
+#define GOO_CANVAS_BATCH_GET_PRIVATE(batch)  \
+   (G_TYPE_INSTANCE_GET_PRIVATE ((batch), GOO_TYPE_CANVAS_BATCH, GooCanvasBatchPrivate))
+
+
+static void goo_canvas_batch_finalize (GObject *object);
+
+G_DEFINE_TYPE (GooCanvasBatch, goo_canvas_batch, GOO_TYPE_CANVAS_ITEM_SIMPLE)
+
+
+static void
+goo_canvas_batch_init (GooCanvasBatch *batch)
+{
+  GooCanvasBatchPrivate *priv = GOO_CANVAS_BATCH_GET_PRIVATE (batch);
+
+  priv->types = g_array_new (FALSE, FALSE, sizeof (guint8));
+  priv->x = g_array_new (FALSE, FALSE, sizeof (gdouble));
+  priv->y = g_array_new (FALSE, FALSE, sizeof (gdouble));
+  priv->width = g_array_new (FALSE, FALSE, sizeof (gdouble));
+  priv->height = g_array_new (FALSE, FALSE, sizeof (gdouble));
+  priv->style_ids = g_array_new (FALSE, FALSE, sizeof (gint));
+
+  priv->styles = g_ptr_array_new_with_free_func (g_object_unref);
+  priv->line_widths = g_array_new (FALSE, FALSE, sizeof (gdouble));
+
+  priv->grid_starts = g_array_new (FALSE, FALSE, sizeof (guint));
+  priv->grid_shapes = g_array_new (FALSE, FALSE, sizeof (gint));
+}
+
+
+/**
+ * goo_canvas_batch_new:
+ * @parent: (skip): the parent item, or %NULL. If a parent is specified, it will assume
+ *  ownership of the item, and the item will automatically be freed when it is
+ *  removed from the parent. Otherwise call g_object_unref() to free it.
+ * @...: optional pairs of property names and values, and a terminating %NULL.
+ *
+ * Creates a new batch item, with no shapes.
+ *
+ * Here's an example showing how to create a batch holding red markers:
+ *
+ * <informalexample><programlisting>
+ *  GooCanvasItem *batch = goo_canvas_batch_new (mygroup,
+ *                                               "fill-color", "red",
+ *                                               "line-width", 0.0,
+ *                                               NULL);
+ *  for (i = 0; i < n_points; i++)
+ *    goo_canvas_batch_add_shape (GOO_CANVAS_BATCH (batch),
+ *                                GOO_CANVAS_BATCH_MARKER,
+ *                                points[i].x, points[i].y, 4.0, 4.0, -1);
+ * </programlisting></informalexample>
+ *
+ * Returns: (transfer full): a new batch item.
+ *
+ * Since: 3.0
+ **/
+GooCanvasItem*
+goo_canvas_batch_new (GooCanvasItem *parent,
+		      ...)
+{
+  GooCanvasItem *item;
+  const char *first_property;
+  va_list var_args;
+
+  item = g_object_new (GOO_TYPE_CANVAS_BATCH, NULL);
+
+  va_start (var_args, parent);
+  first_property = va_arg (var_args, char*);
+  if (first_property)
+    g_object_set_valist ((GObject*) item, first_property, var_args);
+  va_end (var_args);
+
+  if (parent)
+    {
+      goo_canvas_item_add_child (parent, item, -1);
+      g_object_unref (item);
+    }
+
+  return item;
+}
+
+
+static void
+goo_canvas_batch_finalize (GObject *object)
+{
+  GooCanvasBatchPrivate *priv = GOO_CANVAS_BATCH_GET_PRIVATE (object);
+
+  g_array_free (priv->types, TRUE);
+  g_array_free (priv->x, TRUE);
+  g_array_free (priv->y, TRUE);
+  g_array_free (priv->width, TRUE);
+  g_array_free (priv->height, TRUE);
+  g_array_free (priv->style_ids, TRUE);
+
+  g_ptr_array_free (priv->styles, TRUE);
+  g_array_free (priv->line_widths, TRUE);
+
+  g_array_free (priv->grid_starts, TRUE);
+  g_array_free (priv->grid_shapes, TRUE);
+
+  G_OBJECT_CLASS (goo_canvas_batch_parent_class)->finalize (object);
+}
+
+
+/* This is used by goo_canvas_get_memory_stats(). It returns the size of the
+   shape and style arrays, and the shared styles, which are counted
+   separately as they may be shared with other items. */
+gsize
+goo_canvas_batch_get_memory_used (GooCanvasBatch  *batch,
+				  GPtrArray      **styles)
+{
+  GooCanvasBatchPrivate *priv = GOO_CANVAS_BATCH_GET_PRIVATE (batch);
+
+  *styles = priv->styles;
+
+  return priv->types->len * (sizeof (guint8) + 4 * sizeof (gdouble)
+			     + sizeof (gint))
+    + priv->styles->len * (sizeof (gpointer) + sizeof (gdouble))
+    + priv->grid_starts->len * sizeof (guint)
+    + priv->grid_shapes->len * sizeof (gint);
+}
+
+
+/* Called when shapes are added, moved or change style. The grid is no
+   longer valid until the next update. */
+static void
+goo_canvas_batch_shapes_changed (GooCanvasBatch *batch)
+{
+  GooCanvasBatchPrivate *priv = GOO_CANVAS_BATCH_GET_PRIVATE (batch);
+
+  priv->grid_valid = FALSE;
+  goo_canvas_item_simple_changed ((GooCanvasItemSimple*) batch, TRUE);
+}
+
+
+/**
+ * goo_canvas_batch_add_style:
+ * @batch: a #GooCanvasBatch.
+ * @style: the style to add.
+ *
+ * Adds a style which can be shared by the shapes in the batch. The batch
+ * keeps a reference to the style.
+ *
+ * If the style is changed after it is added, call
+ * goo_canvas_item_request_update() on the batch to redraw it.
+ *
+ * Returns: the ID of the style, to pass to goo_canvas_batch_add_shape().
+ *
+ * Since: 3.0
+ **/
+gint
+goo_canvas_batch_add_style (GooCanvasBatch *batch,
+			    GooCanvasStyle *style)
+{
+  GooCanvasBatchPrivate *priv;
+  gdouble line_width = 0.0;
+
+  g_return_val_if_fail (GOO_IS_CANVAS_BATCH (batch), -1);
+  g_return_val_if_fail (GOO_IS_CANVAS_STYLE (style), -1);
+
+  priv = GOO_CANVAS_BATCH_GET_PRIVATE (batch);
+
+  g_ptr_array_add (priv->styles, g_object_ref (style));
+  g_array_append_val (priv->line_widths, line_width);
+
+  goo_canvas_item_simple_changed ((GooCanvasItemSimple*) batch, TRUE);
+
+  return priv->styles->len - 1;
+}
+
+
+/**
+ * goo_canvas_batch_get_style:
+ * @batch: a #GooCanvasBatch.
+ * @style_id: the ID of a style added with goo_canvas_batch_add_style().
+ *
+ * Gets one of the styles shared by the shapes in the batch.
+ *
+ * Returns: (transfer none): the style.
+ *
+ * Since: 3.0
+ **/
+GooCanvasStyle*
+goo_canvas_batch_get_style (GooCanvasBatch *batch,
+			    gint            style_id)
+{
+  GooCanvasBatchPrivate *priv;
+
+  g_return_val_if_fail (GOO_IS_CANVAS_BATCH (batch), NULL);
+
+  priv = GOO_CANVAS_BATCH_GET_PRIVATE (batch);
+  g_return_val_if_fail (style_id >= 0 && style_id < (gint) priv->styles->len,
+			NULL);
+
+  return priv->styles->pdata[style_id];
+}
+
+
+/**
+ * goo_canvas_batch_add_shape:
+ * @batch: a #GooCanvasBatch.
+ * @type: the type of the shape.
+ * @x: the x coordinate of the shape.
+ * @y: the y coordinate of the shape.
+ * @width: the width of the shape.
+ * @height: the height of the shape.
+ * @style_id: the ID of a style added with goo_canvas_batch_add_style(), or
+ *  -1 to use the item's own style.
+ *
+ * Adds a shape to the end of the batch, so it is drawn on top of the other
+ * shapes. See #GooCanvasBatchShapeType for how the coordinates are used.
+ *
+ * Returns: the index of the new shape.
+ *
+ * Since: 3.0
+ **/
+gint
+goo_canvas_batch_add_shape (GooCanvasBatch          *batch,
+			    GooCanvasBatchShapeType  type,
+			    gdouble                  x,
+			    gdouble                  y,
+			    gdouble                  width,
+			    gdouble                  height,
+			    gint                     style_id)
+{
+  gdouble coords[4];
+
+  coords[0] = x;
+  coords[1] = y;
+  coords[2] = width;
+  coords[3] = height;
+
+  return goo_canvas_batch_add_shapes (batch, type, coords, 1, style_id);
+}
+
+
+/**
+ * goo_canvas_batch_add_shapes:
+ * @batch: a #GooCanvasBatch.
+ * @type: the type of the shapes.
+ * @coords: (array): the x, y, width and height of each shape, one after the
+ *  other.
+ * @n_shapes: the number of shapes to add.
+ * @style_id: the ID of a style added with goo_canvas_batch_add_style(), or
+ *  -1 to use the item's own style.
+ *
+ * Adds several shapes of the same type and style to the end of the batch.
+ * This is quicker than calling goo_canvas_batch_add_shape() for each one.
+ *
+ * Returns: the index of the first new shape.
+ *
+ * Since: 3.0
+ **/
+gint
+goo_canvas_batch_add_shapes (GooCanvasBatch          *batch,
+			     GooCanvasBatchShapeType  type,
+			     const gdouble           *coords,
+			     gint                     n_shapes,
+			     gint                     style_id)
+{
+  GooCanvasBatchPrivate *priv;
+  guint8 type_byte = type;
+  gint first_shape, i;
+
+  g_return_val_if_fail (GOO_IS_CANVAS_BATCH (batch), -1);
+  g_return_val_if_fail (type >= GOO_CANVAS_BATCH_RECT
+			&& type <= GOO_CANVAS_BATCH_MARKER, -1);
+  g_return_val_if_fail (n_shapes == 0 || coords != NULL, -1);
+
+  priv = GOO_CANVAS_BATCH_GET_PRIVATE (batch);
+  g_return_val_if_fail (style_id >= -1 && style_id < (gint) priv->styles->len,
+			-1);
+
+  first_shape = priv->types->len;
+  if (n_shapes <= 0)
+    return first_shape;
+
+  g_array_set_size (priv->types, first_shape + n_shapes);
+  g_array_set_size (priv->x, first_shape + n_shapes);
+  g_array_set_size (priv->y, first_shape + n_shapes);
+  g_array_set_size (priv->width, first_shape + n_shapes);
+  g_array_set_size (priv->height, first_shape + n_shapes);
+  g_array_set_size (priv->style_ids, first_shape + n_shapes);
+
+  for (i = 0; i < n_shapes; i++)
+    {
+      g_array_index (priv->types, guint8, first_shape + i) = type_byte;
+      g_array_index (priv->x, gdouble, first_shape + i) = coords[i * 4];
+      g_array_index (priv->y, gdouble, first_shape + i) = coords[i * 4 + 1];
+      g_array_index (priv->width, gdouble, first_shape + i) = coords[i * 4 + 2];
+      g_array_index (priv->height, gdouble, first_shape + i) = coords[i * 4 + 3];
+      g_array_index (priv->style_ids, gint, first_shape + i) = style_id;
+    }
+
+  goo_canvas_batch_shapes_changed (batch);
+
+  return first_shape;
+}
+
+
+/**
+ * goo_canvas_batch_set_shape:
+ * @batch: a #GooCanvasBatch.
+ * @shape: the index of the shape.
+ * @x: the new x coordinate of the shape.
+ * @y: the new y coordinate of the shape.
+ * @width: the new width of the shape.
+ * @height: the new height of the shape.
+ *
+ * Moves or resizes one of the shapes in the batch.
+ *
+ * Since: 3.0
+ **/
+void
+goo_canvas_batch_set_shape (GooCanvasBatch *batch,
+			    gint            shape,
+			    gdouble         x,
+			    gdouble         y,
+			    gdouble         width,
+			    gdouble         height)
+{
+  GooCanvasBatchPrivate *priv;
+
+  g_return_if_fail (GOO_IS_CANVAS_BATCH (batch));
+
+  priv = GOO_CANVAS_BATCH_GET_PRIVATE (batch);
+  g_return_if_fail (shape >= 0 && shape < (gint) priv->types->len);
+
+  g_array_index (priv->x, gdouble, shape) = x;
+  g_array_index (priv->y, gdouble, shape) = y;
+  g_array_index (priv->width, gdouble, shape) = width;
+  g_array_index (priv->height, gdouble, shape) = height;
+
+  goo_canvas_batch_shapes_changed (batch);
+}
+
+
+/**
+ * goo_canvas_batch_set_shape_style:
+ * @batch: a #GooCanvasBatch.
+ * @shape: the index of the shape.
+ * @style_id: the ID of a style added with goo_canvas_batch_add_style(), or
+ *  -1 to use the item's own style.
+ *
+ * Sets the style of one of the shapes in the batch.
+ *
+ * Since: 3.0
+ **/
+void
+goo_canvas_batch_set_shape_style (GooCanvasBatch *batch,
+				  gint            shape,
+				  gint            style_id)
+{
+  GooCanvasBatchPrivate *priv;
+
+  g_return_if_fail (GOO_IS_CANVAS_BATCH (batch));
+
+  priv = GOO_CANVAS_BATCH_GET_PRIVATE (batch);
+  g_return_if_fail (shape >= 0 && shape < (gint) priv->types->len);
+  g_return_if_fail (style_id >= -1 && style_id < (gint) priv->styles->len);
+
+  g_array_index (priv->style_ids, gint, shape) = style_id;
+
+  /* The line width may have changed, so we recompute the bounds. */
+  goo_canvas_batch_shapes_changed (batch);
+}
+
+
+/**
+ * goo_canvas_batch_get_shape:
+ * @batch: a #GooCanvasBatch.
+ * @shape: the index of the shape.
+ * @type: (out) (allow-none): returns the type of the shape.
+ * @x: (out) (allow-none): returns the x coordinate of the shape.
+ * @y: (out) (allow-none): returns the y coordinate of the shape.
+ * @width: (out) (allow-none): returns the width of the shape.
+ * @height: (out) (allow-none): returns the height of the shape.
+ * @style_id: (out) (allow-none): returns the style ID of the shape.
+ *
+ * Gets the settings of one of the shapes in the batch.
+ *
+ * Returns: %TRUE if the shape exists.
+ *
+ * Since: 3.0
+ **/
+gboolean
+goo_canvas_batch_get_shape (GooCanvasBatch          *batch,
+			    gint                     shape,
+			    GooCanvasBatchShapeType *type,
+			    gdouble                 *x,
+			    gdouble                 *y,
+			    gdouble                 *width,
+			    gdouble                 *height,
+			    gint                    *style_id)
+{
+  GooCanvasBatchPrivate *priv;
+
+  g_return_val_if_fail (GOO_IS_CANVAS_BATCH (batch), FALSE);
+
+  priv = GOO_CANVAS_BATCH_GET_PRIVATE (batch);
+  if (shape < 0 || shape >= (gint) priv->types->len)
+    return FALSE;
+
+  if (type)
+    *type = g_array_index (priv->types, guint8, shape);
+  if (x)
+    *x = g_array_index (priv->x, gdouble, shape);
+  if (y)
+    *y = g_array_index (priv->y, gdouble, shape);
+  if (width)
+    *width = g_array_index (priv->width, gdouble, shape);
+  if (height)
+    *height = g_array_index (priv->height, gdouble, shape);
+  if (style_id)
+    *style_id = g_array_index (priv->style_ids, gint, shape);
+
+  return TRUE;
+}
+
+
+/**
+ * goo_canvas_batch_get_n_shapes:
+ * @batch: a #GooCanvasBatch.
+ *
+ * Gets the number of shapes in the batch.
+ *
+ * Returns: the number of shapes.
+ *
+ * Since: 3.0
+ **/
+gint
+goo_canvas_batch_get_n_shapes (GooCanvasBatch *batch)
+{
+  g_return_val_if_fail (GOO_IS_CANVAS_BATCH (batch), 0);
+
+  return GOO_CANVAS_BATCH_GET_PRIVATE (batch)->types->len;
+}
+
+
+/**
+ * goo_canvas_batch_clear:
+ * @batch: a #GooCanvasBatch.
+ *
+ * Removes all the shapes from the batch. The shared styles are kept.
+ *
+ * Since: 3.0
+ **/
+void
+goo_canvas_batch_clear (GooCanvasBatch *batch)
+{
+  GooCanvasBatchPrivate *priv;
+
+  g_return_if_fail (GOO_IS_CANVAS_BATCH (batch));
+
+  priv = GOO_CANVAS_BATCH_GET_PRIVATE (batch);
+
+  g_array_set_size (priv->types, 0);
+  g_array_set_size (priv->x, 0);
+  g_array_set_size (priv->y, 0);
+  g_array_set_size (priv->width, 0);
+  g_array_set_size (priv->height, 0);
+  g_array_set_size (priv->style_ids, 0);
+
+  goo_canvas_batch_shapes_changed (batch);
+}
+
+
+static GooCanvasStyle*
+goo_canvas_batch_get_shape_style (GooCanvasBatch *batch,
+				  gint            style_id)
+{
+  GooCanvasBatchPrivate *priv = GOO_CANVAS_BATCH_GET_PRIVATE (batch);
+
+  if (style_id < 0)
+    return ((GooCanvasItemSimple*) batch)->simple_data->style;
+  return priv->styles->pdata[style_id];
+}
+
+
+static gdouble
+goo_canvas_batch_get_shape_line_width (GooCanvasBatchPrivate *priv,
+				       gint                   style_id)
+{
+  if (style_id < 0)
+    return priv->line_width;
+  return g_array_index (priv->line_widths, gdouble, style_id);
+}
+
+
+/* Gets the extents of the shape's geometry in user space, not including
+   the line width. */
+static void
+goo_canvas_batch_get_shape_extents (GooCanvasBatchPrivate *priv,
+				    gint                   shape,
+				    GooCanvasBounds       *extents)
+{
+  gdouble x = g_array_index (priv->x, gdouble, shape);
+  gdouble y = g_array_index (priv->y, gdouble, shape);
+  gdouble width = g_array_index (priv->width, gdouble, shape);
+  gdouble height = g_array_index (priv->height, gdouble, shape);
+
+  if (g_array_index (priv->types, guint8, shape) == GOO_CANVAS_BATCH_MARKER)
+    {
+      x -= width / 2;
+      y -= height / 2;
+    }
+
+  extents->x1 = MIN (x, x + width);
+  extents->y1 = MIN (y, y + height);
+  extents->x2 = MAX (x, x + width);
+  extents->y2 = MAX (y, y + height);
+}
+
+
+/* Gets the extents of the shape in user space, including the line width. */
+static void
+goo_canvas_batch_get_shape_stroke_extents (GooCanvasBatchPrivate *priv,
+					   gint                   shape,
+					   GooCanvasBounds       *extents)
+{
+  gint style_id = g_array_index (priv->style_ids, gint, shape);
+  gdouble half_line_width;
+
+  goo_canvas_batch_get_shape_extents (priv, shape, extents);
+  half_line_width = goo_canvas_batch_get_shape_line_width (priv, style_id) / 2;
+
+  extents->x1 -= half_line_width;
+  extents->y1 -= half_line_width;
+  extents->x2 += half_line_width;
+  extents->y2 += half_line_width;
+}
+
+
+/* Returns the column or row of the grid containing pos, clamped to the
+   grid. */
+static gint
+goo_canvas_batch_get_grid_index (gdouble pos,
+				 gdouble start,
+				 gdouble cell_size,
+				 gint    n_cells)
+{
+  gdouble index = floor ((pos - start) / cell_size);
+
+  return (gint) CLAMP (index, 0.0, (gdouble) (n_cells - 1));
+}
+
+
+static void
+goo_canvas_batch_get_grid_cells (GooCanvasBatchPrivate *priv,
+				 const GooCanvasBounds *extents,
+				 gint                  *column1,
+				 gint                  *row1,
+				 gint                  *column2,
+				 gint                  *row2)
+{
+  *column1 = goo_canvas_batch_get_grid_index (extents->x1, priv->grid_bounds.x1,
+					      priv->grid_cell_width,
+					      priv->grid_columns);
+  *column2 = goo_canvas_batch_get_grid_index (extents->x2, priv->grid_bounds.x1,
+					      priv->grid_cell_width,
+					      priv->grid_columns);
+  *row1 = goo_canvas_batch_get_grid_index (extents->y1, priv->grid_bounds.y1,
+					   priv->grid_cell_height,
+					   priv->grid_rows);
+  *row2 = goo_canvas_batch_get_grid_index (extents->y2, priv->grid_bounds.y1,
+					   priv->grid_cell_height,
+					   priv->grid_rows);
+}
+
+
+/* Rebuilds the grid used for hit-testing, given the extents of all the
+   shapes in user space. The shapes are added to each cell they overlap,
+   counting them first so the cells can share one array. */
+static void
+goo_canvas_batch_build_grid (GooCanvasBatchPrivate *priv,
+			     const GooCanvasBounds *bounds)
+{
+  GooCanvasBounds extents;
+  gdouble width, height;
+  gint n_shapes, n_cells, column1, row1, column2, row2, column, row, i;
+  guint *starts, *next;
+
+  n_shapes = priv->types->len;
+  if (n_shapes < GOO_CANVAS_BATCH_GRID_MIN_SHAPES)
+    {
+      g_array_set_size (priv->grid_starts, 0);
+      g_array_set_size (priv->grid_shapes, 0);
+      priv->grid_valid = FALSE;
+      return;
+    }
+
+  /* Make the cells roughly square. */
+  n_cells = CLAMP (n_shapes / GOO_CANVAS_BATCH_GRID_SHAPES_PER_CELL, 1,
+		   GOO_CANVAS_BATCH_GRID_MAX_CELLS);
+  width = bounds->x2 - bounds->x1;
+  height = bounds->y2 - bounds->y1;
+  if (width > 0.0 && height > 0.0)
+    priv->grid_columns = CLAMP (sqrt (n_cells * width / height), 1.0,
+				(gdouble) n_cells);
+  else if (width > 0.0)
+    priv->grid_columns = n_cells;
+  else
+    priv->grid_columns = 1;
+  priv->grid_rows = MAX (n_cells / priv->grid_columns, 1);
+
+  priv->grid_bounds = *bounds;
+  priv->grid_cell_width = width > 0.0 ? width / priv->grid_columns : 1.0;
+  priv->grid_cell_height = height > 0.0 ? height / priv->grid_rows : 1.0;
+
+  n_cells = priv->grid_columns * priv->grid_rows;
+  g_array_set_size (priv->grid_starts, n_cells + 1);
+  starts = (guint*) priv->grid_starts->data;
+  memset (starts, 0, (n_cells + 1) * sizeof (guint));
+
+  /* Count the shapes in each cell, in the entry after the cell's. */
+  for (i = 0; i < n_shapes; i++)
+    {
+      goo_canvas_batch_get_shape_stroke_extents (priv, i, &extents);
+      goo_canvas_batch_get_grid_cells (priv, &extents, &column1, &row1,
+				       &column2, &row2);
+      for (row = row1; row <= row2; row++)
+	for (column = column1; column <= column2; column++)
+	  starts[row * priv->grid_columns + column + 1]++;
+    }
+
+  for (i = 0; i < n_cells; i++)
+    starts[i + 1] += starts[i];
+
+  g_array_set_size (priv->grid_shapes, starts[n_cells]);
+  next = g_memdup (starts, n_cells * sizeof (guint));
+
+  for (i = 0; i < n_shapes; i++)
+    {
+      goo_canvas_batch_get_shape_stroke_extents (priv, i, &extents);
+      goo_canvas_batch_get_grid_cells (priv, &extents, &column1, &row1,
+				       &column2, &row2);
+      for (row = row1; row <= row2; row++)
+	for (column = column1; column <= column2; column++)
+	  g_array_index (priv->grid_shapes, gint,
+			 next[row * priv->grid_columns + column]++) = i;
+    }
+
+  g_free (next);
+  priv->grid_valid = TRUE;
+}
+
+
+static void
+goo_canvas_batch_create_shape_path (GooCanvasBatchPrivate *priv,
+				    gint                   shape,
+				    cairo_t               *cr)
+{
+  gdouble x = g_array_index (priv->x, gdouble, shape);
+  gdouble y = g_array_index (priv->y, gdouble, shape);
+  gdouble width = g_array_index (priv->width, gdouble, shape);
+  gdouble height = g_array_index (priv->height, gdouble, shape);
+
+  switch (g_array_index (priv->types, guint8, shape))
+    {
+    case GOO_CANVAS_BATCH_RECT:
+      cairo_rectangle (cr, x, y, width, height);
+      break;
+    case GOO_CANVAS_BATCH_ELLIPSE:
+      if (width == 0.0 || height == 0.0)
+	break;
+      cairo_save (cr);
+      cairo_translate (cr, x + width / 2, y + height / 2);
+      cairo_scale (cr, width / 2, height / 2);
+      cairo_new_sub_path (cr);
+      cairo_arc (cr, 0.0, 0.0, 1.0, 0.0, 2.0 * M_PI);
+      cairo_close_path (cr);
+      cairo_restore (cr);
+      break;
+    case GOO_CANVAS_BATCH_LINE:
+      cairo_move_to (cr, x, y);
+      cairo_line_to (cr, x + width, y + height);
+      break;
+    case GOO_CANVAS_BATCH_MARKER:
+      cairo_rectangle (cr, x - width / 2, y - height / 2, width, height);
+      break;
+    }
+}
+
+
+static gdouble
+goo_canvas_batch_get_style_line_width (GooCanvasBatch *batch,
+				       GooCanvasStyle *style)
+{
+  GooCanvasItemSimple *simple = (GooCanvasItemSimple*) batch;
+  GValue *value;
+
+  value = goo_canvas_style_get_property (style, goo_canvas_style_line_width_id);
+  if (value)
+    return value->data[0].v_double;
+  else if (simple->canvas)
+    return goo_canvas_get_default_line_width (simple->canvas);
+  else
+    return 2.0;
+}
+
+
+static void
+goo_canvas_batch_update (GooCanvasItemSimple *simple,
+			 cairo_t             *cr)
+{
+  GooCanvasBatch *batch = (GooCanvasBatch*) simple;
+  GooCanvasBatchPrivate *priv = GOO_CANVAS_BATCH_GET_PRIVATE (batch);
+  GooCanvasBounds extents;
+  gint n_shapes, i;
+
+  /* Cache the line width of each style, for painting and hit-testing. */
+  priv->line_width = goo_canvas_item_simple_get_line_width (simple);
+  for (i = 0; i < (gint) priv->styles->len; i++)
+    g_array_index (priv->line_widths, gdouble, i) =
+      goo_canvas_batch_get_style_line_width (batch, priv->styles->pdata[i]);
+
+  n_shapes = priv->types->len;
+  if (n_shapes == 0)
+    {
+      simple->bounds.x1 = simple->bounds.y1 = 0.0;
+      simple->bounds.x2 = simple->bounds.y2 = 0.0;
+      goo_canvas_batch_build_grid (priv, &simple->bounds);
+      return;
+    }
+
+  simple->bounds.x1 = simple->bounds.y1 = G_MAXDOUBLE;
+  simple->bounds.x2 = simple->bounds.y2 = -G_MAXDOUBLE;
+
+  /* The bounds are computed in user space, using the stroke width of each
+     shape. This is slightly larger than cairo's stroke extents at line
+     joins, which doesn't matter for redrawing. */
+  for (i = 0; i < n_shapes; i++)
+    {
+      goo_canvas_batch_get_shape_stroke_extents (priv, i, &extents);
+
+      simple->bounds.x1 = MIN (simple->bounds.x1, extents.x1);
+      simple->bounds.y1 = MIN (simple->bounds.y1, extents.y1);
+      simple->bounds.x2 = MAX (simple->bounds.x2, extents.x2);
+      simple->bounds.y2 = MAX (simple->bounds.y2, extents.y2);
+    }
+
+  /* The bounds are still in user space here, as the grid needs. */
+  goo_canvas_batch_build_grid (priv, &simple->bounds);
+}
+
+
+static void
+goo_canvas_batch_paint (GooCanvasItemSimple   *simple,
+			cairo_t               *cr,
+			const GooCanvasBounds *bounds)
+{
+  GooCanvasBatch *batch = (GooCanvasBatch*) simple;
+  GooCanvasBatchPrivate *priv = GOO_CANVAS_BATCH_GET_PRIVATE (batch);
+  GooCanvasStyle *style;
+  GooCanvasBounds clip, extents;
+  gdouble half_line_width;
+  gint n_shapes, style_id, n_painted, i;
+
+  /* Find the part of the batch that needs painting, in user space. */
+  cairo_clip_extents (cr, &clip.x1, &clip.y1, &clip.x2, &clip.y2);
+
+  /* Each run of shapes with the same style is painted as a single path. */
+  n_shapes = priv->types->len;
+  i = 0;
+  while (i < n_shapes)
+    {
+      style_id = g_array_index (priv->style_ids, gint, i);
+      half_line_width = goo_canvas_batch_get_shape_line_width (priv,
+							       style_id) / 2;
+      n_painted = 0;
+
+      for (; i < n_shapes; i++)
+	{
+	  if (g_array_index (priv->style_ids, gint, i) != style_id)
+	    break;
+
+	  goo_canvas_batch_get_shape_extents (priv, i, &extents);
+	  if (extents.x1 - half_line_width > clip.x2
+	      || extents.x2 + half_line_width < clip.x1
+	      || extents.y1 - half_line_width > clip.y2
+	      || extents.y2 + half_line_width < clip.y1)
+	    continue;
+
+	  goo_canvas_batch_create_shape_path (priv, i, cr);
+	  n_painted++;
+	}
+
+      if (n_painted == 0)
+	continue;
+
+      /* We save and restore the cairo context so settings missing from one
+	 style aren't inherited from the previous one. */
+      style = goo_canvas_batch_get_shape_style (batch, style_id);
+      cairo_save (cr);
+      if (goo_canvas_style_set_fill_options (style, cr))
+	cairo_fill_preserve (cr);
+      if (goo_canvas_style_set_stroke_options (style, cr))
+	cairo_stroke (cr);
+      cairo_new_path (cr);
+      cairo_restore (cr);
+    }
+}
+
+
+static gboolean
+goo_canvas_batch_check_in_path (GooCanvasStyle         *style,
+				gdouble                 x,
+				gdouble                 y,
+				cairo_t                *cr,
+				GooCanvasPointerEvents  pointer_events)
+{
+  gboolean do_fill, do_stroke;
+
+  /* Check the filled path, if required. */
+  if (pointer_events & GOO_CANVAS_EVENTS_FILL_MASK)
+    {
+      do_fill = goo_canvas_style_set_fill_options (style, cr);
+      if (!(pointer_events & GOO_CANVAS_EVENTS_PAINTED_MASK) || do_fill)
+	{
+	  if (cairo_in_fill (cr, x, y))
+	    return TRUE;
+	}
+    }
+
+  /* Check the stroke, if required. */
+  if (pointer_events & GOO_CANVAS_EVENTS_STROKE_MASK)
+    {
+      do_stroke = goo_canvas_style_set_stroke_options (style, cr);
+      if (!(pointer_events & GOO_CANVAS_EVENTS_PAINTED_MASK) || do_stroke)
+	{
+	  if (cairo_in_stroke (cr, x, y))
+	    return TRUE;
+	}
+    }
+
+  return FALSE;
+}
+
+
+/* Returns TRUE if the shape is at the given point in user space. */
+static gboolean
+goo_canvas_batch_shape_is_at (GooCanvasBatch         *batch,
+			      gint                    shape,
+			      gdouble                 x,
+			      gdouble                 y,
+			      cairo_t                *cr,
+			      GooCanvasPointerEvents  pointer_events)
+{
+  GooCanvasBatchPrivate *priv = GOO_CANVAS_BATCH_GET_PRIVATE (batch);
+  gint style_id = g_array_index (priv->style_ids, gint, shape);
+  GooCanvasStyle *style;
+  GooCanvasBounds extents;
+  gboolean found;
+
+  goo_canvas_batch_get_shape_stroke_extents (priv, shape, &extents);
+  if (x < extents.x1 || x > extents.x2 || y < extents.y1 || y > extents.y2)
+    return FALSE;
+
+  cairo_save (cr);
+  cairo_new_path (cr);
+  goo_canvas_batch_create_shape_path (priv, shape, cr);
+  style = goo_canvas_batch_get_shape_style (batch, style_id);
+  found = goo_canvas_batch_check_in_path (style, x, y, cr, pointer_events);
+  cairo_new_path (cr);
+  cairo_restore (cr);
+
+  return found;
+}
+
+
+/* Returns the index of the top shape at the given point in user space, or
+   -1. If the grid is valid only the shapes in the cell containing the point
+   are tested, otherwise all of them are. */
+static gint
+goo_canvas_batch_find_shape (GooCanvasBatch *batch,
+			     gdouble         x,
+			     gdouble         y,
+			     cairo_t        *cr,
+			     gboolean        is_pointer_event)
+{
+  GooCanvasBatchPrivate *priv = GOO_CANVAS_BATCH_GET_PRIVATE (batch);
+  GooCanvasItemSimple *simple = (GooCanvasItemSimple*) batch;
+  GooCanvasPointerEvents pointer_events = GOO_CANVAS_EVENTS_ALL;
+  gint column, row, cell, shape, i;
+
+  if (is_pointer_event)
+    pointer_events = simple->simple_data->pointer_events;
+
+  if (!priv->grid_valid)
+    {
+      for (i = priv->types->len - 1; i >= 0; i--)
+	{
+	  if (goo_canvas_batch_shape_is_at (batch, i, x, y, cr,
+					    pointer_events))
+	    return i;
+	}
+      return -1;
+    }
+
+  if (x < priv->grid_bounds.x1 || x > priv->grid_bounds.x2
+      || y < priv->grid_bounds.y1 || y > priv->grid_bounds.y2)
+    return -1;
+
+  column = goo_canvas_batch_get_grid_index (x, priv->grid_bounds.x1,
+					    priv->grid_cell_width,
+					    priv->grid_columns);
+  row = goo_canvas_batch_get_grid_index (y, priv->grid_bounds.y1,
+					 priv->grid_cell_height,
+					 priv->grid_rows);
+  cell = row * priv->grid_columns + column;
+
+  /* The shapes in the cell are in increasing order, so we test them from
+     the end to find the top one first. */
+  for (i = (gint) g_array_index (priv->grid_starts, guint, cell + 1) - 1;
+       i >= (gint) g_array_index (priv->grid_starts, guint, cell); i--)
+    {
+      shape = g_array_index (priv->grid_shapes, gint, i);
+      if (goo_canvas_batch_shape_is_at (batch, shape, x, y, cr,
+					pointer_events))
+	return shape;
+    }
+
+  return -1;
+}
+
+
+static gboolean
+goo_canvas_batch_is_item_at (GooCanvasItemSimple *simple,
+			     gdouble              x,
+			     gdouble              y,
+			     cairo_t             *cr,
+			     gboolean             is_pointer_event)
+{
+  return goo_canvas_batch_find_shape ((GooCanvasBatch*) simple, x, y, cr,
+				      is_pointer_event) != -1;
+}
+
+
+/**
+ * goo_canvas_batch_get_shape_at:
+ * @batch: a #GooCanvasBatch.
+ * @x: the x coordinate of the point, in the item's coordinate space.
+ * @y: the y coordinate of the point, in the item's coordinate space.
+ * @is_pointer_event: %TRUE if the "pointer-events" property of the item
+ *  should be used to determine which parts of the shapes are tested.
+ *
+ * Finds the top shape at the given point. The coordinates are in the same
+ * space as the coordinates of the events passed to the item's signal
+ * handlers. Use goo_canvas_convert_to_item_space() to convert canvas
+ * coordinates.
+ *
+ * Returns: the index of the shape, or -1 if there is no shape at the point.
+ *
+ * Since: 3.0
+ **/
+gint
+goo_canvas_batch_get_shape_at (GooCanvasBatch *batch,
+			       gdouble         x,
+			       gdouble         y,
+			       gboolean        is_pointer_event)
+{
+  GooCanvasItemSimple *simple = (GooCanvasItemSimple*) batch;
+  cairo_t *cr;
+  gint shape;
+
+  g_return_val_if_fail (GOO_IS_CANVAS_BATCH (batch), -1);
+
+  if (!simple->canvas)
+    return -1;
+
+  if (simple->need_update)
+    goo_canvas_item_ensure_updated ((GooCanvasItem*) batch);
+
+  cr = goo_canvas_create_cairo_context (simple->canvas);
+  shape = goo_canvas_batch_find_shape (batch, x, y, cr, is_pointer_event);
+  cairo_destroy (cr);
+
+  return shape;
+}
+
+
+static void
+goo_canvas_batch_class_init (GooCanvasBatchClass *klass)
+{
+  GObjectClass *gobject_class = (GObjectClass*) klass;
+  GooCanvasItemSimpleClass *simple_class = (GooCanvasItemSimpleClass*) klass;
+
+  g_type_class_add_private (gobject_class, sizeof (GooCanvasBatchPrivate));
+
+  gobject_class->finalize = goo_canvas_batch_finalize;
+
+  simple_class->simple_update      = goo_canvas_batch_update;
+  simple_class->simple_paint       = goo_canvas_batch_paint;
+  simple_class->simple_is_item_at  = goo_canvas_batch_is_item_at;
+}
@@ -0,0 +1,125 @@
+/*
+ * GooCanvas. Copyright (C) 2005 Damon Chaplin.
+ * Released under the GNU LGPL license. See COPYING for details.
+ *
+ * goocanvasbatch.h - item holding many simple shapes.
+ */
+#ifndef __GOO_CANVAS_BATCH_H__
+#define __GOO_CANVAS_BATCH_H__
+
+#include <gtk/gtk.h>
+#include "goocanvasitemsimple.h"
+
+G_BEGIN_DECLS
+
+
+/**
+ * GooCanvasBatchShapeType:
+ * @GOO_CANVAS_BATCH_RECT: a rectangle with its top-left corner at (x, y).
+ * @GOO_CANVAS_BATCH_ELLIPSE: an ellipse filling the rectangle with its
+ *  top-left corner at (x, y).
+ * @GOO_CANVAS_BATCH_LINE: a line from (x, y) to (x + width, y + height).
+ * @GOO_CANVAS_BATCH_MARKER: a rectangular marker centered on (x, y), for
+ *  example to show a data point.
+ *
+ * #GooCanvasBatchShapeType specifies the type of each shape in a
+ * #GooCanvasBatch.
+ *
+ * Since: 3.0
+ */
+typedef enum
+{
+  GOO_CANVAS_BATCH_RECT,
+  GOO_CANVAS_BATCH_ELLIPSE,
+  GOO_CANVAS_BATCH_LINE,
+  GOO_CANVAS_BATCH_MARKER
+} GooCanvasBatchShapeType;
+
+
+#define GOO_TYPE_CANVAS_BATCH            (goo_canvas_batch_get_type ())
+#define GOO_CANVAS_BATCH(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), GOO_TYPE_CANVAS_BATCH, GooCanvasBatch))
+#define GOO_CANVAS_BATCH_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass), GOO_TYPE_CANVAS_BATCH, GooCanvasBatchClass))
+#define GOO_IS_CANVAS_BATCH(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), GOO_TYPE_CANVAS_BATCH))
+#define GOO_IS_CANVAS_BATCH_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass), GOO_TYPE_CANVAS_BATCH))
+#define GOO_CANVAS_BATCH_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj), GOO_TYPE_CANVAS_BATCH, GooCanvasBatchClass))
+
+
+typedef struct _GooCanvasBatch       GooCanvasBatch;
+typedef struct _GooCanvasBatchClass  GooCanvasBatchClass;
+
+/**
+ * GooCanvasBatch:
+ *
+ * The #GooCanvasBatch-struct struct contains private data only.
+ *
+ * Since: 3.0
+ */
+struct _GooCanvasBatch
+{
+  GooCanvasItemSimple parent_object;
+};
+
+struct _GooCanvasBatchClass
+{
+  GooCanvasItemSimpleClass parent_class;
+
+  /*< private >*/
+
+  /* Padding for future expansion */
+  void (*_goo_canvas_reserved1) (void);
+  void (*_goo_canvas_reserved2) (void);
+  void (*_goo_canvas_reserved3) (void);
+  void (*_goo_canvas_reserved4) (void);
+};
+
+
+GType          goo_canvas_batch_get_type       (void) G_GNUC_CONST;
+GooCanvasItem* goo_canvas_batch_new            (GooCanvasItem           *parent,
+						...);
+
+gint           goo_canvas_batch_add_style      (GooCanvasBatch          *batch,
+						GooCanvasStyle          *style);
+GooCanvasStyle* goo_canvas_batch_get_style     (GooCanvasBatch          *batch,
+						gint                     style_id);
+
+gint           goo_canvas_batch_add_shape      (GooCanvasBatch          *batch,
+						GooCanvasBatchShapeType  type,
+						gdouble                  x,
+						gdouble                  y,
+						gdouble                  width,
+						gdouble                  height,
+						gint                     style_id);
+gint           goo_canvas_batch_add_shapes     (GooCanvasBatch          *batch,
+						GooCanvasBatchShapeType  type,
+						const gdouble           *coords,
+						gint                     n_shapes,
+						gint                     style_id);
+void           goo_canvas_batch_set_shape      (GooCanvasBatch          *batch,
+						gint                     shape,
+						gdouble                  x,
+						gdouble                  y,
+						gdouble                  width,
+						gdouble                  height);
+void           goo_canvas_batch_set_shape_style (GooCanvasBatch         *batch,
+						 gint                    shape,
+						 gint                    style_id);
+gboolean       goo_canvas_batch_get_shape      (GooCanvasBatch          *batch,
+						gint                     shape,
+						GooCanvasBatchShapeType *type,
+						gdouble                 *x,
+						gdouble                 *y,
+						gdouble                 *width,
+						gdouble                 *height,
+						gint                    *style_id);
+gint           goo_canvas_batch_get_n_shapes   (GooCanvasBatch          *batch);
+void           goo_canvas_batch_clear          (GooCanvasBatch          *batch);
+
+gint           goo_canvas_batch_get_shape_at   (GooCanvasBatch          *batch,
+						gdouble                  x,
+						gdouble                  y,
+						gboolean                 is_pointer_event);
+
+
+G_END_DECLS
+
+#endif /* __GOO_CANVAS_BATCH_H__ */
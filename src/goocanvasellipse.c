@@ -32,6 +32,7 @@
 #include <math.h>
 #include <glib/gi18n-lib.h>
 #include <gtk/gtk.h>
+#include "goocanvasprivate.h"
 #include "goocanvasellipse.h"
 
 
@@ -586,7 +587,7 @@ goo_canvas_ellipse_model_set_property (GObject              *object,
 
   goo_canvas_ellipse_set_common_property (object, &emodel->ellipse_data,
 					  prop_id, value, pspec);
-  g_signal_emit_by_name (emodel, "changed", TRUE);
+  _goo_canvas_item_model_emit_changed ((GooCanvasItemModel*) emodel, TRUE);
 }
 
 
@@ -770,6 +770,62 @@ calculate_start_position (gdouble start_pos,
 }
 
 
+/* Returns the step between the grid lines we actually paint. If the lines
+   would be closer than one device pixel apart we paint only every n'th line,
+   as the extra lines can't be seen and can be very slow to draw. */
+static gdouble
+calculate_paint_step (cairo_t *cr,
+		      gdouble  step,
+		      gboolean vertical_lines)
+{
+  gdouble dx = 0.0, dy = 0.0, device_step;
+
+  if (step <= 0.0)
+    return step;
+
+  if (vertical_lines)
+    dx = step;
+  else
+    dy = step;
+  cairo_user_to_device_distance (cr, &dx, &dy);
+  device_step = sqrt (dx * dx + dy * dy);
+
+  if (device_step <= 0.0 || device_step >= 1.0)
+    return step;
+
+  return step * ceil (1.0 / device_step);
+}
+
+
+#define IS_INTEGRAL(value) (fabs ((value) - floor ((value) + 0.5)) < 0.001)
+
+/* Returns TRUE if all the grid lines start and end exactly on device pixel
+   boundaries, in which case we can fill them as rectangles, which cairo can
+   do much faster than stroking them. */
+static gboolean
+lines_are_pixel_aligned (cairo_t *cr,
+			 gdouble  pos,
+			 gdouble  step,
+			 gdouble  line_width,
+			 gboolean vertical_lines)
+{
+  cairo_matrix_t matrix;
+  gdouble scale, offset;
+
+  cairo_get_matrix (cr, &matrix);
+  if (matrix.xy != 0.0 || matrix.yx != 0.0 || cairo_get_dash_count (cr) > 0)
+    return FALSE;
+
+  scale = vertical_lines ? matrix.xx : matrix.yy;
+  offset = vertical_lines ? matrix.x0 : matrix.y0;
+
+  return scale * line_width != 0.0
+    && IS_INTEGRAL (scale * (pos - line_width / 2.0) + offset)
+    && IS_INTEGRAL (scale * step)
+    && IS_INTEGRAL (scale * line_width);
+}
+
+
 static void
 paint_vertical_lines (GooCanvasItemSimple   *simple,
 		      cairo_t               *cr,
@@ -778,8 +834,8 @@ paint_vertical_lines (GooCanvasItemSimple   *simple,
   GooCanvasItemSimpleData *simple_data = simple->simple_data;
   GooCanvasGrid *grid = (GooCanvasGrid*) simple;
   GooCanvasGridData *grid_data = grid->grid_data;
-  double x, max_x, max_y, max_bounds_x, line_width;
-  gboolean has_stroke;
+  double x, max_x, max_y, max_bounds_x, line_width, step;
+  gboolean has_stroke, fill_lines;
 
   if (!grid_data->show_vert_grid_lines)
     return;
@@ -806,28 +862,51 @@ paint_vertical_lines (GooCanvasItemSimple   *simple,
 
   cairo_set_line_cap (cr, CAIRO_LINE_CAP_BUTT);
 
+  step = calculate_paint_step (cr, grid_data->x_step, TRUE);
+
   /* Calculate the first grid line that intersects the bounds to redraw. */
   x = calculate_start_position (grid_data->x + grid_data->x_offset,
-				grid_data->x_step, bounds->x1, line_width);
+				step, bounds->x1, line_width);
 
   /* Calculate the last possible line position. */
   max_bounds_x = bounds->x2 + (line_width / 2.0);
   max_x = MIN (max_x, max_bounds_x);
 
   /* Add on a tiny fraction of step to avoid any double comparison issues. */
-  max_x += grid_data->x_step * 0.00001;
+  max_x += step * 0.00001;
 
+  fill_lines = lines_are_pixel_aligned (cr, x, step, line_width, TRUE);
+
+  /* Add all the lines to one path, so they are painted in one operation. */
   while (x <= max_x)
     {
-      cairo_move_to (cr, x, grid_data->y);
-      cairo_line_to (cr, x, max_y);
-      cairo_stroke (cr);
+      if (fill_lines)
+	{
+	  cairo_rectangle (cr, x - line_width / 2.0, grid_data->y,
+			   line_width, max_y - grid_data->y);
+	}
+      else
+	{
+	  cairo_move_to (cr, x, grid_data->y);
+	  cairo_line_to (cr, x, max_y);
+	}
 
       /* Avoid an infinite loop. */
-      if (grid_data->x_step <= 0.0)
+      if (step <= 0.0)
         break;
 
-      x += grid_data->x_step;
+      x += step;
+    }
+
+  if (fill_lines)
+    {
+      /* Lines may overlap if they are very close, so use the winding rule. */
+      cairo_set_fill_rule (cr, CAIRO_FILL_RULE_WINDING);
+      cairo_fill (cr);
+    }
+  else
+    {
+      cairo_stroke (cr);
     }
 }
 
@@ -840,8 +919,8 @@ paint_horizontal_lines (GooCanvasItemSimple   *simple,
   GooCanvasItemSimpleData *simple_data = simple->simple_data;
   GooCanvasGrid *grid = (GooCanvasGrid*) simple;
   GooCanvasGridData *grid_data = grid->grid_data;
-  double y, max_x, max_y, max_bounds_y, line_width;
-  gboolean has_stroke;
+  double y, max_x, max_y, max_bounds_y, line_width, step;
+  gboolean has_stroke, fill_lines;
 
   if (!grid_data->show_horz_grid_lines)
     return;
@@ -868,28 +947,51 @@ paint_horizontal_lines (GooCanvasItemSimple   *simple,
 
   cairo_set_line_cap (cr, CAIRO_LINE_CAP_BUTT);
 
+  step = calculate_paint_step (cr, grid_data->y_step, FALSE);
+
   /* Calculate the first grid line that intersects the bounds to redraw. */
   y = calculate_start_position (grid_data->y + grid_data->y_offset,
-				grid_data->y_step, bounds->y1, line_width);
+				step, bounds->y1, line_width);
 
   /* Calculate the last possible line position. */
   max_bounds_y = bounds->y2 + (line_width / 2.0);
   max_y = MIN (max_y, max_bounds_y);
 
   /* Add on a tiny fraction of step to avoid any double comparison issues. */
-  max_y += grid_data->y_step * 0.00001;
+  max_y += step * 0.00001;
+
+  fill_lines = lines_are_pixel_aligned (cr, y, step, line_width, FALSE);
 
+  /* Add all the lines to one path, so they are painted in one operation. */
   while (y <= max_y)
     {
-      cairo_move_to (cr, grid_data->x, y);
-      cairo_line_to (cr, max_x, y);
-      cairo_stroke (cr);
+      if (fill_lines)
+	{
+	  cairo_rectangle (cr, grid_data->x, y - line_width / 2.0,
+			   max_x - grid_data->x, line_width);
+	}
+      else
+	{
+	  cairo_move_to (cr, grid_data->x, y);
+	  cairo_line_to (cr, max_x, y);
+	}
 
       /* Avoid an infinite loop. */
-      if (grid_data->y_step <= 0.0)
+      if (step <= 0.0)
         break;
 
-      y += grid_data->y_step;
+      y += step;
+    }
+
+  if (fill_lines)
+    {
+      /* Lines may overlap if they are very close, so use the winding rule. */
+      cairo_set_fill_rule (cr, CAIRO_FILL_RULE_WINDING);
+      cairo_fill (cr);
+    }
+  else
+    {
+      cairo_stroke (cr);
     }
 }
 
@@ -1190,7 +1292,7 @@ goo_canvas_grid_model_set_property (GObject              *object,
 
   goo_canvas_grid_set_common_property (object, &gmodel->grid_data,
 					  prop_id, value, pspec);
-  g_signal_emit_by_name (gmodel, "changed", TRUE);
+  _goo_canvas_item_model_emit_changed ((GooCanvasItemModel*) gmodel, TRUE);
 }
 
 
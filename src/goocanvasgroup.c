@@ -34,6 +34,7 @@
  * g_object_get() and g_object_set().
  */
 #include <config.h>
+#include <string.h>
 #include <glib/gi18n-lib.h>
 #include <gtk/gtk.h>
 #include "goocanvasprivate.h"
@@ -49,6 +50,29 @@ struct _GooCanvasGroupPrivate {
   gdouble y;
   gdouble width;
   gdouble height;
+
+  /* This is TRUE if the group is viewing a model lazily, and hasn't created
+     the items for its children yet. It is only used in the item's own
+     private data, never the model's. */
+  gboolean children_pending;
+
+  /* This maps children to their positions, so they can be found quickly.
+     It is created the first time a child is searched for. The positions of
+     the children from child_index_valid onwards may be out of date, and are
+     only updated when needed. Inserting or removing a child means all the
+     children above it are renumbered on the next search, which costs about
+     as much as moving them in the array did. Moving a child only renumbers
+     the children it moved past. Items and models each use their own. */
+  GHashTable *child_index;
+  gint child_index_valid;
+
+  /* The bounds of the area the group is clipped to in device space, from
+     its clip path and width & height, if has_clip_bounds is set. They are
+     calculated when the group is updated, so children which are clipped out
+     can be skipped when painting and hit testing. They are only used in the
+     item's own private data. */
+  GooCanvasBounds clip_bounds;
+  gboolean has_clip_bounds;
 };
 
 #define GOO_CANVAS_GROUP_GET_PRIVATE(group)  \
@@ -153,6 +177,9 @@ goo_canvas_group_init (GooCanvasGroup *group)
   priv->y = 0.0;
   priv->width = -1.0;
   priv->height = -1.0;
+  priv->children_pending = FALSE;
+  priv->child_index = NULL;
+  priv->child_index_valid = 0;
 }
 
 
@@ -193,6 +220,112 @@ goo_canvas_group_new (GooCanvasItem *parent,
 }
 
 
+/* Notes that the positions of the children from the given position onwards
+   have changed. If a child has been removed it is passed in, so it can be
+   removed from the index. */
+static void
+goo_canvas_group_invalidate_child_index (GooCanvasGroupPrivate *priv,
+					 gint                   position,
+					 gpointer               removed_child)
+{
+  if (!priv->child_index)
+    return;
+
+  priv->child_index_valid = MIN (priv->child_index_valid, position);
+  if (removed_child)
+    g_hash_table_remove (priv->child_index, removed_child);
+}
+
+
+/* Empties the child index, when all the children have been removed. */
+static void
+goo_canvas_group_clear_child_index (GooCanvasGroupPrivate *priv)
+{
+  if (!priv->child_index)
+    return;
+
+  priv->child_index_valid = 0;
+  g_hash_table_remove_all (priv->child_index);
+}
+
+
+/* Updates the child index after a child has been moved in the array, which
+   only changes the positions of the children between the old and new
+   positions. If they are up to date in the index we renumber them now,
+   otherwise they are renumbered on the next search. */
+static void
+goo_canvas_group_move_child_index (GooCanvasGroupPrivate *priv,
+				   GPtrArray             *children,
+				   gint                   old_position,
+				   gint                   new_position)
+{
+  gint first = MIN (old_position, new_position);
+  gint last = MAX (old_position, new_position);
+  gint i;
+
+  if (!priv->child_index)
+    return;
+
+  if (priv->child_index_valid <= last)
+    {
+      priv->child_index_valid = MIN (priv->child_index_valid, first);
+      return;
+    }
+
+  for (i = first; i <= last; i++)
+    g_hash_table_insert (priv->child_index, children->pdata[i],
+			 GINT_TO_POINTER (i));
+}
+
+
+/* Finds the position of a child item or model. Small groups are just
+   searched, but for larger ones we use the child index, renumbering any
+   children whose positions may have changed. */
+static gint
+goo_canvas_group_find_child_in_array (GooCanvasGroupPrivate *priv,
+				      GPtrArray             *children,
+				      gpointer               child)
+{
+  gpointer value;
+  gint i;
+
+  if (children->len < 16)
+    {
+      for (i = 0; i < children->len; i++)
+	if (children->pdata[i] == child)
+	  return i;
+      return -1;
+    }
+
+  if (!priv->child_index)
+    {
+      priv->child_index = g_hash_table_new (g_direct_hash, g_direct_equal);
+      priv->child_index_valid = 0;
+    }
+
+  /* The index entries are checked against the array, so an entry which is
+     out of date is never returned. */
+  if (g_hash_table_lookup_extended (priv->child_index, child, NULL, &value))
+    {
+      i = GPOINTER_TO_INT (value);
+      if (i < children->len && children->pdata[i] == child)
+	return i;
+    }
+
+  if (priv->child_index_valid >= children->len)
+    return -1;
+
+  for (i = priv->child_index_valid; i < children->len; i++)
+    g_hash_table_insert (priv->child_index, children->pdata[i],
+			 GINT_TO_POINTER (i));
+  priv->child_index_valid = children->len;
+
+  if (g_hash_table_lookup_extended (priv->child_index, child, NULL, &value))
+    return GPOINTER_TO_INT (value);
+  return -1;
+}
+
+
 static void
 goo_canvas_group_dispose (GObject *object)
 {
@@ -208,6 +341,7 @@ goo_canvas_group_dispose (GObject *object)
     }
 
   g_ptr_array_set_size (group->items, 0);
+  goo_canvas_group_clear_child_index (GOO_CANVAS_GROUP_GET_PRIVATE (group));
 
   G_OBJECT_CLASS (goo_canvas_group_parent_class)->dispose (object);
 }
@@ -217,8 +351,11 @@ static void
 goo_canvas_group_finalize (GObject *object)
 {
   GooCanvasGroup *group = (GooCanvasGroup*) object;
+  GooCanvasGroupPrivate *view_priv = GOO_CANVAS_GROUP_GET_PRIVATE (group);
 
   g_ptr_array_free (group->items, TRUE);
+  if (view_priv->child_index)
+    g_hash_table_destroy (view_priv->child_index);
 
   G_OBJECT_CLASS (goo_canvas_group_parent_class)->finalize (object);
 }
@@ -343,6 +480,8 @@ goo_canvas_group_add_child     (GooCanvasItem  *item,
       position = group->items->len;
       g_ptr_array_add (group->items, child);
     }
+  goo_canvas_group_invalidate_child_index (GOO_CANVAS_GROUP_GET_PRIVATE (group),
+					   position, NULL);
 
   goo_canvas_item_set_parent (child, item);
   goo_canvas_item_set_is_static (child, simple->simple_data->is_static);
@@ -360,6 +499,53 @@ goo_canvas_group_add_child     (GooCanvasItem  *item,
 }
 
 
+static void
+goo_canvas_group_add_children  (GooCanvasItem  *item,
+				GooCanvasItem **children,
+				gint            n_children,
+				gint            position)
+{
+  GooCanvasItemSimple *simple = (GooCanvasItemSimple*) item;
+  GooCanvasGroup *group = (GooCanvasGroup*) item;
+  AtkObject *atk_obj, *child_atk_obj;
+  gint old_len, i;
+
+  old_len = group->items->len;
+  if (position < 0 || position > old_len)
+    position = old_len;
+
+  /* Make room for all the children and move the items above them up. */
+  g_ptr_array_set_size (group->items, old_len + n_children);
+  memmove (group->items->pdata + position + n_children,
+	   group->items->pdata + position,
+	   (old_len - position) * sizeof (gpointer));
+  goo_canvas_group_invalidate_child_index (GOO_CANVAS_GROUP_GET_PRIVATE (group),
+					   position, NULL);
+
+  for (i = 0; i < n_children; i++)
+    {
+      group->items->pdata[position + i] = g_object_ref (children[i]);
+      goo_canvas_item_set_parent (children[i], item);
+      goo_canvas_item_set_is_static (children[i],
+				     simple->simple_data->is_static);
+    }
+
+  /* Emit the "children_changed" ATK signal, if ATK is enabled. */
+  atk_obj = atk_gobject_accessible_for_object (G_OBJECT (item));
+  if (!ATK_IS_NO_OP_OBJECT (atk_obj))
+    {
+      for (i = 0; i < n_children; i++)
+	{
+	  child_atk_obj = atk_gobject_accessible_for_object (G_OBJECT (children[i]));
+	  g_signal_emit_by_name (atk_obj, "children_changed::add",
+				 position + i, child_atk_obj);
+	}
+    }
+
+  goo_canvas_item_request_update (item);
+}
+
+
 static void
 goo_canvas_group_move_child    (GooCanvasItem  *item,
 				gint	        old_position,
@@ -380,6 +566,8 @@ goo_canvas_group_move_child    (GooCanvasItem  *item,
     }
 
   goo_canvas_util_ptr_array_move (group->items, old_position, new_position);
+  goo_canvas_group_move_child_index (GOO_CANVAS_GROUP_GET_PRIVATE (group),
+				     group->items, old_position, new_position);
 
   goo_canvas_item_request_update (item);
 }
@@ -416,6 +604,8 @@ goo_canvas_group_remove_child  (GooCanvasItem  *item,
     }
 
   g_ptr_array_remove_index (group->items, child_num);
+  goo_canvas_group_invalidate_child_index (GOO_CANVAS_GROUP_GET_PRIVATE (group),
+					   child_num, child);
 
   goo_canvas_item_set_parent (child, NULL);
   g_object_unref (child);
@@ -424,6 +614,17 @@ goo_canvas_group_remove_child  (GooCanvasItem  *item,
 }
 
 
+static gint
+goo_canvas_group_find_child    (GooCanvasItem  *item,
+				GooCanvasItem  *child)
+{
+  GooCanvasGroup *group = (GooCanvasGroup*) item;
+
+  return goo_canvas_group_find_child_in_array (GOO_CANVAS_GROUP_GET_PRIVATE (group),
+					       group->items, child);
+}
+
+
 static gint
 goo_canvas_group_get_n_children (GooCanvasItem  *item)
 {
@@ -492,6 +693,23 @@ goo_canvas_group_set_is_static  (GooCanvasItem *item,
 }
 
 
+/* Gets the bounds of the group's model if the items for its children can be
+   created lazily, in the group's coordinate space. Subclasses such as
+   GooCanvasTable lay out their children, so they always need them. */
+static gboolean
+goo_canvas_group_get_lazy_bounds (GooCanvasGroup  *group,
+				  GooCanvasBounds *bounds)
+{
+  GooCanvasItemSimple *simple = (GooCanvasItemSimple*) group;
+
+  return simple->model && simple->canvas
+    && G_OBJECT_TYPE (group) == GOO_TYPE_CANVAS_GROUP
+    && !simple->simple_data->is_static
+    && goo_canvas_get_lazy_views (simple->canvas)
+    && goo_canvas_item_model_get_bounds (simple->model, bounds);
+}
+
+
 static void
 on_model_child_added (GooCanvasGroupModel *model,
 		      gint                 position,
@@ -499,9 +717,14 @@ on_model_child_added (GooCanvasGroupModel *model,
 {
   GooCanvasItemSimple *simple = (GooCanvasItemSimple*) group;
   GooCanvasItem *item = (GooCanvasItem*) group;
+  GooCanvasGroupPrivate *view_priv = GOO_CANVAS_GROUP_GET_PRIVATE (group);
   GooCanvasItemModel *child_model;
   GooCanvasItem *child;
 
+  /* If the children haven't been created yet, it will be created with them. */
+  if (view_priv->children_pending)
+    return;
+
   /* Create a canvas item for the model. */
   child_model = goo_canvas_item_model_get_child ((GooCanvasItemModel*) model,
 						 position);
@@ -511,14 +734,52 @@ on_model_child_added (GooCanvasGroupModel *model,
 }
 
 
+static void
+on_model_children_added (GooCanvasGroupModel *model,
+			 gint                 position,
+			 gint                 n_children,
+			 GooCanvasGroup      *group)
+{
+  GooCanvasItemSimple *simple = (GooCanvasItemSimple*) group;
+  GooCanvasItem *item = (GooCanvasItem*) group;
+  GooCanvasGroupPrivate *view_priv = GOO_CANVAS_GROUP_GET_PRIVATE (group);
+  GooCanvasItemModel *child_model;
+  GooCanvasItem **children;
+  gint i;
+
+  /* If the children haven't been created yet, these will be created with
+     them. */
+  if (view_priv->children_pending || n_children <= 0)
+    return;
+
+  /* Create canvas items for the models, and add them all at once. */
+  children = g_new (GooCanvasItem*, n_children);
+  for (i = 0; i < n_children; i++)
+    {
+      child_model = goo_canvas_item_model_get_child ((GooCanvasItemModel*) model,
+						     position + i);
+      children[i] = goo_canvas_create_item (simple->canvas, child_model);
+    }
+
+  goo_canvas_item_add_children (item, children, n_children, position);
+
+  for (i = 0; i < n_children; i++)
+    g_object_unref (children[i]);
+  g_free (children);
+}
+
+
 static void
 on_model_child_moved (GooCanvasGroupModel *model,
 		      gint                 old_position,
 		      gint                 new_position,
 		      GooCanvasGroup      *group)
 {
-  goo_canvas_item_move_child ((GooCanvasItem*) group, old_position,
-			       new_position);
+  GooCanvasGroupPrivate *view_priv = GOO_CANVAS_GROUP_GET_PRIVATE (group);
+
+  if (!view_priv->children_pending)
+    goo_canvas_item_move_child ((GooCanvasItem*) group, old_position,
+				new_position);
 }
 
 
@@ -527,7 +788,10 @@ on_model_child_removed (GooCanvasGroupModel *model,
 			gint                 child_num,
 			GooCanvasGroup      *group)
 {
-  goo_canvas_item_remove_child ((GooCanvasItem*) group, child_num);
+  GooCanvasGroupPrivate *view_priv = GOO_CANVAS_GROUP_GET_PRIVATE (group);
+
+  if (!view_priv->children_pending)
+    goo_canvas_item_remove_child ((GooCanvasItem*) group, child_num);
 }
 
 
@@ -537,7 +801,9 @@ goo_canvas_group_set_model (GooCanvasItem       *item,
 {
   GooCanvasItemSimple *simple = (GooCanvasItemSimple*) item;
   GooCanvasGroup *group = (GooCanvasGroup*) item;
-  gint n_children, i;
+  GooCanvasGroupPrivate *view_priv = GOO_CANVAS_GROUP_GET_PRIVATE (group);
+  GooCanvasBounds model_bounds;
+  gint n_children;
 
   /* Do the default GooCanvasItemSimple code first. */
   goo_canvas_item_simple_set_model (simple, model);
@@ -545,15 +811,158 @@ goo_canvas_group_set_model (GooCanvasItem       *item,
   /* Now add our own handlers. */
   g_signal_connect (model, "child-added",
 		    G_CALLBACK (on_model_child_added), group);
+  g_signal_connect (model, "children-added",
+		    G_CALLBACK (on_model_children_added), group);
   g_signal_connect (model, "child-moved",
 		    G_CALLBACK (on_model_child_moved), group);
   g_signal_connect (model, "child-removed",
 		    G_CALLBACK (on_model_child_removed), group);
 
+  /* If the canvas creates items lazily, wait until the group is visible. */
+  if (goo_canvas_group_get_lazy_bounds (group, &model_bounds))
+    {
+      view_priv->children_pending = TRUE;
+      return;
+    }
+
   /* Recursively create child items for any children. */
   n_children = goo_canvas_item_model_get_n_children (model);
+  on_model_children_added ((GooCanvasGroupModel*) simple->model, 0,
+			   n_children, group);
+}
+
+
+/* Creates the items for the children of the group's model, if they were
+   not created when the model was set because the canvas creates items
+   lazily. */
+void
+goo_canvas_group_create_pending_children (GooCanvasGroup *group)
+{
+  GooCanvasItemSimple *simple = (GooCanvasItemSimple*) group;
+  GooCanvasGroupPrivate *view_priv = GOO_CANVAS_GROUP_GET_PRIVATE (group);
+  gint n_children;
+
+  if (!view_priv->children_pending)
+    return;
+
+  view_priv->children_pending = FALSE;
+
+  n_children = goo_canvas_item_model_get_n_children (simple->model);
+  on_model_children_added ((GooCanvasGroupModel*) simple->model, 0,
+			   n_children, group);
+}
+
+
+/* Removes the item and its descendants from the canvas's hash table of
+   items, so goo_canvas_get_item() doesn't return them once they have been
+   released, even if the application still has references to them. */
+static void
+goo_canvas_group_unregister_items (GooCanvasItem *item)
+{
+  GooCanvasItemSimple *simple;
+  gint n_children, i;
+
+  if (GOO_IS_CANVAS_ITEM_SIMPLE (item))
+    {
+      simple = (GooCanvasItemSimple*) item;
+      if (simple->canvas && simple->model)
+	goo_canvas_unregister_item (simple->canvas, simple->model);
+    }
+
+  n_children = goo_canvas_item_get_n_children (item);
   for (i = 0; i < n_children; i++)
-    on_model_child_added ((GooCanvasGroupModel*) simple->model, i, group);
+    goo_canvas_group_unregister_items (goo_canvas_item_get_child (item, i));
+}
+
+
+/* Frees the items created for the children of group models which are
+   outside the visible area, so they can be created again when needed. */
+void
+goo_canvas_group_release_hidden_children (GooCanvasGroup        *group,
+					  const GooCanvasBounds *visible_bounds)
+{
+  GooCanvasItemSimple *simple = (GooCanvasItemSimple*) group;
+  GooCanvasGroupPrivate *view_priv = GOO_CANVAS_GROUP_GET_PRIVATE (group);
+  GooCanvasBounds model_bounds;
+  GooCanvasItem *child;
+  gint i;
+
+  if (view_priv->children_pending)
+    return;
+
+  if (goo_canvas_group_get_lazy_bounds (group, &model_bounds)
+      && (simple->bounds.x1 > visible_bounds->x2
+	  || simple->bounds.x2 < visible_bounds->x1
+	  || simple->bounds.y1 > visible_bounds->y2
+	  || simple->bounds.y2 < visible_bounds->y1))
+    {
+      for (i = 0; i < group->items->len; i++)
+	{
+	  child = group->items->pdata[i];
+	  goo_canvas_group_unregister_items (child);
+	  goo_canvas_item_set_parent (child, NULL);
+	  g_object_unref (child);
+	}
+      g_ptr_array_set_size (group->items, 0);
+      goo_canvas_group_clear_child_index (view_priv);
+
+      view_priv->children_pending = TRUE;
+      goo_canvas_item_request_update ((GooCanvasItem*) group);
+      return;
+    }
+
+  for (i = 0; i < group->items->len; i++)
+    {
+      child = group->items->pdata[i];
+      if (GOO_IS_CANVAS_GROUP (child))
+	goo_canvas_group_release_hidden_children ((GooCanvasGroup*) child,
+						  visible_bounds);
+    }
+}
+
+
+/* Requests an update of the groups whose children haven't been created yet
+   but which are now in the visible area, so the update creates them.
+   If old_bounds is set it is the visible area last checked, and groups
+   entirely inside it are skipped, as they have been checked already and
+   any of their pending descendants were visible then. So scrolling only
+   descends into the groups overlapping the newly exposed area. */
+void
+goo_canvas_group_request_visible_updates (GooCanvasGroup        *group,
+					  const GooCanvasBounds *visible_bounds,
+					  const GooCanvasBounds *old_bounds)
+{
+  GooCanvasItemSimple *simple = (GooCanvasItemSimple*) group;
+  GooCanvasGroupPrivate *view_priv = GOO_CANVAS_GROUP_GET_PRIVATE (group);
+  GooCanvasItem *child;
+  gint i;
+
+  if (simple->bounds.x1 > visible_bounds->x2
+      || simple->bounds.x2 < visible_bounds->x1
+      || simple->bounds.y1 > visible_bounds->y2
+      || simple->bounds.y2 < visible_bounds->y1)
+    return;
+
+  if (old_bounds
+      && simple->bounds.x1 >= old_bounds->x1
+      && simple->bounds.x2 <= old_bounds->x2
+      && simple->bounds.y1 >= old_bounds->y1
+      && simple->bounds.y2 <= old_bounds->y2)
+    return;
+
+  if (view_priv->children_pending)
+    {
+      goo_canvas_item_request_update ((GooCanvasItem*) group);
+      return;
+    }
+
+  for (i = 0; i < group->items->len; i++)
+    {
+      child = group->items->pdata[i];
+      if (GOO_IS_CANVAS_GROUP (child))
+	goo_canvas_group_request_visible_updates ((GooCanvasGroup*) child,
+						  visible_bounds, old_bounds);
+    }
 }
 
 
@@ -574,6 +983,59 @@ goo_canvas_group_request_update  (GooCanvasItem *item)
 }
 
 
+/* Calculates the bounds of the area the group is clipped to, in device
+   space. The cairo context must have the group's transformation and
+   translation set. */
+static void
+goo_canvas_group_update_clip_bounds (GooCanvasGroup *group,
+				     cairo_t        *cr)
+{
+  GooCanvasItemSimple *simple = (GooCanvasItemSimple*) group;
+  GooCanvasItemSimpleData *simple_data = simple->simple_data;
+  GooCanvasGroupPrivate *priv = goo_canvas_group_get_private (group);
+  GooCanvasGroupPrivate *view_priv = GOO_CANVAS_GROUP_GET_PRIVATE (group);
+  GooCanvasBounds *clip_bounds = &view_priv->clip_bounds;
+
+  view_priv->has_clip_bounds = FALSE;
+
+  if (simple_data->clip_path_commands)
+    {
+      goo_canvas_item_simple_data_get_clip_extents (simple_data, cr,
+						    clip_bounds);
+      view_priv->has_clip_bounds = TRUE;
+    }
+
+  if (priv->width > 0.0 && priv->height > 0.0)
+    {
+      if (view_priv->has_clip_bounds)
+	{
+	  clip_bounds->x1 = MAX (clip_bounds->x1, 0.0);
+	  clip_bounds->y1 = MAX (clip_bounds->y1, 0.0);
+	  clip_bounds->x2 = MIN (clip_bounds->x2, priv->width);
+	  clip_bounds->y2 = MIN (clip_bounds->y2, priv->height);
+	}
+      else
+	{
+	  clip_bounds->x1 = clip_bounds->y1 = 0.0;
+	  clip_bounds->x2 = priv->width;
+	  clip_bounds->y2 = priv->height;
+	  view_priv->has_clip_bounds = TRUE;
+	}
+    }
+
+  if (view_priv->has_clip_bounds)
+    {
+      /* Keep an empty clip area empty when it is converted. */
+      if (clip_bounds->x1 > clip_bounds->x2)
+	clip_bounds->x2 = clip_bounds->x1;
+      if (clip_bounds->y1 > clip_bounds->y2)
+	clip_bounds->y2 = clip_bounds->y1;
+
+      goo_canvas_item_simple_user_bounds_to_device (simple, cr, clip_bounds);
+    }
+}
+
+
 static void
 goo_canvas_group_update  (GooCanvasItem   *item,
 			  gboolean         entire_tree,
@@ -583,7 +1045,8 @@ goo_canvas_group_update  (GooCanvasItem   *item,
   GooCanvasItemSimple *simple = (GooCanvasItemSimple*) item;
   GooCanvasGroup *group = (GooCanvasGroup*) item;
   GooCanvasGroupPrivate *priv = goo_canvas_group_get_private (group);
-  GooCanvasBounds child_bounds;
+  GooCanvasGroupPrivate *view_priv = GOO_CANVAS_GROUP_GET_PRIVATE (group);
+  GooCanvasBounds child_bounds, model_bounds, visible_bounds;
   gboolean initial_bounds = TRUE;
   gint i;
 
@@ -592,8 +1055,42 @@ goo_canvas_group_update  (GooCanvasItem   *item,
       if (simple->need_entire_subtree_update)
 	entire_tree = TRUE;
 
+      /* If the children haven't been created yet, use the model's bounds
+	 unless they are visible, in which case we create the children. */
+      if (view_priv->children_pending)
+	{
+	  if (goo_canvas_group_get_lazy_bounds (group, &model_bounds))
+	    {
+	      cairo_save (cr);
+	      if (simple->simple_data->transform)
+		cairo_transform (cr, simple->simple_data->transform);
+	      goo_canvas_item_simple_user_bounds_to_device (simple, cr,
+							    &model_bounds);
+	      cairo_restore (cr);
+
+	      goo_canvas_get_visible_bounds (simple->canvas, &visible_bounds);
+	      if (model_bounds.x1 > visible_bounds.x2
+		  || model_bounds.x2 < visible_bounds.x1
+		  || model_bounds.y1 > visible_bounds.y2
+		  || model_bounds.y2 < visible_bounds.y1)
+		{
+		  simple->need_update = FALSE;
+		  simple->need_entire_subtree_update = FALSE;
+		  simple->bounds = model_bounds;
+		  *bounds = simple->bounds;
+		  return;
+		}
+	    }
+
+	  /* Make sure adding the children doesn't request another update. */
+	  simple->need_update = TRUE;
+	  goo_canvas_group_create_pending_children (group);
+	  entire_tree = TRUE;
+	}
+
       simple->need_update = FALSE;
       simple->need_entire_subtree_update = FALSE;
+      GOO_CANVAS_COUNT (items_updated);
 
       goo_canvas_item_simple_check_style (simple);
 
@@ -606,6 +1103,8 @@ goo_canvas_group_update  (GooCanvasItem   *item,
 
       cairo_translate (cr, priv->x, priv->y);
 
+      goo_canvas_group_update_clip_bounds (group, cr);
+
       for (i = 0; i < group->items->len; i++)
         {
           GooCanvasItem *child = group->items->pdata[i];
@@ -635,6 +1134,20 @@ goo_canvas_group_update  (GooCanvasItem   *item,
         }
 
       cairo_restore (cr);
+
+      /* The group's bounds don't extend beyond its clip area. */
+      if (view_priv->has_clip_bounds && !initial_bounds)
+	{
+	  simple->bounds.x1 = MAX (simple->bounds.x1, view_priv->clip_bounds.x1);
+	  simple->bounds.y1 = MAX (simple->bounds.y1, view_priv->clip_bounds.y1);
+	  simple->bounds.x2 = MIN (simple->bounds.x2, view_priv->clip_bounds.x2);
+	  simple->bounds.y2 = MIN (simple->bounds.y2, view_priv->clip_bounds.y2);
+
+	  if (simple->bounds.x1 > simple->bounds.x2)
+	    simple->bounds.x2 = simple->bounds.x1;
+	  if (simple->bounds.y1 > simple->bounds.y2)
+	    simple->bounds.y2 = simple->bounds.y1;
+	}
     }
 
   *bounds = simple->bounds;
@@ -654,6 +1167,7 @@ goo_canvas_group_get_items_at (GooCanvasItem  *item,
   GooCanvasItemSimpleData *simple_data = simple->simple_data;
   GooCanvasGroup *group = (GooCanvasGroup*) item;
   GooCanvasGroupPrivate *priv = goo_canvas_group_get_private (group);
+  GooCanvasGroupPrivate *view_priv = GOO_CANVAS_GROUP_GET_PRIVATE (group);
   gboolean visible = parent_visible;
   int i;
 
@@ -665,9 +1179,15 @@ goo_canvas_group_get_items_at (GooCanvasItem  *item,
       || simple->bounds.y1 > y || simple->bounds.y2 < y)
     return found_items;
 
+  /* Skip the group if the point is outside its clip area. */
+  if (view_priv->has_clip_bounds
+      && (view_priv->clip_bounds.x1 > x || view_priv->clip_bounds.x2 < x
+	  || view_priv->clip_bounds.y1 > y || view_priv->clip_bounds.y2 < y))
+    return found_items;
+
   if (simple_data->visibility <= GOO_CANVAS_ITEM_INVISIBLE
       || (simple_data->visibility == GOO_CANVAS_ITEM_VISIBLE_ABOVE_THRESHOLD
-	  && simple->canvas->scale < simple_data->visibility_threshold))
+	  && goo_canvas_get_hit_test_scale (simple->canvas, cr) < simple_data->visibility_threshold))
     visible = FALSE;
 
   /* Check if the group should receive events. */
@@ -689,9 +1209,8 @@ goo_canvas_group_get_items_at (GooCanvasItem  *item,
       double user_x = x, user_y = y;
 
       cairo_device_to_user (cr, &user_x, &user_y);
-      goo_canvas_create_path (simple_data->clip_path_commands, cr);
-      cairo_set_fill_rule (cr, simple_data->clip_fill_rule);
-      if (!cairo_in_fill (cr, user_x, user_y))
+      if (!goo_canvas_item_simple_data_in_clip (simple_data, cr,
+						user_x, user_y))
 	{
 	  cairo_restore (cr);
 	  return found_items;
@@ -737,12 +1256,17 @@ goo_canvas_group_paint (GooCanvasItem         *item,
   GooCanvasItemSimpleData *simple_data = simple->simple_data;
   GooCanvasGroup *group = (GooCanvasGroup*) item;
   GooCanvasGroupPrivate *priv = goo_canvas_group_get_private (group);
+  GooCanvasGroupPrivate *view_priv = GOO_CANVAS_GROUP_GET_PRIVATE (group);
+  GooCanvasBounds clip_bounds;
   gint i;
 
   /* Skip the item if the bounds don't intersect the expose rectangle. */
   if (simple->bounds.x1 > bounds->x2 || simple->bounds.x2 < bounds->x1
       || simple->bounds.y1 > bounds->y2 || simple->bounds.y2 < bounds->y1)
-    return;
+    {
+      GOO_CANVAS_COUNT (items_culled);
+      return;
+    }
 
   /* Check if the item should be visible. */
   if (simple_data->visibility <= GOO_CANVAS_ITEM_INVISIBLE
@@ -750,6 +1274,21 @@ goo_canvas_group_paint (GooCanvasItem         *item,
 	  && scale < simple_data->visibility_threshold))
     return;
 
+  GOO_CANVAS_COUNT (items_painted);
+
+  /* If the group is clipped, only the children inside the clip area need
+     to be painted, so we pass the intersection down to them. */
+  if (view_priv->has_clip_bounds)
+    {
+      clip_bounds.x1 = MAX (bounds->x1, view_priv->clip_bounds.x1);
+      clip_bounds.y1 = MAX (bounds->y1, view_priv->clip_bounds.y1);
+      clip_bounds.x2 = MIN (bounds->x2, view_priv->clip_bounds.x2);
+      clip_bounds.y2 = MIN (bounds->y2, view_priv->clip_bounds.y2);
+      if (clip_bounds.x1 > clip_bounds.x2 || clip_bounds.y1 > clip_bounds.y2)
+	return;
+      bounds = &clip_bounds;
+    }
+
   /* Paint all the items in the group. */
   cairo_save (cr);
   if (simple_data->transform)
@@ -759,11 +1298,7 @@ goo_canvas_group_paint (GooCanvasItem         *item,
 
   /* Clip with the group's clip path, if it is set. */
   if (simple_data->clip_path_commands)
-    {
-      goo_canvas_create_path (simple_data->clip_path_commands, cr);
-      cairo_set_fill_rule (cr, simple_data->clip_fill_rule);
-      cairo_clip (cr);
-    }
+    goo_canvas_item_simple_data_clip (simple_data, cr);
 
   if (priv->width > 0.0 && priv->height > 0.0)
     {
@@ -787,8 +1322,10 @@ canvas_item_interface_init (GooCanvasItemIface *iface)
   iface->get_n_children = goo_canvas_group_get_n_children;
   iface->get_child      = goo_canvas_group_get_child;
   iface->request_update = goo_canvas_group_request_update;
+  iface->find_child     = goo_canvas_group_find_child;
 
   iface->add_child      = goo_canvas_group_add_child;
+  iface->add_children   = goo_canvas_group_add_children;
   iface->move_child     = goo_canvas_group_move_child;
   iface->remove_child   = goo_canvas_group_remove_child;
 
@@ -873,6 +1410,9 @@ goo_canvas_group_model_init (GooCanvasGroupModel *gmodel)
   priv->y = 0.0;
   priv->width = -1.0;
   priv->height = -1.0;
+  priv->children_pending = FALSE;
+  priv->child_index = NULL;
+  priv->child_index_valid = 0;
 }
 
 
@@ -928,6 +1468,7 @@ goo_canvas_group_model_dispose (GObject *object)
     }
 
   g_ptr_array_set_size (gmodel->children, 0);
+  goo_canvas_group_clear_child_index (GOO_CANVAS_GROUP_MODEL_GET_PRIVATE (gmodel));
 
   G_OBJECT_CLASS (goo_canvas_group_model_parent_class)->dispose (object);
 }
@@ -937,8 +1478,11 @@ static void
 goo_canvas_group_model_finalize (GObject *object)
 {
   GooCanvasGroupModel *gmodel = (GooCanvasGroupModel*) object;
+  GooCanvasGroupPrivate *priv = GOO_CANVAS_GROUP_MODEL_GET_PRIVATE (gmodel);
 
   g_ptr_array_free (gmodel->children, TRUE);
+  if (priv->child_index)
+    g_hash_table_destroy (priv->child_index);
 
   G_OBJECT_CLASS (goo_canvas_group_model_parent_class)->finalize (object);
 }
@@ -963,18 +1507,16 @@ static void goo_canvas_group_model_set_property (GObject            *object,
   GooCanvasGroupPrivate *priv = GOO_CANVAS_GROUP_MODEL_GET_PRIVATE (model);
 
   goo_canvas_group_set_common_property (object, priv, prop_id, value, pspec);
-  g_signal_emit_by_name (model, "changed", TRUE);
+  _goo_canvas_item_model_emit_changed ((GooCanvasItemModel*) model, TRUE);
 }
 
-extern void _goo_canvas_item_model_emit_child_added (GooCanvasItemModel *model,
-						     gint                position);
-
 static void
 goo_canvas_group_model_add_child     (GooCanvasItemModel *model,
 				      GooCanvasItemModel *child,
 				      gint                position)
 {
   GooCanvasGroupModel *gmodel = (GooCanvasGroupModel*) model;
+  GooCanvasGroupPrivate *priv = GOO_CANVAS_GROUP_MODEL_GET_PRIVATE (gmodel);
 
   g_object_ref (child);
 
@@ -987,6 +1529,7 @@ goo_canvas_group_model_add_child     (GooCanvasItemModel *model,
       position = gmodel->children->len;
       g_ptr_array_add (gmodel->children, child);
     }
+  goo_canvas_group_invalidate_child_index (priv, position, NULL);
 
   goo_canvas_item_model_set_parent (child, model);
 
@@ -994,6 +1537,39 @@ goo_canvas_group_model_add_child     (GooCanvasItemModel *model,
 }
 
 
+static void
+goo_canvas_group_model_add_children  (GooCanvasItemModel  *model,
+				      GooCanvasItemModel **children,
+				      gint                 n_children,
+				      gint                 position)
+{
+  GooCanvasGroupModel *gmodel = (GooCanvasGroupModel*) model;
+  GooCanvasGroupPrivate *priv = GOO_CANVAS_GROUP_MODEL_GET_PRIVATE (gmodel);
+  gint old_len, i;
+
+  old_len = gmodel->children->len;
+  if (position < 0 || position > old_len)
+    position = old_len;
+
+  /* Make room for all the children and move the models above them up. */
+  g_ptr_array_set_size (gmodel->children, old_len + n_children);
+  memmove (gmodel->children->pdata + position + n_children,
+	   gmodel->children->pdata + position,
+	   (old_len - position) * sizeof (gpointer));
+  goo_canvas_group_invalidate_child_index (priv, position, NULL);
+
+  for (i = 0; i < n_children; i++)
+    {
+      gmodel->children->pdata[position + i] = g_object_ref (children[i]);
+      goo_canvas_item_model_set_parent (children[i], model);
+    }
+
+  /* This replaces the "child-added" signal for each child, so adding a
+     large number of children only needs one emission. */
+  _goo_canvas_item_model_emit_children_added (model, position, n_children);
+}
+
+
 static void
 goo_canvas_group_model_move_child    (GooCanvasItemModel *model,
 				      gint	          old_position,
@@ -1003,6 +1579,9 @@ goo_canvas_group_model_move_child    (GooCanvasItemModel *model,
 
   goo_canvas_util_ptr_array_move (gmodel->children, old_position,
 				  new_position);
+  goo_canvas_group_move_child_index (GOO_CANVAS_GROUP_MODEL_GET_PRIVATE (gmodel),
+				     gmodel->children, old_position,
+				     new_position);
 
   g_signal_emit_by_name (gmodel, "child-moved", old_position, new_position);
 }
@@ -1019,6 +1598,8 @@ goo_canvas_group_model_remove_child  (GooCanvasItemModel *model,
   goo_canvas_item_model_set_parent (child, NULL);
 
   g_ptr_array_remove_index (gmodel->children, child_num);
+  goo_canvas_group_invalidate_child_index (GOO_CANVAS_GROUP_MODEL_GET_PRIVATE (gmodel),
+					   child_num, child);
 
   g_signal_emit_by_name (gmodel, "child-removed", child_num);
 
@@ -1026,6 +1607,17 @@ goo_canvas_group_model_remove_child  (GooCanvasItemModel *model,
 }
 
 
+static gint
+goo_canvas_group_model_find_child    (GooCanvasItemModel  *model,
+				      GooCanvasItemModel  *child)
+{
+  GooCanvasGroupModel *gmodel = (GooCanvasGroupModel*) model;
+
+  return goo_canvas_group_find_child_in_array (GOO_CANVAS_GROUP_MODEL_GET_PRIVATE (gmodel),
+					       gmodel->children, child);
+}
+
+
 static gint
 goo_canvas_group_model_get_n_children (GooCanvasItemModel  *model)
 {
@@ -1063,16 +1655,37 @@ goo_canvas_group_model_create_item (GooCanvasItemModel *model,
 }
 
 
+static gboolean
+goo_canvas_group_model_get_bounds (GooCanvasItemModel *model,
+				   GooCanvasBounds    *bounds)
+{
+  GooCanvasGroupPrivate *priv = GOO_CANVAS_GROUP_MODEL_GET_PRIVATE (model);
+
+  /* The group is only clipped to a known area if the size is set. */
+  if (priv->width <= 0.0 || priv->height <= 0.0)
+    return FALSE;
+
+  bounds->x1 = priv->x;
+  bounds->y1 = priv->y;
+  bounds->x2 = priv->x + priv->width;
+  bounds->y2 = priv->y + priv->height;
+  return TRUE;
+}
+
+
 static void
 item_model_interface_init (GooCanvasItemModelIface *iface)
 {
   iface->add_child      = goo_canvas_group_model_add_child;
+  iface->add_children   = goo_canvas_group_model_add_children;
   iface->move_child     = goo_canvas_group_model_move_child;
   iface->remove_child   = goo_canvas_group_model_remove_child;
   iface->get_n_children = goo_canvas_group_model_get_n_children;
   iface->get_child      = goo_canvas_group_model_get_child;
+  iface->find_child     = goo_canvas_group_model_find_child;
 
   iface->create_item    = goo_canvas_group_model_create_item;
+  iface->get_bounds     = goo_canvas_group_model_get_bounds;
 }
 
 
@@ -17,6 +17,15 @@
  * scale the image to fit the given rectangle.
  * </para></note>
  *
+ * Images set with the "pixbuf" property share the cairo surface converted
+ * from the pixbuf with all other items using the same pixbuf. The pixels
+ * are only converted the first time, so if they are changed afterwards
+ * goo_canvas_image_cache_invalidate() must be called before setting the
+ * "pixbuf" property again. When these images are drawn at less than half
+ * their natural size, smaller copies of the surface are created and shared
+ * as well. Patterns set with the "pattern" property are always drawn at full
+ * resolution, since the application may change their contents.
+ *
  * It is a subclass of #GooCanvasItemSimple and so inherits all of the style
  * properties such as "operator" and "pointer-events".
  *
@@ -30,6 +39,7 @@
  * g_object_get() and g_object_set().
  */
 #include <config.h>
+#include <math.h>
 #include <glib/gi18n-lib.h>
 #include <gtk/gtk.h>
 #include "goocanvasprivate.h"
@@ -43,6 +53,12 @@ struct _GooCanvasImagePrivate {
   gboolean scale_to_fit;
   gdouble alpha;
   gdouble scale_to_units; /* How much to scale the image when the units are not pixels. */
+
+  /* TRUE while an image is being loaded asynchronously. The serial number is
+     increased whenever the image is set, so we can tell if a load has been
+     superseded by the time it completes. */
+  gboolean loading;
+  guint load_serial;
 };
 
 #define GOO_CANVAS_IMAGE_GET_PRIVATE(image)  \
@@ -389,6 +405,8 @@ goo_canvas_image_set_common_property (GObject              *object,
       cairo_pattern_destroy (image_data->pattern);
       image_data->pattern = g_value_get_boxed (value);
       cairo_pattern_reference (image_data->pattern);
+      priv->loading = FALSE;
+      priv->load_serial++;
       break;
     case PROP_X:
       image_data->x = g_value_get_double (value);
@@ -411,6 +429,8 @@ goo_canvas_image_set_common_property (GObject              *object,
       image_data->pattern = pixbuf ? goo_canvas_cairo_pattern_from_pixbuf (pixbuf) : NULL;
       image_data->width = pixbuf ? gdk_pixbuf_get_width (pixbuf) : 0;
       image_data->height = pixbuf ? gdk_pixbuf_get_height (pixbuf) : 0;
+      priv->loading = FALSE;
+      priv->load_serial++;
 
       if (GOO_IS_CANVAS_ITEM (object))
 	goo_canvas_image_convert_pixbuf_sizes (GOO_CANVAS_ITEM (object),
@@ -487,6 +507,187 @@ goo_canvas_image_update  (GooCanvasItemSimple  *simple,
 }
 
 
+/*
+ * Mipmaps. When an image is drawn at a much smaller size than its natural
+ * size, having cairo downsample the full-resolution surface on every paint
+ * is slow and aliases badly. So we build a chain of surfaces, each half the
+ * size of the previous one, as they are needed, and paint the one closest to
+ * the size on the device. The chain is attached to the source surface, so it
+ * is shared by all the images using that surface.
+ *
+ * The chain is never updated, so it is only used for surfaces converted
+ * from a "pixbuf", which the canvas owns. Surfaces set with the "pattern"
+ * property may be drawn into by the application, so they are always painted
+ * at full resolution.
+ */
+#define GOO_CANVAS_IMAGE_MAX_MIP_LEVELS 16
+
+typedef struct _GooCanvasImageMipChain GooCanvasImageMipChain;
+struct _GooCanvasImageMipChain
+{
+  gint n_levels;
+
+  /* levels[0] is half the size of the source surface, and so on. */
+  cairo_surface_t *levels[GOO_CANVAS_IMAGE_MAX_MIP_LEVELS];
+};
+
+static const cairo_user_data_key_t mip_chain_key;
+
+
+static void
+goo_canvas_image_mip_chain_free (gpointer data)
+{
+  GooCanvasImageMipChain *chain = data;
+  gint i;
+
+  for (i = 0; i < chain->n_levels; i++)
+    cairo_surface_destroy (chain->levels[i]);
+
+  g_slice_free (GooCanvasImageMipChain, chain);
+}
+
+
+/* Returns the surface to use for the given mip level, creating any levels
+   that don't exist yet. Level 0 is the source surface itself. If the source
+   surface is too small to have the requested level, the smallest level is
+   returned. */
+static cairo_surface_t*
+goo_canvas_image_get_mip_level (cairo_surface_t *surface,
+				gint             level)
+{
+  GooCanvasImageMipChain *chain;
+  cairo_surface_t *prev, *new_level;
+  gint prev_width, prev_height, width, height;
+  cairo_t *cr;
+
+  level = MIN (level, GOO_CANVAS_IMAGE_MAX_MIP_LEVELS);
+  if (level <= 0)
+    return surface;
+
+  chain = cairo_surface_get_user_data (surface, &mip_chain_key);
+  if (!chain)
+    {
+      chain = g_slice_new0 (GooCanvasImageMipChain);
+      cairo_surface_set_user_data (surface, &mip_chain_key, chain,
+				   goo_canvas_image_mip_chain_free);
+    }
+
+  while (chain->n_levels < level)
+    {
+      prev = chain->n_levels ? chain->levels[chain->n_levels - 1] : surface;
+      prev_width = cairo_image_surface_get_width (prev);
+      prev_height = cairo_image_surface_get_height (prev);
+      if (prev_width <= 1 && prev_height <= 1)
+	break;
+
+      width = MAX (1, (prev_width + 1) / 2);
+      height = MAX (1, (prev_height + 1) / 2);
+
+      /* Scaling by a half with a bilinear filter averages each 2x2 block. */
+      new_level = cairo_image_surface_create (cairo_image_surface_get_format (prev),
+					      width, height);
+      cr = cairo_create (new_level);
+      cairo_scale (cr, (gdouble) width / prev_width,
+		   (gdouble) height / prev_height);
+      cairo_set_source_surface (cr, prev, 0, 0);
+      cairo_pattern_set_filter (cairo_get_source (cr), CAIRO_FILTER_BILINEAR);
+      cairo_set_operator (cr, CAIRO_OPERATOR_SOURCE);
+      cairo_paint (cr);
+      cairo_destroy (cr);
+
+      chain->levels[chain->n_levels++] = new_level;
+    }
+
+  if (chain->n_levels == 0)
+    return surface;
+
+  return chain->levels[MIN (level, chain->n_levels) - 1];
+}
+
+
+/* This is used by goo_canvas_get_memory_stats(). It returns the size of the
+   mip levels created for the surface, if any. */
+gsize
+goo_canvas_image_get_mip_chain_memory_used (cairo_surface_t *surface)
+{
+  GooCanvasImageMipChain *chain;
+  gsize n_bytes = 0;
+  gint i;
+
+  chain = cairo_surface_get_user_data (surface, &mip_chain_key);
+  if (!chain)
+    return 0;
+
+  for (i = 0; i < chain->n_levels; i++)
+    n_bytes += (gsize) cairo_image_surface_get_stride (chain->levels[i])
+      * cairo_image_surface_get_height (chain->levels[i]);
+
+  return n_bytes + sizeof (GooCanvasImageMipChain);
+}
+
+
+/* Returns a new reference to the pattern to paint the image with. If the
+   image is being drawn at less than half its natural size, this is a pattern
+   for the closest mip level with the matrix adjusted to match. Otherwise it
+   is the image's own pattern, which is always the case for patterns set by
+   the application. */
+static cairo_pattern_t*
+goo_canvas_image_get_paint_pattern (cairo_pattern_t      *pattern,
+				    const cairo_matrix_t *matrix,
+				    cairo_t              *cr)
+{
+  cairo_surface_t *surface, *level_surface;
+  cairo_pattern_t *level_pattern;
+  cairo_matrix_t level_matrix, scale_matrix;
+  gdouble dx1 = 1.0, dy1 = 0.0, dx2 = 0.0, dy2 = 1.0;
+  gdouble sx, sy, ratio;
+  gint level;
+
+  if (!goo_canvas_pattern_is_from_pixbuf (pattern)
+      || cairo_pattern_get_surface (pattern, &surface) != CAIRO_STATUS_SUCCESS
+      || cairo_surface_get_type (surface) != CAIRO_SURFACE_TYPE_IMAGE
+      || matrix->xy != 0.0 || matrix->yx != 0.0
+      || matrix->xx == 0.0 || matrix->yy == 0.0)
+    return cairo_pattern_reference (pattern);
+
+  /* Work out how many device pixels each pixel of the surface covers. We use
+     the larger of the two directions, so we never make the image blurry. */
+  cairo_user_to_device_distance (cr, &dx1, &dy1);
+  cairo_user_to_device_distance (cr, &dx2, &dy2);
+  sx = sqrt (dx1 * dx1 + dy1 * dy1) / fabs (matrix->xx);
+  sy = sqrt (dx2 * dx2 + dy2 * dy2) / fabs (matrix->yy);
+  ratio = MAX (sx, sy);
+
+  if (ratio <= 0.0)
+    return cairo_pattern_reference (pattern);
+
+  /* Only use a smaller level once the image is drawn at half the level's
+     size or less, so it is never scaled up. */
+  level = floor (log2 (1.0 / ratio));
+  if (level <= 0)
+    return cairo_pattern_reference (pattern);
+
+  level_surface = goo_canvas_image_get_mip_level (surface, level);
+  if (level_surface == surface)
+    return cairo_pattern_reference (pattern);
+
+  /* Map the source surface's coordinates onto the smaller surface. */
+  cairo_matrix_init_scale (&scale_matrix,
+			   (gdouble) cairo_image_surface_get_width (level_surface)
+			   / cairo_image_surface_get_width (surface),
+			   (gdouble) cairo_image_surface_get_height (level_surface)
+			   / cairo_image_surface_get_height (surface));
+  cairo_matrix_multiply (&level_matrix, matrix, &scale_matrix);
+
+  level_pattern = cairo_pattern_create_for_surface (level_surface);
+  cairo_pattern_set_matrix (level_pattern, &level_matrix);
+  cairo_pattern_set_extend (level_pattern, cairo_pattern_get_extend (pattern));
+  cairo_pattern_set_filter (level_pattern, cairo_pattern_get_filter (pattern));
+
+  return level_pattern;
+}
+
+
 static void
 goo_canvas_image_paint (GooCanvasItemSimple   *simple,
 			cairo_t               *cr,
@@ -497,10 +698,24 @@ goo_canvas_image_paint (GooCanvasItemSimple   *simple,
   GooCanvasImageData *image_data = image->image_data;
   cairo_matrix_t matrix = { 1, 0, 0, 1, 0, 0 };
   cairo_surface_t *surface;
+  cairo_pattern_t *pattern;
   gdouble width, height;
 
   if (!image_data->pattern)
-    return;
+    {
+      /* If the image is still loading, paint a placeholder, using the fill
+	 pattern if one has been set. */
+      if (priv->loading)
+	{
+	  if (!goo_canvas_style_set_fill_options (simple->simple_data->style,
+						  cr))
+	    cairo_set_source_rgba (cr, 0.5, 0.5, 0.5, 0.25);
+	  cairo_rectangle (cr, image_data->x, image_data->y,
+			   image_data->width, image_data->height);
+	  cairo_fill (cr);
+	}
+      return;
+    }
 
   /* scale-to-fit means a simple scale, not keeping the aspect ratio.
      This does not need to consider the units used. */ 
@@ -533,7 +748,10 @@ goo_canvas_image_paint (GooCanvasItemSimple   *simple,
 
   cairo_pattern_set_matrix (image_data->pattern, &matrix);
   goo_canvas_style_set_fill_options (simple->simple_data->style, cr);
-  cairo_set_source (cr, image_data->pattern);
+  pattern = goo_canvas_image_get_paint_pattern (image_data->pattern, &matrix,
+						cr);
+  cairo_set_source (cr, pattern);
+  cairo_pattern_destroy (pattern);
   cairo_rectangle (cr, image_data->x, image_data->y,
 		   image_data->width, image_data->height);
   /* To have better performance, we don't use cairo_paint_with_alpha if
@@ -550,6 +768,299 @@ goo_canvas_image_paint (GooCanvasItemSimple   *simple,
 }
 
 
+/*
+ * Asynchronous loading. The image is decoded and converted to a cairo surface
+ * in a worker thread, and the placeholder is painted until it is done. This
+ * code is shared by the item and model.
+ */
+typedef struct _GooCanvasImageLoadData GooCanvasImageLoadData;
+struct _GooCanvasImageLoadData
+{
+  GFile *file;
+  GInputStream *stream;
+  guint serial;
+
+  /* The task used to report the result to the caller. */
+  GTask *result_task;
+};
+
+
+static void
+goo_canvas_image_load_data_free (gpointer data)
+{
+  GooCanvasImageLoadData *load_data = data;
+
+  if (load_data->file)
+    g_object_unref (load_data->file);
+  if (load_data->stream)
+    g_object_unref (load_data->stream);
+  if (load_data->result_task)
+    g_object_unref (load_data->result_task);
+
+  g_slice_free (GooCanvasImageLoadData, load_data);
+}
+
+
+static GooCanvasImageData*
+goo_canvas_image_get_image_data (GObject *object)
+{
+  if (GOO_IS_CANVAS_IMAGE (object))
+    return ((GooCanvasImage*) object)->image_data;
+  else
+    return &((GooCanvasImageModel*) object)->image_data;
+}
+
+
+static void
+goo_canvas_image_emit_changed (GObject  *object,
+			       gboolean  recompute_bounds)
+{
+  if (GOO_IS_CANVAS_IMAGE (object))
+    goo_canvas_item_simple_changed ((GooCanvasItemSimple*) object,
+				    recompute_bounds);
+  else
+    _goo_canvas_item_model_emit_changed ((GooCanvasItemModel*) object,
+					 recompute_bounds);
+}
+
+
+/* This runs in a worker thread. */
+static void
+goo_canvas_image_load_thread (GTask        *task,
+			      gpointer      source_object,
+			      gpointer      task_data,
+			      GCancellable *cancellable)
+{
+  GooCanvasImageLoadData *load_data = task_data;
+  GInputStream *stream;
+  cairo_surface_t *surface;
+  GdkPixbuf *pixbuf;
+  GError *error = NULL;
+
+  if (load_data->file)
+    stream = (GInputStream*) g_file_read (load_data->file, cancellable,
+					  &error);
+  else
+    stream = g_object_ref (load_data->stream);
+
+  if (!stream)
+    {
+      g_task_return_error (task, error);
+      return;
+    }
+
+  pixbuf = gdk_pixbuf_new_from_stream (stream, cancellable, &error);
+  g_object_unref (stream);
+
+  if (!pixbuf)
+    {
+      g_task_return_error (task, error);
+      return;
+    }
+
+  surface = goo_canvas_cairo_surface_from_pixbuf (pixbuf);
+  g_object_unref (pixbuf);
+
+  g_task_return_pointer (task, surface,
+			 (GDestroyNotify) cairo_surface_destroy);
+}
+
+
+/* This runs in the main thread when the worker thread has finished. */
+static void
+goo_canvas_image_load_done (GObject      *object,
+			    GAsyncResult *result,
+			    gpointer      user_data)
+{
+  GooCanvasImagePrivate *priv = goo_canvas_image_get_private (object);
+  GooCanvasImageLoadData *load_data = g_task_get_task_data (G_TASK (result));
+  GooCanvasImageData *image_data;
+  GTask *result_task = load_data->result_task;
+  cairo_surface_t *surface;
+  gboolean recompute_bounds = FALSE;
+  GError *error = NULL;
+
+  load_data->result_task = NULL;
+  surface = g_task_propagate_pointer (G_TASK (result), &error);
+
+  /* If another image has been set since the load started, drop this one. */
+  if (load_data->serial != priv->load_serial)
+    {
+      if (surface)
+	cairo_surface_destroy (surface);
+      g_clear_error (&error);
+      g_task_return_new_error (result_task, G_IO_ERROR, G_IO_ERROR_CANCELLED,
+			       "%s", _("The image was replaced before it finished loading"));
+      g_object_unref (result_task);
+      return;
+    }
+
+  priv->loading = FALSE;
+
+  if (!surface)
+    {
+      /* Remove the placeholder. */
+      goo_canvas_image_emit_changed (object, FALSE);
+      g_task_return_error (result_task, error);
+      g_object_unref (result_task);
+      return;
+    }
+
+  image_data = goo_canvas_image_get_image_data (object);
+  image_data->pattern = cairo_pattern_create_for_surface (surface);
+
+  /* If no size was set, use the image's natural size. Otherwise the image
+     replaces the placeholder exactly, so we only need to redraw it. */
+  if (image_data->width == 0.0 && image_data->height == 0.0)
+    {
+      image_data->width = cairo_image_surface_get_width (surface);
+      image_data->height = cairo_image_surface_get_height (surface);
+
+      if (GOO_IS_CANVAS_ITEM (object))
+	goo_canvas_image_convert_pixbuf_sizes (GOO_CANVAS_ITEM (object),
+					       image_data);
+      recompute_bounds = TRUE;
+    }
+  cairo_surface_destroy (surface);
+
+  goo_canvas_image_emit_changed (object, recompute_bounds);
+
+  g_task_return_boolean (result_task, TRUE);
+  g_object_unref (result_task);
+}
+
+
+static void
+goo_canvas_image_load_async (GObject             *object,
+			     GFile               *file,
+			     GInputStream        *stream,
+			     GCancellable        *cancellable,
+			     GAsyncReadyCallback  callback,
+			     gpointer             user_data)
+{
+  GooCanvasImagePrivate *priv = goo_canvas_image_get_private (object);
+  GooCanvasImageData *image_data = goo_canvas_image_get_image_data (object);
+  GooCanvasImageLoadData *load_data;
+  GTask *task;
+
+  load_data = g_slice_new0 (GooCanvasImageLoadData);
+  load_data->file = file ? g_object_ref (file) : NULL;
+  load_data->stream = stream ? g_object_ref (stream) : NULL;
+  load_data->serial = ++priv->load_serial;
+  load_data->result_task = g_task_new (object, cancellable, callback,
+				       user_data);
+  g_task_set_source_tag (load_data->result_task, goo_canvas_image_load_async);
+
+  /* Remove any existing image and show the placeholder instead. */
+  cairo_pattern_destroy (image_data->pattern);
+  image_data->pattern = NULL;
+  priv->loading = TRUE;
+  goo_canvas_image_emit_changed (object, FALSE);
+
+  task = g_task_new (object, cancellable, goo_canvas_image_load_done, NULL);
+  g_task_set_task_data (task, load_data, goo_canvas_image_load_data_free);
+  g_task_run_in_thread (task, goo_canvas_image_load_thread);
+  g_object_unref (task);
+}
+
+
+/**
+ * goo_canvas_image_load_file_async:
+ * @image: a #GooCanvasImage.
+ * @file: the image file to load.
+ * @cancellable: (allow-none): a #GCancellable, or %NULL.
+ * @callback: (scope async) (allow-none): a #GAsyncReadyCallback to call when
+ *  the image has been loaded, or %NULL.
+ * @user_data: (closure): the data to pass to @callback.
+ *
+ * Loads the image from the given file in a worker thread, so large images
+ * can be used without blocking the user interface. The file can be in any
+ * format supported by #GdkPixbuf.
+ *
+ * Until the image is loaded a placeholder is painted in its place, using
+ * the item's fill color or pattern if it has one, or a translucent grey.
+ * If the #GooCanvasImage:width and #GooCanvasImage:height properties have
+ * been set the placeholder has that size and the image keeps it when it is
+ * loaded. Otherwise the image is set to its natural size once it is loaded.
+ *
+ * Setting the #GooCanvasImage:pixbuf or #GooCanvasImage:pattern properties
+ * or starting another load before this one completes causes this one to be
+ * ignored.
+ *
+ * Since: 3.0
+ **/
+void
+goo_canvas_image_load_file_async (GooCanvasImage      *image,
+				  GFile               *file,
+				  GCancellable        *cancellable,
+				  GAsyncReadyCallback  callback,
+				  gpointer             user_data)
+{
+  g_return_if_fail (GOO_IS_CANVAS_IMAGE (image));
+  g_return_if_fail (G_IS_FILE (file));
+  g_return_if_fail (((GooCanvasItemSimple*) image)->model == NULL);
+
+  goo_canvas_image_load_async ((GObject*) image, file, NULL, cancellable,
+			       callback, user_data);
+}
+
+
+/**
+ * goo_canvas_image_load_stream_async:
+ * @image: a #GooCanvasImage.
+ * @stream: the #GInputStream to read the image from.
+ * @cancellable: (allow-none): a #GCancellable, or %NULL.
+ * @callback: (scope async) (allow-none): a #GAsyncReadyCallback to call when
+ *  the image has been loaded, or %NULL.
+ * @user_data: (closure): the data to pass to @callback.
+ *
+ * Loads the image from the given stream in a worker thread. The stream must
+ * not be used by anything else until the load has completed.
+ *
+ * See goo_canvas_image_load_file_async() for more details.
+ *
+ * Since: 3.0
+ **/
+void
+goo_canvas_image_load_stream_async (GooCanvasImage      *image,
+				    GInputStream        *stream,
+				    GCancellable        *cancellable,
+				    GAsyncReadyCallback  callback,
+				    gpointer             user_data)
+{
+  g_return_if_fail (GOO_IS_CANVAS_IMAGE (image));
+  g_return_if_fail (G_IS_INPUT_STREAM (stream));
+  g_return_if_fail (((GooCanvasItemSimple*) image)->model == NULL);
+
+  goo_canvas_image_load_async ((GObject*) image, NULL, stream, cancellable,
+			       callback, user_data);
+}
+
+
+/**
+ * goo_canvas_image_load_finish:
+ * @image: a #GooCanvasImage.
+ * @result: the #GAsyncResult passed to the callback.
+ * @error: return location for an error, or %NULL.
+ *
+ * Finishes loading an image started with goo_canvas_image_load_file_async()
+ * or goo_canvas_image_load_stream_async().
+ *
+ * Returns: %TRUE if the image was loaded.
+ *
+ * Since: 3.0
+ **/
+gboolean
+goo_canvas_image_load_finish (GooCanvasImage  *image,
+			      GAsyncResult    *result,
+			      GError         **error)
+{
+  g_return_val_if_fail (g_task_is_valid (result, image), FALSE);
+
+  return g_task_propagate_boolean (G_TASK (result), error);
+}
+
+
 static void
 goo_canvas_image_set_model    (GooCanvasItem      *item,
 			       GooCanvasItemModel *model)
@@ -617,6 +1128,10 @@ goo_canvas_image_class_init (GooCanvasImageClass *klass)
  * properties to set the desired size.
  * </para></note>
  *
+ * As with #GooCanvasImage, the surface converted from a "pixbuf" is shared,
+ * so goo_canvas_image_cache_invalidate() must be called after changing its
+ * pixels.
+ *
  * It is a subclass of #GooCanvasItemModelSimple and so inherits all of the
  * style properties such as "operator" and "pointer-events".
  *
@@ -793,7 +1308,93 @@ goo_canvas_image_model_set_property (GObject              *object,
 							   &imodel->image_data,
 							   prop_id,
 							   value, pspec);
-  g_signal_emit_by_name (imodel, "changed", recompute_bounds);
+  _goo_canvas_item_model_emit_changed ((GooCanvasItemModel*) imodel,
+				       recompute_bounds);
+}
+
+
+/**
+ * goo_canvas_image_model_load_file_async:
+ * @imodel: a #GooCanvasImageModel.
+ * @file: the image file to load.
+ * @cancellable: (allow-none): a #GCancellable, or %NULL.
+ * @callback: (scope async) (allow-none): a #GAsyncReadyCallback to call when
+ *  the image has been loaded, or %NULL.
+ * @user_data: (closure): the data to pass to @callback.
+ *
+ * Loads the image from the given file in a worker thread.
+ *
+ * See goo_canvas_image_load_file_async() for more details.
+ *
+ * Since: 3.0
+ **/
+void
+goo_canvas_image_model_load_file_async (GooCanvasImageModel *imodel,
+					GFile               *file,
+					GCancellable        *cancellable,
+					GAsyncReadyCallback  callback,
+					gpointer             user_data)
+{
+  g_return_if_fail (GOO_IS_CANVAS_IMAGE_MODEL (imodel));
+  g_return_if_fail (G_IS_FILE (file));
+
+  goo_canvas_image_load_async ((GObject*) imodel, file, NULL, cancellable,
+			       callback, user_data);
+}
+
+
+/**
+ * goo_canvas_image_model_load_stream_async:
+ * @imodel: a #GooCanvasImageModel.
+ * @stream: the #GInputStream to read the image from.
+ * @cancellable: (allow-none): a #GCancellable, or %NULL.
+ * @callback: (scope async) (allow-none): a #GAsyncReadyCallback to call when
+ *  the image has been loaded, or %NULL.
+ * @user_data: (closure): the data to pass to @callback.
+ *
+ * Loads the image from the given stream in a worker thread.
+ *
+ * See goo_canvas_image_load_file_async() for more details.
+ *
+ * Since: 3.0
+ **/
+void
+goo_canvas_image_model_load_stream_async (GooCanvasImageModel *imodel,
+					  GInputStream        *stream,
+					  GCancellable        *cancellable,
+					  GAsyncReadyCallback  callback,
+					  gpointer             user_data)
+{
+  g_return_if_fail (GOO_IS_CANVAS_IMAGE_MODEL (imodel));
+  g_return_if_fail (G_IS_INPUT_STREAM (stream));
+
+  goo_canvas_image_load_async ((GObject*) imodel, NULL, stream, cancellable,
+			       callback, user_data);
+}
+
+
+/**
+ * goo_canvas_image_model_load_finish:
+ * @imodel: a #GooCanvasImageModel.
+ * @result: the #GAsyncResult passed to the callback.
+ * @error: return location for an error, or %NULL.
+ *
+ * Finishes loading an image started with
+ * goo_canvas_image_model_load_file_async() or
+ * goo_canvas_image_model_load_stream_async().
+ *
+ * Returns: %TRUE if the image was loaded.
+ *
+ * Since: 3.0
+ **/
+gboolean
+goo_canvas_image_model_load_finish (GooCanvasImageModel  *imodel,
+				    GAsyncResult         *result,
+				    GError              **error)
+{
+  g_return_val_if_fail (g_task_is_valid (result, imodel), FALSE);
+
+  return g_task_propagate_boolean (G_TASK (result), error);
 }
 
 
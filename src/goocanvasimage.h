@@ -68,6 +68,20 @@ GooCanvasItem*      goo_canvas_image_new       (GooCanvasItem      *parent,
 						gdouble             y,
 						...);
 
+void                goo_canvas_image_load_file_async   (GooCanvasImage      *image,
+							GFile               *file,
+							GCancellable        *cancellable,
+							GAsyncReadyCallback  callback,
+							gpointer             user_data);
+void                goo_canvas_image_load_stream_async (GooCanvasImage      *image,
+							GInputStream        *stream,
+							GCancellable        *cancellable,
+							GAsyncReadyCallback  callback,
+							gpointer             user_data);
+gboolean            goo_canvas_image_load_finish       (GooCanvasImage      *image,
+							GAsyncResult        *result,
+							GError             **error);
+
 
 
 #define GOO_TYPE_CANVAS_IMAGE_MODEL            (goo_canvas_image_model_get_type ())
@@ -115,6 +129,20 @@ GooCanvasItemModel* goo_canvas_image_model_new (GooCanvasItemModel *parent,
 						gdouble             y,
 						...);
 
+void                goo_canvas_image_model_load_file_async   (GooCanvasImageModel *imodel,
+							      GFile               *file,
+							      GCancellable        *cancellable,
+							      GAsyncReadyCallback  callback,
+							      gpointer             user_data);
+void                goo_canvas_image_model_load_stream_async (GooCanvasImageModel *imodel,
+							      GInputStream        *stream,
+							      GCancellable        *cancellable,
+							      GAsyncReadyCallback  callback,
+							      gpointer             user_data);
+gboolean            goo_canvas_image_model_load_finish       (GooCanvasImageModel  *imodel,
+							      GAsyncResult         *result,
+							      GError              **error);
+
 
 G_END_DECLS
 
@@ -617,6 +617,52 @@ goo_canvas_item_add_child      (GooCanvasItem       *item,
 }
 
 
+/**
+ * goo_canvas_item_add_children:
+ * @item: the container to add the items to.
+ * @children: (array length=n_children): the items to add.
+ * @n_children: the number of items to add.
+ * @position: the position of the first item, or -1 to place them last (at
+ *  the top of the stacking order).
+ *
+ * Adds several child items to a container item, starting at the given stack
+ * position. The items keep their order in the array.
+ *
+ * This is equivalent to calling goo_canvas_item_add_child() for each item,
+ * but containers such as #GooCanvasGroup add all the items at once and only
+ * request a single update.
+ *
+ * Since: 3.0
+ **/
+void
+goo_canvas_item_add_children   (GooCanvasItem       *item,
+				GooCanvasItem      **children,
+				gint                 n_children,
+				gint                 position)
+{
+  GooCanvasItemIface *iface = GOO_CANVAS_ITEM_GET_IFACE (item);
+  gint i;
+
+  g_return_if_fail (iface->add_child != NULL);
+  g_return_if_fail (children != NULL || n_children == 0);
+
+  for (i = 0; i < n_children; i++)
+    g_return_if_fail (item != children[i]);
+
+  if (n_children <= 0)
+    return;
+
+  if (iface->add_children)
+    {
+      iface->add_children (item, children, n_children, position);
+      return;
+    }
+
+  for (i = 0; i < n_children; i++)
+    iface->add_child (item, children[i], position < 0 ? -1 : position + i);
+}
+
+
 /**
  * goo_canvas_item_move_child:
  * @item: a container item.
@@ -663,6 +709,9 @@ goo_canvas_item_remove_child   (GooCanvasItem       *item,
  * @child: the child item to find.
  * 
  * Attempts to find the given child item with the container's stack.
+ *
+ * Containers such as #GooCanvasGroup keep an index of their children, so
+ * this doesn't need to search through all of them.
  * 
  * Returns: the position of the given @child item, or -1 if it isn't found.
  **/
@@ -670,9 +719,13 @@ gint
 goo_canvas_item_find_child     (GooCanvasItem *item,
 				GooCanvasItem *child)
 {
+  GooCanvasItemIface *iface = GOO_CANVAS_ITEM_GET_IFACE (item);
   GooCanvasItem *tmp;
   int n_children, i;
 
+  if (iface->find_child)
+    return iface->find_child (item, child);
+
   /* Find the current position of item and above. */
   n_children = goo_canvas_item_get_n_children (item);
   for (i = 0; i < n_children; i++)
@@ -861,27 +914,20 @@ void
 goo_canvas_item_raise          (GooCanvasItem *item,
 				GooCanvasItem *above)
 {
-  GooCanvasItem *parent, *child;
-  int n_children, i, item_pos = -1, above_pos = -1;
+  GooCanvasItem *parent;
+  int item_pos, above_pos;
 
   parent = goo_canvas_item_get_parent (item);
   if (!parent || item == above)
     return;
 
-  /* Find the current position of item and above. */
-  n_children = goo_canvas_item_get_n_children (parent);
-  for (i = 0; i < n_children; i++)
-    {
-      child = goo_canvas_item_get_child (parent, i);
-      if (child == item)
-	item_pos = i;
-      if (child == above)
-	above_pos = i;
-    }
-
-  /* If above is NULL we raise the item to the top of the stack. */
-  if (!above)
-    above_pos = n_children - 1;
+  /* Find the current position of item and above. If above is NULL we raise
+     the item to the top of the stack. */
+  item_pos = goo_canvas_item_find_child (parent, item);
+  if (above)
+    above_pos = goo_canvas_item_find_child (parent, above);
+  else
+    above_pos = goo_canvas_item_get_n_children (parent) - 1;
 
   g_return_if_fail (item_pos != -1);
   g_return_if_fail (above_pos != -1);
@@ -904,27 +950,17 @@ void
 goo_canvas_item_lower          (GooCanvasItem *item,
 				GooCanvasItem *below)
 {
-  GooCanvasItem *parent, *child;
-  int n_children, i, item_pos = -1, below_pos = -1;
+  GooCanvasItem *parent;
+  int item_pos, below_pos;
 
   parent = goo_canvas_item_get_parent (item);
   if (!parent || item == below)
     return;
 
-  /* Find the current position of item and below. */
-  n_children = goo_canvas_item_get_n_children (parent);
-  for (i = 0; i < n_children; i++)
-    {
-      child = goo_canvas_item_get_child (parent, i);
-      if (child == item)
-	item_pos = i;
-      if (child == below)
-	below_pos = i;
-    }
-
-  /* If below is NULL we lower the item to the bottom of the stack. */
-  if (!below)
-    below_pos = 0;
+  /* Find the current position of item and below. If below is NULL we lower
+     the item to the bottom of the stack. */
+  item_pos = goo_canvas_item_find_child (parent, item);
+  below_pos = below ? goo_canvas_item_find_child (parent, below) : 0;
 
   g_return_if_fail (item_pos != -1);
   g_return_if_fail (below_pos != -1);
@@ -1289,6 +1325,10 @@ goo_canvas_item_animate_cb (GooCanvasItemAnimation *anim)
   gboolean keep_source = TRUE;
   gdouble scale;
   gint step;
+  gint64 trace_time = GOO_CANVAS_TRACE_TIME ();
+  /* The animation may be freed below, so we get the name now. */
+  const gchar *type_name G_GNUC_UNUSED = !trace_time ? NULL
+    : model ? G_OBJECT_TYPE_NAME (model) : G_OBJECT_TYPE_NAME (item);
 
   if (model)
     model_iface = GOO_CANVAS_ITEM_MODEL_GET_IFACE (model);
@@ -1366,6 +1406,8 @@ goo_canvas_item_animate_cb (GooCanvasItemAnimation *anim)
 	iface->set_transform (item, &new_matrix);
     }
 
+  GOO_CANVAS_TRACE_MARK (trace_time, "Animation tick", "%s", type_name);
+
   /* Return FALSE to remove the timeout handler when we are finished. */
   return keep_source;
 }
@@ -1698,8 +1740,18 @@ goo_canvas_item_update      (GooCanvasItem   *item,
 			     GooCanvasBounds *bounds)
 {
   GooCanvasItemIface *iface = GOO_CANVAS_ITEM_GET_IFACE (item);
+  GooCanvasProfile *profile = _goo_canvas_profile;
+  gint64 start_time, outer_child_time;
+
+  if (G_LIKELY (!profile))
+    {
+      iface->update (item, entire_tree, cr, bounds);
+      return;
+    }
 
+  start_time = goo_canvas_profile_begin (profile, &outer_child_time);
   iface->update (item, entire_tree, cr, bounds);
+  goo_canvas_profile_end (profile, item, FALSE, start_time, outer_child_time);
 }
 
 
@@ -1726,8 +1778,18 @@ goo_canvas_item_paint (GooCanvasItem         *item,
 		       gdouble                scale)
 {
   GooCanvasItemIface *iface = GOO_CANVAS_ITEM_GET_IFACE (item);
+  GooCanvasProfile *profile = _goo_canvas_profile;
+  gint64 start_time, outer_child_time;
+
+  if (G_LIKELY (!profile))
+    {
+      iface->paint (item, cr, bounds, scale);
+      return;
+    }
 
+  start_time = goo_canvas_profile_begin (profile, &outer_child_time);
   iface->paint (item, cr, bounds, scale);
+  goo_canvas_profile_end (profile, item, TRUE, start_time, outer_child_time);
 }
 
 
@@ -84,6 +84,11 @@ typedef struct _GooCanvasItem       GooCanvasItem;
  * @get_child: returns the child at the given index.
  * @request_update: requests that an update is scheduled.
  * @add_child: adds a child.
+ * @add_children: adds several children at once. If this is %NULL, add_child()
+ *  is called for each child. Since 3.0.
+ * @find_child: returns the position of the given child, or -1. If this is
+ *  %NULL the children are searched using get_n_children() and get_child().
+ *  Since 3.0.
  * @move_child: moves a child up or down the stacking order.
  * @remove_child: removes a child.
  * @get_child_property: gets a child property of a given child item,
@@ -302,12 +307,17 @@ struct _GooCanvasItemIface
 							 gdouble		 width,
 							 GooCanvasBounds	*requested_area);
 
+  void			(* add_children)		(GooCanvasItem		*item,
+							 GooCanvasItem	       **children,
+							 gint			 n_children,
+							 gint			 position);
+  gint			(* find_child)			(GooCanvasItem		*item,
+							 GooCanvasItem		*child);
+
   /*< private >*/
 
   /* Padding for future expansion */
   void (*_goo_canvas_reserved1) (void);
-  void (*_goo_canvas_reserved2) (void);
-  void (*_goo_canvas_reserved3) (void);
 };
 
 
@@ -325,6 +335,10 @@ gint               goo_canvas_item_find_child     (GooCanvasItem   *item,
 void               goo_canvas_item_add_child      (GooCanvasItem   *item,
 						   GooCanvasItem   *child,
 						   gint             position);
+void               goo_canvas_item_add_children   (GooCanvasItem   *item,
+						   GooCanvasItem  **children,
+						   gint             n_children,
+						   gint             position);
 void               goo_canvas_item_move_child     (GooCanvasItem   *item,
 						   gint             old_position,
 						   gint             new_position);
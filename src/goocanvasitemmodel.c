@@ -34,12 +34,42 @@
 static GParamSpecPool       *_goo_canvas_item_model_child_property_pool = NULL;
 static GObjectNotifyContext *_goo_canvas_item_model_child_property_notify_context = NULL;
 static const char *animation_key = "GooCanvasItemAnimation";
+static const char *changes_key = "GooCanvasItemModelChanges";
+static const char *batches_key = "GooCanvasItemModelBatches";
+
+/* The number of batches of changes active in all model trees, so changes
+   don't need to look for the root model when there are none. */
+static gint n_active_batches = 0;
+
+/* This holds a batch of changes, started with
+   goo_canvas_item_model_begin_changes(). It is attached to the model the
+   batch was started on, and holds the changes to it and its descendants. */
+typedef struct _GooCanvasItemModelChanges GooCanvasItemModelChanges;
+struct _GooCanvasItemModelChanges
+{
+  /* The number of begin_changes() calls without a matching end_changes(). */
+  gint depth;
+
+  /* The models that have changed, in the order they first changed. We hold a
+     ref on each of them until the batch ends. */
+  GPtrArray *models;
+
+  /* Maps each changed model to 1, or 2 if its bounds need recomputing. */
+  GHashTable *flags;
+
+  /* The root of the model's tree when the batch started. The number of
+     batches in progress in each tree is attached to its root, so we don't
+     have to look for a batch when a model changes in a tree without any. */
+  GooCanvasItemModel *root;
+};
 
 enum {
   CHILD_ADDED,
   CHILD_MOVED,
   CHILD_REMOVED,
   CHANGED,
+  CHILDREN_ADDED,
+  CHANGES_BATCHED,
 
   CHILD_NOTIFY,
   ANIMATION_FINISHED,
@@ -131,6 +161,30 @@ goo_canvas_item_model_base_init (gpointer g_iface)
 		      G_TYPE_NONE, 1,
 		      G_TYPE_INT);
 
+      /**
+       * GooCanvasItemModel::children-added:
+       * @model: the item model that received the signal.
+       * @child_num: the index of the first new child.
+       * @n_children: the number of children added.
+       *
+       * Emitted when several children have been added at once with
+       * goo_canvas_item_model_add_children(), so they can be handled in one
+       * pass. It replaces the #GooCanvasItemModel::child-added signal, which
+       * isn't emitted for each of the children, so code which tracks the
+       * children of a model should connect to both signals.
+       *
+       * Since: 3.0
+       */
+      item_model_signals[CHILDREN_ADDED] =
+	g_signal_new ("children-added",
+		      iface_type,
+		      G_SIGNAL_RUN_LAST,
+		      G_STRUCT_OFFSET (GooCanvasItemModelIface, children_added),
+		      NULL, NULL,
+		      goo_canvas_marshal_VOID__INT_INT,
+		      G_TYPE_NONE, 2,
+		      G_TYPE_INT, G_TYPE_INT);
+
       /**
        * GooCanvasItemModel::child-moved:
        * @model: the item model that received the signal.
@@ -183,6 +237,30 @@ goo_canvas_item_model_base_init (gpointer g_iface)
 		      G_TYPE_NONE, 1,
 		      G_TYPE_BOOLEAN);
 
+      /**
+       * GooCanvasItemModel::changes-batched:
+       * @model: the item model that received the signal.
+       * @models: (element-type GooCanvasItemModel): the models that changed
+       *  during the batch, in the order they first changed.
+       *
+       * Emitted on the model passed to goo_canvas_item_model_begin_changes()
+       * when the batch of changes ends, after the #GooCanvasItemModel::changed
+       * signal has been emitted on each of the changed models. It is not
+       * emitted if nothing changed, or if the batch was inside a batch
+       * started on one of the model's ancestors.
+       *
+       * Since: 3.0
+       */
+      item_model_signals[CHANGES_BATCHED] =
+	g_signal_new ("changes-batched",
+		      iface_type,
+		      G_SIGNAL_RUN_LAST,
+		      G_STRUCT_OFFSET (GooCanvasItemModelIface, changes_batched),
+		      NULL, NULL,
+		      g_cclosure_marshal_VOID__BOXED,
+		      G_TYPE_NONE, 1,
+		      G_TYPE_PTR_ARRAY);
+
       /**
        * GooCanvasItemModel::child-notify:
        * @item: the item model that received the signal.
@@ -316,6 +394,54 @@ goo_canvas_item_model_add_child      (GooCanvasItemModel  *model,
 }
 
 
+/**
+ * goo_canvas_item_model_add_children:
+ * @model: an item model.
+ * @children: (array length=n_children): the children to add.
+ * @n_children: the number of children to add.
+ * @position: the position of the first child, or -1 to place them last (at
+ *  the top of the stacking order).
+ *
+ * Adds several children, starting at the given stack position. The children
+ * keep their order in the array.
+ *
+ * Models which implement the add_children() method, such as
+ * #GooCanvasGroupModel, emit a single #GooCanvasItemModel::children-added
+ * signal instead of the #GooCanvasItemModel::child-added signal for each
+ * child, so canvas items viewing the model can create the new items in one
+ * pass. Other models emit #GooCanvasItemModel::child-added for each child.
+ *
+ * Since: 3.0
+ **/
+void
+goo_canvas_item_model_add_children   (GooCanvasItemModel  *model,
+				      GooCanvasItemModel **children,
+				      gint                 n_children,
+				      gint                 position)
+{
+  GooCanvasItemModelIface *iface = GOO_CANVAS_ITEM_MODEL_GET_IFACE (model);
+  gint i;
+
+  g_return_if_fail (iface->add_child != NULL);
+  g_return_if_fail (children != NULL || n_children == 0);
+
+  for (i = 0; i < n_children; i++)
+    g_return_if_fail (model != children[i]);
+
+  if (n_children <= 0)
+    return;
+
+  if (iface->add_children)
+    {
+      iface->add_children (model, children, n_children, position);
+      return;
+    }
+
+  for (i = 0; i < n_children; i++)
+    iface->add_child (model, children[i], position < 0 ? -1 : position + i);
+}
+
+
 /**
  * goo_canvas_item_model_move_child:
  * @model: an item model.
@@ -362,6 +488,9 @@ goo_canvas_item_model_remove_child   (GooCanvasItemModel  *model,
  * @child: the child to find.
  * 
  * Attempts to find the given child with the container's stack.
+ *
+ * Containers such as #GooCanvasGroupModel keep an index of their children,
+ * so this doesn't need to search through all of them.
  * 
  * Returns: the position of the given @child, or -1 if it isn't found.
  **/
@@ -369,9 +498,13 @@ gint
 goo_canvas_item_model_find_child     (GooCanvasItemModel *model,
 				      GooCanvasItemModel *child)
 {
+  GooCanvasItemModelIface *iface = GOO_CANVAS_ITEM_MODEL_GET_IFACE (model);
   GooCanvasItemModel *item;
   int n_children, i;
 
+  if (iface->find_child)
+    return iface->find_child (model, child);
+
   /* Find the current position of item and above. */
   n_children = goo_canvas_item_model_get_n_children (model);
   for (i = 0; i < n_children; i++)
@@ -515,27 +648,20 @@ void
 goo_canvas_item_model_raise          (GooCanvasItemModel *model,
 				      GooCanvasItemModel *above)
 {
-  GooCanvasItemModel *parent, *child;
-  int n_children, i, model_pos = -1, above_pos = -1;
+  GooCanvasItemModel *parent;
+  int model_pos, above_pos;
 
   parent = goo_canvas_item_model_get_parent (model);
   if (!parent || model == above)
     return;
 
-  /* Find the current position of model and above. */
-  n_children = goo_canvas_item_model_get_n_children (parent);
-  for (i = 0; i < n_children; i++)
-    {
-      child = goo_canvas_item_model_get_child (parent, i);
-      if (child == model)
-	model_pos = i;
-      if (child == above)
-	above_pos = i;
-    }
-
-  /* If above is NULL we raise the model to the top of the stack. */
-  if (!above)
-    above_pos = n_children - 1;
+  /* Find the current position of model and above. If above is NULL we raise
+     the model to the top of the stack. */
+  model_pos = goo_canvas_item_model_find_child (parent, model);
+  if (above)
+    above_pos = goo_canvas_item_model_find_child (parent, above);
+  else
+    above_pos = goo_canvas_item_model_get_n_children (parent) - 1;
 
   g_return_if_fail (model_pos != -1);
   g_return_if_fail (above_pos != -1);
@@ -558,27 +684,17 @@ void
 goo_canvas_item_model_lower          (GooCanvasItemModel *model,
 				      GooCanvasItemModel *below)
 {
-  GooCanvasItemModel *parent, *child;
-  int n_children, i, model_pos = -1, below_pos = -1;
+  GooCanvasItemModel *parent;
+  int model_pos, below_pos;
 
   parent = goo_canvas_item_model_get_parent (model);
   if (!parent || model == below)
     return;
 
-  /* Find the current position of model and below. */
-  n_children = goo_canvas_item_model_get_n_children (parent);
-  for (i = 0; i < n_children; i++)
-    {
-      child = goo_canvas_item_model_get_child (parent, i);
-      if (child == model)
-	model_pos = i;
-      if (child == below)
-	below_pos = i;
-    }
-
-  /* If below is NULL we lower the model to the bottom of the stack. */
-  if (!below)
-    below_pos = 0;
+  /* Find the current position of model and below. If below is NULL we lower
+     the model to the bottom of the stack. */
+  model_pos = goo_canvas_item_model_find_child (parent, model);
+  below_pos = below ? goo_canvas_item_model_find_child (parent, below) : 0;
 
   g_return_if_fail (model_pos != -1);
   g_return_if_fail (below_pos != -1);
@@ -589,6 +705,172 @@ goo_canvas_item_model_lower          (GooCanvasItemModel *model,
 }
 
 
+static GooCanvasItemModel*
+goo_canvas_item_model_get_root (GooCanvasItemModel *model)
+{
+  GooCanvasItemModel *parent;
+
+  while ((parent = goo_canvas_item_model_get_parent (model)))
+    model = parent;
+
+  return model;
+}
+
+
+static void
+goo_canvas_item_model_add_batches (GooCanvasItemModel *root,
+				   gint                n_batches)
+{
+  n_active_batches += n_batches;
+  n_batches += GPOINTER_TO_INT (g_object_get_data (G_OBJECT (root),
+						   batches_key));
+  g_object_set_data (G_OBJECT (root), batches_key,
+		     GINT_TO_POINTER (n_batches));
+}
+
+
+static GooCanvasItemModelChanges*
+goo_canvas_item_model_find_changes (GooCanvasItemModel *model)
+{
+  GooCanvasItemModelChanges *changes;
+
+  while (model)
+    {
+      changes = g_object_get_data (G_OBJECT (model), changes_key);
+      if (changes)
+	return changes;
+      model = goo_canvas_item_model_get_parent (model);
+    }
+
+  return NULL;
+}
+
+
+static void
+goo_canvas_item_model_record_change (GooCanvasItemModelChanges *changes,
+				     GooCanvasItemModel        *model,
+				     gint                       flags)
+{
+  gint old_flags;
+
+  old_flags = GPOINTER_TO_INT (g_hash_table_lookup (changes->flags, model));
+  if (!old_flags)
+    g_ptr_array_add (changes->models, g_object_ref (model));
+  if (flags > old_flags)
+    g_hash_table_insert (changes->flags, model, GINT_TO_POINTER (flags));
+}
+
+
+/**
+ * goo_canvas_item_model_begin_changes:
+ * @model: an item model.
+ * 
+ * Starts a batch of changes to the model and all of its descendants.
+ *
+ * Until the matching call to goo_canvas_item_model_end_changes(), the
+ * #GooCanvasItemModel::changed signal is not emitted when properties of the
+ * models are set. Instead it is emitted once for each model that changed when
+ * the batch ends, so the views only need to handle each change once.
+ *
+ * Calls may be nested. If a batch is started on a model whose ancestor is
+ * already batching changes, the changes are passed on to the ancestor's
+ * batch when the inner batch ends.
+ *
+ * If a model is moved to another tree of models during a batch, its changes
+ * are no longer batched.
+ *
+ * Since: 3.0
+ **/
+void
+goo_canvas_item_model_begin_changes  (GooCanvasItemModel *model)
+{
+  GooCanvasItemModelChanges *changes;
+
+  g_return_if_fail (GOO_IS_CANVAS_ITEM_MODEL (model));
+
+  changes = g_object_get_data (G_OBJECT (model), changes_key);
+  if (!changes)
+    {
+      changes = g_slice_new (GooCanvasItemModelChanges);
+      changes->depth = 0;
+      changes->models = g_ptr_array_new ();
+      changes->flags = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+      changes->root = g_object_ref (goo_canvas_item_model_get_root (model));
+      goo_canvas_item_model_add_batches (changes->root, 1);
+
+      /* Keep the model alive until the batch ends. */
+      g_object_ref (model);
+      g_object_set_data (G_OBJECT (model), changes_key, changes);
+    }
+
+  changes->depth++;
+}
+
+
+/**
+ * goo_canvas_item_model_end_changes:
+ * @model: an item model.
+ * 
+ * Ends a batch of changes started with goo_canvas_item_model_begin_changes().
+ *
+ * When the outermost batch ends the #GooCanvasItemModel::changed signal is
+ * emitted once on each model that changed, with @recompute_bounds set if
+ * any of its changes needed the bounds to be recomputed. The
+ * #GooCanvasItemModel::changes-batched signal is then emitted on @model.
+ *
+ * Since: 3.0
+ **/
+void
+goo_canvas_item_model_end_changes    (GooCanvasItemModel *model)
+{
+  GooCanvasItemModelChanges *changes, *outer_changes;
+  GooCanvasItemModel *changed_model;
+  gint flags;
+  guint i;
+
+  g_return_if_fail (GOO_IS_CANVAS_ITEM_MODEL (model));
+
+  changes = g_object_get_data (G_OBJECT (model), changes_key);
+  g_return_if_fail (changes != NULL);
+
+  if (--changes->depth > 0)
+    return;
+
+  g_object_steal_data (G_OBJECT (model), changes_key);
+  goo_canvas_item_model_add_batches (changes->root, -1);
+
+  /* If an ancestor is batching changes as well, we hand the changes on to
+     it. Otherwise we emit them now. */
+  outer_changes = goo_canvas_item_model_find_changes (goo_canvas_item_model_get_parent (model));
+
+  for (i = 0; i < changes->models->len; i++)
+    {
+      changed_model = changes->models->pdata[i];
+      flags = GPOINTER_TO_INT (g_hash_table_lookup (changes->flags,
+						    changed_model));
+      if (outer_changes)
+	goo_canvas_item_model_record_change (outer_changes, changed_model,
+					     flags);
+      else
+	g_signal_emit (changed_model, item_model_signals[CHANGED], 0,
+		       flags == 2);
+    }
+
+  if (!outer_changes && changes->models->len > 0)
+    g_signal_emit (model, item_model_signals[CHANGES_BATCHED], 0,
+		   changes->models);
+
+  g_ptr_array_foreach (changes->models, (GFunc) g_object_unref, NULL);
+  g_ptr_array_free (changes->models, TRUE);
+  g_hash_table_destroy (changes->flags);
+  g_object_unref (changes->root);
+  g_slice_free (GooCanvasItemModelChanges, changes);
+
+  g_object_unref (model);
+}
+
+
 /**
  * goo_canvas_item_model_get_transform:
  * @model: an item model.
@@ -608,6 +890,39 @@ goo_canvas_item_model_get_transform  (GooCanvasItemModel *model,
 }
 
 
+/**
+ * goo_canvas_item_model_get_bounds:
+ * @model: an item model.
+ * @bounds: (out): the place to store the bounds.
+ *
+ * Gets the bounds of an item model, if they are known without creating a
+ * canvas item to view it. The bounds are in the model's own coordinate
+ * space, i.e. the model's transform has not been applied.
+ *
+ * Only models which implement the get_bounds() method can provide their
+ * bounds. For #GooCanvasGroupModel this is when the #GooCanvasGroupModel:width
+ * and #GooCanvasGroupModel:height properties are set, since the group is
+ * clipped to that area.
+ *
+ * Returns: %TRUE if the bounds are known.
+ *
+ * Since: 3.0
+ **/
+gboolean
+goo_canvas_item_model_get_bounds     (GooCanvasItemModel *model,
+				      GooCanvasBounds    *bounds)
+{
+  GooCanvasItemModelIface *iface;
+
+  g_return_val_if_fail (GOO_IS_CANVAS_ITEM_MODEL (model), FALSE);
+  g_return_val_if_fail (bounds != NULL, FALSE);
+
+  iface = GOO_CANVAS_ITEM_MODEL_GET_IFACE (model);
+
+  return iface->get_bounds ? iface->get_bounds (model, bounds) : FALSE;
+}
+
+
 /**
  * goo_canvas_item_model_set_transform:
  * @model: an item model.
@@ -1181,9 +1496,35 @@ _goo_canvas_item_model_emit_child_added (GooCanvasItemModel *model,
 }
 
 
+void
+_goo_canvas_item_model_emit_children_added (GooCanvasItemModel *model,
+					    gint                position,
+					    gint                n_children)
+{
+  g_signal_emit (model, item_model_signals[CHILDREN_ADDED], 0, position,
+		 n_children);
+}
+
+
 void
 _goo_canvas_item_model_emit_changed (GooCanvasItemModel *model,
 				     gboolean            recompute_bounds)
 {
+  GooCanvasItemModelChanges *changes;
+
+  /* If the model is part of a batch of changes, just record the change. */
+  if (n_active_batches > 0
+      && g_object_get_data (G_OBJECT (goo_canvas_item_model_get_root (model)),
+			    batches_key))
+    {
+      changes = goo_canvas_item_model_find_changes (model);
+      if (changes)
+	{
+	  goo_canvas_item_model_record_change (changes, model,
+					       recompute_bounds ? 2 : 1);
+	  return;
+	}
+    }
+
   g_signal_emit (model, item_model_signals[CHANGED], 0, recompute_bounds);
 }
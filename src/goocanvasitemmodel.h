@@ -55,6 +55,17 @@ G_BEGIN_DECLS
  * @changed: signal emitted when the model has changed.
  * @child_notify: signal emitted when a child property has changed.
  * @animation_finished: signal emitted when the model's animation has finished.
+ * @get_bounds: gets the bounds of the model, if they are known without
+ *  creating a canvas item to view it. Since 3.0.
+ * @add_children: adds several children at once. If this is %NULL, add_child()
+ *  is called for each child. Since 3.0.
+ * @children_added: signal emitted when several children are added at once.
+ *  Since 3.0.
+ * @find_child: returns the position of the given child, or -1. If this is
+ *  %NULL the children are searched using get_n_children() and get_child().
+ *  Since 3.0.
+ * @changes_batched: signal emitted when a batch of changes started with
+ *  goo_canvas_item_model_begin_changes() has ended. Since 3.0.
  *
  * #GooCanvasItemModelIFace holds the virtual methods that make up the
  * #GooCanvasItemModel interface.
@@ -66,6 +77,10 @@ G_BEGIN_DECLS
  * set_transform(). Items that support styles should implement get_style()
  * and set_style().
  *
+ * Container models whose bounds are known in advance may implement
+ * get_bounds(), so canvases with the #GooCanvas:lazy-views property set can
+ * avoid creating items for their children until they are visible.
+ *
  * Container items must implement get_n_children() and get_child().
  * Containers that support dynamic changes to their children should implement
  * add_child(), move_child() and remove_child().
@@ -138,16 +153,32 @@ struct _GooCanvasItemModelIface
   void		       (* animation_finished)		(GooCanvasItemModel     *model,
 							 gboolean                stopped);
 
+  /* Virtual methods that item models may implement. */
+  gboolean             (* get_bounds)			(GooCanvasItemModel	*model,
+							 GooCanvasBounds	*bounds);
+  void                 (* add_children)			(GooCanvasItemModel	*model,
+							 GooCanvasItemModel    **children,
+							 gint			 n_children,
+							 gint			 position);
+
+  /* Signals. */
+  void                 (* children_added)		(GooCanvasItemModel	*model,
+							 gint			 child_num,
+							 gint			 n_children);
+
+  /* Virtual methods that group models may implement. */
+  gint                 (* find_child)			(GooCanvasItemModel	*model,
+							 GooCanvasItemModel	*child);
+
+  /* Signals. */
+  void                 (* changes_batched)		(GooCanvasItemModel	*model,
+							 GPtrArray		*models);
+
   /*< private >*/
 
   /* Padding for future expansion */
   void (*_goo_canvas_reserved1) (void);
   void (*_goo_canvas_reserved2) (void);
-  void (*_goo_canvas_reserved3) (void);
-  void (*_goo_canvas_reserved4) (void);
-  void (*_goo_canvas_reserved5) (void);
-  void (*_goo_canvas_reserved6) (void);
-  void (*_goo_canvas_reserved7) (void);
 };
 
 
@@ -163,6 +194,10 @@ GooCanvasItemModel* goo_canvas_item_model_get_child      (GooCanvasItemModel *mo
 void                goo_canvas_item_model_add_child      (GooCanvasItemModel *model,
 							  GooCanvasItemModel *child,
 							  gint                position);
+void                goo_canvas_item_model_add_children   (GooCanvasItemModel  *model,
+							  GooCanvasItemModel **children,
+							  gint                 n_children,
+							  gint                 position);
 void                goo_canvas_item_model_move_child     (GooCanvasItemModel *model,
 							  gint                old_position,
 							  gint                new_position);
@@ -207,8 +242,13 @@ void                goo_canvas_item_model_raise          (GooCanvasItemModel *mo
 void                goo_canvas_item_model_lower          (GooCanvasItemModel *model,
 							  GooCanvasItemModel *below);
 
+void                goo_canvas_item_model_begin_changes  (GooCanvasItemModel *model);
+void                goo_canvas_item_model_end_changes    (GooCanvasItemModel *model);
+
 gboolean            goo_canvas_item_model_get_transform  (GooCanvasItemModel *model,
 							  cairo_matrix_t     *transform);
+gboolean            goo_canvas_item_model_get_bounds     (GooCanvasItemModel *model,
+							  GooCanvasBounds    *bounds);
 void                goo_canvas_item_model_set_transform  (GooCanvasItemModel   *model,
 							  const cairo_matrix_t *transform);
 gboolean	    goo_canvas_item_model_get_simple_transform (GooCanvasItemModel *model,
@@ -442,8 +442,11 @@ goo_canvas_item_simple_dispose (GObject *object)
 {
   GooCanvasItemSimple *simple = (GooCanvasItemSimple*) object;
 
-  /* Remove the view from the GooCanvas hash table. */
-  if (simple->canvas && simple->model)
+  /* Remove the view from the GooCanvas hash table, unless it has been
+     released by a lazily-created group and replaced by another item. */
+  if (simple->canvas && simple->model && simple->canvas->model_to_item
+      && g_hash_table_lookup (simple->canvas->model_to_item,
+			      simple->model) == simple)
     goo_canvas_unregister_item (simple->canvas,
 				(GooCanvasItemModel*) simple->model);
 
@@ -1049,7 +1052,7 @@ goo_canvas_item_simple_get_items_at (GooCanvasItem  *item,
 	  && (!parent_visible
 	      || simple_data->visibility <= GOO_CANVAS_ITEM_INVISIBLE
 	      || (simple_data->visibility == GOO_CANVAS_ITEM_VISIBLE_ABOVE_THRESHOLD
-		  && simple->canvas->scale < simple_data->visibility_threshold)))
+		  && goo_canvas_get_hit_test_scale (simple->canvas, cr) < simple_data->visibility_threshold)))
 	return found_items;
     }
 
@@ -1067,15 +1070,15 @@ goo_canvas_item_simple_get_items_at (GooCanvasItem  *item,
   /* If the item has a clip path, check if the point is inside it. */
   if (simple_data->clip_path_commands)
     {
-      goo_canvas_create_path (simple_data->clip_path_commands, cr);
-      cairo_set_fill_rule (cr, simple_data->clip_fill_rule);
-      if (!cairo_in_fill (cr, user_x, user_y))
+      if (!goo_canvas_item_simple_data_in_clip (simple_data, cr,
+						user_x, user_y))
 	{
 	  cairo_restore (cr);
 	  return found_items;
 	}
     }
 
+  GOO_CANVAS_COUNT (hit_tests);
   add_item = class->simple_is_item_at (simple, user_x, user_y, cr,
                                        is_pointer_event);
 
@@ -1105,6 +1108,7 @@ goo_canvas_item_simple_default_is_item_at (GooCanvasItemSimple *simple,
 
   /* Use the virtual method subclasses define to create the path. */
   class->simple_create_path (simple, cr);
+  GOO_CANVAS_COUNT (paths_created);
 
   if (goo_canvas_item_simple_check_in_path (simple, x, y, cr, pointer_events))
     return TRUE;
@@ -1201,6 +1205,7 @@ goo_canvas_item_simple_update_internal  (GooCanvasItemSimple *simple,
   cairo_matrix_t transform;
 
   simple->need_update = FALSE;
+  GOO_CANVAS_COUNT (items_updated);
 
   goo_canvas_item_simple_check_style (simple);
 
@@ -1212,10 +1217,8 @@ goo_canvas_item_simple_update_internal  (GooCanvasItemSimple *simple,
   if (simple_data->clip_path_commands)
     {
       cairo_identity_matrix (cr);
-      goo_canvas_create_path (simple_data->clip_path_commands, cr);
-      cairo_set_fill_rule (cr, simple_data->clip_fill_rule);
-      cairo_fill_extents (cr, &tmp_bounds.x1, &tmp_bounds.y1,
-			  &tmp_bounds.x2, &tmp_bounds.y2);
+      goo_canvas_item_simple_data_get_clip_extents (simple_data, cr,
+						    &tmp_bounds);
       simple->bounds.x1 = MAX (simple->bounds.x1, tmp_bounds.x1);
       simple->bounds.y1 = MAX (simple->bounds.y1, tmp_bounds.y1);
       simple->bounds.x2 = MIN (simple->bounds.x2, tmp_bounds.x2);
@@ -1241,6 +1244,7 @@ goo_canvas_item_simple_default_update (GooCanvasItemSimple   *simple,
   cairo_identity_matrix (cr);
 
   class->simple_create_path (simple, cr);
+  GOO_CANVAS_COUNT (paths_created);
   goo_canvas_item_simple_get_path_bounds (simple, cr, &simple->bounds);
 }
 
@@ -1394,6 +1398,69 @@ goo_canvas_item_simple_allocate_area      (GooCanvasItem         *item,
 }
 
 
+/* Sets the cairo clip to the item's clip path. Rectangles are set with
+   cairo_rectangle(), which cairo handles as a fast region clip. They are
+   recognized each time, which only looks at a few commands, rather than
+   keeping the rectangle in the public GooCanvasItemSimpleData. */
+void
+goo_canvas_item_simple_data_clip (GooCanvasItemSimpleData *simple_data,
+				  cairo_t                 *cr)
+{
+  GooCanvasBounds rect;
+
+  if (goo_canvas_path_get_rectangle (simple_data->clip_path_commands, &rect))
+    {
+      cairo_new_path (cr);
+      cairo_rectangle (cr, rect.x1, rect.y1,
+		       rect.x2 - rect.x1, rect.y2 - rect.y1);
+    }
+  else
+    {
+      goo_canvas_create_path (simple_data->clip_path_commands, cr);
+      GOO_CANVAS_COUNT (paths_created);
+      cairo_set_fill_rule (cr, simple_data->clip_fill_rule);
+    }
+
+  cairo_clip (cr);
+}
+
+
+/* Returns TRUE if the point, in user space, is inside the item's clip path. */
+gboolean
+goo_canvas_item_simple_data_in_clip (GooCanvasItemSimpleData *simple_data,
+				     cairo_t                 *cr,
+				     gdouble                  x,
+				     gdouble                  y)
+{
+  GooCanvasBounds rect;
+
+  if (goo_canvas_path_get_rectangle (simple_data->clip_path_commands, &rect))
+    return x >= rect.x1 && x <= rect.x2 && y >= rect.y1 && y <= rect.y2;
+
+  goo_canvas_create_path (simple_data->clip_path_commands, cr);
+  GOO_CANVAS_COUNT (paths_created);
+  cairo_set_fill_rule (cr, simple_data->clip_fill_rule);
+  return cairo_in_fill (cr, x, y);
+}
+
+
+/* Gets the extents of the item's clip path, in user space. */
+void
+goo_canvas_item_simple_data_get_clip_extents (GooCanvasItemSimpleData *simple_data,
+					      cairo_t                 *cr,
+					      GooCanvasBounds         *extents)
+{
+  if (goo_canvas_path_get_rectangle (simple_data->clip_path_commands, extents))
+    return;
+
+  goo_canvas_create_path (simple_data->clip_path_commands, cr);
+  GOO_CANVAS_COUNT (paths_created);
+  cairo_set_fill_rule (cr, simple_data->clip_fill_rule);
+  cairo_fill_extents (cr, &extents->x1, &extents->y1,
+		      &extents->x2, &extents->y2);
+}
+
+
 static void
 goo_canvas_item_simple_paint (GooCanvasItem         *item,
 			      cairo_t               *cr,
@@ -1403,11 +1470,15 @@ goo_canvas_item_simple_paint (GooCanvasItem         *item,
   GooCanvasItemSimpleClass *class = GOO_CANVAS_ITEM_SIMPLE_GET_CLASS (item);
   GooCanvasItemSimple *simple = (GooCanvasItemSimple*) item;
   GooCanvasItemSimpleData *simple_data = simple->simple_data;
+  gint64 trace_time;
 
   /* Skip the item if the bounds don't intersect the expose rectangle. */
   if (simple->bounds.x1 > bounds->x2 || simple->bounds.x2 < bounds->x1
       || simple->bounds.y1 > bounds->y2 || simple->bounds.y2 < bounds->y1)
-    return;
+    {
+      GOO_CANVAS_COUNT (items_culled);
+      return;
+    }
 
   /* Check if the item should be visible. */
   if (simple_data->visibility <= GOO_CANVAS_ITEM_INVISIBLE
@@ -1415,21 +1486,23 @@ goo_canvas_item_simple_paint (GooCanvasItem         *item,
 	  && scale < simple_data->visibility_threshold))
     return;
 
+  GOO_CANVAS_COUNT (items_painted);
+  trace_time = GOO_CANVAS_TRACE_TIME ();
+
   cairo_save (cr);
   if (simple_data->transform)
     cairo_transform (cr, simple_data->transform);
 
   /* Clip with the item's clip path, if it is set. */
   if (simple_data->clip_path_commands)
-    {
-      goo_canvas_create_path (simple_data->clip_path_commands, cr);
-      cairo_set_fill_rule (cr, simple_data->clip_fill_rule);
-      cairo_clip (cr);
-    }
+    goo_canvas_item_simple_data_clip (simple_data, cr);
 
   class->simple_paint (simple, cr, bounds);
 
   cairo_restore (cr);
+
+  GOO_CANVAS_TRACE_SLOW_MARK (trace_time, "Paint item", "%s",
+			      G_OBJECT_TYPE_NAME (item));
 }
 
 
@@ -1441,6 +1514,7 @@ goo_canvas_item_simple_default_paint (GooCanvasItemSimple   *simple,
   GooCanvasItemSimpleClass *class = GOO_CANVAS_ITEM_SIMPLE_GET_CLASS (simple);
 
   class->simple_create_path (simple, cr);
+  GOO_CANVAS_COUNT (paths_created);
   goo_canvas_item_simple_paint_path (simple, cr);
 }
 
@@ -2018,9 +2092,6 @@ goo_canvas_item_model_simple_get_property (GObject              *object,
 }
 
 
-extern void _goo_canvas_item_model_emit_changed (GooCanvasItemModel *model,
-						 gboolean            recompute_bounds);
-
 static void
 goo_canvas_item_model_simple_set_property (GObject              *object,
 					   guint                 prop_id,
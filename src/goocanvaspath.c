@@ -24,6 +24,10 @@
  * Vector Graphics (SVG) path element. For details see the
  * <ulink url="http://www.w3.org/Graphics/SVG/">SVG specification</ulink>.
  *
+ * Paths with a very large number of commands, such as imported map data,
+ * can be stored much more compactly as a #GooCanvasPackedPath, set with the
+ * #GooCanvasPath:packed-data property.
+ *
  * To create a #GooCanvasPath use goo_canvas_path_new().
  *
  * To get or set the properties of an existing #GooCanvasPath, use
@@ -32,6 +36,7 @@
 #include <config.h>
 #include <glib/gi18n-lib.h>
 #include <gtk/gtk.h>
+#include "goocanvasprivate.h"
 #include "goocanvaspath.h"
 #include "goocanvas.h"
 
@@ -40,6 +45,7 @@ enum {
   PROP_0,
 
   PROP_DATA,
+  PROP_PACKED_DATA,
 
   PROP_X,
   PROP_Y,
@@ -47,6 +53,24 @@ enum {
   PROP_HEIGHT
 };
 
+typedef struct _GooCanvasPathPrivate GooCanvasPathPrivate;
+struct _GooCanvasPathPrivate {
+  /* The bounds of the path in user space, and the settings used to calculate
+     them. The editing functions keep the bounds up to date where possible,
+     so they don't need to be calculated from scratch for small changes. */
+  GooCanvasBounds user_bounds;
+  gdouble line_width, miter_limit;
+  cairo_line_join_t line_join;
+  cairo_line_cap_t line_cap;
+  cairo_fill_rule_t fill_rule;
+  guint has_fill : 1;
+  guint has_stroke : 1;
+  guint user_bounds_valid : 1;
+};
+
+#define GOO_CANVAS_PATH_GET_PRIVATE(path)  \
+   (G_TYPE_INSTANCE_GET_PRIVATE ((path), GOO_TYPE_CANVAS_PATH, GooCanvasPathPrivate))
+
 static void canvas_item_interface_init   (GooCanvasItemIface  *iface);
 
 G_DEFINE_TYPE_WITH_CODE (GooCanvasPath, goo_canvas_path,
@@ -72,6 +96,23 @@ goo_canvas_path_install_common_properties (GObjectClass *gobject_class)
 							NULL,
 							G_PARAM_WRITABLE));
 
+  /**
+   * GooCanvasPath:packed-data:
+   *
+   * The sequence of path commands, as a #GooCanvasPackedPath. This uses
+   * much less memory than the #GooCanvasPath:data property for paths with
+   * a large number of commands. The packed path is shared, so it should
+   * not be changed after it is set.
+   *
+   * Since: 3.0
+   */
+  g_object_class_install_property (gobject_class, PROP_PACKED_DATA,
+				   g_param_spec_boxed ("packed-data",
+						       _("Packed Path Data"),
+						       _("The sequence of path commands, in a packed form"),
+						       GOO_TYPE_CANVAS_PACKED_PATH,
+						       G_PARAM_READWRITE));
+
   g_object_class_install_property (gobject_class, PROP_X,
 				   g_param_spec_double ("x",
 							"X",
@@ -111,6 +152,38 @@ goo_canvas_path_init (GooCanvasPath *path)
 }
 
 
+static void
+goo_canvas_path_data_clear (GooCanvasPathData *path_data)
+{
+  if (path_data->path_commands)
+    g_array_free (path_data->path_commands, TRUE);
+  path_data->path_commands = NULL;
+
+  goo_canvas_packed_path_unref (path_data->packed_path);
+  path_data->packed_path = NULL;
+}
+
+
+static guint
+goo_canvas_path_data_get_n_commands (GooCanvasPathData *path_data)
+{
+  if (path_data->packed_path)
+    return goo_canvas_packed_path_get_n_commands (path_data->packed_path);
+  return path_data->path_commands ? path_data->path_commands->len : 0;
+}
+
+
+static void
+goo_canvas_path_data_create_path (GooCanvasPathData *path_data,
+				  cairo_t           *cr)
+{
+  if (path_data->packed_path)
+    goo_canvas_create_packed_path (path_data->packed_path, cr);
+  else
+    goo_canvas_create_path (path_data->path_commands, cr);
+}
+
+
 /**
  * goo_canvas_path_new:
  * @parent: (skip): the parent item, or %NULL. If a parent is specified, it will assume
@@ -197,8 +270,7 @@ goo_canvas_path_finalize (GObject *object)
      have been reset in dispose() and simple_data will be NULL.) */
   if (simple->simple_data)
     {
-      if (path->path_data->path_commands)
-	g_array_free (path->path_data->path_commands, TRUE);
+      goo_canvas_path_data_clear (path->path_data);
       g_slice_free (GooCanvasPathData, path->path_data);
     }
   path->path_data = NULL;
@@ -214,7 +286,7 @@ goo_canvas_path_common_get_extent (GooCanvas            *canvas,
   cairo_t *cr;
 
   cr = goo_canvas_create_cairo_context (canvas);
-  goo_canvas_create_path (path_data->path_commands, cr);
+  goo_canvas_path_data_create_path (path_data, cr);
   cairo_fill_extents (cr, &bounds->x1, &bounds->y1, &bounds->x2, &bounds->y2);
   cairo_destroy (cr);
 }
@@ -336,6 +408,57 @@ goo_canvas_path_scale_command (GooCanvasPathCommand *cmd,
   }
 }
 
+
+/* The scale and offset applied to the path by the "x", "y", "width" and
+   "height" properties. */
+typedef struct _GooCanvasPathTransform GooCanvasPathTransform;
+struct _GooCanvasPathTransform
+{
+  gdouble x_origin, y_origin, x_scale, y_scale;
+  gdouble x_offset, y_offset;
+};
+
+
+static void
+goo_canvas_path_transform_command (GooCanvasPathCommand *cmd,
+				   gpointer              data)
+{
+  GooCanvasPathTransform *transform = data;
+
+  goo_canvas_path_scale_command (cmd, transform->x_origin, transform->y_origin,
+				 transform->x_scale, transform->y_scale);
+  goo_canvas_path_move_command (cmd, transform->x_offset, transform->y_offset);
+}
+
+
+static void
+goo_canvas_path_data_transform (GooCanvasPathData      *path_data,
+				GooCanvasPathTransform *transform)
+{
+  GooCanvasPackedPath *packed_path;
+  GooCanvasPathCommand *cmd;
+  guint i;
+
+  if (path_data->packed_path)
+    {
+      /* The packed path may be shared, so we change a copy of it. */
+      packed_path = goo_canvas_packed_path_copy (path_data->packed_path);
+      goo_canvas_packed_path_unref (path_data->packed_path);
+      path_data->packed_path = packed_path;
+
+      goo_canvas_packed_path_foreach (packed_path,
+				      goo_canvas_path_transform_command,
+				      transform);
+      return;
+    }
+
+  for (i = 0; i < path_data->path_commands->len; i++)
+    {
+      cmd = &g_array_index (path_data->path_commands, GooCanvasPathCommand, i);
+      goo_canvas_path_transform_command (cmd, transform);
+    }
+}
+
 static void
 goo_canvas_path_get_common_property (GObject              *object,
                                      GooCanvas            *canvas,
@@ -348,6 +471,9 @@ goo_canvas_path_get_common_property (GObject              *object,
 
   switch (prop_id)
     {
+    case PROP_PACKED_DATA:
+      g_value_set_boxed (value, path_data->packed_path);
+      break;
     case PROP_X:
       goo_canvas_path_common_get_extent (canvas, path_data, &extent);
       g_value_set_double (value, extent.x1);
@@ -393,94 +519,76 @@ goo_canvas_path_set_common_property (GObject              *object,
 				     const GValue         *value,
 				     GParamSpec           *pspec)
 {
+  GooCanvasPathTransform transform = { 0.0, 0.0, 1.0, 1.0, 0.0, 0.0 };
   GooCanvasBounds extent;
-  GooCanvasPathCommand *cmd;
-  gdouble x_offset, y_offset, x_scale, y_scale;
-  guint i;
+  guint n_commands = goo_canvas_path_data_get_n_commands (path_data);
 
   switch (prop_id)
     {
     case PROP_DATA:
-      if (path_data->path_commands)
-	g_array_free (path_data->path_commands, TRUE);
+      goo_canvas_path_data_clear (path_data);
       path_data->path_commands = goo_canvas_parse_path_data (g_value_get_string (value));
       g_object_notify (object, "x");
       g_object_notify (object, "y");
       g_object_notify (object, "width");
       g_object_notify (object, "height");
       break;
+    case PROP_PACKED_DATA:
+      goo_canvas_path_data_clear (path_data);
+      path_data->packed_path = g_value_dup_boxed (value);
+      if (!path_data->packed_path)
+	path_data->path_commands = goo_canvas_parse_path_data (NULL);
+      g_object_notify (object, "x");
+      g_object_notify (object, "y");
+      g_object_notify (object, "width");
+      g_object_notify (object, "height");
+      break;
     case PROP_X:
-      if (path_data->path_commands->len > 0)
+      if (n_commands > 0)
         {
-	  /* Calculate the x offset from the current position. */
+	  /* Calculate the x offset from the current position, and add it to
+	     all the absolute x coordinates. */
           goo_canvas_path_common_get_extent (canvas, path_data, &extent);
-          x_offset = g_value_get_double (value) - extent.x1;
-
-	  /* Add the offset to all the absolute x coordinates. */
-          for (i = 0; i < path_data->path_commands->len; i++)
-            {
-              cmd = &g_array_index (path_data->path_commands,
-				    GooCanvasPathCommand, i);
-              goo_canvas_path_move_command (cmd, x_offset, 0.0);
-            }
+          transform.x_offset = g_value_get_double (value) - extent.x1;
+          goo_canvas_path_data_transform (path_data, &transform);
           g_object_notify (object, "data");
         }
       break;
     case PROP_Y:
-      if (path_data->path_commands->len > 0)
+      if (n_commands > 0)
         {
-	  /* Calculate the y offset from the current position. */
+	  /* Calculate the y offset from the current position, and add it to
+	     all the absolute y coordinates. */
           goo_canvas_path_common_get_extent (canvas, path_data, &extent);
-          y_offset = g_value_get_double (value) - extent.y1;
-
-	  /* Add the offset to all the absolute y coordinates. */
-          for (i = 0; i < path_data->path_commands->len; i++)
-            {
-              cmd = &g_array_index (path_data->path_commands,
-				    GooCanvasPathCommand, i);
-              goo_canvas_path_move_command (cmd, 0.0, y_offset);
-            }
+          transform.y_offset = g_value_get_double (value) - extent.y1;
+          goo_canvas_path_data_transform (path_data, &transform);
           g_object_notify (object, "data");
         }
       break;
     case PROP_WIDTH:
-      if (path_data->path_commands->len >= 2)
+      if (n_commands >= 2)
         {
           goo_canvas_path_common_get_extent (canvas, path_data, &extent);
           if (extent.x2 - extent.x1 != 0.0)
             {
-	      /* Calculate the amount to scale the path. */
-              x_scale = g_value_get_double (value) / (extent.x2 - extent.x1);
-
 	      /* Scale the x coordinates, relative to the left-most point. */
-              for (i = 0; i < path_data->path_commands->len; i++)
-                {
-                  cmd = &g_array_index (path_data->path_commands,
-					GooCanvasPathCommand, i);
-                  goo_canvas_path_scale_command (cmd, extent.x1, 0.0,
-						 x_scale, 1.0);
-                }
+              transform.x_origin = extent.x1;
+              transform.x_scale = g_value_get_double (value) / (extent.x2 - extent.x1);
+              goo_canvas_path_data_transform (path_data, &transform);
               g_object_notify (object, "data");
             }
         }
       break;
     case PROP_HEIGHT:
-      if (path_data->path_commands->len >= 2)
+      if (n_commands >= 2)
         {
           goo_canvas_path_common_get_extent (canvas, path_data, &extent);
           if (extent.y2 - extent.y1 != 0.0)
             {
-	      /* Calculate the amount to scale the polyline. */
-              y_scale = g_value_get_double (value) / (extent.y2 - extent.y1);
-
 	      /* Scale the y coordinates, relative to the top-most point. */
-              for (i = 0; i < path_data->path_commands->len; i++)
-                {
-                  cmd = &g_array_index (path_data->path_commands,
-					GooCanvasPathCommand, i);
-                  goo_canvas_path_scale_command (cmd, 0.0, extent.y1,
-						 1.0, y_scale);
-                }
+              transform.y_origin = extent.y1;
+              transform.y_scale = g_value_get_double (value) / (extent.y2 - extent.y1);
+              goo_canvas_path_data_transform (path_data, &transform);
               g_object_notify (object, "data");
             }
         }
@@ -507,6 +615,7 @@ goo_canvas_path_set_property (GObject              *object,
       return;
     }
 
+  GOO_CANVAS_PATH_GET_PRIVATE (path)->user_bounds_valid = FALSE;
   goo_canvas_path_set_common_property (object, simple->canvas, path->path_data,
                                        prop_id, value, pspec);
   goo_canvas_item_simple_changed (simple, TRUE);
@@ -519,7 +628,7 @@ goo_canvas_path_create_path (GooCanvasItemSimple *simple,
 {
   GooCanvasPath *path = (GooCanvasPath*) simple;
 
-  goo_canvas_create_path (path->path_data->path_commands, cr);
+  goo_canvas_path_data_create_path (path->path_data, cr);
 }
 
 
@@ -551,6 +660,581 @@ goo_canvas_path_is_item_at (GooCanvasItemSimple *simple,
 }
 
 
+/* Stores the settings which affect the bounds of the path, and returns TRUE
+   if they have changed since the bounds were last calculated. */
+static gboolean
+goo_canvas_path_bounds_settings_changed (GooCanvasPath *path,
+					 cairo_t       *cr)
+{
+  GooCanvasItemSimple *simple = (GooCanvasItemSimple*) path;
+  GooCanvasPathPrivate *priv = GOO_CANVAS_PATH_GET_PRIVATE (path);
+  GooCanvasStyle *style = simple->simple_data->style;
+  gboolean has_fill, has_stroke, changed;
+
+  has_fill = goo_canvas_style_set_fill_options (style, cr);
+  has_stroke = goo_canvas_style_set_stroke_options (style, cr);
+
+  changed = priv->has_fill != has_fill || priv->has_stroke != has_stroke
+    || priv->line_width != cairo_get_line_width (cr)
+    || priv->miter_limit != cairo_get_miter_limit (cr)
+    || priv->line_join != cairo_get_line_join (cr)
+    || priv->line_cap != cairo_get_line_cap (cr)
+    || priv->fill_rule != cairo_get_fill_rule (cr);
+
+  priv->has_fill = has_fill;
+  priv->has_stroke = has_stroke;
+  priv->line_width = cairo_get_line_width (cr);
+  priv->miter_limit = cairo_get_miter_limit (cr);
+  priv->line_join = cairo_get_line_join (cr);
+  priv->line_cap = cairo_get_line_cap (cr);
+  priv->fill_rule = cairo_get_fill_rule (cr);
+
+  return changed;
+}
+
+
+static void
+goo_canvas_path_update (GooCanvasItemSimple *simple,
+			cairo_t             *cr)
+{
+  GooCanvasPath *path = (GooCanvasPath*) simple;
+  GooCanvasPathPrivate *priv = GOO_CANVAS_PATH_GET_PRIVATE (path);
+
+  /* Use the identity matrix to get the bounds completely in user space. */
+  cairo_identity_matrix (cr);
+
+  /* We can't tell when a model's data changes, so we don't keep the bounds
+     if we have a model. */
+  if (goo_canvas_path_bounds_settings_changed (path, cr) || simple->model)
+    priv->user_bounds_valid = FALSE;
+
+  if (!priv->user_bounds_valid)
+    {
+      goo_canvas_path_create_path (simple, cr);
+      GOO_CANVAS_COUNT (paths_created);
+      goo_canvas_item_simple_get_path_bounds (simple, cr, &priv->user_bounds);
+      priv->user_bounds_valid = TRUE;
+    }
+
+  simple->bounds = priv->user_bounds;
+}
+
+
+/*
+ * Path editing.
+ */
+
+/* The state of an incremental update of the path's bounds, while some of
+   its commands are changed. */
+typedef struct _GooCanvasPathEdit GooCanvasPathEdit;
+struct _GooCanvasPathEdit
+{
+  cairo_t *cr;
+  GooCanvasBounds old_bounds;
+  gboolean old_empty;
+};
+
+
+/* Returns the array of commands, converting any packed path data. */
+static GArray*
+goo_canvas_path_get_editable_commands (GooCanvasPath *path)
+{
+  GooCanvasPathData *path_data = path->path_data;
+
+  if (path_data->packed_path)
+    {
+      path_data->path_commands = goo_canvas_packed_path_to_commands (path_data->packed_path);
+      goo_canvas_packed_path_unref (path_data->packed_path);
+      path_data->packed_path = NULL;
+    }
+  else if (!path_data->path_commands)
+    {
+      path_data->path_commands = g_array_new (FALSE, FALSE,
+					      sizeof (GooCanvasPathCommand));
+    }
+
+  return path_data->path_commands;
+}
+
+
+static gboolean
+goo_canvas_path_range_has_move (GArray *commands,
+				gint    first,
+				gint    last)
+{
+  GooCanvasPathCommand *cmd;
+  gint i;
+
+  for (i = MAX (first, 0); i <= last && i < (gint) commands->len; i++)
+    {
+      cmd = &g_array_index (commands, GooCanvasPathCommand, i);
+      if (cmd->simple.type == GOO_CANVAS_PATH_MOVE_TO)
+	return TRUE;
+    }
+
+  return FALSE;
+}
+
+
+/* Returns the last command whose segment depends on the end point of the
+   given command, or -1 if the rest of the path would have to be checked. */
+static gint
+goo_canvas_path_get_affected_end (GArray *commands,
+				  gint    index)
+{
+  GooCanvasPathCommand *cmd;
+  gint i;
+
+  for (i = index + 1; i < (gint) commands->len; i++)
+    {
+      cmd = &g_array_index (commands, GooCanvasPathCommand, i);
+      switch (cmd->simple.type)
+	{
+	case GOO_CANVAS_PATH_MOVE_TO:
+	  /* A relative move would shift the entire next subpath. */
+	  return cmd->simple.relative ? -1 : i - 1;
+
+	case GOO_CANVAS_PATH_CLOSE_PATH:
+	  /* This goes back to the start of the subpath, which is unchanged. */
+	  return i;
+
+	case GOO_CANVAS_PATH_HORIZONTAL_LINE_TO:
+	case GOO_CANVAS_PATH_VERTICAL_LINE_TO:
+	  /* These keep one coordinate of the previous point. */
+	  break;
+
+	case GOO_CANVAS_PATH_SMOOTH_QUADRATIC_CURVE_TO:
+	  /* The control point is the reflection of the previous one, so it
+	     can change even if the end point is absolute, and the next
+	     smooth quadratic curve reflects it again. */
+	  if (!cmd->simple.relative
+	      && (i + 1 >= (gint) commands->len
+		  || g_array_index (commands, GooCanvasPathCommand, i + 1).simple.type != GOO_CANVAS_PATH_SMOOTH_QUADRATIC_CURVE_TO))
+	    return i;
+	  break;
+
+	default:
+	  /* Absolute commands end at a fixed point, but the end points of
+	     relative commands move with the previous point. An absolute
+	     smooth curve's first control point is reflected from the previous
+	     command, but its second one is fixed so the next curve which
+	     reflects it isn't affected. */
+	  if (!cmd->simple.relative)
+	    return i;
+	  break;
+	}
+    }
+
+  return (gint) commands->len - 1;
+}
+
+
+/* Calculates the bounds of the segments of the given commands, in user
+   space. Returns FALSE if they don't draw anything. */
+static gboolean
+goo_canvas_path_get_range_bounds (GooCanvasPath   *path,
+				  cairo_t         *cr,
+				  gint             first,
+				  gint             last,
+				  GooCanvasBounds *bounds)
+{
+  GooCanvasItemSimple *simple = (GooCanvasItemSimple*) path;
+  GArray *commands = path->path_data->path_commands;
+  gdouble join_size;
+
+  if (first > last || first >= (gint) commands->len)
+    return FALSE;
+
+  cairo_identity_matrix (cr);
+  goo_canvas_create_path_range (commands, first, last, cr);
+  GOO_CANVAS_COUNT (paths_created);
+  goo_canvas_item_simple_get_path_bounds (simple, cr, bounds);
+
+  if (bounds->x1 == bounds->x2 && bounds->y1 == bounds->y2)
+    return FALSE;
+
+  /* The joins with the segments on either side aren't included, so we add
+     the most they can stick out past the end points. */
+  join_size = cairo_get_line_width (cr) / 2.0;
+  if (cairo_get_line_join (cr) == CAIRO_LINE_JOIN_MITER)
+    join_size *= cairo_get_miter_limit (cr);
+
+  bounds->x1 -= join_size;
+  bounds->y1 -= join_size;
+  bounds->x2 += join_size;
+  bounds->y2 += join_size;
+
+  return TRUE;
+}
+
+
+/* Updates the bounds of the path, after the segments in old_bounds have
+   been replaced by the segments in new_bounds. Returns FALSE if the whole
+   path needs to be checked, since it may have shrunk. */
+static gboolean
+goo_canvas_path_update_user_bounds (GooCanvasBounds       *bounds,
+				    const GooCanvasBounds *old_bounds,
+				    gboolean               old_empty,
+				    const GooCanvasBounds *new_bounds,
+				    gboolean               new_empty)
+{
+  /* If the old segments reached an edge of the bounds, the new ones must
+     reach it too, or we don't know where the edge is now. */
+  if (!old_empty)
+    {
+      if (old_bounds->x1 <= bounds->x1
+	  && (new_empty || new_bounds->x1 > bounds->x1))
+	return FALSE;
+      if (old_bounds->y1 <= bounds->y1
+	  && (new_empty || new_bounds->y1 > bounds->y1))
+	return FALSE;
+      if (old_bounds->x2 >= bounds->x2
+	  && (new_empty || new_bounds->x2 < bounds->x2))
+	return FALSE;
+      if (old_bounds->y2 >= bounds->y2
+	  && (new_empty || new_bounds->y2 < bounds->y2))
+	return FALSE;
+    }
+
+  if (!new_empty)
+    {
+      bounds->x1 = MIN (bounds->x1, new_bounds->x1);
+      bounds->y1 = MIN (bounds->y1, new_bounds->y1);
+      bounds->x2 = MAX (bounds->x2, new_bounds->x2);
+      bounds->y2 = MAX (bounds->y2, new_bounds->y2);
+    }
+
+  return TRUE;
+}
+
+
+/* Called before the commands from first to last are changed. It calculates
+   the bounds of the segments which will be affected. Subpaths starting in
+   the range could affect segments anywhere, so they aren't handled. */
+static void
+goo_canvas_path_begin_edit (GooCanvasPath     *path,
+			    gint               first,
+			    gint               last,
+			    GooCanvasPathEdit *edit)
+{
+  GooCanvasItemSimple *simple = (GooCanvasItemSimple*) path;
+  GooCanvasPathPrivate *priv = GOO_CANVAS_PATH_GET_PRIVATE (path);
+  GArray *commands = path->path_data->path_commands;
+  gint end = -1;
+
+  edit->cr = NULL;
+
+  if (priv->user_bounds_valid && simple->canvas
+      && !goo_canvas_path_range_has_move (commands, first, last))
+    end = goo_canvas_path_get_affected_end (commands, last);
+
+  if (end < 0)
+    {
+      priv->user_bounds_valid = FALSE;
+      return;
+    }
+
+  edit->cr = goo_canvas_create_cairo_context (simple->canvas);
+  edit->old_empty = !goo_canvas_path_get_range_bounds (path, edit->cr,
+						       first, end,
+						       &edit->old_bounds);
+}
+
+
+/* Called after the commands have been changed. The commands from first to
+   last are the ones which have been changed or added. */
+static void
+goo_canvas_path_end_edit (GooCanvasPath     *path,
+			  gint               first,
+			  gint               last,
+			  GooCanvasPathEdit *edit)
+{
+  GooCanvasItemSimple *simple = (GooCanvasItemSimple*) path;
+  GooCanvasPathPrivate *priv = GOO_CANVAS_PATH_GET_PRIVATE (path);
+  GArray *commands = path->path_data->path_commands;
+  GooCanvasBounds new_bounds;
+  gboolean new_empty;
+  gint end = -1;
+
+  if (edit->cr)
+    {
+      if (!goo_canvas_path_range_has_move (commands, first, last))
+	end = goo_canvas_path_get_affected_end (commands, last);
+
+      if (end < 0)
+	{
+	  priv->user_bounds_valid = FALSE;
+	}
+      else
+	{
+	  new_empty = !goo_canvas_path_get_range_bounds (path, edit->cr,
+							 first, end,
+							 &new_bounds);
+	  if (!goo_canvas_path_update_user_bounds (&priv->user_bounds,
+						   &edit->old_bounds,
+						   edit->old_empty,
+						   &new_bounds, new_empty))
+	    priv->user_bounds_valid = FALSE;
+	}
+
+      cairo_destroy (edit->cr);
+    }
+
+  goo_canvas_item_simple_changed (simple, TRUE);
+}
+
+
+/**
+ * goo_canvas_path_get_n_commands:
+ * @path: a #GooCanvasPath.
+ *
+ * Gets the number of commands in the path.
+ *
+ * Returns: the number of commands.
+ *
+ * Since: 3.0
+ **/
+guint
+goo_canvas_path_get_n_commands (GooCanvasPath *path)
+{
+  g_return_val_if_fail (GOO_IS_CANVAS_PATH (path), 0);
+
+  return goo_canvas_path_data_get_n_commands (path->path_data);
+}
+
+
+/**
+ * goo_canvas_path_get_command:
+ * @path: a #GooCanvasPath.
+ * @index: the index of the command.
+ * @cmd: (out): returns the command.
+ *
+ * Gets one of the commands of the path.
+ *
+ * If the path uses packed data it is converted to an array of commands
+ * first, as with the other functions to access individual commands.
+ *
+ * Returns: %TRUE if the command exists.
+ *
+ * Since: 3.0
+ **/
+gboolean
+goo_canvas_path_get_command (GooCanvasPath        *path,
+			     guint                 index,
+			     GooCanvasPathCommand *cmd)
+{
+  GArray *commands;
+
+  g_return_val_if_fail (GOO_IS_CANVAS_PATH (path), FALSE);
+  g_return_val_if_fail (cmd != NULL, FALSE);
+
+  commands = goo_canvas_path_get_editable_commands (path);
+  if (index >= commands->len)
+    return FALSE;
+
+  *cmd = g_array_index (commands, GooCanvasPathCommand, index);
+  return TRUE;
+}
+
+
+/**
+ * goo_canvas_path_set_command:
+ * @path: a #GooCanvasPath.
+ * @index: the index of the command.
+ * @cmd: the new command.
+ *
+ * Replaces one of the commands of the path.
+ *
+ * The bounds of the path are updated by checking only the segments which
+ * have changed where possible, so this is much faster than setting the
+ * #GooCanvasPath:data property when editing long paths.
+ *
+ * Since: 3.0
+ **/
+void
+goo_canvas_path_set_command (GooCanvasPath              *path,
+			     guint                       index,
+			     const GooCanvasPathCommand *cmd)
+{
+  GooCanvasItemSimple *simple = (GooCanvasItemSimple*) path;
+  GooCanvasPathEdit edit;
+  GArray *commands;
+
+  g_return_if_fail (GOO_IS_CANVAS_PATH (path));
+  g_return_if_fail (simple->model == NULL);
+  g_return_if_fail (cmd != NULL);
+
+  commands = goo_canvas_path_get_editable_commands (path);
+  g_return_if_fail (index < commands->len);
+
+  goo_canvas_path_begin_edit (path, index, index, &edit);
+  g_array_index (commands, GooCanvasPathCommand, index) = *cmd;
+  goo_canvas_path_end_edit (path, index, index, &edit);
+}
+
+
+/**
+ * goo_canvas_path_insert_command:
+ * @path: a #GooCanvasPath.
+ * @index: the position to insert the command, or -1 to add it at the end.
+ * @cmd: the command to insert.
+ *
+ * Inserts a command into the path.
+ *
+ * Since: 3.0
+ **/
+void
+goo_canvas_path_insert_command (GooCanvasPath              *path,
+				gint                        index,
+				const GooCanvasPathCommand *cmd)
+{
+  GooCanvasItemSimple *simple = (GooCanvasItemSimple*) path;
+  GooCanvasPathEdit edit;
+  GArray *commands;
+
+  g_return_if_fail (GOO_IS_CANVAS_PATH (path));
+  g_return_if_fail (simple->model == NULL);
+  g_return_if_fail (cmd != NULL);
+
+  commands = goo_canvas_path_get_editable_commands (path);
+  if (index < 0 || index > (gint) commands->len)
+    index = commands->len;
+
+  /* The segment of the command currently at the index will start at the
+     end of the new command. */
+  goo_canvas_path_begin_edit (path, index, index - 1, &edit);
+  g_array_insert_val (commands, index, *cmd);
+  goo_canvas_path_end_edit (path, index, index, &edit);
+}
+
+
+/**
+ * goo_canvas_path_remove_commands:
+ * @path: a #GooCanvasPath.
+ * @index: the index of the first command to remove.
+ * @n_commands: the number of commands to remove.
+ *
+ * Removes commands from the path.
+ *
+ * Since: 3.0
+ **/
+void
+goo_canvas_path_remove_commands (GooCanvasPath *path,
+				 guint          index,
+				 guint          n_commands)
+{
+  GooCanvasItemSimple *simple = (GooCanvasItemSimple*) path;
+  GooCanvasPathEdit edit;
+  GArray *commands;
+
+  g_return_if_fail (GOO_IS_CANVAS_PATH (path));
+  g_return_if_fail (simple->model == NULL);
+
+  commands = goo_canvas_path_get_editable_commands (path);
+  g_return_if_fail (index + n_commands <= commands->len);
+
+  if (n_commands == 0)
+    return;
+
+  goo_canvas_path_begin_edit (path, index, index + n_commands - 1, &edit);
+  g_array_remove_range (commands, index, n_commands);
+
+  /* The segment of the command after the removed ones now starts at the
+     end of the command before them. */
+  goo_canvas_path_end_edit (path, index, (gint) index - 1, &edit);
+}
+
+
+/**
+ * goo_canvas_path_translate_commands:
+ * @path: a #GooCanvasPath.
+ * @index: the index of the first command to move.
+ * @n_commands: the number of commands to move.
+ * @dx: the amount to move the points horizontally.
+ * @dy: the amount to move the points vertically.
+ *
+ * Moves the points of a range of commands, for example to drag a node of
+ * the path. Only absolute coordinates are changed, so any relative
+ * commands following them move with them.
+ *
+ * Since: 3.0
+ **/
+void
+goo_canvas_path_translate_commands (GooCanvasPath *path,
+				    guint          index,
+				    guint          n_commands,
+				    gdouble        dx,
+				    gdouble        dy)
+{
+  GooCanvasItemSimple *simple = (GooCanvasItemSimple*) path;
+  GooCanvasPathEdit edit;
+  GArray *commands;
+  guint i;
+
+  g_return_if_fail (GOO_IS_CANVAS_PATH (path));
+  g_return_if_fail (simple->model == NULL);
+
+  commands = goo_canvas_path_get_editable_commands (path);
+  g_return_if_fail (index + n_commands <= commands->len);
+
+  if (n_commands == 0)
+    return;
+
+  goo_canvas_path_begin_edit (path, index, index + n_commands - 1, &edit);
+  for (i = index; i < index + n_commands; i++)
+    goo_canvas_path_move_command (&g_array_index (commands, GooCanvasPathCommand, i),
+				  dx, dy);
+  goo_canvas_path_end_edit (path, index, index + n_commands - 1, &edit);
+}
+
+
+/**
+ * goo_canvas_path_scale_commands:
+ * @path: a #GooCanvasPath.
+ * @index: the index of the first command to scale.
+ * @n_commands: the number of commands to scale.
+ * @x_origin: the x coordinate of the point to scale about.
+ * @y_origin: the y coordinate of the point to scale about.
+ * @x_scale: the horizontal scale factor.
+ * @y_scale: the vertical scale factor.
+ *
+ * Scales the points of a range of commands. Absolute coordinates are
+ * scaled about the given origin, and relative coordinates are simply
+ * scaled.
+ *
+ * Since: 3.0
+ **/
+void
+goo_canvas_path_scale_commands (GooCanvasPath *path,
+				guint          index,
+				guint          n_commands,
+				gdouble        x_origin,
+				gdouble        y_origin,
+				gdouble        x_scale,
+				gdouble        y_scale)
+{
+  GooCanvasItemSimple *simple = (GooCanvasItemSimple*) path;
+  GooCanvasPathEdit edit;
+  GArray *commands;
+  guint i;
+
+  g_return_if_fail (GOO_IS_CANVAS_PATH (path));
+  g_return_if_fail (simple->model == NULL);
+
+  commands = goo_canvas_path_get_editable_commands (path);
+  g_return_if_fail (index + n_commands <= commands->len);
+
+  if (n_commands == 0)
+    return;
+
+  goo_canvas_path_begin_edit (path, index, index + n_commands - 1, &edit);
+  for (i = index; i < index + n_commands; i++)
+    goo_canvas_path_scale_command (&g_array_index (commands, GooCanvasPathCommand, i),
+				   x_origin, y_origin, x_scale, y_scale);
+  goo_canvas_path_end_edit (path, index, index + n_commands - 1, &edit);
+}
+
+
 static void
 goo_canvas_path_set_model    (GooCanvasItem      *item,
 			      GooCanvasItemModel *model)
@@ -562,13 +1246,13 @@ goo_canvas_path_set_model    (GooCanvasItem      *item,
   /* If our data was allocated, free it. */
   if (!simple->model)
     {
-      if (path->path_data->path_commands)
-	g_array_free (path->path_data->path_commands, TRUE);
+      goo_canvas_path_data_clear (path->path_data);
       g_slice_free (GooCanvasPathData, path->path_data);
     }
 
   /* Now use the new model's data instead. */
   path->path_data = &emodel->path_data;
+  GOO_CANVAS_PATH_GET_PRIVATE (path)->user_bounds_valid = FALSE;
 
   /* Let the parent GooCanvasItemSimple code do the rest. */
   goo_canvas_item_simple_set_model (simple, model);
@@ -588,11 +1272,14 @@ goo_canvas_path_class_init (GooCanvasPathClass *klass)
   GObjectClass *gobject_class = (GObjectClass*) klass;
   GooCanvasItemSimpleClass *simple_class = (GooCanvasItemSimpleClass*) klass;
 
+  g_type_class_add_private (gobject_class, sizeof (GooCanvasPathPrivate));
+
   gobject_class->finalize     = goo_canvas_path_finalize;
 
   gobject_class->get_property = goo_canvas_path_get_property;
   gobject_class->set_property = goo_canvas_path_set_property;
 
+  simple_class->simple_update      = goo_canvas_path_update;
   simple_class->simple_create_path = goo_canvas_path_create_path;
   simple_class->simple_is_item_at  = goo_canvas_path_is_item_at;
 
@@ -748,8 +1435,7 @@ goo_canvas_path_model_finalize (GObject *object)
 {
   GooCanvasPathModel *pmodel = (GooCanvasPathModel*) object;
 
-  if (pmodel->path_data.path_commands)
-    g_array_free (pmodel->path_data.path_commands, TRUE);
+  goo_canvas_path_data_clear (&pmodel->path_data);
 
   G_OBJECT_CLASS (goo_canvas_path_model_parent_class)->finalize (object);
 }
@@ -778,7 +1464,7 @@ goo_canvas_path_model_set_property (GObject              *object,
 
   goo_canvas_path_set_common_property (object, NULL, &pmodel->path_data,
                                        prop_id, value, pspec);
-  g_signal_emit_by_name (pmodel, "changed", TRUE);
+  _goo_canvas_item_model_emit_changed ((GooCanvasItemModel*) pmodel, TRUE);
 }
 
 
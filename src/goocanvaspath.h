@@ -19,6 +19,9 @@ struct _GooCanvasPathData
 {
   /* An array of GooCanvasPathCommand. */
   GArray *path_commands;
+
+  /* The packed commands, used instead of path_commands if set. */
+  GooCanvasPackedPath *packed_path;
 };
 
 
@@ -65,6 +68,32 @@ GooCanvasItem*      goo_canvas_path_new       (GooCanvasItem      *parent,
 					       const gchar        *path_data,
 					       ...);
 
+guint    goo_canvas_path_get_n_commands     (GooCanvasPath              *path);
+gboolean goo_canvas_path_get_command        (GooCanvasPath              *path,
+					     guint                       index,
+					     GooCanvasPathCommand       *cmd);
+void     goo_canvas_path_set_command        (GooCanvasPath              *path,
+					     guint                       index,
+					     const GooCanvasPathCommand *cmd);
+void     goo_canvas_path_insert_command     (GooCanvasPath              *path,
+					     gint                        index,
+					     const GooCanvasPathCommand *cmd);
+void     goo_canvas_path_remove_commands    (GooCanvasPath              *path,
+					     guint                       index,
+					     guint                       n_commands);
+void     goo_canvas_path_translate_commands (GooCanvasPath              *path,
+					     guint                       index,
+					     guint                       n_commands,
+					     gdouble                     dx,
+					     gdouble                     dy);
+void     goo_canvas_path_scale_commands     (GooCanvasPath              *path,
+					     guint                       index,
+					     guint                       n_commands,
+					     gdouble                     x_origin,
+					     gdouble                     y_origin,
+					     gdouble                     x_scale,
+					     gdouble                     y_scale);
+
 
 
 #define GOO_TYPE_CANVAS_PATH_MODEL            (goo_canvas_path_model_get_type ())
@@ -32,6 +32,7 @@
 #include <string.h>
 #include <glib/gi18n-lib.h>
 #include <gtk/gtk.h>
+#include "goocanvasprivate.h"
 #include "goocanvaspolyline.h"
 #include "goocanvas.h"
 
@@ -1357,7 +1358,7 @@ goo_canvas_polyline_model_set_property (GObject              *object,
 
   goo_canvas_polyline_set_common_property (object, &pmodel->polyline_data,
 					   prop_id, value, pspec);
-  g_signal_emit_by_name (pmodel, "changed", TRUE);
+  _goo_canvas_item_model_emit_changed ((GooCanvasItemModel*) pmodel, TRUE);
 }
 
 
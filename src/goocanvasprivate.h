@@ -9,6 +9,8 @@
 
 #include <gtk/gtk.h>
 #include "goocanvasstyle.h"
+#include "goocanvasgroup.h"
+#include "goocanvas.h"
 
 G_BEGIN_DECLS
 
@@ -29,6 +31,7 @@ gint goo_canvas_util_ptr_array_find_index (GPtrArray *ptr_array,
 
 
 cairo_pattern_t* goo_canvas_cairo_pattern_from_pixbuf (GdkPixbuf *pixbuf);
+gboolean         goo_canvas_pattern_is_from_pixbuf   (cairo_pattern_t *pattern);
 cairo_surface_t* goo_canvas_cairo_surface_from_pixbuf (GdkPixbuf *pixbuf);
 
 guint goo_canvas_convert_colors_to_rgba (double red,
@@ -52,12 +55,193 @@ cairo_pattern_t* goo_canvas_create_pattern_from_gdk_rgba_value (const GValue *va
 cairo_pattern_t* goo_canvas_create_pattern_from_pixbuf_value   (const GValue *value);
 
 
+void goo_canvas_create_path_range (GArray  *commands,
+				   guint    first,
+				   guint    last,
+				   cairo_t *cr);
+
+gboolean goo_canvas_path_get_rectangle (GArray          *commands,
+					GooCanvasBounds *rect);
+
+typedef void (*GooCanvasPathCommandFunc) (GooCanvasPathCommand *cmd,
+					  gpointer              data);
+
+void goo_canvas_packed_path_foreach (GooCanvasPackedPath      *path,
+				     GooCanvasPathCommandFunc  func,
+				     gpointer                  data);
+
+
+/*
+ * Clip paths of simple items.
+ */
+void     goo_canvas_item_simple_data_clip             (GooCanvasItemSimpleData *simple_data,
+						       cairo_t                 *cr);
+gboolean goo_canvas_item_simple_data_in_clip          (GooCanvasItemSimpleData *simple_data,
+						       cairo_t                 *cr,
+						       gdouble                  x,
+						       gdouble                  y);
+void     goo_canvas_item_simple_data_get_clip_extents (GooCanvasItemSimpleData *simple_data,
+						       cairo_t                 *cr,
+						       GooCanvasBounds         *extents);
+
+
+/*
+ * Signal emission for item models.
+ */
+void _goo_canvas_item_model_emit_changed        (GooCanvasItemModel *model,
+						 gboolean            recompute_bounds);
+void _goo_canvas_item_model_emit_child_added    (GooCanvasItemModel *model,
+						 gint                position);
+void _goo_canvas_item_model_emit_children_added (GooCanvasItemModel *model,
+						 gint                position,
+						 gint                n_children);
+
+
 gboolean goo_canvas_boolean_handled_accumulator (GSignalInvocationHint *ihint,
 						 GValue                *return_accu,
 						 const GValue          *handler_return,
 						 gpointer               dummy);
 
 
+/*
+ * Lazy creation of the items viewing group models.
+ */
+gboolean goo_canvas_get_lazy_views     (GooCanvas       *canvas);
+void     goo_canvas_get_visible_bounds (GooCanvas       *canvas,
+					GooCanvasBounds *bounds);
+
+void goo_canvas_group_create_pending_children (GooCanvasGroup        *group);
+void goo_canvas_group_release_hidden_children (GooCanvasGroup        *group,
+					       const GooCanvasBounds *visible_bounds);
+void goo_canvas_group_request_visible_updates (GooCanvasGroup        *group,
+					       const GooCanvasBounds *visible_bounds,
+					       const GooCanvasBounds *old_bounds);
+
+
+/*
+ * Hidden canvases, used to hold the source items of GooCanvasUse items.
+ */
+typedef void (*GooCanvasChangeFunc) (GooCanvas             *canvas,
+				     const GooCanvasBounds *bounds,
+				     gpointer               data);
+
+void goo_canvas_set_change_func (GooCanvas           *canvas,
+				 GooCanvasChangeFunc  change_func,
+				 gpointer             change_data);
+
+
+/*
+ * Performance counters. This points to the stats of the canvas currently
+ * being updated, drawn or hit tested, if it is collecting them.
+ */
+extern GooCanvasFrameStats *_goo_canvas_frame_stats;
+
+#define GOO_CANVAS_COUNT(counter)				\
+  G_STMT_START {						\
+    if (G_UNLIKELY (_goo_canvas_frame_stats))			\
+      _goo_canvas_frame_stats->counter++;			\
+  } G_STMT_END
+
+
+/*
+ * The scale used for the items' visibility thresholds while hit testing. It
+ * differs from the scale of the items' own canvas if the canvas displays
+ * another canvas's items, see goo_canvas_set_view_source().
+ */
+gdouble goo_canvas_get_hit_test_scale (GooCanvas *canvas,
+				       cairo_t   *cr);
+
+
+/*
+ * Item profiling. This points to the profile of the canvas currently being
+ * updated or drawn, if its GooCanvas:profile-items property is set.
+ */
+typedef struct _GooCanvasProfile GooCanvasProfile;
+
+extern GooCanvasProfile *_goo_canvas_profile;
+
+GooCanvasProfile* goo_canvas_profile_new       (void);
+void              goo_canvas_profile_reset     (GooCanvasProfile      *profile);
+void              goo_canvas_profile_free      (GooCanvasProfile      *profile);
+gint64            goo_canvas_profile_begin     (GooCanvasProfile      *profile,
+						gint64                *outer_child_time);
+void              goo_canvas_profile_end       (GooCanvasProfile      *profile,
+						GooCanvasItem         *item,
+						gboolean               is_paint,
+						gint64                 start_time,
+						gint64                 outer_child_time);
+GArray*           goo_canvas_profile_get_costs (GooCanvasProfile      *profile,
+						gboolean               by_type,
+						guint                  max_entries);
+void              goo_canvas_profile_paint     (GooCanvasProfile      *profile,
+						GooCanvas             *canvas,
+						GooCanvas             *view_source,
+						cairo_t               *cr,
+						const GooCanvasBounds *bounds);
+
+
+/*
+ * Memory accounting, used by goo_canvas_get_memory_stats().
+ */
+gpointer goo_canvas_use_get_memory_source       (GooCanvasUse         *use,
+						 GooCanvas           **source_canvas,
+						 gsize                *cache_bytes);
+gsize    goo_canvas_tiled_image_get_memory_used (GooCanvasTiledImage  *image);
+gsize    goo_canvas_batch_get_memory_used       (GooCanvasBatch       *batch,
+						 GPtrArray           **styles);
+gsize    goo_canvas_image_get_mip_chain_memory_used (cairo_surface_t  *surface);
+
+
+/*
+ * Tracing marks, which are shown in sysprof if GooCanvas was configured
+ * with --enable-sysprof. The begin time is 0 if sysprof isn't recording.
+ * Marks for single items are only added if they took longer than
+ * GOO_CANVAS_TRACE_SLOW_ITEM nanoseconds.
+ */
+#ifdef HAVE_SYSPROF
+#include <sysprof-capture.h>
+
+#define GOO_CANVAS_TRACE_SLOW_ITEM	(1000 * 1000)
+
+#define GOO_CANVAS_TRACE_ACTIVE()	sysprof_collector_is_active ()
+
+#define GOO_CANVAS_TRACE_TIME()					\
+  (sysprof_collector_is_active () ? SYSPROF_CAPTURE_CURRENT_TIME : 0)
+
+#define GOO_CANVAS_TRACE_MARK(begin_time, name, ...)		\
+  G_STMT_START {						\
+    if (begin_time)						\
+      sysprof_collector_mark ((begin_time),			\
+			      SYSPROF_CAPTURE_CURRENT_TIME - (begin_time), \
+			      "GooCanvas", (name), __VA_ARGS__);	\
+  } G_STMT_END
+
+#define GOO_CANVAS_TRACE_SLOW_MARK(begin_time, name, ...)	\
+  G_STMT_START {						\
+    gint64 _goo_duration;					\
+    if (begin_time)						\
+      {								\
+	_goo_duration = SYSPROF_CAPTURE_CURRENT_TIME - (begin_time); \
+	if (_goo_duration >= GOO_CANVAS_TRACE_SLOW_ITEM)	\
+	  sysprof_collector_mark ((begin_time), _goo_duration,	\
+				  "GooCanvas", (name), __VA_ARGS__); \
+      }								\
+  } G_STMT_END
+
+#else
+
+/* The marks don't evaluate their arguments, except the begin time which is
+   used to avoid unused variable warnings. */
+#define GOO_CANVAS_TRACE_ACTIVE()				FALSE
+#define GOO_CANVAS_TRACE_TIME()					0
+#define GOO_CANVAS_TRACE_MARK(begin_time, name, ...)		\
+  G_STMT_START { (void) (begin_time); } G_STMT_END
+#define GOO_CANVAS_TRACE_SLOW_MARK(begin_time, name, ...)	\
+  G_STMT_START { (void) (begin_time); } G_STMT_END
+
+#endif /* HAVE_SYSPROF */
+
+
 G_END_DECLS
 
 #endif /* __GOO_CANVAS_PRIVATE_H__ */
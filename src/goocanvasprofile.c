@@ -0,0 +1,287 @@
+/*
+ * GooCanvas. Copyright (C) 2005-6 Damon Chaplin.
+ * Released under the GNU LGPL license. See COPYING for details.
+ *
+ * goocanvasprofile.c - measures the time spent updating & painting items.
+ */
+#include <config.h>
+#ifdef HAVE_CLOCK_GETTIME
+#include <time.h>
+#endif
+#include <gtk/gtk.h>
+#include "goocanvasprivate.h"
+#include "goocanvas.h"
+#include "goocanvasitem.h"
+
+
+/* The item costs of the canvas currently being updated or drawn, if it is
+   profiling its items. */
+GooCanvasProfile *_goo_canvas_profile = NULL;
+
+
+struct _GooCanvasProfile
+{
+  /* The costs of each item, with weak references to the items so they are
+     removed when the items are finalized. */
+  GHashTable *item_costs;
+
+  /* The costs of each type of item, including items that have been
+     finalized. */
+  GHashTable *type_costs;
+
+  /* The time spent in the children of the item currently being updated or
+     painted, which is subtracted from the item's own time. */
+  gint64 child_time;
+};
+
+
+static void
+goo_canvas_profile_item_finalized (gpointer  data,
+				   GObject  *where_the_object_was)
+{
+  GooCanvasProfile *profile = data;
+
+  g_hash_table_remove (profile->item_costs, where_the_object_was);
+}
+
+
+GooCanvasProfile*
+goo_canvas_profile_new (void)
+{
+  GooCanvasProfile *profile = g_slice_new0 (GooCanvasProfile);
+
+  profile->item_costs = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+					       NULL, g_free);
+  profile->type_costs = g_hash_table_new_full (g_direct_hash, g_direct_equal,
+					       NULL, g_free);
+
+  return profile;
+}
+
+
+void
+goo_canvas_profile_reset (GooCanvasProfile *profile)
+{
+  GHashTableIter iter;
+  gpointer item;
+
+  g_hash_table_iter_init (&iter, profile->item_costs);
+  while (g_hash_table_iter_next (&iter, &item, NULL))
+    g_object_weak_unref (item, goo_canvas_profile_item_finalized, profile);
+
+  g_hash_table_remove_all (profile->item_costs);
+  g_hash_table_remove_all (profile->type_costs);
+}
+
+
+void
+goo_canvas_profile_free (GooCanvasProfile *profile)
+{
+  goo_canvas_profile_reset (profile);
+  g_hash_table_destroy (profile->item_costs);
+  g_hash_table_destroy (profile->type_costs);
+  g_slice_free (GooCanvasProfile, profile);
+}
+
+
+/* Returns the current time in nanoseconds. Most items are painted in less
+   than a microsecond, so g_get_monotonic_time() isn't precise enough. */
+static gint64
+goo_canvas_profile_get_time (void)
+{
+#if defined (HAVE_SYSPROF)
+  return SYSPROF_CAPTURE_CURRENT_TIME;
+#elif defined (HAVE_CLOCK_GETTIME) && defined (CLOCK_MONOTONIC)
+  struct timespec ts;
+
+  clock_gettime (CLOCK_MONOTONIC, &ts);
+  return (gint64) ts.tv_sec * G_GINT64_CONSTANT (1000000000) + ts.tv_nsec;
+#else
+  return g_get_monotonic_time () * 1000;
+#endif
+}
+
+
+/* This is called before an item is updated or painted. It returns the start
+   time, and saves the time spent in the children of the enclosing item so
+   far, which must be passed to goo_canvas_profile_end(). */
+gint64
+goo_canvas_profile_begin (GooCanvasProfile *profile,
+			  gint64           *outer_child_time)
+{
+  *outer_child_time = profile->child_time;
+  profile->child_time = 0;
+
+  return goo_canvas_profile_get_time ();
+}
+
+
+static GooCanvasItemCost*
+goo_canvas_profile_lookup (GHashTable    *costs,
+			   gpointer       key,
+			   GooCanvasItem *item,
+			   GType          type,
+			   gboolean      *created)
+{
+  GooCanvasItemCost *cost;
+
+  cost = g_hash_table_lookup (costs, key);
+  *created = cost == NULL;
+  if (!cost)
+    {
+      cost = g_new0 (GooCanvasItemCost, 1);
+      cost->item = item;
+      cost->type = type;
+      g_hash_table_insert (costs, key, cost);
+    }
+
+  return cost;
+}
+
+
+/* This is called after an item is updated or painted. It adds the time
+   spent, less the time spent in its children, to the costs of the item and
+   its type. */
+void
+goo_canvas_profile_end (GooCanvasProfile *profile,
+			GooCanvasItem    *item,
+			gboolean          is_paint,
+			gint64            start_time,
+			gint64            outer_child_time)
+{
+  GooCanvasItemCost *costs[2];
+  GType type = G_OBJECT_TYPE (item);
+  gint64 total_time, self_time;
+  gboolean created;
+  gint i;
+
+  total_time = goo_canvas_profile_get_time () - start_time;
+  self_time = MAX (total_time - profile->child_time, 0);
+  profile->child_time = outer_child_time + total_time;
+
+  costs[0] = goo_canvas_profile_lookup (profile->item_costs, item, item, type,
+					&created);
+  if (created)
+    g_object_weak_ref ((GObject*) item, goo_canvas_profile_item_finalized,
+		       profile);
+
+  costs[1] = goo_canvas_profile_lookup (profile->type_costs,
+					GSIZE_TO_POINTER (type), NULL, type,
+					&created);
+
+  for (i = 0; i < 2; i++)
+    {
+      if (is_paint)
+	{
+	  costs[i]->n_paints++;
+	  costs[i]->paint_time += self_time;
+	}
+      else
+	{
+	  costs[i]->n_updates++;
+	  costs[i]->update_time += self_time;
+	}
+    }
+}
+
+
+static gint
+goo_canvas_profile_compare_costs (gconstpointer a,
+				  gconstpointer b)
+{
+  const GooCanvasItemCost *cost_a = a, *cost_b = b;
+  gint64 time_a = cost_a->update_time + cost_a->paint_time;
+  gint64 time_b = cost_b->update_time + cost_b->paint_time;
+
+  return time_a < time_b ? 1 : (time_a > time_b ? -1 : 0);
+}
+
+
+/* Returns the item or type costs, most costly first. */
+GArray*
+goo_canvas_profile_get_costs (GooCanvasProfile *profile,
+			      gboolean          by_type,
+			      guint             max_entries)
+{
+  GHashTable *costs = by_type ? profile->type_costs : profile->item_costs;
+  GHashTableIter iter;
+  gpointer cost;
+  GArray *array;
+
+  array = g_array_sized_new (FALSE, FALSE, sizeof (GooCanvasItemCost),
+			     g_hash_table_size (costs));
+
+  g_hash_table_iter_init (&iter, costs);
+  while (g_hash_table_iter_next (&iter, NULL, &cost))
+    g_array_append_vals (array, cost, 1);
+
+  g_array_sort (array, goo_canvas_profile_compare_costs);
+
+  if (max_entries && array->len > max_entries)
+    g_array_set_size (array, max_entries);
+
+  return array;
+}
+
+
+/* Paints a heat map over the items, with the most costly items in the
+   strongest red. Only the items of the given canvas, or of the canvas it
+   displays, are painted, as the bounds of the items of other canvases (e.g.
+   the sources of GooCanvasUse items) are in different coordinate spaces.
+   The cairo context must be set up to use canvas coordinates. */
+void
+goo_canvas_profile_paint (GooCanvasProfile      *profile,
+			  GooCanvas             *canvas,
+			  GooCanvas             *view_source,
+			  cairo_t               *cr,
+			  const GooCanvasBounds *bounds)
+{
+  GooCanvasItemCost *cost;
+  GooCanvasBounds item_bounds;
+  GooCanvas *item_canvas;
+  GHashTableIter iter;
+  gint64 time, max_time = 0;
+  gpointer value;
+
+  g_hash_table_iter_init (&iter, profile->item_costs);
+  while (g_hash_table_iter_next (&iter, NULL, &value))
+    {
+      cost = value;
+      max_time = MAX (max_time, cost->update_time + cost->paint_time);
+    }
+
+  if (max_time == 0)
+    return;
+
+  cairo_save (cr);
+  cairo_set_operator (cr, CAIRO_OPERATOR_OVER);
+
+  g_hash_table_iter_init (&iter, profile->item_costs);
+  while (g_hash_table_iter_next (&iter, NULL, &value))
+    {
+      cost = value;
+
+      /* Skip items that cost less than 1% of the most costly item. */
+      time = cost->update_time + cost->paint_time;
+      if (time * 100 < max_time)
+	continue;
+
+      item_canvas = goo_canvas_item_get_canvas (cost->item);
+      if (item_canvas != canvas && (!view_source || item_canvas != view_source))
+	continue;
+
+      goo_canvas_item_get_bounds (cost->item, &item_bounds);
+      if (item_bounds.x1 > bounds->x2 || item_bounds.x2 < bounds->x1
+	  || item_bounds.y1 > bounds->y2 || item_bounds.y2 < bounds->y1)
+	continue;
+
+      cairo_rectangle (cr, item_bounds.x1, item_bounds.y1,
+		       item_bounds.x2 - item_bounds.x1,
+		       item_bounds.y2 - item_bounds.y1);
+      cairo_set_source_rgba (cr, 1.0, 0.0, 0.0,
+			     0.6 * time / max_time);
+      cairo_fill (cr);
+    }
+
+  cairo_restore (cr);
+}
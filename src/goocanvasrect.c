@@ -28,6 +28,7 @@
 #include <math.h>
 #include <glib/gi18n-lib.h>
 #include <gtk/gtk.h>
+#include "goocanvasprivate.h"
 #include "goocanvasrect.h"
 #include "goocanvas.h"
 
@@ -575,7 +576,7 @@ goo_canvas_rect_model_set_property (GObject              *object,
 
   goo_canvas_rect_set_common_property (object, &rmodel->rect_data, prop_id,
 				       value, pspec);
-  g_signal_emit_by_name (rmodel, "changed", TRUE);
+  _goo_canvas_item_model_emit_changed ((GooCanvasItemModel*) rmodel, TRUE);
 }
 
 
@@ -44,6 +44,7 @@
 #include <string.h>
 #include <glib/gi18n-lib.h>
 #include <gtk/gtk.h>
+#include "goocanvasprivate.h"
 #include "goocanvastable.h"
 #include "goocanvas.h"
 
@@ -132,6 +133,11 @@ struct _GooCanvasTableDimensionLayoutData
   gdouble start;
   gdouble end;
 
+  /* The start and end positions from the last complete layout, used to check
+     if an incremental layout has changed the size of the row or column. */
+  gdouble last_start;
+  gdouble last_end;
+
   /* These flags are initialized in goo_canvas_table_init_layout_data() and
      set in goo_canvas_table_size_request_init(). */
   guint need_expand : 1;
@@ -147,6 +153,25 @@ struct _GooCanvasTableChildLayoutData
   gdouble requested_position[2];
   gdouble requested_size[2];
   gdouble start_pad[2], end_pad[2];
+
+  /* The area the child originally requested, and the area it requested
+     for the width in requested_for_width, or -1. These are kept so we don't
+     need to ask children that haven't changed for their requested area. */
+  gdouble initial_position[2];
+  gdouble initial_size[2];
+  gdouble requested_for_width;
+  gdouble width_position[2];
+  gdouble width_size[2];
+
+  /* This is TRUE if the child must be requested and allocated again. */
+  gboolean changed;
+
+  /* This is TRUE if the child's bounds extend outside the rows and columns
+     it is in, so it can't be found using the row and column indices. */
+  gboolean overflow;
+
+  /* Used to avoid returning a child twice when finding children. */
+  guint find_serial;
 };
 
 /* Convenience macros to set/unset/check bit-flags. */
@@ -159,12 +184,19 @@ struct _GooCanvasTableChildLayoutData
 #define GOO_CANVAS_TABLE_IS_GRID_LINE_VISIBLE(dim, x, y) \
   ((dim)[(x)].grid_line_visibility[(y)/32] & (1 << ((y) % 32)))
 
-/* The children array is only kept around while doing the layout.
-   It gets freed in goo_canvas_table_allocate_area(). */
+/* The children array is kept after the layout, so that children which
+   haven't changed don't need to be requested again in the next layout.
+   children_valid is only TRUE if the last layout was a complete one done in
+   goo_canvas_table_update() by layout_owner, and no children have been added,
+   moved or removed since. */
 struct _GooCanvasTableLayoutData
 {
   GooCanvasTableDimensionLayoutData *dldata[2];
   GooCanvasTableChildLayoutData *children;
+  gint n_children;
+  gboolean children_valid;
+  GooCanvasTable *layout_owner;
+  GtkTextDirection direction;
 
   /* Position of the table */
   gdouble x;
@@ -196,6 +228,18 @@ struct _GooCanvasTableLayoutData
      It is initialized to -1 in goo_canvas_table_init_layout_data() and
      checked/set in goo_canvas_table_update_requested_heights(). */
   gdouble last_width;
+
+  /* Indices of the children in each row and column, used to find the
+     children in an area without checking every child. The children in row
+     or column i of dimension d are dim_children[d][dim_children_start[d][i]]
+     to dim_children[d][dim_children_start[d][i + 1] - 1], in stacking order.
+     Children whose bounds extend outside their cells are only in
+     overflow_children. The indices are rebuilt after each layout. */
+  gboolean index_valid;
+  gint *dim_children_start[2];
+  gint *dim_children[2];
+  GArray *overflow_children;
+  guint find_serial;
 };
 
 static GooCanvasItemIface *goo_canvas_table_parent_iface;
@@ -431,9 +475,18 @@ goo_canvas_table_init_data (GooCanvasTableData *table_data)
   table_data->layout_data->y = 0.0;
 
   table_data->layout_data->children = NULL;
+  table_data->layout_data->n_children = 0;
+  table_data->layout_data->children_valid = FALSE;
+  table_data->layout_data->layout_owner = NULL;
+  table_data->layout_data->direction = GTK_TEXT_DIR_NONE;
+  table_data->layout_data->index_valid = FALSE;
+  table_data->layout_data->overflow_children = g_array_new (FALSE, FALSE, sizeof (gint));
+  table_data->layout_data->find_serial = 0;
   for (d = 0; d < 2; d++)
     {
       table_data->layout_data->dldata[d] = NULL;
+      table_data->layout_data->dim_children_start[d] = NULL;
+      table_data->layout_data->dim_children[d] = NULL;
       table_data->layout_data->prop_grid_line_width[d] = 0.0;
       table_data->layout_data->grid_line_width[d] = 0.0;
       table_data->layout_data->border_spacing[d] = 0.0;
@@ -815,7 +868,7 @@ goo_canvas_table_add_child_internal (GooCanvasTableData *table_data,
       table_child.flags[d] = 0;
     }
 
-  if (position < 0)
+  if (position < 0 || position > table_data->children->len)
     position = table_data->children->len;
   g_array_insert_val (table_data->children, position, table_child);
 
@@ -833,12 +886,39 @@ goo_canvas_table_add_child     (GooCanvasItem  *item,
 
   if (!simple->model)
     goo_canvas_table_add_child_internal (table->table_data, position);
+  table->table_data->layout_data->children_valid = FALSE;
+  table->table_data->layout_data->index_valid = FALSE;
 
   /* Let the parent GooCanvasGroup code do the rest. */
   goo_canvas_table_parent_iface->add_child (item, child, position);
 }
 
 
+static void
+goo_canvas_table_add_children  (GooCanvasItem  *item,
+				GooCanvasItem **children,
+				gint            n_children,
+				gint            position)
+{
+  GooCanvasItemSimple *simple = (GooCanvasItemSimple*) item;
+  GooCanvasTable *table = (GooCanvasTable*) item;
+  gint i;
+
+  if (!simple->model)
+    {
+      for (i = 0; i < n_children; i++)
+	goo_canvas_table_add_child_internal (table->table_data,
+					     position < 0 ? -1 : position + i);
+    }
+  table->table_data->layout_data->children_valid = FALSE;
+  table->table_data->layout_data->index_valid = FALSE;
+
+  /* Let the parent GooCanvasGroup code do the rest. */
+  goo_canvas_table_parent_iface->add_children (item, children, n_children,
+					       position);
+}
+
+
 static void
 goo_canvas_table_move_child_internal    (GooCanvasTableData *table_data,
 					 gint	             old_position,
@@ -888,6 +968,8 @@ goo_canvas_table_move_child    (GooCanvasItem  *item,
   if (!simple->model)
     goo_canvas_table_move_child_internal (table->table_data, old_position,
 					  new_position);
+  table->table_data->layout_data->children_valid = FALSE;
+  table->table_data->layout_data->index_valid = FALSE;
 
   /* Let the parent GooCanvasGroup code do the rest. */
   goo_canvas_table_parent_iface->move_child (item, old_position, new_position);
@@ -906,6 +988,8 @@ goo_canvas_table_remove_child  (GooCanvasItem  *item,
 
   if (!simple->model)
     g_array_remove_index (table->table_data->children, child_num);
+  table->table_data->layout_data->children_valid = FALSE;
+  table->table_data->layout_data->index_valid = FALSE;
 
   /* Let the parent GooCanvasGroup code do the rest. */
   goo_canvas_table_parent_iface->remove_child (item, child_num);
@@ -1173,6 +1257,12 @@ goo_canvas_table_free_layout_data (GooCanvasTableData *table_data)
       g_free (table_data->layout_data->dldata[HORZ]);
       g_free (table_data->layout_data->dldata[VERT]);
       g_free (table_data->layout_data->children);
+      for (i = 0; i < 2; i++)
+	{
+	  g_free (table_data->layout_data->dim_children_start[i]);
+	  g_free (table_data->layout_data->dim_children[i]);
+	}
+      g_array_free (table_data->layout_data->overflow_children, TRUE);
       g_slice_free (GooCanvasTableLayoutData, table_data->layout_data);
       table_data->layout_data = NULL;
     }
@@ -1190,8 +1280,20 @@ goo_canvas_table_init_layout_data (GooCanvasTable *table)
   GooCanvasTableDimensionLayoutData *dldata;
   gint d, i;
 
-  layout_data->children = g_new (GooCanvasTableChildLayoutData,
-				 table_data->children->len);
+  if (layout_data->n_children != table_data->children->len)
+    {
+      layout_data->children = g_renew (GooCanvasTableChildLayoutData,
+				       layout_data->children,
+				       table_data->children->len);
+      for (i = layout_data->n_children; i < table_data->children->len; i++)
+	{
+	  layout_data->children[i].overflow = FALSE;
+	  layout_data->children[i].find_serial = 0;
+	}
+      layout_data->n_children = table_data->children->len;
+      layout_data->children_valid = FALSE;
+      layout_data->index_valid = FALSE;
+    }
   layout_data->last_width = -1;
 
   /* If we are not yet added to a canvas, integer layout is irrelevant anyway.
@@ -1251,7 +1353,8 @@ goo_canvas_table_init_layout_data (GooCanvasTable *table)
 }
 
 
-/* This gets the requested size of all child items, and sets the expand,
+/* This gets the requested size of all child items which have changed
+   (the previous requests are used for the others), and sets the expand,
    shrink and empty flags for each row and column.
    It should only be called once in the entire size_request/allocate procedure
    and nothing should change the values it sets (except the requested height
@@ -1265,6 +1368,7 @@ goo_canvas_table_size_request_init (GooCanvasTable *table,
   GooCanvasTableLayoutData *layout_data = table_data->layout_data;
   GooCanvasTableDimension *dimension;
   GooCanvasTableDimensionLayoutData *dldata;
+  GooCanvasTableChildLayoutData *child_data;
   GooCanvasTableChild *child;
   GooCanvasItem *child_item;
   GooCanvasBounds bounds;
@@ -1276,40 +1380,55 @@ goo_canvas_table_size_request_init (GooCanvasTable *table,
     {
       child = &g_array_index (table_data->children, GooCanvasTableChild, i);
       child_item = group->items->pdata[i];
+      child_data = &layout_data->children[i];
 
-      /* Children will return FALSE if they don't need space allocated. */
-      allocate = goo_canvas_item_get_requested_area (child_item, cr, &bounds);
-
-      /* Remember the requested position and size of the child. */
-      layout_data->children[i].requested_position[HORZ] = bounds.x1;
-      layout_data->children[i].requested_position[VERT] = bounds.y1;
-
-      if (!allocate)
+      if (child_data->changed)
 	{
-	  layout_data->children[i].requested_size[HORZ] = -1.0;
-	  layout_data->children[i].requested_size[VERT] = -1.0;
-	  continue;
-	}
+	  /* Children will return FALSE if they don't need space allocated. */
+	  allocate = goo_canvas_item_get_requested_area (child_item, cr,
+							 &bounds);
 
-      layout_data->children[i].requested_size[HORZ] = bounds.x2 - bounds.x1;
-      layout_data->children[i].requested_size[VERT] = bounds.y2 - bounds.y1;
+	  /* Remember the requested position and size of the child. */
+	  child_data->initial_position[HORZ] = bounds.x1;
+	  child_data->initial_position[VERT] = bounds.y1;
+	  child_data->requested_for_width = -1.0;
 
-      layout_data->children[i].start_pad[HORZ] = child->start_pad[HORZ];
-      layout_data->children[i].end_pad[HORZ] = child->end_pad[HORZ];
-      layout_data->children[i].start_pad[VERT] = child->start_pad[VERT];
-      layout_data->children[i].end_pad[VERT] = child->end_pad[VERT];
+	  if (!allocate)
+	    {
+	      child_data->initial_size[HORZ] = -1.0;
+	      child_data->initial_size[VERT] = -1.0;
+	    }
+	  else
+	    {
+	      child_data->initial_size[HORZ] = bounds.x2 - bounds.x1;
+	      child_data->initial_size[VERT] = bounds.y2 - bounds.y1;
 
-      if (layout_data->integer_layout)
-	{
-	  layout_data->children[i].requested_size[HORZ] = ceil (layout_data->children[i].requested_size[HORZ]);
-	  layout_data->children[i].requested_size[VERT] = ceil (layout_data->children[i].requested_size[VERT]);
+	      child_data->start_pad[HORZ] = child->start_pad[HORZ];
+	      child_data->end_pad[HORZ] = child->end_pad[HORZ];
+	      child_data->start_pad[VERT] = child->start_pad[VERT];
+	      child_data->end_pad[VERT] = child->end_pad[VERT];
 
-	  layout_data->children[i].start_pad[HORZ] = floor (layout_data->children[i].start_pad[HORZ] + 0.5);
-	  layout_data->children[i].end_pad[HORZ] = floor (layout_data->children[i].end_pad[HORZ] + 0.5);
-	  layout_data->children[i].start_pad[VERT] = floor (layout_data->children[i].start_pad[VERT] + 0.5);
-	  layout_data->children[i].end_pad[VERT] = floor (layout_data->children[i].end_pad[VERT] + 0.5);
+	      if (layout_data->integer_layout)
+		{
+		  child_data->initial_size[HORZ] = ceil (child_data->initial_size[HORZ]);
+		  child_data->initial_size[VERT] = ceil (child_data->initial_size[VERT]);
+
+		  child_data->start_pad[HORZ] = floor (child_data->start_pad[HORZ] + 0.5);
+		  child_data->end_pad[HORZ] = floor (child_data->end_pad[HORZ] + 0.5);
+		  child_data->start_pad[VERT] = floor (child_data->start_pad[VERT] + 0.5);
+		  child_data->end_pad[VERT] = floor (child_data->end_pad[VERT] + 0.5);
+		}
+	    }
 	}
 
+      child_data->requested_position[HORZ] = child_data->initial_position[HORZ];
+      child_data->requested_position[VERT] = child_data->initial_position[VERT];
+      child_data->requested_size[HORZ] = child_data->initial_size[HORZ];
+      child_data->requested_size[VERT] = child_data->initial_size[VERT];
+
+      if (child_data->requested_size[HORZ] < 0.0)
+	continue;
+
       /* Set the expand, shrink & empty flags in the
 	 GooCanvasTableDimensionLayoutData for the row/column, if the item
 	 only spans 1 row/column. */
@@ -1757,12 +1876,14 @@ goo_canvas_table_size_allocate_pass2 (GooCanvasTable *table,
 
 
 /* This does the actual allocation of each child, calculating its size and
-   position according to the rows & columns it spans. */
+   position according to the rows & columns it spans. If changed_only is TRUE
+   only the children which have been requested again are allocated. */
 static void
 goo_canvas_table_size_allocate_pass3 (GooCanvasTable *table,
 				      cairo_t        *cr,
 				      gdouble         table_x_offset,
-				      gdouble         table_y_offset)
+				      gdouble         table_y_offset,
+				      gboolean        changed_only)
 {
   GooCanvasItemSimple *simple = (GooCanvasItemSimple*) table;
   GooCanvasGroup *group = (GooCanvasGroup*) table;
@@ -1773,7 +1894,8 @@ goo_canvas_table_size_allocate_pass3 (GooCanvasTable *table,
   GooCanvasTableChild *child;
   GooCanvasItem *child_item;
   GooCanvasTableChildLayoutData *child_data;
-  GooCanvasBounds requested_area, allocated_area;
+  GooCanvasBounds requested_area, allocated_area, cell_area, child_bounds;
+  cairo_matrix_t matrix;
   GtkTextDirection direction = GTK_TEXT_DIR_NONE;
   gint start_column, end_column, start_row, end_row, i;
   gdouble x, y, max_width, max_height, width, height;
@@ -1792,9 +1914,13 @@ goo_canvas_table_size_allocate_pass3 (GooCanvasTable *table,
       requested_width = child_data->requested_size[HORZ];
       requested_height = child_data->requested_size[VERT];
 
+      if (changed_only && !child_data->changed)
+	continue;
+
+      child_data->overflow = FALSE;
       if (requested_width <= 0.0)
 	continue;
-      
+
       start_column = child->start[HORZ];
       end_column = child->start[HORZ] + child->size[HORZ] - 1;
       x = columns[start_column].start + layout_data->children[i].start_pad[HORZ];
@@ -1856,7 +1982,40 @@ goo_canvas_table_size_allocate_pass3 (GooCanvasTable *table,
 				     &allocated_area, x_offset, y_offset);
 
       cairo_translate (cr, -child->position[HORZ], -child->position[VERT]);
+
+      /* Check if the child's bounds are inside the rows and columns it is
+	 in, since that is where the indices will look for it. If the table
+	 is rotated the device bounds can't tell us, so we assume they aren't. */
+      cairo_get_matrix (cr, &matrix);
+      if (matrix.xy != 0.0 || matrix.yx != 0.0)
+	{
+	  child_data->overflow = TRUE;
+	  continue;
+	}
+
+      cell_area.x1 = columns[start_column].start;
+      cell_area.x2 = columns[end_column].end;
+      if (direction == GTK_TEXT_DIR_RTL)
+	{
+	  cell_area.x1 = layout_data->allocated_size[HORZ] - columns[end_column].end;
+	  cell_area.x2 = layout_data->allocated_size[HORZ] - columns[start_column].start;
+	}
+      cell_area.y1 = rows[start_row].start;
+      cell_area.y2 = rows[end_row].end;
+      goo_canvas_item_simple_user_bounds_to_device (simple, cr, &cell_area);
+      cell_area.x1 += table_x_offset;
+      cell_area.x2 += table_x_offset;
+      cell_area.y1 += table_y_offset;
+      cell_area.y2 += table_y_offset;
+
+      goo_canvas_item_get_bounds (child_item, &child_bounds);
+      if (child_bounds.x1 < child_bounds.x2 && child_bounds.y1 < child_bounds.y2
+	  && (child_bounds.x1 < cell_area.x1 || child_bounds.x2 > cell_area.x2
+	      || child_bounds.y1 < cell_area.y1 || child_bounds.y2 > cell_area.y2))
+	child_data->overflow = TRUE;
     }
+
+  layout_data->index_valid = FALSE;
 }
 
 
@@ -1912,6 +2071,20 @@ goo_canvas_table_update_requested_heights (GooCanvasItem       *item,
       if (!(child->flags[HORZ] & GOO_CANVAS_TABLE_CHILD_FILL))
 	width = MIN (max_width, requested_width);
 
+      /* If the child hasn't changed and we have already asked it for its
+	 requested area at this width, use the result we got last time. */
+      if (!child_data->changed && child_data->requested_for_width == width)
+	{
+	  child_data->requested_position[HORZ] = child_data->width_position[HORZ];
+	  child_data->requested_position[VERT] = child_data->width_position[VERT];
+	  child_data->requested_size[HORZ] = child_data->width_size[HORZ];
+	  child_data->requested_size[VERT] = child_data->width_size[VERT];
+	  continue;
+	}
+
+      /* The child's bounds may change, so it must be allocated again. */
+      child_data->changed = TRUE;
+
       iface = GOO_CANVAS_ITEM_GET_IFACE (child_item);
 
       /* See if the child supports the new get_requested_area_for_width()
@@ -1948,6 +2121,12 @@ goo_canvas_table_update_requested_heights (GooCanvasItem       *item,
 		child_data->requested_size[VERT] = requested_height;
 	    }
 	}
+
+      child_data->requested_for_width = width;
+      child_data->width_position[HORZ] = child_data->requested_position[HORZ];
+      child_data->width_position[VERT] = child_data->requested_position[VERT];
+      child_data->width_size[HORZ] = child_data->requested_size[HORZ];
+      child_data->width_size[VERT] = child_data->requested_size[VERT];
     }
 
   /* Now recalculate the requested heights of each row. */
@@ -1969,45 +2148,22 @@ goo_canvas_table_update_requested_heights (GooCanvasItem       *item,
 }
 
 
-/* Returns FALSE if item shouldn't be allocated. */
-static gboolean
-goo_canvas_table_get_requested_area (GooCanvasItem        *item,
-				     cairo_t              *cr,
-				     GooCanvasBounds      *requested_area)
+/* This calculates the requested size of the table, using the cached
+   requests of any children which haven't changed. The layout data must
+   have been initialized with goo_canvas_table_init_layout_data(). */
+static void
+goo_canvas_table_size_request (GooCanvasTable *table,
+			       cairo_t        *cr)
 {
-  GooCanvasItemSimple *simple = (GooCanvasItemSimple*) item;
-  GooCanvasItemSimpleData *simple_data = simple->simple_data;
-  GooCanvasTable *table = (GooCanvasTable*) item;
   GooCanvasTableData *table_data = table->table_data;
   GooCanvasTableLayoutData *layout_data = table_data->layout_data;
   GooCanvasTableDimensionLayoutData *rows, *columns;
   gdouble width = 0.0, height = 0.0;
   gint row, column, end;
+  gint64 trace_time = GOO_CANVAS_TRACE_TIME ();
 
-  /* Request a redraw of the existing bounds */
-  goo_canvas_request_item_redraw (simple->canvas, &simple->bounds, simple_data->is_static);
-  
-  /* We reset the bounds to 0, just in case we are hidden or aren't allocated
-     any area. */
-  simple->bounds.x1 = simple->bounds.x2 = 0.0;
-  simple->bounds.y1 = simple->bounds.y2 = 0.0;
-
-  simple->need_update = FALSE;
-
-  goo_canvas_item_simple_check_style (simple);
-
-  if (simple_data->visibility == GOO_CANVAS_ITEM_HIDDEN)
-    return FALSE;
-
-  cairo_save (cr);
-  if (simple_data->transform)
-    cairo_transform (cr, simple_data->transform);
-
-  cairo_translate (cr, layout_data->x, layout_data->y);
-
-  /* Initialize the layout data, get the requested sizes of all children, and
-     set the expand, shrink and empty flags. */
-  goo_canvas_table_init_layout_data (table);
+  /* Get the requested sizes of the changed children, and set the expand,
+     shrink and empty flags. */
   goo_canvas_table_size_request_init (table, cr);
 
   /* Calculate the requested width of the table. */
@@ -2039,7 +2195,7 @@ goo_canvas_table_get_requested_area (GooCanvasItem        *item,
   layout_data->allocated_size[HORZ] = width;
 
   /* Update the requested heights, based on the requested column widths. */
-  goo_canvas_table_update_requested_heights (item, cr);
+  goo_canvas_table_update_requested_heights ((GooCanvasItem*) table, cr);
 
   goo_canvas_table_size_request_pass1 (table, VERT);
   goo_canvas_table_size_request_pass2 (table, VERT);
@@ -2064,6 +2220,63 @@ goo_canvas_table_get_requested_area (GooCanvasItem        *item,
 
   layout_data->requested_size[VERT] = height;
 
+  GOO_CANVAS_TRACE_MARK (trace_time, "Table size request",
+			 "%i rows, %i columns, %u children",
+			 table_data->dimensions[VERT].size,
+			 table_data->dimensions[HORZ].size,
+			 table_data->children->len);
+}
+
+
+/* Returns FALSE if item shouldn't be allocated. */
+static gboolean
+goo_canvas_table_get_requested_area (GooCanvasItem        *item,
+				     cairo_t              *cr,
+				     GooCanvasBounds      *requested_area)
+{
+  GooCanvasItemSimple *simple = (GooCanvasItemSimple*) item;
+  GooCanvasItemSimpleData *simple_data = simple->simple_data;
+  GooCanvasTable *table = (GooCanvasTable*) item;
+  GooCanvasTableData *table_data = table->table_data;
+  GooCanvasTableLayoutData *layout_data = table_data->layout_data;
+  gdouble width, height;
+  gint i;
+
+  /* Request a redraw of the existing bounds */
+  goo_canvas_request_item_redraw (simple->canvas, &simple->bounds, simple_data->is_static);
+  
+  /* We reset the bounds to 0, just in case we are hidden or aren't allocated
+     any area. */
+  simple->bounds.x1 = simple->bounds.x2 = 0.0;
+  simple->bounds.y1 = simple->bounds.y2 = 0.0;
+
+  simple->need_update = FALSE;
+
+  /* A complete layout is done here, so the cached layout is not valid until
+     goo_canvas_table_update() has finished. */
+  layout_data->children_valid = FALSE;
+
+  goo_canvas_item_simple_check_style (simple);
+
+  if (simple_data->visibility == GOO_CANVAS_ITEM_HIDDEN)
+    return FALSE;
+
+  cairo_save (cr);
+  if (simple_data->transform)
+    cairo_transform (cr, simple_data->transform);
+
+  cairo_translate (cr, layout_data->x, layout_data->y);
+
+  /* Initialize the layout data and ask all the children for their requested
+     area. */
+  goo_canvas_table_init_layout_data (table);
+  for (i = 0; i < table_data->children->len; i++)
+    layout_data->children[i].changed = TRUE;
+
+  goo_canvas_table_size_request (table, cr);
+  width = layout_data->requested_size[HORZ];
+  height = layout_data->requested_size[VERT];
+
   /* Copy the user bounds to the requested area. */
   requested_area->x1 = requested_area->y1 = 0.0;
   requested_area->x2 = width;
@@ -2141,6 +2354,7 @@ goo_canvas_table_allocate_area (GooCanvasItem         *item,
   GooCanvasTableLayoutData *layout_data = table_data->layout_data;
   gdouble requested_width, requested_height, allocated_width, allocated_height;
   gdouble width_proportion, height_proportion, min_proportion;
+  gint64 trace_time = GOO_CANVAS_TRACE_TIME ();
 
   requested_width = requested_area->x2 - requested_area->x1;
   requested_height = requested_area->y2 - requested_area->y1;
@@ -2204,16 +2418,120 @@ goo_canvas_table_allocate_area (GooCanvasItem         *item,
   goo_canvas_table_size_allocate_pass1 (table, VERT);
   goo_canvas_table_size_allocate_pass2 (table, VERT);
 
-  goo_canvas_table_size_allocate_pass3 (table, cr, x_offset, y_offset);
-
-  /* We free the children array but keep the dimension layout data, since
-     we may need that for clipping children. */
-  g_free (layout_data->children);
-  layout_data->children = NULL;
+  goo_canvas_table_size_allocate_pass3 (table, cr, x_offset, y_offset, FALSE);
 
   cairo_restore (cr);
 
   goo_canvas_request_item_redraw (simple->canvas, &simple->bounds, simple_data->is_static);
+
+  GOO_CANVAS_TRACE_MARK (trace_time, "Table allocate",
+			 "%i rows, %i columns, %u children",
+			 table_data->dimensions[VERT].size,
+			 table_data->dimensions[HORZ].size,
+			 table_data->children->len);
+}
+
+
+/* This tries to update the layout after some of the children have changed,
+   asking only those children for their requested area and allocating only
+   those children. It returns FALSE if the size of the table or any of its
+   rows or columns has changed, in which case a complete layout is needed. */
+static gboolean
+goo_canvas_table_update_changed_children (GooCanvasTable *table,
+					  cairo_t        *cr)
+{
+  GooCanvasItemSimple *simple = (GooCanvasItemSimple*) table;
+  GooCanvasItemSimpleData *simple_data = simple->simple_data;
+  GooCanvasGroup *group = (GooCanvasGroup*) table;
+  GooCanvasTableData *table_data = table->table_data;
+  GooCanvasTableLayoutData *layout_data = table_data->layout_data;
+  GooCanvasTableDimensionLayoutData *dldata;
+  GooCanvasItem *child_item;
+  GtkTextDirection direction = GTK_TEXT_DIR_NONE;
+  gdouble old_allocated_size[2];
+  gboolean changed = FALSE, relayout = FALSE;
+  gint i, d;
+
+  if (simple->canvas)
+    direction = gtk_widget_get_direction (GTK_WIDGET (simple->canvas));
+
+  if (!layout_data->children_valid || layout_data->layout_owner != table
+      || layout_data->direction != direction
+      || layout_data->n_children != table_data->children->len
+      || simple_data->visibility == GOO_CANVAS_ITEM_HIDDEN)
+    return FALSE;
+
+  /* Mark the children which need to be requested and allocated again.
+     We can only tell if simple items have changed, so any other items are
+     always requested again. */
+  for (i = 0; i < table_data->children->len; i++)
+    {
+      child_item = group->items->pdata[i];
+      layout_data->children[i].changed = !GOO_IS_CANVAS_ITEM_SIMPLE (child_item)
+	|| ((GooCanvasItemSimple*) child_item)->need_update;
+      if (layout_data->children[i].changed)
+	changed = TRUE;
+    }
+
+  if (!changed)
+    return TRUE;
+
+  old_allocated_size[HORZ] = layout_data->allocated_size[HORZ];
+  old_allocated_size[VERT] = layout_data->allocated_size[VERT];
+
+  cairo_save (cr);
+  if (simple_data->transform)
+    cairo_transform (cr, simple_data->transform);
+  cairo_translate (cr, layout_data->x, layout_data->y);
+
+  goo_canvas_table_init_layout_data (table);
+  goo_canvas_table_size_request (table, cr);
+
+  /* We allocate exactly what is requested, as in a complete layout. */
+  layout_data->allocated_size[HORZ] = layout_data->requested_size[HORZ];
+  layout_data->allocated_size[VERT] = layout_data->requested_size[VERT];
+  if (layout_data->integer_layout)
+    {
+      layout_data->allocated_size[HORZ] = floor (layout_data->requested_size[HORZ]);
+      layout_data->allocated_size[VERT] = floor (layout_data->requested_size[VERT]);
+    }
+  goo_canvas_table_update_requested_heights ((GooCanvasItem*) table, cr);
+
+  goo_canvas_table_size_allocate_init (table, VERT);
+  goo_canvas_table_size_allocate_pass1 (table, VERT);
+  goo_canvas_table_size_allocate_pass2 (table, VERT);
+
+  /* If any of the rows or columns have moved, all the children have to be
+     allocated again. */
+  if (layout_data->allocated_size[HORZ] != old_allocated_size[HORZ]
+      || layout_data->allocated_size[VERT] != old_allocated_size[VERT])
+    relayout = TRUE;
+
+  for (d = 0; d < 2 && !relayout; d++)
+    {
+      dldata = layout_data->dldata[d];
+      for (i = 0; i < table_data->dimensions[d].size; i++)
+	{
+	  if (dldata[i].start != dldata[i].last_start
+	      || dldata[i].end != dldata[i].last_end)
+	    {
+	      relayout = TRUE;
+	      break;
+	    }
+	}
+    }
+
+  if (!relayout)
+    {
+      goo_canvas_table_size_allocate_pass3 (table, cr, 0, 0, TRUE);
+
+      for (i = 0; i < table_data->children->len; i++)
+	layout_data->children[i].changed = FALSE;
+    }
+
+  cairo_restore (cr);
+
+  return !relayout;
 }
 
 
@@ -2224,10 +2542,26 @@ goo_canvas_table_update  (GooCanvasItem   *item,
 			  GooCanvasBounds *bounds)
 {
   GooCanvasItemSimple *simple = (GooCanvasItemSimple*) item;
+  GooCanvasTable *table = (GooCanvasTable*) item;
+  GooCanvasTableLayoutData *layout_data = table->table_data->layout_data;
+  GooCanvasTableDimensionLayoutData *dldata;
   GooCanvasBounds tmp_bounds;
+  gint i, d;
 
   if (entire_tree || simple->need_update)
     {
+      GOO_CANVAS_COUNT (items_updated);
+
+      /* If only some of the children have changed, try to avoid laying out
+	 the entire table again. */
+      if (!entire_tree && !simple->need_entire_subtree_update
+	  && goo_canvas_table_update_changed_children (table, cr))
+	{
+	  simple->need_update = FALSE;
+	  *bounds = simple->bounds;
+	  return;
+	}
+
       simple->need_update = FALSE;
       simple->need_entire_subtree_update = FALSE;
 
@@ -2238,6 +2572,27 @@ goo_canvas_table_update  (GooCanvasItem   *item,
 	{
 	  goo_canvas_table_allocate_area (item, cr, &tmp_bounds, &tmp_bounds,
 					  0, 0);
+
+	  /* Remember the layout so we can check if it changes when only some
+	     of the children are updated. */
+	  for (d = 0; d < 2; d++)
+	    {
+	      dldata = layout_data->dldata[d];
+	      for (i = 0; i < table->table_data->dimensions[d].size; i++)
+		{
+		  dldata[i].last_start = dldata[i].start;
+		  dldata[i].last_end = dldata[i].end;
+		}
+	    }
+
+	  for (i = 0; i < layout_data->n_children; i++)
+	    layout_data->children[i].changed = FALSE;
+
+	  layout_data->layout_owner = table;
+	  layout_data->direction = GTK_TEXT_DIR_NONE;
+	  if (simple->canvas)
+	    layout_data->direction = gtk_widget_get_direction (GTK_WIDGET (simple->canvas));
+	  layout_data->children_valid = TRUE;
 	}
     }
 
@@ -2245,6 +2600,207 @@ goo_canvas_table_update  (GooCanvasItem   *item,
 }
 
 
+/* Builds the indices of the children in each row and column. */
+static void
+goo_canvas_table_build_index (GooCanvasTable *table)
+{
+  GooCanvasTableData *table_data = table->table_data;
+  GooCanvasTableLayoutData *layout_data = table_data->layout_data;
+  GooCanvasTableChild *child;
+  gint size, *start, *next, i, d, pos, end;
+
+  g_array_set_size (layout_data->overflow_children, 0);
+  for (i = 0; i < table_data->children->len; i++)
+    if (layout_data->children[i].overflow)
+      g_array_append_val (layout_data->overflow_children, i);
+
+  for (d = 0; d < 2; d++)
+    {
+      size = table_data->dimensions[d].size;
+      start = g_renew (gint, layout_data->dim_children_start[d], size + 1);
+      layout_data->dim_children_start[d] = start;
+      memset (start, 0, (size + 1) * sizeof (gint));
+
+      /* Count the children in each row or column. */
+      for (i = 0; i < table_data->children->len; i++)
+	{
+	  child = &g_array_index (table_data->children, GooCanvasTableChild, i);
+	  if (layout_data->children[i].overflow)
+	    continue;
+
+	  end = MIN (child->start[d] + child->size[d], size);
+	  for (pos = child->start[d]; pos < end; pos++)
+	    start[pos + 1]++;
+	}
+
+      for (pos = 0; pos < size; pos++)
+	start[pos + 1] += start[pos];
+
+      /* Now fill in the children of each row or column, in stacking
+	 order. */
+      layout_data->dim_children[d] = g_renew (gint,
+					      layout_data->dim_children[d],
+					      start[size]);
+      next = g_memdup (start, size * sizeof (gint));
+
+      for (i = 0; i < table_data->children->len; i++)
+	{
+	  child = &g_array_index (table_data->children, GooCanvasTableChild, i);
+	  if (layout_data->children[i].overflow)
+	    continue;
+
+	  end = MIN (child->start[d] + child->size[d], size);
+	  for (pos = child->start[d]; pos < end; pos++)
+	    layout_data->dim_children[d][next[pos]++] = i;
+	}
+
+      g_free (next);
+    }
+
+  layout_data->index_valid = TRUE;
+}
+
+
+/* Returns the range of rows or columns which overlap the given range of
+   positions, using a binary search. It returns FALSE if there are none. */
+static gboolean
+goo_canvas_table_find_dimension_range (GooCanvasTableDimensionLayoutData *dldata,
+				       gint                               size,
+				       gdouble                            pos1,
+				       gdouble                            pos2,
+				       gint                              *first,
+				       gint                              *last)
+{
+  gint low, high, mid;
+
+  /* Find the first row or column which ends at or after pos1. */
+  low = 0;
+  high = size;
+  while (low < high)
+    {
+      mid = low + (high - low) / 2;
+      if (dldata[mid].end < pos1)
+	low = mid + 1;
+      else
+	high = mid;
+    }
+  *first = low;
+
+  /* Find the last row or column which starts at or before pos2. */
+  low = -1;
+  high = size - 1;
+  while (low < high)
+    {
+      mid = low + (high - low + 1) / 2;
+      if (dldata[mid].start <= pos2)
+	low = mid;
+      else
+	high = mid - 1;
+    }
+  *last = low;
+
+  return *first <= *last;
+}
+
+
+static gint
+goo_canvas_table_compare_child_nums (gconstpointer a,
+				     gconstpointer b)
+{
+  return *(const gint*) a - *(const gint*) b;
+}
+
+
+/* Returns the indices of the children which may be in the given area, in the
+   table's coordinate space, in stacking order. It returns NULL if the
+   layout isn't complete, in which case all the children must be checked. */
+static GArray*
+goo_canvas_table_find_children (GooCanvasTable *table,
+				gdouble         x1,
+				gdouble         y1,
+				gdouble         x2,
+				gdouble         y2)
+{
+  GooCanvasItemSimple *simple = (GooCanvasItemSimple*) table;
+  GooCanvasTableData *table_data = table->table_data;
+  GooCanvasTableLayoutData *layout_data = table_data->layout_data;
+  GooCanvasTableChildLayoutData *child_data;
+  GooCanvasTableChild *child;
+  GArray *found;
+  gdouble tmp;
+  gint first[2], last[2], *start, d, other, pos, i, j;
+
+  if (!layout_data->children
+      || layout_data->n_children != table_data->children->len)
+    return NULL;
+
+  if (!layout_data->index_valid)
+    goo_canvas_table_build_index (table);
+
+  found = g_array_new (FALSE, FALSE, sizeof (gint));
+  g_array_append_vals (found, layout_data->overflow_children->data,
+		       layout_data->overflow_children->len);
+
+  /* Columns are laid out from the right in right-to-left locales. */
+  if (simple->canvas
+      && gtk_widget_get_direction (GTK_WIDGET (simple->canvas)) == GTK_TEXT_DIR_RTL)
+    {
+      tmp = x1;
+      x1 = layout_data->allocated_size[HORZ] - x2;
+      x2 = layout_data->allocated_size[HORZ] - tmp;
+    }
+
+  if (goo_canvas_table_find_dimension_range (layout_data->dldata[VERT],
+					     table_data->dimensions[VERT].size,
+					     y1, y2, &first[VERT], &last[VERT])
+      && goo_canvas_table_find_dimension_range (layout_data->dldata[HORZ],
+						table_data->dimensions[HORZ].size,
+						x1, x2, &first[HORZ],
+						&last[HORZ]))
+    {
+      /* We use the index of whichever dimension has the fewest children in
+	 the area, and check the children against the other dimension. */
+      start = layout_data->dim_children_start[VERT];
+      d = start[last[VERT] + 1] - start[first[VERT]];
+      start = layout_data->dim_children_start[HORZ];
+      d = (start[last[HORZ] + 1] - start[first[HORZ]] < d) ? HORZ : VERT;
+      other = 1 - d;
+      start = layout_data->dim_children_start[d];
+
+      /* Children spanning several rows or columns are in the index of each
+	 one, so we use a serial number to make sure we only add them once. */
+      layout_data->find_serial++;
+
+      for (pos = first[d]; pos <= last[d]; pos++)
+	{
+	  for (j = start[pos]; j < start[pos + 1]; j++)
+	    {
+	      i = layout_data->dim_children[d][j];
+	      child_data = &layout_data->children[i];
+	      if (child_data->find_serial == layout_data->find_serial)
+		continue;
+	      child_data->find_serial = layout_data->find_serial;
+
+	      child = &g_array_index (table_data->children,
+				      GooCanvasTableChild, i);
+	      if (child->start[other] > last[other]
+		  || child->start[other] + child->size[other] - 1 < first[other])
+		continue;
+
+	      g_array_append_val (found, i);
+	    }
+	}
+
+      /* The children of each row or column are already in stacking
+	 order. */
+      if (layout_data->overflow_children->len > 0 || last[d] > first[d])
+	g_array_sort (found, goo_canvas_table_compare_child_nums);
+    }
+
+  return found;
+}
+
+
 static void
 goo_canvas_table_paint (GooCanvasItem         *item,
 			cairo_t               *cr,
@@ -2266,8 +2822,10 @@ goo_canvas_table_paint (GooCanvasItem         *item,
   GooCanvasTableChild *table_child;
   GooCanvasItem *child;
   gboolean check_clip = FALSE, clip;
-  gint start_column, end_column, start_row, end_row, i, j;
+  gint start_column, end_column, start_row, end_row, i, j, k, n_found;
   gdouble x, y, end_x, end_y, clip_width, clip_height;
+  gdouble clip_x1, clip_y1, clip_x2, clip_y2;
+  GArray *found;
   gdouble frame_width, frame_height;
   gdouble line_start, line_end;
   gdouble spacing, half_spacing_before, half_spacing_after;
@@ -2277,14 +2835,19 @@ goo_canvas_table_paint (GooCanvasItem         *item,
   /* Skip the item if the bounds don't intersect the expose rectangle. */
   if (simple->bounds.x1 > bounds->x2 || simple->bounds.x2 < bounds->x1
       || simple->bounds.y1 > bounds->y2 || simple->bounds.y2 < bounds->y1)
-    return;
+    {
+      GOO_CANVAS_COUNT (items_culled);
+      return;
+    }
 
   /* Check if the item should be visible. */
   if (simple_data->visibility <= GOO_CANVAS_ITEM_INVISIBLE
       || (simple_data->visibility == GOO_CANVAS_ITEM_VISIBLE_ABOVE_THRESHOLD
-	  && simple->canvas->scale < simple_data->visibility_threshold))
+	  && scale < simple_data->visibility_threshold))
     return;
 
+  GOO_CANVAS_COUNT (items_painted);
+
   if (simple->canvas)
     direction = gtk_widget_get_direction (GTK_WIDGET (simple->canvas));
 
@@ -2296,11 +2859,7 @@ goo_canvas_table_paint (GooCanvasItem         *item,
 
   /* Clip with the table's clip path, if it is set. */
   if (simple_data->clip_path_commands)
-    {
-      goo_canvas_create_path (simple_data->clip_path_commands, cr);
-      cairo_set_fill_rule (cr, simple_data->clip_fill_rule);
-      cairo_clip (cr);
-    }
+    goo_canvas_item_simple_data_clip (simple_data, cr);
 
   /* Check if the table was allocated less space than it requested, in which
      case we may need to clip children. */
@@ -2480,8 +3039,15 @@ goo_canvas_table_paint (GooCanvasItem         *item,
 
   cairo_restore (cr);
 
-  for (i = 0; i < group->items->len; i++)
+  /* Only paint the children in the rows and columns being painted. */
+  cairo_clip_extents (cr, &clip_x1, &clip_y1, &clip_x2, &clip_y2);
+  found = goo_canvas_table_find_children (table, clip_x1, clip_y1,
+					  clip_x2, clip_y2);
+  n_found = found ? found->len : group->items->len;
+
+  for (k = 0; k < n_found; k++)
     {
+      i = found ? g_array_index (found, gint, k) : k;
       child = group->items->pdata[i];
 
       table_child = &g_array_index (children, GooCanvasTableChild, i);
@@ -2550,6 +3116,10 @@ goo_canvas_table_paint (GooCanvasItem         *item,
       if (clip)
 	cairo_restore (cr);
     }
+
+  if (found)
+    g_array_free (found, TRUE);
+
   cairo_restore (cr);
 }
 
@@ -2576,8 +3146,9 @@ goo_canvas_table_get_items_at (GooCanvasItem  *item,
   GooCanvasItem *child;
   gboolean visible = parent_visible, check_clip = FALSE;
   double user_x = x, user_y = y;
-  gint start_column, end_column, start_row, end_row, i;
+  gint start_column, end_column, start_row, end_row, i, k, n_candidates;
   gdouble start_x, end_x, start_y, end_y;
+  GArray *candidates;
 
   if (simple->need_update)
     goo_canvas_item_ensure_updated (item);
@@ -2589,7 +3160,7 @@ goo_canvas_table_get_items_at (GooCanvasItem  *item,
 
   if (simple_data->visibility <= GOO_CANVAS_ITEM_INVISIBLE
       || (simple_data->visibility == GOO_CANVAS_ITEM_VISIBLE_ABOVE_THRESHOLD
-	  && simple->canvas->scale < simple_data->visibility_threshold))
+	  && goo_canvas_get_hit_test_scale (simple->canvas, cr) < simple_data->visibility_threshold))
     visible = FALSE;
 
   /* Check if the group should receive events. */
@@ -2609,9 +3180,8 @@ goo_canvas_table_get_items_at (GooCanvasItem  *item,
   /* If the table has a clip path, check if the point is inside it. */
   if (simple_data->clip_path_commands)
     {
-      goo_canvas_create_path (simple_data->clip_path_commands, cr);
-      cairo_set_fill_rule (cr, simple_data->clip_fill_rule);
-      if (!cairo_in_fill (cr, user_x, user_y))
+      if (!goo_canvas_item_simple_data_in_clip (simple_data, cr,
+						user_x, user_y))
 	{
 	  cairo_restore (cr);
 	  return found_items;
@@ -2624,10 +3194,17 @@ goo_canvas_table_get_items_at (GooCanvasItem  *item,
       || layout_data->allocated_size[VERT] < layout_data->natural_size[VERT])
     check_clip = TRUE;
 
+  /* Only the children in the row and column containing the point, and any
+     children which overflow their cells, need to be checked. */
+  candidates = goo_canvas_table_find_children (table, user_x, user_y,
+					       user_x, user_y);
+  n_candidates = candidates ? candidates->len : group->items->len;
+
   /* Step up from the bottom of the children to the top, adding any items
      found to the start of the list. */
-  for (i = 0; i < group->items->len; i++)
+  for (k = 0; k < n_candidates; k++)
     {
+      i = candidates ? g_array_index (candidates, gint, k) : k;
       child = group->items->pdata[i];
 
       table_child = &g_array_index (children, GooCanvasTableChild, i);
@@ -2670,6 +3247,10 @@ goo_canvas_table_get_items_at (GooCanvasItem  *item,
       cairo_translate (cr, -table_child->position[HORZ],
 		       -table_child->position[VERT]);
     }
+
+  if (candidates)
+    g_array_free (candidates, TRUE);
+
   cairo_restore (cr);
 
   return found_items;
@@ -2720,6 +3301,7 @@ static void
 item_interface_init (GooCanvasItemIface *iface)
 {
   iface->add_child               = goo_canvas_table_add_child;
+  iface->add_children            = goo_canvas_table_add_children;
   iface->move_child              = goo_canvas_table_move_child;
   iface->remove_child            = goo_canvas_table_remove_child;
   iface->get_child_property      = goo_canvas_table_get_child_property;
@@ -2924,7 +3506,8 @@ goo_canvas_table_model_set_property (GObject              *object,
 							   &emodel->table_data,
 							   prop_id, value,
 							   pspec);
-  g_signal_emit_by_name (emodel, "changed", recompute_bounds);
+  _goo_canvas_item_model_emit_changed ((GooCanvasItemModel*) emodel,
+				       recompute_bounds);
 }
 
 
@@ -2942,6 +3525,25 @@ goo_canvas_table_model_add_child     (GooCanvasItemModel *model,
 }
 
 
+static void
+goo_canvas_table_model_add_children  (GooCanvasItemModel  *model,
+				      GooCanvasItemModel **children,
+				      gint                 n_children,
+				      gint                 position)
+{
+  GooCanvasTableModel *tmodel = (GooCanvasTableModel*) model;
+  gint i;
+
+  for (i = 0; i < n_children; i++)
+    goo_canvas_table_add_child_internal (&tmodel->table_data,
+					 position < 0 ? -1 : position + i);
+
+  /* Let the parent GooCanvasGroupModel code do the rest. */
+  goo_canvas_table_model_parent_iface->add_children (model, children,
+						     n_children, position);
+}
+
+
 static void
 goo_canvas_table_model_move_child    (GooCanvasItemModel *model,
 				      gint	          old_position,
@@ -3026,7 +3628,7 @@ goo_canvas_table_model_set_child_property (GooCanvasItemModel *model,
 	}
     }
 
-  g_signal_emit_by_name (tmodel, "changed", TRUE);
+  _goo_canvas_item_model_emit_changed ((GooCanvasItemModel*) tmodel, TRUE);
 }
 
 
@@ -3050,6 +3652,7 @@ static void
 item_model_interface_init (GooCanvasItemModelIface *iface)
 {
   iface->add_child          = goo_canvas_table_model_add_child;
+  iface->add_children       = goo_canvas_table_model_add_children;
   iface->move_child         = goo_canvas_table_model_move_child;
   iface->remove_child       = goo_canvas_table_model_remove_child;
   iface->get_child_property = goo_canvas_table_model_get_child_property;
@@ -31,6 +31,7 @@
 #include <config.h>
 #include <glib/gi18n-lib.h>
 #include <gtk/gtk.h>
+#include "goocanvasprivate.h"
 #include "goocanvastext.h"
 #include "goocanvas.h"
 
@@ -444,6 +445,7 @@ goo_canvas_text_create_layout (GooCanvasItemSimpleData *simple_data,
   string = text_data->text ? text_data->text : "";
 
   layout = pango_cairo_create_layout (cr);
+  GOO_CANVAS_COUNT (layouts_created);
   context = pango_layout_get_context (layout);
 
   if (layout_width > 0)
@@ -1093,7 +1095,7 @@ goo_canvas_text_model_set_property (GObject              *object,
 
   goo_canvas_text_set_common_property (object, &tmodel->text_data, priv,
 				       prop_id, value, pspec);
-  g_signal_emit_by_name (tmodel, "changed", TRUE);
+  _goo_canvas_item_model_emit_changed ((GooCanvasItemModel*) tmodel, TRUE);
 }
 
 
@@ -0,0 +1,859 @@
+/*
+ * GooCanvas. Copyright (C) 2005 Damon Chaplin.
+ * Released under the GNU LGPL license. See COPYING for details.
+ *
+ * goocanvastiledimage.c - tiled image item.
+ */
+
+/**
+ * SECTION:goocanvastiledimage
+ * @Title: GooCanvasTiledImage
+ * @Short_Description: a large image item, loaded in tiles.
+ *
+ * GooCanvasTiledImage represents an image which is too large to be held in
+ * memory as a single #GdkPixbuf, such as a huge map or scanned document.
+ *
+ * The image is divided into a grid of tiles of #GooCanvasTiledImage:tile-width
+ * by #GooCanvasTiledImage:tile-height pixels. Tiles are only loaded when they
+ * need to be painted, either by calling a #GooCanvasTileFunc set with
+ * goo_canvas_tiled_image_set_tile_func() or by loading image files named
+ * according to a template set with
+ * goo_canvas_tiled_image_set_tile_file_template().
+ *
+ * Note that a single large image file can't be used directly. #GdkPixbuf
+ * can only decode an entire image, so loading one tile from a single file
+ * would need as much memory as loading the whole image. Either split the
+ * image into tile files beforehand, e.g. with "vips dzsave" or ImageMagick's
+ * "convert -crop 256x256", or use a #GooCanvasTileFunc which decodes
+ * regions of the file with a library that supports that, such as libvips
+ * or OpenSlide.
+ *
+ * Loaded tiles are kept in a cache, and the least recently used tiles are
+ * freed when the total size of the cache exceeds the
+ * #GooCanvasTiledImage:max-tile-memory property. Tiles that are needed for
+ * the current paint are never freed, so the cache may grow beyond this limit
+ * if it is too small to hold all the visible tiles.
+ *
+ * It is a subclass of #GooCanvasItemSimple and so inherits all of the style
+ * properties such as "operator" and "pointer-events".
+ *
+ * It also implements the #GooCanvasItem interface, so you can use the
+ * #GooCanvasItem functions such as goo_canvas_item_raise() and
+ * goo_canvas_item_rotate().
+ *
+ * Note that #GooCanvasTiledImage doesn't have a model/view variant like
+ * the other standard items, so it can only be used in a simple canvas
+ * without a model.
+ *
+ * To create a #GooCanvasTiledImage use goo_canvas_tiled_image_new().
+ *
+ * To get or set the properties of an existing #GooCanvasTiledImage, use
+ * g_object_get() and g_object_set().
+ */
+#include <config.h>
+#include <string.h>
+#include <math.h>
+#include <glib/gi18n-lib.h>
+#include <gtk/gtk.h>
+#include "goocanvasprivate.h"
+#include "goocanvastiledimage.h"
+#include "goocanvas.h"
+
+
+#define GOO_CANVAS_TILED_IMAGE_DEFAULT_TILE_SIZE   256
+#define GOO_CANVAS_TILED_IMAGE_DEFAULT_MAX_MEMORY  (64 * 1024 * 1024)
+
+
+/* A loaded tile. The surface is NULL if the tile couldn't be loaded, so we
+   don't keep trying to load it. */
+typedef struct _GooCanvasTile GooCanvasTile;
+struct _GooCanvasTile
+{
+  gint64 key;
+  cairo_surface_t *surface;
+  gsize n_bytes;
+
+  /* The paint in which the tile was last used. */
+  guint paint_serial;
+
+  /* The link in the LRU queue, whose data is the tile itself. */
+  GList link;
+};
+
+
+typedef struct _GooCanvasTiledImagePrivate GooCanvasTiledImagePrivate;
+struct _GooCanvasTiledImagePrivate {
+  GooCanvasTileFunc tile_func;
+  gpointer tile_data;
+  GDestroyNotify tile_notify;
+
+  /* The loaded tiles, hashed by their column and row, and the queue of
+     tiles with the most recently used at the head. */
+  GHashTable *tiles;
+  GQueue lru;
+
+  gsize memory_used;
+  guint64 max_memory;
+
+  guint paint_serial;
+};
+
+#define GOO_CANVAS_TILED_IMAGE_GET_PRIVATE(image)  \
+   (G_TYPE_INSTANCE_GET_PRIVATE ((image), GOO_TYPE_CANVAS_TILED_IMAGE, GooCanvasTiledImagePrivate))
+
+
+enum {
+  PROP_0,
+
+  PROP_X,
+  PROP_Y,
+  PROP_WIDTH,
+  PROP_HEIGHT,
+  PROP_ALPHA,
+  PROP_IMAGE_WIDTH,
+  PROP_IMAGE_HEIGHT,
+  PROP_TILE_WIDTH,
+  PROP_TILE_HEIGHT,
+  PROP_MAX_TILE_MEMORY
+};
+
+static void goo_canvas_tiled_image_dispose      (GObject            *object);
+static void goo_canvas_tiled_image_finalize     (GObject            *object);
+static void goo_canvas_tiled_image_get_property (GObject            *object,
+						 guint               param_id,
+						 GValue             *value,
+						 GParamSpec         *pspec);
+static void goo_canvas_tiled_image_set_property (GObject            *object,
+						 guint               param_id,
+						 const GValue       *value,
+						 GParamSpec         *pspec);
+
+G_DEFINE_TYPE (GooCanvasTiledImage, goo_canvas_tiled_image,
+	       GOO_TYPE_CANVAS_ITEM_SIMPLE)
+
+
+static void
+goo_canvas_tiled_image_free_tile (gpointer data)
+{
+  GooCanvasTile *tile = data;
+
+  if (tile->surface)
+    cairo_surface_destroy (tile->surface);
+  g_slice_free (GooCanvasTile, tile);
+}
+
+
+static void
+goo_canvas_tiled_image_init (GooCanvasTiledImage *image)
+{
+  GooCanvasTiledImagePrivate *priv = GOO_CANVAS_TILED_IMAGE_GET_PRIVATE (image);
+
+  image->tile_width = GOO_CANVAS_TILED_IMAGE_DEFAULT_TILE_SIZE;
+  image->tile_height = GOO_CANVAS_TILED_IMAGE_DEFAULT_TILE_SIZE;
+  image->alpha = 1.0;
+
+  priv->tiles = g_hash_table_new_full (g_int64_hash, g_int64_equal, NULL,
+				       goo_canvas_tiled_image_free_tile);
+  g_queue_init (&priv->lru);
+  priv->max_memory = GOO_CANVAS_TILED_IMAGE_DEFAULT_MAX_MEMORY;
+}
+
+
+/**
+ * goo_canvas_tiled_image_new:
+ * @parent: (skip): the parent item, or %NULL. If a parent is specified, it will assume
+ *  ownership of the item, and the item will automatically be freed when it is
+ *  removed from the parent. Otherwise call g_object_unref() to free it.
+ * @image_width: the width of the entire image, in pixels.
+ * @image_height: the height of the entire image, in pixels.
+ * @x: the x coordinate of the image.
+ * @y: the y coordinate of the image.
+ * @...: optional pairs of property names and values, and a terminating %NULL.
+ *
+ * Creates a new tiled image item. The image is displayed at its natural
+ * size unless the #GooCanvasTiledImage:width and
+ * #GooCanvasTiledImage:height properties are set.
+ *
+ * Use goo_canvas_tiled_image_set_tile_func() or
+ * goo_canvas_tiled_image_set_tile_file_template() to specify where the
+ * tiles are loaded from.
+ *
+ * Here's an example showing how to create a 20000x20000 pixel image made
+ * from 512x512 pixel tiles stored in PNG files:
+ *
+ * <informalexample><programlisting>
+ *  GooCanvasItem *image = goo_canvas_tiled_image_new (mygroup, 20000, 20000,
+ *                                                     0.0, 0.0,
+ *                                                     "tile-width", 512,
+ *                                                     "tile-height", 512,
+ *                                                     NULL);
+ *  goo_canvas_tiled_image_set_tile_file_template (GOO_CANVAS_TILED_IMAGE (image),
+ *                                                 "tiles/{column}-{row}.png");
+ * </programlisting></informalexample>
+ *
+ * Returns: (transfer full): a new tiled image item.
+ *
+ * Since: 3.0
+ **/
+GooCanvasItem*
+goo_canvas_tiled_image_new (GooCanvasItem *parent,
+			    gint           image_width,
+			    gint           image_height,
+			    gdouble        x,
+			    gdouble        y,
+			    ...)
+{
+  GooCanvasItem *item;
+  GooCanvasTiledImage *image;
+  const char *first_property;
+  va_list var_args;
+
+  item = g_object_new (GOO_TYPE_CANVAS_TILED_IMAGE, NULL);
+
+  if (parent)
+    {
+      goo_canvas_item_add_child (parent, item, -1);
+      g_object_unref (item);
+    }
+
+  image = (GooCanvasTiledImage*) item;
+  image->image_width = image_width;
+  image->image_height = image_height;
+  image->x = x;
+  image->y = y;
+
+  va_start (var_args, y);
+  first_property = va_arg (var_args, char*);
+  if (first_property)
+    g_object_set_valist ((GObject*) item, first_property, var_args);
+  va_end (var_args);
+
+  return item;
+}
+
+
+/* This is used by goo_canvas_get_memory_stats(). */
+gsize
+goo_canvas_tiled_image_get_memory_used (GooCanvasTiledImage *image)
+{
+  GooCanvasTiledImagePrivate *priv = GOO_CANVAS_TILED_IMAGE_GET_PRIVATE (image);
+
+  return priv->memory_used
+    + g_queue_get_length (&priv->lru) * sizeof (GooCanvasTile);
+}
+
+
+static void
+goo_canvas_tiled_image_dispose (GObject *object)
+{
+  GooCanvasTiledImagePrivate *priv = GOO_CANVAS_TILED_IMAGE_GET_PRIVATE (object);
+
+  g_queue_init (&priv->lru);
+  g_hash_table_remove_all (priv->tiles);
+  priv->memory_used = 0;
+
+  if (priv->tile_notify)
+    priv->tile_notify (priv->tile_data);
+  priv->tile_func = NULL;
+  priv->tile_data = NULL;
+  priv->tile_notify = NULL;
+
+  G_OBJECT_CLASS (goo_canvas_tiled_image_parent_class)->dispose (object);
+}
+
+
+static void
+goo_canvas_tiled_image_finalize (GObject *object)
+{
+  GooCanvasTiledImagePrivate *priv = GOO_CANVAS_TILED_IMAGE_GET_PRIVATE (object);
+
+  g_hash_table_destroy (priv->tiles);
+
+  G_OBJECT_CLASS (goo_canvas_tiled_image_parent_class)->finalize (object);
+}
+
+
+/* Frees the least recently used tiles until the cache fits within its
+   memory limit, though never tiles used in the latest paint. */
+static void
+goo_canvas_tiled_image_trim_tiles (GooCanvasTiledImage *image)
+{
+  GooCanvasTiledImagePrivate *priv = GOO_CANVAS_TILED_IMAGE_GET_PRIVATE (image);
+  GooCanvasTile *tile;
+
+  while (priv->memory_used > priv->max_memory && priv->lru.tail)
+    {
+      tile = priv->lru.tail->data;
+      if (tile->paint_serial == priv->paint_serial)
+	break;
+
+      g_queue_unlink (&priv->lru, &tile->link);
+      priv->memory_used -= tile->n_bytes;
+      g_hash_table_remove (priv->tiles, &tile->key);
+    }
+}
+
+
+/* Returns the surface for the given tile, loading it if necessary. The
+   returned surface is owned by the cache and may be NULL. */
+static cairo_surface_t*
+goo_canvas_tiled_image_get_tile (GooCanvasTiledImage *image,
+				 gint                 column,
+				 gint                 row)
+{
+  GooCanvasTiledImagePrivate *priv = GOO_CANVAS_TILED_IMAGE_GET_PRIVATE (image);
+  GooCanvasTile *tile;
+  gint64 key = ((gint64) row << 32) | (guint32) column;
+  cairo_surface_t *surface;
+
+  tile = g_hash_table_lookup (priv->tiles, &key);
+  if (tile)
+    {
+      /* Move it to the head of the LRU queue. */
+      g_queue_unlink (&priv->lru, &tile->link);
+      g_queue_push_head_link (&priv->lru, &tile->link);
+      tile->paint_serial = priv->paint_serial;
+      return tile->surface;
+    }
+
+  surface = priv->tile_func (image, column, row, priv->tile_data);
+  if (surface && cairo_surface_status (surface) != CAIRO_STATUS_SUCCESS)
+    {
+      cairo_surface_destroy (surface);
+      surface = NULL;
+    }
+
+  tile = g_slice_new0 (GooCanvasTile);
+  tile->key = key;
+  tile->surface = surface;
+  tile->paint_serial = priv->paint_serial;
+  tile->link.data = tile;
+
+  if (surface)
+    {
+      if (cairo_surface_get_type (surface) == CAIRO_SURFACE_TYPE_IMAGE)
+	tile->n_bytes = (gsize) cairo_image_surface_get_stride (surface)
+	  * cairo_image_surface_get_height (surface);
+      else
+	tile->n_bytes = (gsize) 4 * image->tile_width * image->tile_height;
+    }
+
+  g_hash_table_insert (priv->tiles, &tile->key, tile);
+  g_queue_push_head_link (&priv->lru, &tile->link);
+  priv->memory_used += tile->n_bytes;
+
+  return surface;
+}
+
+
+static void
+goo_canvas_tiled_image_get_size (GooCanvasTiledImage *image,
+				 gdouble             *width,
+				 gdouble             *height)
+{
+  *width = image->width > 0.0 ? image->width : image->image_width;
+  *height = image->height > 0.0 ? image->height : image->image_height;
+}
+
+
+static void
+goo_canvas_tiled_image_get_property (GObject              *object,
+				     guint                 prop_id,
+				     GValue               *value,
+				     GParamSpec           *pspec)
+{
+  GooCanvasTiledImagePrivate *priv = GOO_CANVAS_TILED_IMAGE_GET_PRIVATE (object);
+  GooCanvasTiledImage *image = (GooCanvasTiledImage*) object;
+
+  switch (prop_id)
+    {
+    case PROP_X:
+      g_value_set_double (value, image->x);
+      break;
+    case PROP_Y:
+      g_value_set_double (value, image->y);
+      break;
+    case PROP_WIDTH:
+      g_value_set_double (value, image->width);
+      break;
+    case PROP_HEIGHT:
+      g_value_set_double (value, image->height);
+      break;
+    case PROP_ALPHA:
+      g_value_set_double (value, image->alpha);
+      break;
+    case PROP_IMAGE_WIDTH:
+      g_value_set_int (value, image->image_width);
+      break;
+    case PROP_IMAGE_HEIGHT:
+      g_value_set_int (value, image->image_height);
+      break;
+    case PROP_TILE_WIDTH:
+      g_value_set_int (value, image->tile_width);
+      break;
+    case PROP_TILE_HEIGHT:
+      g_value_set_int (value, image->tile_height);
+      break;
+    case PROP_MAX_TILE_MEMORY:
+      g_value_set_uint64 (value, priv->max_memory);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+    }
+}
+
+
+static void
+goo_canvas_tiled_image_set_property (GObject              *object,
+				     guint                 prop_id,
+				     const GValue         *value,
+				     GParamSpec           *pspec)
+{
+  GooCanvasTiledImagePrivate *priv = GOO_CANVAS_TILED_IMAGE_GET_PRIVATE (object);
+  GooCanvasItemSimple *simple = (GooCanvasItemSimple*) object;
+  GooCanvasTiledImage *image = (GooCanvasTiledImage*) object;
+  gboolean recompute_bounds = TRUE, invalidate_tiles = FALSE;
+
+  switch (prop_id)
+    {
+    case PROP_X:
+      image->x = g_value_get_double (value);
+      break;
+    case PROP_Y:
+      image->y = g_value_get_double (value);
+      break;
+    case PROP_WIDTH:
+      image->width = g_value_get_double (value);
+      break;
+    case PROP_HEIGHT:
+      image->height = g_value_get_double (value);
+      break;
+    case PROP_ALPHA:
+      image->alpha = g_value_get_double (value);
+      recompute_bounds = FALSE;
+      break;
+    case PROP_IMAGE_WIDTH:
+      image->image_width = g_value_get_int (value);
+      invalidate_tiles = TRUE;
+      break;
+    case PROP_IMAGE_HEIGHT:
+      image->image_height = g_value_get_int (value);
+      invalidate_tiles = TRUE;
+      break;
+    case PROP_TILE_WIDTH:
+      image->tile_width = g_value_get_int (value);
+      invalidate_tiles = TRUE;
+      break;
+    case PROP_TILE_HEIGHT:
+      image->tile_height = g_value_get_int (value);
+      invalidate_tiles = TRUE;
+      break;
+    case PROP_MAX_TILE_MEMORY:
+      priv->max_memory = g_value_get_uint64 (value);
+      goo_canvas_tiled_image_trim_tiles (image);
+      recompute_bounds = FALSE;
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+    }
+
+  if (invalidate_tiles)
+    {
+      g_queue_init (&priv->lru);
+      g_hash_table_remove_all (priv->tiles);
+      priv->memory_used = 0;
+    }
+
+  goo_canvas_item_simple_changed (simple, recompute_bounds);
+}
+
+
+/**
+ * goo_canvas_tiled_image_set_tile_func:
+ * @image: a #GooCanvasTiledImage.
+ * @tile_func: (allow-none): the function to call to load a tile.
+ * @user_data: data to pass to @tile_func.
+ * @notify: (allow-none): the function to call to free @user_data when it is
+ *  no longer needed.
+ *
+ * Sets the function used to load the tiles of the image. @tile_func is only
+ * called when a tile needs to be painted and is not already in the cache.
+ *
+ * If @tile_func returns %NULL the tile is left blank, and it won't be
+ * requested again until goo_canvas_tiled_image_invalidate_tiles() is called.
+ *
+ * Since: 3.0
+ **/
+void
+goo_canvas_tiled_image_set_tile_func (GooCanvasTiledImage *image,
+				      GooCanvasTileFunc    tile_func,
+				      gpointer             user_data,
+				      GDestroyNotify       notify)
+{
+  GooCanvasTiledImagePrivate *priv;
+
+  g_return_if_fail (GOO_IS_CANVAS_TILED_IMAGE (image));
+
+  priv = GOO_CANVAS_TILED_IMAGE_GET_PRIVATE (image);
+
+  if (priv->tile_notify)
+    priv->tile_notify (priv->tile_data);
+
+  priv->tile_func = tile_func;
+  priv->tile_data = user_data;
+  priv->tile_notify = notify;
+
+  goo_canvas_tiled_image_invalidate_tiles (image);
+}
+
+
+/* Substitutes the column and row into the filename template. */
+static gchar*
+goo_canvas_tiled_image_expand_template (const gchar *filename_template,
+					gint         column,
+					gint         row)
+{
+  GString *filename = g_string_new (NULL);
+  const gchar *p = filename_template;
+
+  while (*p)
+    {
+      if (!strncmp (p, "{column}", 8))
+	{
+	  g_string_append_printf (filename, "%i", column);
+	  p += 8;
+	}
+      else if (!strncmp (p, "{row}", 5))
+	{
+	  g_string_append_printf (filename, "%i", row);
+	  p += 5;
+	}
+      else
+	{
+	  g_string_append_c (filename, *p);
+	  p++;
+	}
+    }
+
+  return g_string_free (filename, FALSE);
+}
+
+
+static cairo_surface_t*
+goo_canvas_tiled_image_load_tile_file (GooCanvasTiledImage *image,
+				       gint                 column,
+				       gint                 row,
+				       gpointer             user_data)
+{
+  const gchar *filename_template = user_data;
+  cairo_surface_t *surface;
+  GdkPixbuf *pixbuf;
+  GError *error = NULL;
+  gchar *filename;
+
+  filename = goo_canvas_tiled_image_expand_template (filename_template,
+						     column, row);
+  pixbuf = gdk_pixbuf_new_from_file (filename, &error);
+  if (!pixbuf)
+    {
+      g_warning ("Couldn't load image tile %s: %s", filename, error->message);
+      g_error_free (error);
+      g_free (filename);
+      return NULL;
+    }
+  g_free (filename);
+
+  /* The tile is owned by our own cache, so we don't share its surface. */
+  surface = goo_canvas_cairo_surface_from_pixbuf (pixbuf);
+  g_object_unref (pixbuf);
+
+  return surface;
+}
+
+
+/**
+ * goo_canvas_tiled_image_set_tile_file_template:
+ * @image: a #GooCanvasTiledImage.
+ * @filename_template: the filename of the tile image files, with
+ *  "{column}" and "{row}" in place of the column and row of each tile.
+ *
+ * Sets the image to load its tiles from image files, such as
+ * "tiles/{column}-{row}.png". The files can be in any format supported by
+ * #GdkPixbuf.
+ *
+ * Since: 3.0
+ **/
+void
+goo_canvas_tiled_image_set_tile_file_template (GooCanvasTiledImage *image,
+					       const gchar         *filename_template)
+{
+  g_return_if_fail (GOO_IS_CANVAS_TILED_IMAGE (image));
+  g_return_if_fail (filename_template != NULL);
+
+  goo_canvas_tiled_image_set_tile_func (image,
+					goo_canvas_tiled_image_load_tile_file,
+					g_strdup (filename_template), g_free);
+}
+
+
+/**
+ * goo_canvas_tiled_image_invalidate_tiles:
+ * @image: a #GooCanvasTiledImage.
+ *
+ * Frees all the loaded tiles, so they are loaded again when they are next
+ * painted. This should be called if the contents of the tiles change.
+ *
+ * Since: 3.0
+ **/
+void
+goo_canvas_tiled_image_invalidate_tiles (GooCanvasTiledImage *image)
+{
+  GooCanvasTiledImagePrivate *priv;
+
+  g_return_if_fail (GOO_IS_CANVAS_TILED_IMAGE (image));
+
+  priv = GOO_CANVAS_TILED_IMAGE_GET_PRIVATE (image);
+
+  g_queue_init (&priv->lru);
+  g_hash_table_remove_all (priv->tiles);
+  priv->memory_used = 0;
+
+  goo_canvas_item_simple_changed ((GooCanvasItemSimple*) image, FALSE);
+}
+
+
+static gboolean
+goo_canvas_tiled_image_is_item_at (GooCanvasItemSimple *simple,
+				   gdouble              x,
+				   gdouble              y,
+				   cairo_t             *cr,
+				   gboolean             is_pointer_event)
+{
+  GooCanvasTiledImage *image = (GooCanvasTiledImage*) simple;
+  gdouble width, height;
+
+  goo_canvas_tiled_image_get_size (image, &width, &height);
+
+  if (x < image->x || (x > image->x + width)
+      || y < image->y || (y > image->y + height))
+    return FALSE;
+
+  return TRUE;
+}
+
+
+static void
+goo_canvas_tiled_image_update  (GooCanvasItemSimple  *simple,
+				cairo_t              *cr)
+{
+  GooCanvasTiledImage *image = (GooCanvasTiledImage*) simple;
+  gdouble width, height;
+
+  goo_canvas_tiled_image_get_size (image, &width, &height);
+
+  /* Compute the new bounds. */
+  simple->bounds.x1 = image->x;
+  simple->bounds.y1 = image->y;
+  simple->bounds.x2 = image->x + width;
+  simple->bounds.y2 = image->y + height;
+}
+
+
+static void
+goo_canvas_tiled_image_paint (GooCanvasItemSimple   *simple,
+			      cairo_t               *cr,
+			      const GooCanvasBounds *bounds)
+{
+  GooCanvasTiledImagePrivate *priv = GOO_CANVAS_TILED_IMAGE_GET_PRIVATE (simple);
+  GooCanvasTiledImage *image = (GooCanvasTiledImage*) simple;
+  gdouble width, height, scale_x, scale_y, tile_x, tile_y;
+  gdouble x1, y1, x2, y2;
+  gint n_columns, n_rows, first_column, last_column, first_row, last_row;
+  gint column, row, tile_width, tile_height;
+  cairo_surface_t *surface;
+
+  if (!priv->tile_func || image->image_width <= 0 || image->image_height <= 0
+      || image->tile_width <= 0 || image->tile_height <= 0)
+    return;
+
+  goo_canvas_tiled_image_get_size (image, &width, &height);
+  scale_x = width / image->image_width;
+  scale_y = height / image->image_height;
+
+  /* Find the part of the image that needs painting, in user space. The
+     clip extents take the item's transformation into account. */
+  cairo_clip_extents (cr, &x1, &y1, &x2, &y2);
+  x1 = MAX (x1, image->x);
+  y1 = MAX (y1, image->y);
+  x2 = MIN (x2, image->x + width);
+  y2 = MIN (y2, image->y + height);
+  if (x1 >= x2 || y1 >= y2)
+    return;
+
+  n_columns = (image->image_width + image->tile_width - 1) / image->tile_width;
+  n_rows = (image->image_height + image->tile_height - 1) / image->tile_height;
+
+  first_column = floor ((x1 - image->x) / (image->tile_width * scale_x));
+  last_column = floor ((x2 - image->x) / (image->tile_width * scale_x));
+  first_row = floor ((y1 - image->y) / (image->tile_height * scale_y));
+  last_row = floor ((y2 - image->y) / (image->tile_height * scale_y));
+
+  first_column = CLAMP (first_column, 0, n_columns - 1);
+  last_column = CLAMP (last_column, 0, n_columns - 1);
+  first_row = CLAMP (first_row, 0, n_rows - 1);
+  last_row = CLAMP (last_row, 0, n_rows - 1);
+
+  priv->paint_serial++;
+
+  goo_canvas_style_set_fill_options (simple->simple_data->style, cr);
+
+  for (row = first_row; row <= last_row; row++)
+    {
+      tile_height = MIN (image->tile_height,
+			 image->image_height - row * image->tile_height);
+      tile_y = image->y + row * image->tile_height * scale_y;
+
+      for (column = first_column; column <= last_column; column++)
+	{
+	  surface = goo_canvas_tiled_image_get_tile (image, column, row);
+	  if (!surface)
+	    continue;
+
+	  tile_width = MIN (image->tile_width,
+			    image->image_width - column * image->tile_width);
+	  tile_x = image->x + column * image->tile_width * scale_x;
+
+	  cairo_save (cr);
+	  cairo_translate (cr, tile_x, tile_y);
+	  cairo_scale (cr, scale_x, scale_y);
+
+	  /* If the tile isn't the size we expect, stretch it to fit. */
+	  if (cairo_surface_get_type (surface) == CAIRO_SURFACE_TYPE_IMAGE)
+	    cairo_scale (cr,
+			 (gdouble) tile_width / cairo_image_surface_get_width (surface),
+			 (gdouble) tile_height / cairo_image_surface_get_height (surface));
+
+	  cairo_set_source_surface (cr, surface, 0.0, 0.0);
+
+	  /* Pad the edges so neighbouring tiles don't show seams when scaled. */
+	  cairo_pattern_set_extend (cairo_get_source (cr), CAIRO_EXTEND_PAD);
+
+	  if (cairo_surface_get_type (surface) == CAIRO_SURFACE_TYPE_IMAGE)
+	    cairo_rectangle (cr, 0.0, 0.0,
+			     cairo_image_surface_get_width (surface),
+			     cairo_image_surface_get_height (surface));
+	  else
+	    cairo_rectangle (cr, 0.0, 0.0, tile_width, tile_height);
+
+	  if (image->alpha != 1.0)
+	    {
+	      cairo_clip (cr);
+	      cairo_paint_with_alpha (cr, image->alpha);
+	    }
+	  else
+	    {
+	      cairo_fill (cr);
+	    }
+	  cairo_restore (cr);
+	}
+    }
+
+  goo_canvas_tiled_image_trim_tiles (image);
+}
+
+
+static void
+goo_canvas_tiled_image_class_init (GooCanvasTiledImageClass *klass)
+{
+  GObjectClass *gobject_class = (GObjectClass*) klass;
+  GooCanvasItemSimpleClass *simple_class = (GooCanvasItemSimpleClass*) klass;
+
+  g_type_class_add_private (gobject_class, sizeof (GooCanvasTiledImagePrivate));
+
+  gobject_class->dispose  = goo_canvas_tiled_image_dispose;
+  gobject_class->finalize = goo_canvas_tiled_image_finalize;
+
+  gobject_class->get_property = goo_canvas_tiled_image_get_property;
+  gobject_class->set_property = goo_canvas_tiled_image_set_property;
+
+  simple_class->simple_update      = goo_canvas_tiled_image_update;
+  simple_class->simple_paint       = goo_canvas_tiled_image_paint;
+  simple_class->simple_is_item_at  = goo_canvas_tiled_image_is_item_at;
+
+  g_object_class_install_property (gobject_class, PROP_X,
+				   g_param_spec_double ("x",
+							"X",
+							_("The x coordinate of the image"),
+							-G_MAXDOUBLE,
+							G_MAXDOUBLE, 0.0,
+							G_PARAM_READWRITE));
+
+  g_object_class_install_property (gobject_class, PROP_Y,
+				   g_param_spec_double ("y",
+							"Y",
+							_("The y coordinate of the image"),
+							-G_MAXDOUBLE,
+							G_MAXDOUBLE, 0.0,
+							G_PARAM_READWRITE));
+
+  g_object_class_install_property (gobject_class, PROP_WIDTH,
+				   g_param_spec_double ("width",
+							_("Width"),
+							_("The width of the image, or 0 to use the image's width in pixels"),
+							0.0, G_MAXDOUBLE, 0.0,
+							G_PARAM_READWRITE));
+
+  g_object_class_install_property (gobject_class, PROP_HEIGHT,
+				   g_param_spec_double ("height",
+							_("Height"),
+							_("The height of the image, or 0 to use the image's height in pixels"),
+							0.0, G_MAXDOUBLE, 0.0,
+							G_PARAM_READWRITE));
+
+  g_object_class_install_property (gobject_class, PROP_ALPHA,
+				   g_param_spec_double ("alpha",
+							_("Alpha"),
+							_("The opacity of the image, 0.0 is fully transparent, and 1.0 is opaque."),
+							0.0, 1.0, 1.0,
+							G_PARAM_READWRITE));
+
+  g_object_class_install_property (gobject_class, PROP_IMAGE_WIDTH,
+				   g_param_spec_int ("image-width",
+						     _("Image Width"),
+						     _("The width of the entire image, in pixels"),
+						     0, G_MAXINT, 0,
+						     G_PARAM_READWRITE));
+
+  g_object_class_install_property (gobject_class, PROP_IMAGE_HEIGHT,
+				   g_param_spec_int ("image-height",
+						     _("Image Height"),
+						     _("The height of the entire image, in pixels"),
+						     0, G_MAXINT, 0,
+						     G_PARAM_READWRITE));
+
+  g_object_class_install_property (gobject_class, PROP_TILE_WIDTH,
+				   g_param_spec_int ("tile-width",
+						     _("Tile Width"),
+						     _("The width of each tile, in pixels"),
+						     1, G_MAXINT,
+						     GOO_CANVAS_TILED_IMAGE_DEFAULT_TILE_SIZE,
+						     G_PARAM_READWRITE));
+
+  g_object_class_install_property (gobject_class, PROP_TILE_HEIGHT,
+				   g_param_spec_int ("tile-height",
+						     _("Tile Height"),
+						     _("The height of each tile, in pixels"),
+						     1, G_MAXINT,
+						     GOO_CANVAS_TILED_IMAGE_DEFAULT_TILE_SIZE,
+						     G_PARAM_READWRITE));
+
+  g_object_class_install_property (gobject_class, PROP_MAX_TILE_MEMORY,
+				   g_param_spec_uint64 ("max-tile-memory",
+							_("Maximum Tile Memory"),
+							_("The number of bytes of loaded tiles to keep in memory"),
+							0, G_MAXUINT64,
+							GOO_CANVAS_TILED_IMAGE_DEFAULT_MAX_MEMORY,
+							G_PARAM_READWRITE));
+}
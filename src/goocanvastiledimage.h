@@ -0,0 +1,101 @@
+/*
+ * GooCanvas. Copyright (C) 2005 Damon Chaplin.
+ * Released under the GNU LGPL license. See COPYING for details.
+ *
+ * goocanvastiledimage.h - tiled image item.
+ */
+#ifndef __GOO_CANVAS_TILED_IMAGE_H__
+#define __GOO_CANVAS_TILED_IMAGE_H__
+
+#include <gtk/gtk.h>
+#include "goocanvasitemsimple.h"
+
+G_BEGIN_DECLS
+
+
+#define GOO_TYPE_CANVAS_TILED_IMAGE            (goo_canvas_tiled_image_get_type ())
+#define GOO_CANVAS_TILED_IMAGE(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), GOO_TYPE_CANVAS_TILED_IMAGE, GooCanvasTiledImage))
+#define GOO_CANVAS_TILED_IMAGE_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass), GOO_TYPE_CANVAS_TILED_IMAGE, GooCanvasTiledImageClass))
+#define GOO_IS_CANVAS_TILED_IMAGE(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), GOO_TYPE_CANVAS_TILED_IMAGE))
+#define GOO_IS_CANVAS_TILED_IMAGE_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass), GOO_TYPE_CANVAS_TILED_IMAGE))
+#define GOO_CANVAS_TILED_IMAGE_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj), GOO_TYPE_CANVAS_TILED_IMAGE, GooCanvasTiledImageClass))
+
+
+typedef struct _GooCanvasTiledImage       GooCanvasTiledImage;
+typedef struct _GooCanvasTiledImageClass  GooCanvasTiledImageClass;
+
+/**
+ * GooCanvasTileFunc:
+ * @image: the #GooCanvasTiledImage.
+ * @column: the column of the tile, starting from 0 at the left.
+ * @row: the row of the tile, starting from 0 at the top.
+ * @user_data: the user data passed to goo_canvas_tiled_image_set_tile_func().
+ *
+ * Specifies the type of the function used to load the tiles of a
+ * #GooCanvasTiledImage.
+ *
+ * The returned surface should be the size of a tile, except for the tiles
+ * in the last column and row which may be smaller if the image size is not
+ * a multiple of the tile size.
+ *
+ * Returns: (transfer full): a new cairo image surface containing the tile,
+ *  or %NULL if the tile is not available.
+ *
+ * Since: 3.0
+ */
+typedef cairo_surface_t* (*GooCanvasTileFunc) (GooCanvasTiledImage *image,
+					       gint                 column,
+					       gint                 row,
+					       gpointer             user_data);
+
+/**
+ * GooCanvasTiledImage:
+ *
+ * The #GooCanvasTiledImage-struct struct contains private data only.
+ *
+ * Since: 3.0
+ */
+struct _GooCanvasTiledImage
+{
+  GooCanvasItemSimple parent_object;
+
+  gdouble x, y, width, height;
+  gint image_width, image_height;
+  gint tile_width, tile_height;
+  gdouble alpha;
+};
+
+struct _GooCanvasTiledImageClass
+{
+  GooCanvasItemSimpleClass parent_class;
+
+  /*< private >*/
+
+  /* Padding for future expansion */
+  void (*_goo_canvas_reserved1) (void);
+  void (*_goo_canvas_reserved2) (void);
+  void (*_goo_canvas_reserved3) (void);
+  void (*_goo_canvas_reserved4) (void);
+};
+
+
+GType          goo_canvas_tiled_image_get_type     (void) G_GNUC_CONST;
+GooCanvasItem* goo_canvas_tiled_image_new          (GooCanvasItem       *parent,
+						    gint                 image_width,
+						    gint                 image_height,
+						    gdouble              x,
+						    gdouble              y,
+						    ...);
+
+void           goo_canvas_tiled_image_set_tile_func (GooCanvasTiledImage *image,
+						     GooCanvasTileFunc    tile_func,
+						     gpointer             user_data,
+						     GDestroyNotify       notify);
+void           goo_canvas_tiled_image_set_tile_file_template (GooCanvasTiledImage *image,
+							      const gchar         *filename_template);
+void           goo_canvas_tiled_image_invalidate_tiles (GooCanvasTiledImage *image);
+
+
+G_END_DECLS
+
+#endif /* __GOO_CANVAS_TILED_IMAGE_H__ */
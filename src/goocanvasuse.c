@@ -0,0 +1,882 @@
+/*
+ * GooCanvas. Copyright (C) 2005 Damon Chaplin.
+ * Released under the GNU LGPL license. See COPYING for details.
+ *
+ * goocanvasuse.c - item displaying an instance of another item.
+ */
+
+/**
+ * SECTION:goocanvasuse
+ * @Title: GooCanvasUse
+ * @Short_Description: an item displaying an instance of another item.
+ *
+ * GooCanvasUse displays another item, called the source item, at its own
+ * position and with its own transformation, like the SVG 'use' element.
+ * Any number of #GooCanvasUse items can display the same source item, so
+ * a symbol which is repeated many times only needs to be created once.
+ *
+ * The source item can be any item, including a group containing other
+ * items, but it must not have a parent. It is placed in a hidden canvas
+ * shared by all the #GooCanvasUse items displaying it, and it is only
+ * updated once however many times it is used. The source can also be
+ * given as an item model, see goo_canvas_use_new_for_model().
+ *
+ * When the source item or any of its descendants is changed, all the
+ * #GooCanvasUse items displaying it are updated and redrawn.
+ *
+ * If the #GooCanvasUse:cache-rendering property is set, the source is
+ * rendered into an image surface which is shared by all the #GooCanvasUse
+ * items drawn at the same scale, and the surface is painted instead of the
+ * source item. This is much faster for complicated symbols, though the
+ * result may be slightly blurred. The cache is not used if the item is
+ * rotated or skewed, and it is discarded whenever the source changes.
+ *
+ * Since the source item is not in the canvas, the #GooCanvasUse item
+ * receives the events for it. Use goo_canvas_use_get_item_at() in the event
+ * handlers to find which of the source items the pointer is over.
+ *
+ * It is a subclass of #GooCanvasItemSimple and so inherits all of the style
+ * properties such as "operator" and "pointer-events", though the style of
+ * the source item is not affected by them.
+ *
+ * Note that #GooCanvasUse doesn't have a model/view variant like the other
+ * standard items, so it can only be used in a simple canvas without a model.
+ *
+ * The source item must not contain any #GooCanvasWidget items, since the
+ * widgets would have to be placed in the hidden canvas, and a widget can't
+ * be shown more than once.
+ *
+ * To create a #GooCanvasUse use goo_canvas_use_new().
+ */
+#include <config.h>
+#include <math.h>
+#include <glib/gi18n-lib.h>
+#include <gtk/gtk.h>
+#include "goocanvasprivate.h"
+#include "goocanvasuse.h"
+#include "goocanvas.h"
+
+
+/* The maximum size of each cached rendering of a source, and the maximum
+   number of cached renderings, at different scales, of each source. */
+#define GOO_CANVAS_USE_MAX_CACHE_PIXELS   (2048 * 2048)
+#define GOO_CANVAS_USE_MAX_CACHE_ENTRIES  4
+
+static const char *use_source_key = "GooCanvasUseSource";
+
+
+/* A rendering of the source, at the given scale. */
+typedef struct _GooCanvasUseCache GooCanvasUseCache;
+struct _GooCanvasUseCache
+{
+  gdouble scale_x, scale_y, paint_scale;
+  cairo_surface_t *surface;
+
+  /* The approximate size of the surface, which may not be an image surface
+     so can't be measured. */
+  gsize n_bytes;
+};
+
+
+/* The data shared by all the GooCanvasUse items displaying a source. It is
+   attached to the source item or model. */
+typedef struct _GooCanvasUseSource GooCanvasUseSource;
+struct _GooCanvasUseSource
+{
+  /* The source item or model. */
+  GObject *object;
+
+  /* The hidden canvas holding the source item, as its root item. */
+  GooCanvas *canvas;
+
+  /* The GooCanvasUse items displaying the source. */
+  GList *instances;
+
+  /* The cached renderings of the source, with the most recent first. */
+  GSList *cache;
+
+  /* TRUE while the source is being updated. */
+  guint updating : 1;
+
+  /* TRUE if the instances have been told about a change to the source, and
+     it hasn't been updated or painted since, so they don't need to be told
+     again. */
+  guint update_pending : 1;
+  guint redraw_pending : 1;
+};
+
+
+typedef struct _GooCanvasUsePrivate GooCanvasUsePrivate;
+struct _GooCanvasUsePrivate {
+  GooCanvasUseSource *source;
+
+  /* The scale passed to the item's paint method, which is used to paint the
+     source. */
+  gdouble paint_scale;
+};
+
+#define GOO_CANVAS_USE_GET_PRIVATE(use)  \
+   (G_TYPE_INSTANCE_GET_PRIVATE ((use), GOO_TYPE_CANVAS_USE, GooCanvasUsePrivate))
+
+
+enum {
+  PROP_0,
+
+  PROP_X,
+  PROP_Y,
+  PROP_SOURCE,
+  PROP_SOURCE_MODEL,
+  PROP_CACHE_RENDERING
+};
+
+static GooCanvasItemIface *goo_canvas_use_parent_iface;
+
+static void item_interface_init         (GooCanvasItemIface *iface);
+static void goo_canvas_use_dispose      (GObject            *object);
+static void goo_canvas_use_get_property (GObject            *object,
+					 guint               param_id,
+					 GValue             *value,
+					 GParamSpec         *pspec);
+static void goo_canvas_use_set_property (GObject            *object,
+					 guint               param_id,
+					 const GValue       *value,
+					 GParamSpec         *pspec);
+
+G_DEFINE_TYPE_WITH_CODE (GooCanvasUse, goo_canvas_use,
+			 GOO_TYPE_CANVAS_ITEM_SIMPLE,
+			 G_IMPLEMENT_INTERFACE (GOO_TYPE_CANVAS_ITEM,
+						item_interface_init))
+
+
+static void
+goo_canvas_use_init (GooCanvasUse *use)
+{
+  GooCanvasUsePrivate *priv = GOO_CANVAS_USE_GET_PRIVATE (use);
+
+  priv->source = NULL;
+  priv->paint_scale = 1.0;
+}
+
+
+static void
+goo_canvas_use_free_cache (GooCanvasUseSource *source)
+{
+  GooCanvasUseCache *cache;
+  GSList *elem;
+
+  for (elem = source->cache; elem; elem = elem->next)
+    {
+      cache = elem->data;
+      cairo_surface_destroy (cache->surface);
+      g_slice_free (GooCanvasUseCache, cache);
+    }
+  g_slist_free (source->cache);
+  source->cache = NULL;
+}
+
+
+/* This is called when the source item requests an update or a redraw. The
+   source may make many requests for a single change, so the instances are
+   only told about the first one until the source is updated or painted. */
+static void
+goo_canvas_use_source_changed (GooCanvas             *canvas,
+			       const GooCanvasBounds *bounds,
+			       gpointer               data)
+{
+  GooCanvasUseSource *source = data;
+  GooCanvasItemSimple *simple;
+  GList *elem;
+
+  goo_canvas_use_free_cache (source);
+
+  /* While the source is being updated we skip its redraw requests. The
+     instances have all been scheduled for an update already, which redraws
+     them. */
+  if (bounds && source->updating)
+    return;
+
+  if (!bounds)
+    {
+      /* The source's bounds may change, so the instances need updating. */
+      if (source->update_pending)
+	return;
+      source->update_pending = TRUE;
+
+      for (elem = source->instances; elem; elem = elem->next)
+	goo_canvas_item_simple_changed (elem->data, TRUE);
+      return;
+    }
+
+  /* The source's bounds haven't changed, so the instances only need to be
+     redrawn. */
+  if (source->redraw_pending)
+    return;
+  source->redraw_pending = TRUE;
+
+  for (elem = source->instances; elem; elem = elem->next)
+    {
+      simple = elem->data;
+      if (simple->canvas)
+	goo_canvas_request_item_redraw (simple->canvas, &simple->bounds,
+					simple->simple_data->is_static);
+    }
+}
+
+
+/* This is used by goo_canvas_get_memory_stats(). It returns the data shared
+   by all the items displaying the same source, or NULL if the source isn't
+   set, and the hidden canvas holding the source and the size of its cached
+   renderings. */
+gpointer
+goo_canvas_use_get_memory_source (GooCanvasUse  *use,
+				  GooCanvas    **source_canvas,
+				  gsize         *cache_bytes)
+{
+  GooCanvasUsePrivate *priv = GOO_CANVAS_USE_GET_PRIVATE (use);
+  GooCanvasUseCache *cache;
+  GSList *elem;
+
+  *source_canvas = NULL;
+  *cache_bytes = 0;
+
+  if (!priv->source)
+    return NULL;
+
+  *source_canvas = priv->source->canvas;
+  for (elem = priv->source->cache; elem; elem = elem->next)
+    {
+      cache = elem->data;
+      *cache_bytes += sizeof (GooCanvasUseCache) + cache->n_bytes;
+    }
+
+  return priv->source;
+}
+
+
+static GooCanvasUseSource*
+goo_canvas_use_get_shared_source (GObject *object)
+{
+  GooCanvasUseSource *source;
+
+  source = g_object_get_data (object, use_source_key);
+  if (source)
+    return source;
+
+  source = g_slice_new0 (GooCanvasUseSource);
+  source->object = object;
+  source->canvas = g_object_ref_sink (goo_canvas_new ());
+
+  if (GOO_IS_CANVAS_ITEM_MODEL (object))
+    goo_canvas_set_root_item_model (source->canvas,
+				    (GooCanvasItemModel*) object);
+  else
+    goo_canvas_set_root_item (source->canvas, (GooCanvasItem*) object);
+
+  goo_canvas_set_change_func (source->canvas, goo_canvas_use_source_changed,
+			      source);
+  g_object_set_data (object, use_source_key, source);
+
+  return source;
+}
+
+
+static void
+goo_canvas_use_set_source_object (GooCanvasUse *use,
+				  GObject      *object)
+{
+  GooCanvasUsePrivate *priv = GOO_CANVAS_USE_GET_PRIVATE (use);
+  GooCanvasUseSource *source = priv->source;
+
+  if (source && source->object == object)
+    return;
+
+  if (source)
+    {
+      source->instances = g_list_remove (source->instances, use);
+
+      /* Free the shared data when the last instance is removed. */
+      if (!source->instances)
+	{
+	  g_object_set_data (source->object, use_source_key, NULL);
+	  goo_canvas_set_change_func (source->canvas, NULL, NULL);
+	  goo_canvas_use_free_cache (source);
+	  g_object_unref (source->canvas);
+	  g_slice_free (GooCanvasUseSource, source);
+	}
+      priv->source = NULL;
+    }
+
+  if (object)
+    {
+      priv->source = goo_canvas_use_get_shared_source (object);
+      priv->source->instances = g_list_prepend (priv->source->instances, use);
+    }
+
+  goo_canvas_item_simple_changed ((GooCanvasItemSimple*) use, TRUE);
+}
+
+
+/**
+ * goo_canvas_use_new:
+ * @parent: (skip): the parent item, or %NULL. If a parent is specified, it will assume
+ *  ownership of the item, and the item will automatically be freed when it is
+ *  removed from the parent. Otherwise call g_object_unref() to free it.
+ * @source: the item to display. It must not have a parent.
+ * @x: the x coordinate of the source item's origin.
+ * @y: the y coordinate of the source item's origin.
+ * @...: optional pairs of property names and values, and a terminating %NULL.
+ *
+ * Creates a new item displaying an instance of @source. The source item is
+ * kept alive until all the items displaying it are freed.
+ *
+ * Here's an example showing how to display the same symbol in several
+ * places:
+ *
+ * <informalexample><programlisting>
+ *  GooCanvasItem *symbol = goo_canvas_group_new (NULL, NULL);
+ *  goo_canvas_ellipse_new (symbol, 0.0, 0.0, 10.0, 10.0, NULL);
+ *  goo_canvas_rect_new (symbol, -2.0, -2.0, 4.0, 4.0, NULL);
+ *
+ *  for (i = 0; i < n_points; i++)
+ *    goo_canvas_use_new (mygroup, symbol, points[i].x, points[i].y, NULL);
+ *  g_object_unref (symbol);
+ * </programlisting></informalexample>
+ *
+ * Returns: (transfer full): a new use item.
+ *
+ * Since: 3.0
+ **/
+GooCanvasItem*
+goo_canvas_use_new (GooCanvasItem *parent,
+		    GooCanvasItem *source,
+		    gdouble        x,
+		    gdouble        y,
+		    ...)
+{
+  GooCanvasItem *item;
+  GooCanvasUse *use;
+  const char *first_property;
+  va_list var_args;
+
+  g_return_val_if_fail (GOO_IS_CANVAS_ITEM (source), NULL);
+
+  item = g_object_new (GOO_TYPE_CANVAS_USE, NULL);
+
+  use = (GooCanvasUse*) item;
+  use->x = x;
+  use->y = y;
+  g_object_set (item, "source", source, NULL);
+
+  va_start (var_args, y);
+  first_property = va_arg (var_args, char*);
+  if (first_property)
+    g_object_set_valist ((GObject*) item, first_property, var_args);
+  va_end (var_args);
+
+  if (parent)
+    {
+      goo_canvas_item_add_child (parent, item, -1);
+      g_object_unref (item);
+    }
+
+  return item;
+}
+
+
+/**
+ * goo_canvas_use_new_for_model:
+ * @parent: (skip): the parent item, or %NULL. If a parent is specified, it will assume
+ *  ownership of the item, and the item will automatically be freed when it is
+ *  removed from the parent. Otherwise call g_object_unref() to free it.
+ * @source_model: the item model to display. It must not have a parent.
+ * @x: the x coordinate of the source's origin.
+ * @y: the y coordinate of the source's origin.
+ * @...: optional pairs of property names and values, and a terminating %NULL.
+ *
+ * Creates a new item displaying an instance of @source_model. The items to
+ * view the model are created once, and shared by all the #GooCanvasUse
+ * items displaying the model.
+ *
+ * Returns: (transfer full): a new use item.
+ *
+ * Since: 3.0
+ **/
+GooCanvasItem*
+goo_canvas_use_new_for_model (GooCanvasItem      *parent,
+			      GooCanvasItemModel *source_model,
+			      gdouble             x,
+			      gdouble             y,
+			      ...)
+{
+  GooCanvasItem *item;
+  GooCanvasUse *use;
+  const char *first_property;
+  va_list var_args;
+
+  g_return_val_if_fail (GOO_IS_CANVAS_ITEM_MODEL (source_model), NULL);
+
+  item = g_object_new (GOO_TYPE_CANVAS_USE, NULL);
+
+  use = (GooCanvasUse*) item;
+  use->x = x;
+  use->y = y;
+  g_object_set (item, "source-model", source_model, NULL);
+
+  va_start (var_args, y);
+  first_property = va_arg (var_args, char*);
+  if (first_property)
+    g_object_set_valist ((GObject*) item, first_property, var_args);
+  va_end (var_args);
+
+  if (parent)
+    {
+      goo_canvas_item_add_child (parent, item, -1);
+      g_object_unref (item);
+    }
+
+  return item;
+}
+
+
+static void
+goo_canvas_use_dispose (GObject *object)
+{
+  goo_canvas_use_set_source_object ((GooCanvasUse*) object, NULL);
+
+  G_OBJECT_CLASS (goo_canvas_use_parent_class)->dispose (object);
+}
+
+
+static void
+goo_canvas_use_get_property (GObject              *object,
+			     guint                 prop_id,
+			     GValue               *value,
+			     GParamSpec           *pspec)
+{
+  GooCanvasUsePrivate *priv = GOO_CANVAS_USE_GET_PRIVATE (object);
+  GooCanvasUse *use = (GooCanvasUse*) object;
+  GObject *source_object = priv->source ? priv->source->object : NULL;
+
+  switch (prop_id)
+    {
+    case PROP_X:
+      g_value_set_double (value, use->x);
+      break;
+    case PROP_Y:
+      g_value_set_double (value, use->y);
+      break;
+    case PROP_SOURCE:
+      g_value_set_object (value, priv->source ? priv->source->canvas->root_item : NULL);
+      break;
+    case PROP_SOURCE_MODEL:
+      g_value_set_object (value, GOO_IS_CANVAS_ITEM_MODEL (source_object) ? source_object : NULL);
+      break;
+    case PROP_CACHE_RENDERING:
+      g_value_set_boolean (value, use->cache_rendering);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+    }
+}
+
+
+static void
+goo_canvas_use_set_property (GObject              *object,
+			     guint                 prop_id,
+			     const GValue         *value,
+			     GParamSpec           *pspec)
+{
+  GooCanvasItemSimple *simple = (GooCanvasItemSimple*) object;
+  GooCanvasUse *use = (GooCanvasUse*) object;
+  GooCanvasItem *source;
+
+  switch (prop_id)
+    {
+    case PROP_X:
+      use->x = g_value_get_double (value);
+      break;
+    case PROP_Y:
+      use->y = g_value_get_double (value);
+      break;
+    case PROP_SOURCE:
+      source = g_value_get_object (value);
+      g_return_if_fail (source == NULL
+			|| goo_canvas_item_get_parent (source) == NULL);
+      goo_canvas_use_set_source_object (use, (GObject*) source);
+      break;
+    case PROP_SOURCE_MODEL:
+      goo_canvas_use_set_source_object (use, g_value_get_object (value));
+      break;
+    case PROP_CACHE_RENDERING:
+      use->cache_rendering = g_value_get_boolean (value);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+    }
+
+  goo_canvas_item_simple_changed (simple, TRUE);
+}
+
+
+/**
+ * goo_canvas_use_get_source:
+ * @use: a #GooCanvasUse.
+ *
+ * Gets the item displayed by @use. If the source was given as an item
+ * model, this is the item created to view it.
+ *
+ * Returns: (transfer none): the source item, or %NULL.
+ *
+ * Since: 3.0
+ **/
+GooCanvasItem*
+goo_canvas_use_get_source (GooCanvasUse *use)
+{
+  GooCanvasUsePrivate *priv;
+
+  g_return_val_if_fail (GOO_IS_CANVAS_USE (use), NULL);
+
+  priv = GOO_CANVAS_USE_GET_PRIVATE (use);
+  return priv->source ? priv->source->canvas->root_item : NULL;
+}
+
+
+/* Makes sure the source item is up to date. It is only updated once, in its
+   own canvas, however many items display it. */
+static GooCanvasItem*
+goo_canvas_use_update_source (GooCanvasUse *use)
+{
+  GooCanvasUsePrivate *priv = GOO_CANVAS_USE_GET_PRIVATE (use);
+  GooCanvasUseSource *source = priv->source;
+
+  if (!source || !source->canvas->root_item)
+    return NULL;
+
+  if (source->canvas->need_update)
+    {
+      source->updating = TRUE;
+      goo_canvas_update (source->canvas);
+      source->updating = FALSE;
+    }
+  source->update_pending = FALSE;
+
+  return source->canvas->root_item;
+}
+
+
+/**
+ * goo_canvas_use_get_item_at:
+ * @use: a #GooCanvasUse.
+ * @x: (inout): the x coordinate of the point, in the coordinate space of
+ *  @use. It is converted to the coordinate space of the returned item.
+ * @y: (inout): the y coordinate of the point, in the coordinate space of
+ *  @use. It is converted to the coordinate space of the returned item.
+ * @is_pointer_event: %TRUE if the "pointer-events" property of the items
+ *  should be used to determine which parts of them are tested.
+ *
+ * Finds which of the source items is displayed at the given point. The
+ * coordinates are in the same space as the coordinates of the events
+ * passed to the signal handlers of @use, so this can be used to find which
+ * part of the source the pointer is over.
+ *
+ * Returns: (transfer none): the source item, or one of its descendants, at
+ *  the given point, or %NULL if there is no item there.
+ *
+ * Since: 3.0
+ **/
+GooCanvasItem*
+goo_canvas_use_get_item_at (GooCanvasUse *use,
+			    gdouble      *x,
+			    gdouble      *y,
+			    gboolean      is_pointer_event)
+{
+  GooCanvasUsePrivate *priv;
+  GooCanvasItem *item;
+  gdouble source_x, source_y;
+
+  g_return_val_if_fail (GOO_IS_CANVAS_USE (use), NULL);
+  g_return_val_if_fail (x != NULL && y != NULL, NULL);
+
+  priv = GOO_CANVAS_USE_GET_PRIVATE (use);
+  if (!goo_canvas_use_update_source (use))
+    return NULL;
+
+  /* The source's canvas coordinate space is the space of the use item,
+     offset by its x and y coordinates. */
+  source_x = *x - use->x;
+  source_y = *y - use->y;
+
+  item = goo_canvas_get_item_at (priv->source->canvas, source_x, source_y,
+				 is_pointer_event);
+  if (item)
+    {
+      goo_canvas_convert_to_item_space (priv->source->canvas, item,
+					&source_x, &source_y);
+      *x = source_x;
+      *y = source_y;
+    }
+
+  return item;
+}
+
+
+/* This tests the source items directly, using the cairo context of the hit
+   test translated to the source's coordinate space. */
+static gboolean
+goo_canvas_use_is_item_at (GooCanvasItemSimple *simple,
+			   gdouble              x,
+			   gdouble              y,
+			   cairo_t             *cr,
+			   gboolean             is_pointer_event)
+{
+  GooCanvasUse *use = (GooCanvasUse*) simple;
+  GooCanvasItem *root;
+  GList *list;
+
+  root = goo_canvas_use_update_source (use);
+  if (!root)
+    return FALSE;
+
+  cairo_save (cr);
+  cairo_translate (cr, use->x, use->y);
+  list = goo_canvas_item_get_items_at (root, x - use->x, y - use->y, cr,
+				       is_pointer_event, TRUE, NULL);
+  cairo_restore (cr);
+
+  g_list_free (list);
+  return list != NULL;
+}
+
+
+static void
+goo_canvas_use_update  (GooCanvasItemSimple  *simple,
+			cairo_t              *cr)
+{
+  GooCanvasUse *use = (GooCanvasUse*) simple;
+  GooCanvasItem *root;
+  GooCanvasBounds source_bounds;
+
+  root = goo_canvas_use_update_source (use);
+  if (!root)
+    {
+      simple->bounds.x1 = simple->bounds.x2 = use->x;
+      simple->bounds.y1 = simple->bounds.y2 = use->y;
+      return;
+    }
+
+  /* The source's bounds are in its own canvas space, which is our user
+     space offset by x and y. */
+  goo_canvas_item_get_bounds (root, &source_bounds);
+  simple->bounds.x1 = source_bounds.x1 + use->x;
+  simple->bounds.y1 = source_bounds.y1 + use->y;
+  simple->bounds.x2 = source_bounds.x2 + use->x;
+  simple->bounds.y2 = source_bounds.y2 + use->y;
+}
+
+
+/* Paints the source using a cached rendering at the current scale, creating
+   it if needed. Returns FALSE if the cache can't be used. */
+static gboolean
+goo_canvas_use_paint_cached (GooCanvasUse  *use,
+			     GooCanvasItem *root,
+			     cairo_t       *cr,
+			     gdouble        scale)
+{
+  GooCanvasUsePrivate *priv = GOO_CANVAS_USE_GET_PRIVATE (use);
+  GooCanvasUseSource *source = priv->source;
+  GooCanvasUseCache *cache = NULL;
+  GooCanvasBounds bounds;
+  cairo_matrix_t matrix;
+  cairo_surface_t *surface;
+  cairo_t *cache_cr;
+  gint width, height;
+  GSList *elem;
+
+  /* We can only use a cached rendering if the item isn't rotated. */
+  cairo_get_matrix (cr, &matrix);
+  if (matrix.xy != 0.0 || matrix.yx != 0.0
+      || matrix.xx <= 0.0 || matrix.yy <= 0.0)
+    return FALSE;
+
+  goo_canvas_item_get_bounds (root, &bounds);
+  width = ceil ((bounds.x2 - bounds.x1) * matrix.xx);
+  height = ceil ((bounds.y2 - bounds.y1) * matrix.yy);
+  if (width <= 0 || height <= 0
+      || (gdouble) width * height > GOO_CANVAS_USE_MAX_CACHE_PIXELS)
+    return FALSE;
+
+  for (elem = source->cache; elem; elem = elem->next)
+    {
+      cache = elem->data;
+      if (cache->scale_x == matrix.xx && cache->scale_y == matrix.yy
+	  && cache->paint_scale == scale)
+	break;
+    }
+
+  if (!elem)
+    {
+      surface = cairo_surface_create_similar (cairo_get_target (cr),
+					      CAIRO_CONTENT_COLOR_ALPHA,
+					      width, height);
+      cache_cr = cairo_create (surface);
+      cairo_set_antialias (cache_cr, cairo_get_antialias (cr));
+      cairo_set_line_width (cache_cr, cairo_get_line_width (cr));
+      cairo_scale (cache_cr, matrix.xx, matrix.yy);
+      cairo_translate (cache_cr, -bounds.x1, -bounds.y1);
+      goo_canvas_item_paint (root, cache_cr, &bounds, scale);
+      cairo_destroy (cache_cr);
+
+      cache = g_slice_new (GooCanvasUseCache);
+      cache->scale_x = matrix.xx;
+      cache->scale_y = matrix.yy;
+      cache->paint_scale = scale;
+      cache->surface = surface;
+      cache->n_bytes = (gsize) width * height * 4;
+      source->cache = g_slist_prepend (source->cache, cache);
+
+      /* Free the oldest rendering if we have too many. */
+      elem = g_slist_nth (source->cache, GOO_CANVAS_USE_MAX_CACHE_ENTRIES - 1);
+      if (elem && elem->next)
+	{
+	  cache = elem->next->data;
+	  cairo_surface_destroy (cache->surface);
+	  g_slice_free (GooCanvasUseCache, cache);
+	  g_slist_free (elem->next);
+	  elem->next = NULL;
+	  cache = source->cache->data;
+	}
+    }
+
+  cairo_save (cr);
+  cairo_translate (cr, bounds.x1, bounds.y1);
+  cairo_scale (cr, 1.0 / matrix.xx, 1.0 / matrix.yy);
+  cairo_set_source_surface (cr, cache->surface, 0.0, 0.0);
+  cairo_paint (cr);
+  cairo_restore (cr);
+
+  return TRUE;
+}
+
+
+static void
+goo_canvas_use_paint (GooCanvasItemSimple   *simple,
+		      cairo_t               *cr,
+		      const GooCanvasBounds *bounds)
+{
+  GooCanvasUsePrivate *priv = GOO_CANVAS_USE_GET_PRIVATE (simple);
+  GooCanvasUse *use = (GooCanvasUse*) simple;
+  GooCanvasItem *root;
+  GooCanvasBounds clip_bounds;
+  gdouble scale = priv->paint_scale;
+
+  root = goo_canvas_use_update_source (use);
+  if (!root)
+    return;
+
+  priv->source->redraw_pending = FALSE;
+
+  /* Translate to the source's coordinate space. */
+  cairo_translate (cr, use->x, use->y);
+
+  if (use->cache_rendering
+      && goo_canvas_use_paint_cached (use, root, cr, scale))
+    return;
+
+  /* The source's bounds are in its own coordinate space, so we pass the
+     clip extents in that space. */
+  cairo_clip_extents (cr, &clip_bounds.x1, &clip_bounds.y1,
+		      &clip_bounds.x2, &clip_bounds.y2);
+  goo_canvas_item_paint (root, cr, &clip_bounds, scale);
+}
+
+
+/* The simple_paint() method isn't passed the scale, so we note it here. It
+   may differ from the scale of the item's canvas, for example if the item
+   is displayed in another canvas or rendered with goo_canvas_render(). */
+static void
+goo_canvas_use_paint_item (GooCanvasItem         *item,
+			   cairo_t               *cr,
+			   const GooCanvasBounds *bounds,
+			   gdouble                scale)
+{
+  GooCanvasUsePrivate *priv = GOO_CANVAS_USE_GET_PRIVATE (item);
+
+  priv->paint_scale = scale;
+  goo_canvas_use_parent_iface->paint (item, cr, bounds, scale);
+}
+
+
+static void
+item_interface_init (GooCanvasItemIface *iface)
+{
+  iface->paint = goo_canvas_use_paint_item;
+}
+
+
+static void
+goo_canvas_use_class_init (GooCanvasUseClass *klass)
+{
+  GObjectClass *gobject_class = (GObjectClass*) klass;
+  GooCanvasItemSimpleClass *simple_class = (GooCanvasItemSimpleClass*) klass;
+
+  goo_canvas_use_parent_iface = g_type_interface_peek (goo_canvas_use_parent_class, GOO_TYPE_CANVAS_ITEM);
+
+  g_type_class_add_private (gobject_class, sizeof (GooCanvasUsePrivate));
+
+  gobject_class->dispose  = goo_canvas_use_dispose;
+
+  gobject_class->get_property = goo_canvas_use_get_property;
+  gobject_class->set_property = goo_canvas_use_set_property;
+
+  simple_class->simple_update      = goo_canvas_use_update;
+  simple_class->simple_paint       = goo_canvas_use_paint;
+  simple_class->simple_is_item_at  = goo_canvas_use_is_item_at;
+
+  g_object_class_install_property (gobject_class, PROP_X,
+				   g_param_spec_double ("x",
+							"X",
+							_("The x coordinate of the source item's origin"),
+							-G_MAXDOUBLE,
+							G_MAXDOUBLE, 0.0,
+							G_PARAM_READWRITE));
+
+  g_object_class_install_property (gobject_class, PROP_Y,
+				   g_param_spec_double ("y",
+							"Y",
+							_("The y coordinate of the source item's origin"),
+							-G_MAXDOUBLE,
+							G_MAXDOUBLE, 0.0,
+							G_PARAM_READWRITE));
+
+  g_object_class_install_property (gobject_class, PROP_SOURCE,
+				   g_param_spec_object ("source",
+							_("Source"),
+							_("The item to display"),
+							GOO_TYPE_CANVAS_ITEM,
+							G_PARAM_READWRITE));
+
+  g_object_class_install_property (gobject_class, PROP_SOURCE_MODEL,
+				   g_param_spec_object ("source-model",
+							_("Source Model"),
+							_("The item model to display"),
+							GOO_TYPE_CANVAS_ITEM_MODEL,
+							G_PARAM_READWRITE));
+
+  /**
+   * GooCanvasUse:cache-rendering:
+   *
+   * If the source is rendered into an image surface, shared by all the
+   * items displaying it at the same scale, instead of being painted each
+   * time.
+   *
+   * Since: 3.0
+   */
+  g_object_class_install_property (gobject_class, PROP_CACHE_RENDERING,
+				   g_param_spec_boolean ("cache-rendering",
+							 _("Cache Rendering"),
+							 _("If the rendering of the source is cached and shared"),
+							 FALSE,
+							 G_PARAM_READWRITE));
+}
@@ -0,0 +1,77 @@
+/*
+ * GooCanvas. Copyright (C) 2005 Damon Chaplin.
+ * Released under the GNU LGPL license. See COPYING for details.
+ *
+ * goocanvasuse.h - item displaying an instance of another item.
+ */
+#ifndef __GOO_CANVAS_USE_H__
+#define __GOO_CANVAS_USE_H__
+
+#include <gtk/gtk.h>
+#include "goocanvasitemsimple.h"
+
+G_BEGIN_DECLS
+
+
+#define GOO_TYPE_CANVAS_USE            (goo_canvas_use_get_type ())
+#define GOO_CANVAS_USE(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), GOO_TYPE_CANVAS_USE, GooCanvasUse))
+#define GOO_CANVAS_USE_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass), GOO_TYPE_CANVAS_USE, GooCanvasUseClass))
+#define GOO_IS_CANVAS_USE(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), GOO_TYPE_CANVAS_USE))
+#define GOO_IS_CANVAS_USE_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass), GOO_TYPE_CANVAS_USE))
+#define GOO_CANVAS_USE_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj), GOO_TYPE_CANVAS_USE, GooCanvasUseClass))
+
+
+typedef struct _GooCanvasUse       GooCanvasUse;
+typedef struct _GooCanvasUseClass  GooCanvasUseClass;
+
+/**
+ * GooCanvasUse:
+ *
+ * The #GooCanvasUse-struct struct contains private data only.
+ *
+ * Since: 3.0
+ */
+struct _GooCanvasUse
+{
+  GooCanvasItemSimple parent_object;
+
+  gdouble x, y;
+  guint cache_rendering : 1;
+};
+
+struct _GooCanvasUseClass
+{
+  GooCanvasItemSimpleClass parent_class;
+
+  /*< private >*/
+
+  /* Padding for future expansion */
+  void (*_goo_canvas_reserved1) (void);
+  void (*_goo_canvas_reserved2) (void);
+  void (*_goo_canvas_reserved3) (void);
+  void (*_goo_canvas_reserved4) (void);
+};
+
+
+GType          goo_canvas_use_get_type     (void) G_GNUC_CONST;
+GooCanvasItem* goo_canvas_use_new          (GooCanvasItem      *parent,
+					    GooCanvasItem      *source,
+					    gdouble             x,
+					    gdouble             y,
+					    ...);
+GooCanvasItem* goo_canvas_use_new_for_model (GooCanvasItem      *parent,
+					     GooCanvasItemModel *source_model,
+					     gdouble             x,
+					     gdouble             y,
+					     ...);
+
+GooCanvasItem* goo_canvas_use_get_source   (GooCanvasUse       *use);
+GooCanvasItem* goo_canvas_use_get_item_at  (GooCanvasUse       *use,
+					    gdouble            *x,
+					    gdouble            *y,
+					    gboolean            is_pointer_event);
+
+
+G_END_DECLS
+
+#endif /* __GOO_CANVAS_USE_H__ */
@@ -14,8 +14,10 @@
  */
 #include <config.h>
 #include <math.h>
+#include <string.h>
 #include <gdk/gdk.h>
 #include <gtk/gtk.h>
+#include "goocanvasprivate.h"
 #include "goocanvas.h"
 
 
@@ -178,20 +180,245 @@ goo_canvas_cairo_surface_from_pixbuf (GdkPixbuf *pixbuf)
 }
 
 
+/*
+ * The shared image surface cache. Converting a pixbuf to a cairo surface
+ * is expensive and the result is as big as the pixbuf itself, so we keep a
+ * table mapping each pixbuf to the surface created from it. Each entry
+ * holds a reference to its surface, and counts the patterns created for it.
+ * When the last of these patterns is destroyed the entry is removed and its
+ * reference dropped. Since the count is only changed with the lock held, an
+ * entry found in the table always has a live surface. The table doesn't
+ * hold a reference to the pixbuf - the entry is removed from the table when
+ * the pixbuf is finalized. Patterns and images may be created from other
+ * threads, so the table is locked.
+ */
+typedef struct _GooCanvasSurfaceCacheEntry GooCanvasSurfaceCacheEntry;
+struct _GooCanvasSurfaceCacheEntry
+{
+  GdkPixbuf *pixbuf;
+  cairo_surface_t *surface;
+  gsize n_bytes;
+  guint n_patterns;
+};
+
+G_LOCK_DEFINE_STATIC (surface_cache);
+static GHashTable *surface_cache = NULL;
+static GooCanvasImageCacheStats surface_cache_stats;
+static const cairo_user_data_key_t surface_cache_key;
+
+
+/* This must be called with the lock held. */
+static void
+surface_cache_remove_entry (GooCanvasSurfaceCacheEntry *entry)
+{
+  g_hash_table_remove (surface_cache, entry->pixbuf);
+  entry->pixbuf = NULL;
+
+  surface_cache_stats.n_entries--;
+  surface_cache_stats.bytes_cached -= entry->n_bytes;
+}
+
+
+/* Called when the pixbuf is finalized. The surface may still be in use, so
+   we just remove the entry from the table. Since the pixbuf's address may
+   be reused it mustn't be left in the table. */
+static void
+surface_cache_pixbuf_finalized (gpointer  data,
+				GObject  *where_the_object_was)
+{
+  GooCanvasSurfaceCacheEntry *entry = data;
+
+  G_LOCK (surface_cache);
+  if (entry->pixbuf)
+    surface_cache_remove_entry (entry);
+  G_UNLOCK (surface_cache);
+}
+
+
+/* Called when a pattern created for the entry is destroyed. */
+static void
+surface_cache_pattern_destroyed (gpointer data)
+{
+  GooCanvasSurfaceCacheEntry *entry = data;
+  cairo_surface_t *surface;
+
+  G_LOCK (surface_cache);
+  if (--entry->n_patterns > 0)
+    {
+      G_UNLOCK (surface_cache);
+      return;
+    }
+
+  if (entry->pixbuf)
+    {
+      g_object_weak_unref (G_OBJECT (entry->pixbuf),
+			   surface_cache_pixbuf_finalized, entry);
+      surface_cache_remove_entry (entry);
+    }
+  G_UNLOCK (surface_cache);
+
+  /* The entry can't be found any more, so we can drop its reference without
+     holding the lock. The surface may still be used by cairo. */
+  surface = entry->surface;
+  g_slice_free (GooCanvasSurfaceCacheEntry, entry);
+  cairo_surface_destroy (surface);
+}
+
+
+/* Returns a new pattern for the entry's surface. This must be called with
+   the lock held. */
+static cairo_pattern_t*
+surface_cache_create_pattern (GooCanvasSurfaceCacheEntry *entry)
+{
+  cairo_pattern_t *pattern;
+
+  pattern = cairo_pattern_create_for_surface (entry->surface);
+  if (cairo_pattern_set_user_data (pattern, &surface_cache_key, entry,
+				   surface_cache_pattern_destroyed)
+      == CAIRO_STATUS_SUCCESS)
+    entry->n_patterns++;
+
+  return pattern;
+}
+
+
+/* Returns a new pattern for the surface of the given pixbuf, converting the
+   pixbuf only if no surface has been created for it already. */
 cairo_pattern_t*
 goo_canvas_cairo_pattern_from_pixbuf (GdkPixbuf *pixbuf)
 {
+  GooCanvasSurfaceCacheEntry *entry;
   cairo_surface_t *surface;
   cairo_pattern_t *pattern;
 
+  G_LOCK (surface_cache);
+
+  if (!surface_cache)
+    surface_cache = g_hash_table_new (g_direct_hash, g_direct_equal);
+
+  entry = g_hash_table_lookup (surface_cache, pixbuf);
+  if (entry)
+    {
+      surface_cache_stats.hits++;
+      surface_cache_stats.bytes_saved += entry->n_bytes;
+      pattern = surface_cache_create_pattern (entry);
+      G_UNLOCK (surface_cache);
+      return pattern;
+    }
+
+  surface_cache_stats.misses++;
+  G_UNLOCK (surface_cache);
+
+  /* Convert the pixbuf without holding the lock, as it may take a while. */
   surface = goo_canvas_cairo_surface_from_pixbuf (pixbuf);
-  pattern = cairo_pattern_create_for_surface (surface);
-  cairo_surface_destroy (surface);
+
+  G_LOCK (surface_cache);
+
+  /* Another thread may have converted the same pixbuf in the meantime. If
+     so we use its surface and throw ours away. */
+  entry = g_hash_table_lookup (surface_cache, pixbuf);
+  if (entry)
+    {
+      pattern = surface_cache_create_pattern (entry);
+      G_UNLOCK (surface_cache);
+      cairo_surface_destroy (surface);
+      return pattern;
+    }
+
+  entry = g_slice_new (GooCanvasSurfaceCacheEntry);
+  entry->pixbuf = pixbuf;
+  entry->surface = surface;
+  entry->n_bytes = (gsize) cairo_image_surface_get_stride (surface)
+    * cairo_image_surface_get_height (surface);
+  entry->n_patterns = 0;
+
+  g_hash_table_insert (surface_cache, pixbuf, entry);
+  g_object_weak_ref (G_OBJECT (pixbuf), surface_cache_pixbuf_finalized,
+		     entry);
+
+  surface_cache_stats.n_entries++;
+  surface_cache_stats.bytes_cached += entry->n_bytes;
+
+  pattern = surface_cache_create_pattern (entry);
+
+  G_UNLOCK (surface_cache);
 
   return pattern;
 }
 
 
+/* Returns TRUE if the pattern was created by
+   goo_canvas_cairo_pattern_from_pixbuf(), in which case its surface is only
+   used by the canvas and its contents never change. */
+gboolean
+goo_canvas_pattern_is_from_pixbuf (cairo_pattern_t *pattern)
+{
+  return cairo_pattern_get_user_data (pattern, &surface_cache_key) != NULL;
+}
+
+
+/**
+ * goo_canvas_image_cache_invalidate:
+ * @pixbuf: a #GdkPixbuf.
+ *
+ * Removes the shared surface of the pixbuf from the image surface cache, so
+ * the pixbuf is converted again the next time it is set as the "pixbuf"
+ * property of an image or used for a fill or stroke pattern. Call this after
+ * changing the pixels of a pixbuf which has already been used.
+ *
+ * Items which are already using the old surface keep it, so the pixbuf
+ * must be set again for them to show the new pixels.
+ *
+ * Since: 3.0
+ **/
+void
+goo_canvas_image_cache_invalidate (GdkPixbuf *pixbuf)
+{
+  GooCanvasSurfaceCacheEntry *entry;
+
+  g_return_if_fail (GDK_IS_PIXBUF (pixbuf));
+
+  G_LOCK (surface_cache);
+
+  entry = surface_cache ? g_hash_table_lookup (surface_cache, pixbuf) : NULL;
+  if (entry)
+    {
+      /* The entry is freed when the last pattern using it is destroyed. */
+      g_object_weak_unref (G_OBJECT (pixbuf),
+			   surface_cache_pixbuf_finalized, entry);
+      surface_cache_remove_entry (entry);
+    }
+
+  G_UNLOCK (surface_cache);
+}
+
+
+/**
+ * goo_canvas_image_cache_get_stats:
+ * @stats: (out caller-allocates): a #GooCanvasImageCacheStats to fill in.
+ *
+ * Gets statistics about the shared image surface cache.
+ *
+ * Images and pixbuf fill and stroke patterns created from the same
+ * #GdkPixbuf share a single cairo surface, which is converted from the
+ * pixbuf the first time it is used and freed when the last item or model
+ * using it is destroyed. Note that the pixbuf data is only converted once,
+ * so changes made to the pixels of a pixbuf after it has been used will not
+ * be seen until goo_canvas_image_cache_invalidate() is called.
+ *
+ * Since: 3.0
+ **/
+void
+goo_canvas_image_cache_get_stats (GooCanvasImageCacheStats *stats)
+{
+  g_return_if_fail (stats != NULL);
+
+  G_LOCK (surface_cache);
+  *stats = surface_cache_stats;
+  G_UNLOCK (surface_cache);
+}
+
+
 /*
  * Cairo types.
  */
@@ -510,240 +737,699 @@ goo_canvas_query_child_properties (gpointer  class,
 }
 
 
-static gdouble
-parse_double (gchar    **pos,
-	      gboolean  *error)
-{
-  gdouble result;
-  gchar *p;
+/*
+ * SVG path data parsing.
+ */
+
+/* The results of scanning a token of path data. PARSE_NEED_MORE means the
+   token reaches the end of a block of data which isn't the last one, so it
+   may continue in the next block. */
+enum {
+  PARSE_OK,
+  PARSE_ERROR,
+  PARSE_NEED_MORE
+};
 
-  /* If an error has already occurred, just return. */
-  if (*error)
-    return 0;
+#define IS_PATH_SPACE(c)  ((c) == ' ' || (c) == '\t' || (c) == '\r' || (c) == '\n')
+
+/* Powers of 10 which can be represented exactly as doubles. */
+static const gdouble exact_powers_of_10[] = {
+  1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+
+/* Scans a number, in the locale-independent format used by SVG. Most
+   numbers have few enough digits to be converted exactly using integer
+   arithmetic and a single multiplication or division. Others are passed on
+   to g_ascii_strtod(). On error pos is left at the start of the number. */
+static gint
+scan_number (const gchar **pos,
+	     const gchar  *end,
+	     gboolean      is_final,
+	     gdouble      *result)
+{
+  const gchar *p = *pos, *start, *exponent_start;
+  guint64 mantissa = 0;
+  gint exponent = 0, explicit_exponent = 0, n_digits = 0;
+  gboolean negative = FALSE, negative_exponent = FALSE, found_digits = FALSE;
+  gboolean truncated = FALSE;
+  gchar buffer[G_ASCII_DTOSTR_BUF_SIZE], *tmp;
+  gsize length;
 
   /* Skip whitespace and commas. */
-  p = *pos;
-  while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n' || *p == ',')
+  while (p < end && (IS_PATH_SPACE (*p) || *p == ','))
     p++;
+  *pos = start = p;
 
-  /* Parse the double, and set pos to the first char after it. */
-  result = g_ascii_strtod (p, pos);
+  if (p < end && (*p == '+' || *p == '-'))
+    {
+      negative = (*p == '-');
+      p++;
+    }
 
-  /* If no characters were parsed, set the error flag. */
-  if (p == *pos)
-    *error = TRUE;
+  /* The integer part. We keep up to 19 significant digits, which always
+     fit in a guint64. */
+  for (; p < end && g_ascii_isdigit (*p); p++)
+    {
+      found_digits = TRUE;
+      if (n_digits < 19)
+	{
+	  mantissa = mantissa * 10 + (*p - '0');
+	  if (mantissa)
+	    n_digits++;
+	}
+      else
+	{
+	  exponent++;
+	  truncated = TRUE;
+	}
+    }
 
-  return result;
+  /* The fractional part. */
+  if (p < end && *p == '.')
+    {
+      for (p++; p < end && g_ascii_isdigit (*p); p++)
+	{
+	  found_digits = TRUE;
+	  if (n_digits < 19)
+	    {
+	      mantissa = mantissa * 10 + (*p - '0');
+	      if (mantissa)
+		n_digits++;
+	      exponent--;
+	    }
+	  else
+	    {
+	      truncated = TRUE;
+	    }
+	}
+    }
+
+  if (!found_digits)
+    return (p == end && !is_final) ? PARSE_NEED_MORE : PARSE_ERROR;
+
+  /* The exponent. If there are no digits after the 'e' it isn't part of
+     the number. */
+  if (p < end && (*p == 'e' || *p == 'E'))
+    {
+      exponent_start = p++;
+      if (p < end && (*p == '+' || *p == '-'))
+	{
+	  negative_exponent = (*p == '-');
+	  p++;
+	}
+
+      if (p < end && g_ascii_isdigit (*p))
+	{
+	  for (; p < end && g_ascii_isdigit (*p); p++)
+	    {
+	      if (explicit_exponent < 100000)
+		explicit_exponent = explicit_exponent * 10 + (*p - '0');
+	    }
+	  exponent += negative_exponent ? -explicit_exponent : explicit_exponent;
+	}
+      else if (p < end || is_final)
+	{
+	  p = exponent_start;
+	}
+    }
+
+  if (p == end && !is_final)
+    return PARSE_NEED_MORE;
+
+  if (!truncated && mantissa < (G_GUINT64_CONSTANT (1) << 53)
+      && exponent >= -22 && exponent <= 22)
+    {
+      *result = (gdouble) mantissa;
+      if (exponent > 0)
+	*result *= exact_powers_of_10[exponent];
+      else if (exponent < 0)
+	*result /= exact_powers_of_10[-exponent];
+      if (negative)
+	*result = -*result;
+    }
+  else
+    {
+      /* The number isn't nul-terminated, so we copy it. */
+      length = p - start;
+      tmp = length < sizeof (buffer) ? buffer : g_malloc (length + 1);
+      memcpy (tmp, start, length);
+      tmp[length] = '\0';
+      *result = g_ascii_strtod (tmp, NULL);
+      if (tmp != buffer)
+	g_free (tmp);
+    }
+
+  *pos = p;
+  return PARSE_OK;
 }
 
 
+/* Scans an elliptical arc flag, which must be a '0' or a '1'. */
 static gint
-parse_flag (gchar    **pos,
-	    gboolean  *error)
+scan_flag (const gchar **pos,
+	   const gchar  *end,
+	   gboolean      is_final,
+	   gdouble      *result)
 {
-  gint result = 0;
-  gchar *p;
-
-  /* If an error has already occurred, just return. */
-  if (*error)
-    return 0;
+  const gchar *p = *pos;
 
   /* Skip whitespace and commas. */
-  p = *pos;
-  while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n' || *p == ',')
+  while (p < end && (IS_PATH_SPACE (*p) || *p == ','))
     p++;
+  *pos = p;
 
-  /* The flag must be a '0' or a '1'. */
-  if (*p == '0')
-    result = 0;
-  else if (*p == '1')
-    result = 1;
-  else
+  if (p == end)
+    return is_final ? PARSE_ERROR : PARSE_NEED_MORE;
+
+  if (*p != '0' && *p != '1')
+    return PARSE_ERROR;
+
+  *result = *p - '0';
+  *pos = p + 1;
+  return PARSE_OK;
+}
+
+
+/* Scans the arguments of the given command letter. */
+static gint
+scan_command (gchar                  command,
+	      const gchar          **pos,
+	      const gchar           *end,
+	      gboolean               is_final,
+	      GooCanvasPathCommand  *cmd)
+{
+  GooCanvasPathCommandType type;
+  gdouble args[7];
+  gint n_args, i, result;
+
+  switch (command)
     {
-      *error = TRUE;
-      return 0;
+      /* Simple commands like moveto and lineto: MmZzLlHhVv. */
+    case 'm': case 'M':
+      type = GOO_CANVAS_PATH_MOVE_TO;
+      n_args = 2;
+      break;
+    case 'z': case 'Z':
+      type = GOO_CANVAS_PATH_CLOSE_PATH;
+      n_args = 0;
+      break;
+    case 'l': case 'L':
+      type = GOO_CANVAS_PATH_LINE_TO;
+      n_args = 2;
+      break;
+    case 'h': case 'H':
+      type = GOO_CANVAS_PATH_HORIZONTAL_LINE_TO;
+      n_args = 1;
+      break;
+    case 'v': case 'V':
+      type = GOO_CANVAS_PATH_VERTICAL_LINE_TO;
+      n_args = 1;
+      break;
+
+      /* Bezier curve commands: CcSsQqTt. */
+    case 'c': case 'C':
+      type = GOO_CANVAS_PATH_CURVE_TO;
+      n_args = 6;
+      break;
+    case 's': case 'S':
+      type = GOO_CANVAS_PATH_SMOOTH_CURVE_TO;
+      n_args = 4;
+      break;
+    case 'q': case 'Q':
+      type = GOO_CANVAS_PATH_QUADRATIC_CURVE_TO;
+      n_args = 4;
+      break;
+    case 't': case 'T':
+      type = GOO_CANVAS_PATH_SMOOTH_QUADRATIC_CURVE_TO;
+      n_args = 2;
+      break;
+
+      /* The elliptical arc commands: Aa. */
+    case 'a': case 'A':
+      type = GOO_CANVAS_PATH_ELLIPTICAL_ARC;
+      n_args = 7;
+      break;
+
+    default:
+      /* Leave pos at the unknown command letter. */
+      (*pos)--;
+      return PARSE_ERROR;
     }
 
-  *pos = p + 1;
+  for (i = 0; i < n_args; i++)
+    {
+      if (type == GOO_CANVAS_PATH_ELLIPTICAL_ARC && (i == 3 || i == 4))
+	result = scan_flag (pos, end, is_final, &args[i]);
+      else
+	result = scan_number (pos, end, is_final, &args[i]);
+      if (result != PARSE_OK)
+	return result;
+    }
 
-  return result;
+  cmd->simple.type = type;
+  cmd->simple.relative = g_ascii_islower (command) ? 1 : 0;
+
+  switch (type)
+    {
+    case GOO_CANVAS_PATH_MOVE_TO:
+    case GOO_CANVAS_PATH_LINE_TO:
+      cmd->simple.x = args[0];
+      cmd->simple.y = args[1];
+      break;
+    case GOO_CANVAS_PATH_CLOSE_PATH:
+      break;
+    case GOO_CANVAS_PATH_HORIZONTAL_LINE_TO:
+      cmd->simple.x = args[0];
+      break;
+    case GOO_CANVAS_PATH_VERTICAL_LINE_TO:
+      cmd->simple.y = args[0];
+      break;
+    case GOO_CANVAS_PATH_CURVE_TO:
+      cmd->curve.x1 = args[0];
+      cmd->curve.y1 = args[1];
+      cmd->curve.x2 = args[2];
+      cmd->curve.y2 = args[3];
+      cmd->curve.x = args[4];
+      cmd->curve.y = args[5];
+      break;
+    case GOO_CANVAS_PATH_SMOOTH_CURVE_TO:
+      cmd->curve.x2 = args[0];
+      cmd->curve.y2 = args[1];
+      cmd->curve.x = args[2];
+      cmd->curve.y = args[3];
+      break;
+    case GOO_CANVAS_PATH_QUADRATIC_CURVE_TO:
+      cmd->curve.x1 = args[0];
+      cmd->curve.y1 = args[1];
+      cmd->curve.x = args[2];
+      cmd->curve.y = args[3];
+      break;
+    case GOO_CANVAS_PATH_SMOOTH_QUADRATIC_CURVE_TO:
+      cmd->curve.x = args[0];
+      cmd->curve.y = args[1];
+      break;
+    case GOO_CANVAS_PATH_ELLIPTICAL_ARC:
+      cmd->arc.rx = args[0];
+      cmd->arc.ry = args[1];
+      cmd->arc.x_axis_rotation = args[2];
+      cmd->arc.large_arc_flag = args[3] != 0.0;
+      cmd->arc.sweep_flag = args[4] != 0.0;
+      cmd->arc.x = args[5];
+      cmd->arc.y = args[6];
+      break;
+    }
+
+  return PARSE_OK;
 }
 
 
 /**
- * goo_canvas_parse_path_data:
- * @path_data: the sequence of path commands, specified as a string using the
- *  same syntax as in the <ulink url="http://www.w3.org/Graphics/SVG/">Scalable
- *  Vector Graphics (SVG)</ulink> path element.
- * 
- * Parses the given SVG path specification string.
- * 
- * Returns: (element-type GooCanvasPathCommand) (transfer full): a #GArray of #GooCanvasPathCommand elements.
- **/
-GArray*
-goo_canvas_parse_path_data (const gchar       *path_data)
+ * GooCanvasPathParser:
+ *
+ * #GooCanvasPathParser parses SVG path data which is supplied in blocks,
+ * for example as it is read from a file. It contains private data only.
+ *
+ * Since: 3.0
+ */
+struct _GooCanvasPathParser
 {
+  /* Where the commands are added. Only one of these is set. */
   GArray *commands;
-  GooCanvasPathCommand cmd;
-  gchar *pos, command = 0, next_command;
-  gboolean error = FALSE;
+  GooCanvasPackedPath *packed_path;
 
-  commands = g_array_new (0, 0, sizeof (GooCanvasPathCommand));
+  /* The last command letter, used for repeated commands. */
+  gchar command;
 
-  if (!path_data)
-    return commands;
+  /* The end of the previous block of data, if it ended in the middle of a
+     command. It is only used when parsing in blocks. */
+  GString *pending;
+
+  /* The offset of the next data to parse in the whole path data. */
+  gsize offset;
+
+  /* The offset of the first syntax error, or -1. */
+  gssize error_offset;
+};
+
+
+static void
+path_parser_init (GooCanvasPathParser *parser,
+		  GArray              *commands,
+		  GooCanvasPackedPath *packed_path)
+{
+  parser->commands = commands;
+  parser->packed_path = packed_path;
+  parser->command = 0;
+  parser->pending = NULL;
+  parser->offset = 0;
+  parser->error_offset = -1;
+}
+
+
+/* Parses as many commands as possible from the data. If is_final is FALSE,
+   a command which reaches the end of the data is left unparsed, since it may
+   continue in the next block. Returns the number of bytes parsed. */
+static gsize
+path_parser_parse (GooCanvasPathParser *parser,
+		   const gchar         *data,
+		   gsize                length,
+		   gboolean             is_final)
+{
+  const gchar *pos = data, *end = data + length, *command_start;
+  GooCanvasPathCommand cmd;
+  gchar command;
+  gint result;
 
-  pos = (gchar*) path_data;
   for (;;)
     {
-      while (*pos == ' ' || *pos == '\t' || *pos == '\r' || *pos == '\n')
+      while (pos < end && IS_PATH_SPACE (*pos))
 	pos++;
-      if (!*pos)
+      if (pos == end)
 	break;
 
-      next_command = *pos;
+      command_start = pos;
 
       /* If there is no command letter, we use the same command as the last
-	 one, except for the first command, and 'moveto' (which becomes
-	 'lineto'). */
-      if ((next_command < 'a' || next_command > 'z')
-	  && (next_command < 'A' || next_command > 'Z'))
+	 one, except for 'moveto' which becomes 'lineto'. It is an error if
+	 there is no previous command or it was a 'closepath'. */
+      if (g_ascii_isalpha (*pos))
 	{
-	  /* If this is the first command, then set the error flag and assume
-	     a simple close-path command. */
-	  if (!command)
-	    {
-	      error = TRUE;
-	      command = 'Z';
-	    }
-	  /* moveto commands change to lineto. */
-	  else if (command == 'm')
+	  command = *pos++;
+	}
+      else
+	{
+	  command = parser->command;
+	  if (command == 'm')
 	    command = 'l';
 	  else if (command == 'M')
 	    command = 'L';
+	  else if (command == 0 || command == 'z' || command == 'Z')
+	    {
+	      parser->error_offset = parser->offset + (pos - data);
+	      break;
+	    }
 	}
-      else
+
+      result = scan_command (command, &pos, end, is_final, &cmd);
+
+      if (result == PARSE_NEED_MORE)
 	{
-	  command = next_command;
-	  pos++;
+	  pos = command_start;
+	  break;
 	}
 
-      cmd.simple.relative = 0;
-      switch (command)
+      /* If an error has occurred, stop without adding the new command.
+	 Thus we include everything in the path up to the error, like SVG. */
+      if (result == PARSE_ERROR)
 	{
-	  /* Simple commands like moveto and lineto: MmZzLlHhVv. */
-	case 'm':
-	  cmd.simple.relative = 1;
-	case 'M':
-	  cmd.simple.type = GOO_CANVAS_PATH_MOVE_TO;
-	  cmd.simple.x = parse_double (&pos, &error);
-	  cmd.simple.y = parse_double (&pos, &error);
+	  parser->error_offset = parser->offset + (pos - data);
 	  break;
+	}
 
-	case 'Z':
-	case 'z':
-	  cmd.simple.type = GOO_CANVAS_PATH_CLOSE_PATH;
-	  break;
+      parser->command = command;
+      if (parser->packed_path)
+	goo_canvas_packed_path_add_command (parser->packed_path, &cmd);
+      else
+	g_array_append_val (parser->commands, cmd);
+    }
 
-	case 'l':
-	  cmd.simple.relative = 1;
-	case 'L':
-	  cmd.simple.type = GOO_CANVAS_PATH_LINE_TO;
-	  cmd.simple.x = parse_double (&pos, &error);
-	  cmd.simple.y = parse_double (&pos, &error);
-	  break;
+  parser->offset += pos - data;
+  return pos - data;
+}
 
-	case 'h':
-	  cmd.simple.relative = 1;
-	case 'H':
-	  cmd.simple.type = GOO_CANVAS_PATH_HORIZONTAL_LINE_TO;
-	  cmd.simple.x = parse_double (&pos, &error);
-	  break;
 
-	case 'v':
-	  cmd.simple.relative = 1;
-	case 'V':
-	  cmd.simple.type = GOO_CANVAS_PATH_VERTICAL_LINE_TO;
-	  cmd.simple.y = parse_double (&pos, &error);
-	  break;
+/* Makes a quick estimate of the number of commands in the path data, from
+   the number of command letters and numbers. */
+static guint
+path_parser_estimate_commands (const gchar *data,
+			       gsize        length)
+{
+  const gchar *p, *end = data + length;
+  guint n_letters = 0, n_numbers = 0;
+  gboolean in_number = FALSE;
 
-	  /* Bezier curve commands: CcSsQqTt. */
-	case 'c':
-	  cmd.curve.relative = 1;
-	case 'C':
-	  cmd.curve.type = GOO_CANVAS_PATH_CURVE_TO;
-	  cmd.curve.x1 = parse_double (&pos, &error);
-	  cmd.curve.y1 = parse_double (&pos, &error);
-	  cmd.curve.x2 = parse_double (&pos, &error);
-	  cmd.curve.y2 = parse_double (&pos, &error);
-	  cmd.curve.x = parse_double (&pos, &error);
-	  cmd.curve.y = parse_double (&pos, &error);
-	  break;
+  for (p = data; p < end; p++)
+    {
+      if (g_ascii_isdigit (*p) || *p == '.')
+	{
+	  if (!in_number)
+	    n_numbers++;
+	  in_number = TRUE;
+	}
+      else if (*p == 'e' || *p == 'E')
+	{
+	  /* This is the exponent of a number. */
+	}
+      else
+	{
+	  in_number = FALSE;
+	  if (g_ascii_isalpha (*p))
+	    n_letters++;
+	}
+    }
 
-	case 's':
-	  cmd.curve.relative = 1;
-	case 'S':
-	  cmd.curve.type = GOO_CANVAS_PATH_SMOOTH_CURVE_TO;
-	  cmd.curve.x2 = parse_double (&pos, &error);
-	  cmd.curve.y2 = parse_double (&pos, &error);
-	  cmd.curve.x = parse_double (&pos, &error);
-	  cmd.curve.y = parse_double (&pos, &error);
-	  break;
+  return MAX (n_letters, n_numbers / 2);
+}
 
-	case 'q':
-	  cmd.curve.relative = 1;
-	case 'Q':
-	  cmd.curve.type = GOO_CANVAS_PATH_QUADRATIC_CURVE_TO;
-	  cmd.curve.x1 = parse_double (&pos, &error);
-	  cmd.curve.y1 = parse_double (&pos, &error);
-	  cmd.curve.x = parse_double (&pos, &error);
-	  cmd.curve.y = parse_double (&pos, &error);
-	  break;
 
-	case 't':
-	  cmd.curve.relative = 1;
-	case 'T':
-	  cmd.curve.type = GOO_CANVAS_PATH_SMOOTH_QUADRATIC_CURVE_TO;
-	  cmd.curve.x = parse_double (&pos, &error);
-	  cmd.curve.y = parse_double (&pos, &error);
-	  break;
+/**
+ * goo_canvas_path_parser_new:
+ * @packed_path: (allow-none): a packed path to add the commands to, or %NULL
+ *  to add them to a new array of #GooCanvasPathCommand.
+ *
+ * Creates a parser for SVG path data which is supplied in blocks with
+ * goo_canvas_path_parser_feed(). The blocks can be split anywhere, even in
+ * the middle of a number.
+ *
+ * Returns: a new path parser, which is freed by
+ *  goo_canvas_path_parser_finish().
+ *
+ * Since: 3.0
+ **/
+GooCanvasPathParser*
+goo_canvas_path_parser_new (GooCanvasPackedPath *packed_path)
+{
+  GooCanvasPathParser *parser;
 
-	  /* The elliptical arc commands: Aa. */
-	case 'a':
-	  cmd.arc.relative = 1;
-	case 'A':
-	  cmd.arc.type = GOO_CANVAS_PATH_ELLIPTICAL_ARC;
-	  cmd.arc.rx = parse_double (&pos, &error);
-	  cmd.arc.ry = parse_double (&pos, &error);
-	  cmd.arc.x_axis_rotation = parse_double (&pos, &error);
-	  cmd.arc.large_arc_flag = parse_flag (&pos, &error);
-	  cmd.arc.sweep_flag = parse_flag (&pos, &error);
-	  cmd.arc.x = parse_double (&pos, &error);
-	  cmd.arc.y = parse_double (&pos, &error);
-	  break;
+  parser = g_slice_new (GooCanvasPathParser);
+  path_parser_init (parser, packed_path ? NULL
+		    : g_array_new (FALSE, FALSE, sizeof (GooCanvasPathCommand)),
+		    packed_path ? goo_canvas_packed_path_ref (packed_path) : NULL);
+  parser->pending = g_string_new (NULL);
 
-	default:
-	  error = TRUE;
-	  break;
-	}
+  return parser;
+}
 
-      /* If an error has occurred, return without adding the new command.
-	 Thus we include everything in the path up to the error, like SVG. */
-      if (error)
-	return commands;
 
-      g_array_append_val (commands, cmd);
+/**
+ * goo_canvas_path_parser_feed:
+ * @parser: a #GooCanvasPathParser.
+ * @data: (array length=length): the next block of path data.
+ * @length: the length of @data, in bytes.
+ *
+ * Parses the next block of path data. Any command at the end of the block
+ * which may continue in the next block is kept until more data is fed.
+ *
+ * Returns: %FALSE if a syntax error has been found, in which case the rest
+ *  of the path data is ignored and doesn't need to be fed.
+ *
+ * Since: 3.0
+ **/
+gboolean
+goo_canvas_path_parser_feed (GooCanvasPathParser *parser,
+			     const gchar         *data,
+			     gsize                length)
+{
+  gsize parsed;
+
+  g_return_val_if_fail (parser != NULL, FALSE);
+  g_return_val_if_fail (data != NULL || length == 0, FALSE);
+
+  if (parser->error_offset != -1)
+    return FALSE;
+
+  if (parser->pending->len == 0)
+    {
+      /* Parse the block in place, and keep any unparsed command at the end. */
+      parsed = path_parser_parse (parser, data, length, FALSE);
+      g_string_append_len (parser->pending, data + parsed, length - parsed);
+    }
+  else
+    {
+      g_string_append_len (parser->pending, data, length);
+      parsed = path_parser_parse (parser, parser->pending->str,
+				  parser->pending->len, FALSE);
+      g_string_erase (parser->pending, 0, parsed);
     }
 
-  return commands;
+  return parser->error_offset == -1;
 }
 
 
-static void
-do_curve_to (GooCanvasPathCommand *cmd,
-	     cairo_t              *cr,
-	     gdouble              *x,
-	     gdouble              *y,
+/**
+ * goo_canvas_path_parser_finish:
+ * @parser: a #GooCanvasPathParser.
+ * @error_offset: (out) (allow-none): returns the offset in bytes of the
+ *  first syntax error in the path data, or -1 if there was no error.
+ *
+ * Parses any remaining path data, and frees the parser. If a syntax error
+ * was found the commands up to the error are returned, like SVG.
+ *
+ * Returns: (element-type GooCanvasPathCommand) (transfer full): a #GArray of
+ *  #GooCanvasPathCommand elements, or %NULL if a packed path was passed to
+ *  goo_canvas_path_parser_new().
+ *
+ * Since: 3.0
+ **/
+GArray*
+goo_canvas_path_parser_finish (GooCanvasPathParser *parser,
+			       gssize              *error_offset)
+{
+  GArray *commands;
+
+  g_return_val_if_fail (parser != NULL, NULL);
+
+  if (parser->error_offset == -1 && parser->pending->len > 0)
+    path_parser_parse (parser, parser->pending->str, parser->pending->len,
+		       TRUE);
+
+  if (error_offset)
+    *error_offset = parser->error_offset;
+
+  commands = parser->commands;
+  goo_canvas_packed_path_unref (parser->packed_path);
+  g_string_free (parser->pending, TRUE);
+  g_slice_free (GooCanvasPathParser, parser);
+
+  return commands;
+}
+
+
+/**
+ * goo_canvas_parse_path_data:
+ * @path_data: the sequence of path commands, specified as a string using the
+ *  same syntax as in the <ulink url="http://www.w3.org/Graphics/SVG/">Scalable
+ *  Vector Graphics (SVG)</ulink> path element.
+ * 
+ * Parses the given SVG path specification string.
+ * 
+ * Returns: (element-type GooCanvasPathCommand) (transfer full): a #GArray of #GooCanvasPathCommand elements.
+ **/
+GArray*
+goo_canvas_parse_path_data (const gchar       *path_data)
+{
+  return goo_canvas_parse_path_data_full (path_data, -1, NULL);
+}
+
+
+/**
+ * goo_canvas_parse_path_data_full:
+ * @path_data: (array length=length) (allow-none): the sequence of path
+ *  commands, using the same syntax as in the
+ *  <ulink url="http://www.w3.org/Graphics/SVG/">Scalable Vector Graphics
+ *  (SVG)</ulink> path element.
+ * @length: the length of @path_data in bytes, or -1 if it is nul-terminated.
+ *  The data doesn't need to be nul-terminated if the length is given, so it
+ *  can be parsed directly from a #GMappedFile for example.
+ * @error_offset: (out) (allow-none): returns the offset in bytes of the
+ *  first syntax error in the path data, or -1 if there was no error.
+ *
+ * Parses the given SVG path data. If a syntax error is found the commands up
+ * to the error are returned, like SVG.
+ *
+ * Returns: (element-type GooCanvasPathCommand) (transfer full): a #GArray of
+ *  #GooCanvasPathCommand elements.
+ *
+ * Since: 3.0
+ **/
+GArray*
+goo_canvas_parse_path_data_full (const gchar *path_data,
+				 gssize       length,
+				 gssize      *error_offset)
+{
+  GooCanvasPathParser parser;
+  GArray *commands;
+
+  if (!path_data)
+    length = 0;
+  else if (length < 0)
+    length = strlen (path_data);
+
+  commands = g_array_sized_new (FALSE, FALSE, sizeof (GooCanvasPathCommand),
+				path_parser_estimate_commands (path_data,
+							       length));
+
+  path_parser_init (&parser, commands, NULL);
+  path_parser_parse (&parser, path_data, length, TRUE);
+
+  if (error_offset)
+    *error_offset = parser.error_offset;
+
+  return commands;
+}
+
+
+/**
+ * goo_canvas_parse_path_stream:
+ * @stream: a #GInputStream to read the path data from.
+ * @cancellable: (allow-none): a #GCancellable, or %NULL.
+ * @error_offset: (out) (allow-none): returns the offset in bytes of the
+ *  first syntax error in the path data, or -1 if there was no error.
+ * @error: return location for an error reading the stream, or %NULL.
+ *
+ * Reads SVG path data from a stream and parses it as it is read, without
+ * reading it all into memory first. Reading stops at the first syntax
+ * error, and the commands up to the error are returned.
+ *
+ * Returns: (element-type GooCanvasPathCommand) (transfer full): a #GArray of
+ *  #GooCanvasPathCommand elements, or %NULL if the stream couldn't be read.
+ *
+ * Since: 3.0
+ **/
+GArray*
+goo_canvas_parse_path_stream (GInputStream  *stream,
+			      GCancellable  *cancellable,
+			      gssize        *error_offset,
+			      GError       **error)
+{
+  GooCanvasPathParser *parser;
+  GArray *commands;
+  gchar *buffer;
+  gssize n_read;
+
+  g_return_val_if_fail (G_IS_INPUT_STREAM (stream), NULL);
+
+  parser = goo_canvas_path_parser_new (NULL);
+  buffer = g_malloc (65536);
+
+  for (;;)
+    {
+      n_read = g_input_stream_read (stream, buffer, 65536, cancellable, error);
+      if (n_read < 0)
+	{
+	  g_free (buffer);
+	  g_array_free (goo_canvas_path_parser_finish (parser, NULL), TRUE);
+	  return NULL;
+	}
+
+      if (n_read == 0 || !goo_canvas_path_parser_feed (parser, buffer, n_read))
+	break;
+    }
+
+  g_free (buffer);
+  commands = goo_canvas_path_parser_finish (parser, error_offset);
+
+  return commands;
+}
+
+
+static void
+do_curve_to (GooCanvasPathCommand *cmd,
+	     cairo_t              *cr,
+	     gdouble              *x,
+	     gdouble              *y,
 	     gdouble              *last_control_point_x,
 	     gdouble              *last_control_point_y)
 {
@@ -1056,6 +1742,121 @@ do_elliptical_arc (GooCanvasPathCommand    *cmd,
 }
 
 
+/* The current state of a path being created. */
+typedef struct _GooCanvasPathState GooCanvasPathState;
+struct _GooCanvasPathState
+{
+  GooCanvasPathCommandType prev_cmd_type;
+  gdouble x, y, path_start_x, path_start_y;
+  gdouble last_control_point_x, last_control_point_y;
+};
+
+
+static void
+goo_canvas_path_state_init (GooCanvasPathState *state)
+{
+  state->prev_cmd_type = GOO_CANVAS_PATH_CLOSE_PATH;
+  state->x = state->y = 0.0;
+  state->path_start_x = state->path_start_y = 0.0;
+  state->last_control_point_x = state->last_control_point_y = 0.0;
+}
+
+
+static void
+do_path_command (GooCanvasPathCommand *cmd,
+		 cairo_t              *cr,
+		 GooCanvasPathState   *state)
+{
+  switch (cmd->simple.type)
+    {
+      /* Simple commands like moveto and lineto: MmZzLlHhVv. */
+    case GOO_CANVAS_PATH_MOVE_TO:
+      if (cmd->simple.relative)
+	{
+	  state->x += cmd->simple.x;
+	  state->y += cmd->simple.y;
+	}
+      else
+	{
+	  state->x = cmd->simple.x;
+	  state->y = cmd->simple.y;
+	}
+      state->path_start_x = state->x;
+      state->path_start_y = state->y;
+      cairo_move_to (cr, state->x, state->y);
+      break;
+
+    case GOO_CANVAS_PATH_CLOSE_PATH:
+      state->x = state->path_start_x;
+      state->y = state->path_start_y;
+      cairo_close_path (cr);
+      break;
+
+    case GOO_CANVAS_PATH_LINE_TO:
+      if (cmd->simple.relative)
+	{
+	  state->x += cmd->simple.x;
+	  state->y += cmd->simple.y;
+	}
+      else
+	{
+	  state->x = cmd->simple.x;
+	  state->y = cmd->simple.y;
+	}
+      cairo_line_to (cr, state->x, state->y);
+      break;
+
+    case GOO_CANVAS_PATH_HORIZONTAL_LINE_TO:
+      if (cmd->simple.relative)
+	state->x += cmd->simple.x;
+      else
+	state->x = cmd->simple.x;
+      cairo_line_to (cr, state->x, state->y);
+      break;
+
+    case GOO_CANVAS_PATH_VERTICAL_LINE_TO:
+      if (cmd->simple.relative)
+	state->y += cmd->simple.y;
+      else
+	state->y = cmd->simple.y;
+      cairo_line_to (cr, state->x, state->y);
+      break;
+
+      /* Bezier curve commands: CcSsQqTt. */
+    case GOO_CANVAS_PATH_CURVE_TO:
+      do_curve_to (cmd, cr, &state->x, &state->y,
+		   &state->last_control_point_x, &state->last_control_point_y);
+      break;
+
+    case GOO_CANVAS_PATH_SMOOTH_CURVE_TO:
+      do_smooth_curve_to (cmd, state->prev_cmd_type, cr, &state->x, &state->y,
+			  &state->last_control_point_x,
+			  &state->last_control_point_y);
+      break;
+
+    case GOO_CANVAS_PATH_QUADRATIC_CURVE_TO:
+      do_quadratic_curve_to (cmd, cr, &state->x, &state->y,
+			     &state->last_control_point_x,
+			     &state->last_control_point_y);
+      break;
+
+    case GOO_CANVAS_PATH_SMOOTH_QUADRATIC_CURVE_TO:
+      do_smooth_quadratic_curve_to (cmd, state->prev_cmd_type, cr,
+				    &state->x, &state->y,
+				    &state->last_control_point_x,
+				    &state->last_control_point_y);
+      break;
+
+      /* The elliptical arc commands: Aa. */
+    case GOO_CANVAS_PATH_ELLIPTICAL_ARC:
+      do_elliptical_arc (cmd, cr, &state->x, &state->y);
+      break;
+    }
+
+  state->prev_cmd_type = cmd->simple.type;
+}
+
+
 /**
  * goo_canvas_create_path:
  * @commands: (element-type GooCanvasPathCommand): an array of
@@ -1068,10 +1869,7 @@ void
 goo_canvas_create_path (GArray              *commands,
 			cairo_t             *cr)
 {
-  GooCanvasPathCommand *cmd;
-  GooCanvasPathCommandType prev_cmd_type = GOO_CANVAS_PATH_CLOSE_PATH;
-  gdouble x = 0, y = 0, path_start_x = 0, path_start_y = 0;
-  gdouble last_control_point_x = 0.0, last_control_point_y = 0.0;
+  GooCanvasPathState state;
   gint i;
 
   cairo_new_path (cr);
@@ -1079,93 +1877,1013 @@ goo_canvas_create_path (GArray              *commands,
   if (!commands || commands->len == 0)
     return;
 
+  goo_canvas_path_state_init (&state);
   for (i = 0; i < commands->len; i++)
+    do_path_command (&g_array_index (commands, GooCanvasPathCommand, i),
+		     cr, &state);
+}
+
+
+/* Updates the state as do_path_command() does, without creating the path. */
+static void
+goo_canvas_path_state_skip (GooCanvasPathCommand *cmd,
+			    GooCanvasPathState   *state)
+{
+  gdouble x = state->x, y = state->y;
+
+  switch (cmd->simple.type)
+    {
+    case GOO_CANVAS_PATH_MOVE_TO:
+    case GOO_CANVAS_PATH_LINE_TO:
+      state->x = cmd->simple.relative ? x + cmd->simple.x : cmd->simple.x;
+      state->y = cmd->simple.relative ? y + cmd->simple.y : cmd->simple.y;
+      if (cmd->simple.type == GOO_CANVAS_PATH_MOVE_TO)
+	{
+	  state->path_start_x = state->x;
+	  state->path_start_y = state->y;
+	}
+      break;
+
+    case GOO_CANVAS_PATH_CLOSE_PATH:
+      state->x = state->path_start_x;
+      state->y = state->path_start_y;
+      break;
+
+    case GOO_CANVAS_PATH_HORIZONTAL_LINE_TO:
+      state->x = cmd->simple.relative ? x + cmd->simple.x : cmd->simple.x;
+      break;
+
+    case GOO_CANVAS_PATH_VERTICAL_LINE_TO:
+      state->y = cmd->simple.relative ? y + cmd->simple.y : cmd->simple.y;
+      break;
+
+    case GOO_CANVAS_PATH_CURVE_TO:
+    case GOO_CANVAS_PATH_SMOOTH_CURVE_TO:
+      state->last_control_point_x = cmd->curve.relative
+	? x + cmd->curve.x2 : cmd->curve.x2;
+      state->last_control_point_y = cmd->curve.relative
+	? y + cmd->curve.y2 : cmd->curve.y2;
+      state->x = cmd->curve.relative ? x + cmd->curve.x : cmd->curve.x;
+      state->y = cmd->curve.relative ? y + cmd->curve.y : cmd->curve.y;
+      break;
+
+    case GOO_CANVAS_PATH_QUADRATIC_CURVE_TO:
+      state->last_control_point_x = cmd->curve.relative
+	? x + cmd->curve.x1 : cmd->curve.x1;
+      state->last_control_point_y = cmd->curve.relative
+	? y + cmd->curve.y1 : cmd->curve.y1;
+      state->x = cmd->curve.relative ? x + cmd->curve.x : cmd->curve.x;
+      state->y = cmd->curve.relative ? y + cmd->curve.y : cmd->curve.y;
+      break;
+
+    case GOO_CANVAS_PATH_SMOOTH_QUADRATIC_CURVE_TO:
+      /* The control point is the reflection of the previous one, as in
+	 do_smooth_quadratic_curve_to(). */
+      if (state->prev_cmd_type == GOO_CANVAS_PATH_QUADRATIC_CURVE_TO
+	  || state->prev_cmd_type == GOO_CANVAS_PATH_SMOOTH_QUADRATIC_CURVE_TO)
+	{
+	  state->last_control_point_x = x + (x - state->last_control_point_x);
+	  state->last_control_point_y = y + (y - state->last_control_point_y);
+	}
+      else
+	{
+	  state->last_control_point_x = x;
+	  state->last_control_point_y = y;
+	}
+      state->x = cmd->curve.relative ? x + cmd->curve.x : cmd->curve.x;
+      state->y = cmd->curve.relative ? y + cmd->curve.y : cmd->curve.y;
+      break;
+
+    case GOO_CANVAS_PATH_ELLIPTICAL_ARC:
+      state->x = cmd->arc.relative ? x + cmd->arc.x : cmd->arc.x;
+      state->y = cmd->arc.relative ? y + cmd->arc.y : cmd->arc.y;
+      break;
+    }
+
+  state->prev_cmd_type = cmd->simple.type;
+}
+
+
+/* Finds the state after the commands before first, without creating the
+   path. Absolute commands other than the smooth quadratic curve set the
+   current point and any control point without using the previous state,
+   so we only need to go through the commands from the last of these.
+   The start of the subpath is only found if need_path_start is set, or if
+   it is needed by a close-path command that we go through. */
+static void
+goo_canvas_path_state_find (GArray             *commands,
+			    gint                first,
+			    GooCanvasPathState *state,
+			    gboolean            need_path_start)
+{
+  GooCanvasPathCommand *cmd;
+  GooCanvasPathState move_state;
+  gint start, move, i;
+
+  goo_canvas_path_state_init (state);
+
+  for (start = first - 1; start > 0; start--)
+    {
+      cmd = &g_array_index (commands, GooCanvasPathCommand, start);
+      if (!cmd->simple.relative
+	  && cmd->simple.type != GOO_CANVAS_PATH_CLOSE_PATH
+	  && cmd->simple.type != GOO_CANVAS_PATH_HORIZONTAL_LINE_TO
+	  && cmd->simple.type != GOO_CANVAS_PATH_VERTICAL_LINE_TO
+	  && cmd->simple.type != GOO_CANVAS_PATH_SMOOTH_QUADRATIC_CURVE_TO)
+	break;
+    }
+  start = MAX (start, 0);
+
+  for (i = start; i < first && !need_path_start; i++)
     {
       cmd = &g_array_index (commands, GooCanvasPathCommand, i);
-      switch (cmd->simple.type)
+      if (cmd->simple.type == GOO_CANVAS_PATH_CLOSE_PATH)
+	need_path_start = TRUE;
+    }
+
+  /* If we need the start of the subpath, we find the state at the last
+     move-to command before the commands we go through. Any later move-to
+     commands set it as we go through them. */
+  if (need_path_start)
+    {
+      for (move = start - 1; move >= 0; move--)
 	{
-	  /* Simple commands like moveto and lineto: MmZzLlHhVv. */
-	case GOO_CANVAS_PATH_MOVE_TO:
-	  if (cmd->simple.relative)
-	    {
-	      x += cmd->simple.x;
-	      y += cmd->simple.y;
-	    }
-	  else
-	    {
-	      x = cmd->simple.x;
-	      y = cmd->simple.y;
-	    }
-	  path_start_x = x;
-	  path_start_y = y;
-	  cairo_move_to (cr, x, y);
-	  break;
+	  cmd = &g_array_index (commands, GooCanvasPathCommand, move);
+	  if (cmd->simple.type == GOO_CANVAS_PATH_MOVE_TO)
+	    break;
+	}
 
-	case GOO_CANVAS_PATH_CLOSE_PATH:
-	  x = path_start_x;
-	  y = path_start_y;
-	  cairo_close_path (cr);
+      if (move >= 0)
+	{
+	  goo_canvas_path_state_find (commands, move, &move_state, FALSE);
+	  goo_canvas_path_state_skip (cmd, &move_state);
+	  state->path_start_x = move_state.path_start_x;
+	  state->path_start_y = move_state.path_start_y;
+	}
+    }
+
+  for (i = start; i < first; i++)
+    goo_canvas_path_state_skip (&g_array_index (commands, GooCanvasPathCommand,
+						i), state);
+}
+
+
+/* Creates the path of the commands from first to last, starting from the
+   point where the previous commands end. This is used to calculate the
+   bounds of part of a path. The state of the previous commands is found
+   without going through all of them, so this is quick near the end of a
+   large path. */
+void
+goo_canvas_create_path_range (GArray              *commands,
+			      guint                first,
+			      guint                last,
+			      cairo_t             *cr)
+{
+  GooCanvasPathCommand *cmd;
+  GooCanvasPathState state;
+  gboolean subpath_in_range = FALSE, need_path_start = FALSE;
+  guint i;
+
+  cairo_new_path (cr);
+
+  if (!commands || first > last || first >= commands->len)
+    return;
+
+  last = MIN (last, commands->len - 1);
+
+  /* We only need the start of the subpath if the range closes it before
+     starting a new one. */
+  for (i = first; i <= last; i++)
+    {
+      cmd = &g_array_index (commands, GooCanvasPathCommand, i);
+      if (cmd->simple.type == GOO_CANVAS_PATH_MOVE_TO)
+	break;
+      if (cmd->simple.type == GOO_CANVAS_PATH_CLOSE_PATH)
+	{
+	  need_path_start = TRUE;
 	  break;
+	}
+    }
+
+  /* Find the current point and the state used by the smooth curve
+     commands. */
+  goo_canvas_path_state_find (commands, first, &state, need_path_start);
+
+  if (first > 0)
+    cairo_move_to (cr, state.x, state.y);
+
+  for (i = first; i <= last; i++)
+    {
+      cmd = &g_array_index (commands, GooCanvasPathCommand, i);
+
+      if (cmd->simple.type == GOO_CANVAS_PATH_MOVE_TO)
+	subpath_in_range = TRUE;
+
+      /* If the subpath started before the range, cairo doesn't know where
+	 it started so we draw the closing line ourselves. */
+      if (cmd->simple.type == GOO_CANVAS_PATH_CLOSE_PATH && !subpath_in_range)
+	{
+	  state.x = state.path_start_x;
+	  state.y = state.path_start_y;
+	  cairo_line_to (cr, state.x, state.y);
+	  state.prev_cmd_type = GOO_CANVAS_PATH_CLOSE_PATH;
+	  continue;
+	}
+
+      do_path_command (cmd, cr, &state);
+    }
+}
+
+
+/* Checks if the path is a single rectangle aligned with the axes, such as
+   "M 10 10 h 100 v 50 h -100 z", and returns its bounds if it is. Clipping
+   to a rectangle and testing if a point is inside it can then be done much
+   more quickly. Degenerate rectangles aren't treated as rectangles. */
+gboolean
+goo_canvas_path_get_rectangle (GArray          *commands,
+			       GooCanvasBounds *rect)
+{
+  GooCanvasPathCommand *cmd;
+  gdouble xs[5], ys[5], x = 0.0, y = 0.0;
+  gboolean closed = FALSE, horz_first, vert_first;
+  gint n_points = 0;
+  guint i;
+
+  /* A move, 3 or 4 lines and an optional close path command. */
+  if (!commands || commands->len < 4 || commands->len > 6)
+    return FALSE;
 
+  for (i = 0; i < commands->len; i++)
+    {
+      cmd = &g_array_index (commands, GooCanvasPathCommand, i);
+
+      /* Nothing can come after the close path command, and only the first
+	 command can be a move. */
+      if (closed || (i == 0) != (cmd->simple.type == GOO_CANVAS_PATH_MOVE_TO))
+	return FALSE;
+
+      switch (cmd->simple.type)
+	{
+	case GOO_CANVAS_PATH_MOVE_TO:
 	case GOO_CANVAS_PATH_LINE_TO:
-	  if (cmd->simple.relative)
-	    {
-	      x += cmd->simple.x;
-	      y += cmd->simple.y;
-	    }
-	  else
-	    {
-	      x = cmd->simple.x;
-	      y = cmd->simple.y;
-	    }
-	  cairo_line_to (cr, x, y);
+	  /* A relative move at the start is relative to the origin. */
+	  x = cmd->simple.relative ? x + cmd->simple.x : cmd->simple.x;
+	  y = cmd->simple.relative ? y + cmd->simple.y : cmd->simple.y;
 	  break;
 
 	case GOO_CANVAS_PATH_HORIZONTAL_LINE_TO:
-	  if (cmd->simple.relative)
-	    x += cmd->simple.x;
-	  else
-	    x = cmd->simple.x;
-	  cairo_line_to (cr, x, y);
+	  x = cmd->simple.relative ? x + cmd->simple.x : cmd->simple.x;
 	  break;
 
 	case GOO_CANVAS_PATH_VERTICAL_LINE_TO:
-	  if (cmd->simple.relative)
-	    y += cmd->simple.y;
-	  else
-	    y = cmd->simple.y;
-	  cairo_line_to (cr, x, y);
+	  y = cmd->simple.relative ? y + cmd->simple.y : cmd->simple.y;
 	  break;
 
-	  /* Bezier curve commands: CcSsQqTt. */
-	case GOO_CANVAS_PATH_CURVE_TO:
-	  do_curve_to (cmd, cr, &x, &y,
-		       &last_control_point_x, &last_control_point_y);
+	case GOO_CANVAS_PATH_CLOSE_PATH:
+	  closed = TRUE;
+	  /* If the last line already went back to the start there is nothing
+	     more to add. */
+	  if (x == xs[0] && y == ys[0])
+	    continue;
+	  x = xs[0];
+	  y = ys[0];
 	  break;
 
-	case GOO_CANVAS_PATH_SMOOTH_CURVE_TO:
-	  do_smooth_curve_to (cmd, prev_cmd_type, cr, &x, &y,
-			      &last_control_point_x, &last_control_point_y);
-	  break;
+	default:
+	  return FALSE;
+	}
 
-	case GOO_CANVAS_PATH_QUADRATIC_CURVE_TO:
-	  do_quadratic_curve_to (cmd, cr, &x, &y,
-				 &last_control_point_x, &last_control_point_y);
-	  break;
+      if (n_points == 5)
+	return FALSE;
+      xs[n_points] = x;
+      ys[n_points] = y;
+      n_points++;
+    }
 
-	case GOO_CANVAS_PATH_SMOOTH_QUADRATIC_CURVE_TO:
-	  do_smooth_quadratic_curve_to (cmd, prev_cmd_type, cr, &x, &y,
-					&last_control_point_x,
-					&last_control_point_y);
-	  break;
+  /* Filling closes the path anyway, so it may end at the 4th corner. */
+  if (n_points == 5)
+    {
+      if (xs[4] != xs[0] || ys[4] != ys[0])
+	return FALSE;
+    }
+  else if (n_points != 4)
+    {
+      return FALSE;
+    }
 
-	  /* The elliptical arc commands: Aa. */
-	case GOO_CANVAS_PATH_ELLIPTICAL_ARC:
-	  do_elliptical_arc (cmd, cr, &x, &y);
-	  break;
+  /* The sides must alternate between horizontal and vertical lines. */
+  horz_first = ys[0] == ys[1] && xs[1] == xs[2]
+    && ys[2] == ys[3] && xs[3] == xs[0];
+  vert_first = xs[0] == xs[1] && ys[1] == ys[2]
+    && xs[2] == xs[3] && ys[3] == ys[0];
+  if (!horz_first && !vert_first)
+    return FALSE;
+
+  rect->x1 = MIN (xs[0], xs[2]);
+  rect->y1 = MIN (ys[0], ys[2]);
+  rect->x2 = MAX (xs[0], xs[2]);
+  rect->y2 = MAX (ys[0], ys[2]);
+
+  return rect->x1 < rect->x2 && rect->y1 < rect->y2;
+}
+
+
+/*
+ * Packed paths.
+ */
+
+/* Each command is stored as one tag byte, holding the command type in the
+   low 5 bits followed by the relative flag and the 2 arc flags, and its
+   operands, which are stored in a separate array of floats or doubles. */
+#define PACKED_TAG_TYPE_MASK	0x1F
+#define PACKED_TAG_RELATIVE	(1 << 5)
+#define PACKED_TAG_LARGE_ARC	(1 << 6)
+#define PACKED_TAG_SWEEP	(1 << 7)
+
+/* The maximum number of operands of a command. */
+#define PACKED_MAX_OPERANDS	6
+
+/**
+ * GooCanvasPackedPath:
+ *
+ * #GooCanvasPackedPath holds a sequence of path commands in a compact form,
+ * using a single byte for each command type and only as many floats or
+ * doubles as each command needs. A path of lines uses a third of the memory
+ * of the equivalent #GooCanvasPathCommand array, or a sixth if floats are
+ * used. It contains private data only.
+ *
+ * Since: 3.0
+ */
+struct _GooCanvasPackedPath
+{
+  gint ref_count;
+
+  /* One tag byte per command. */
+  GByteArray *tags;
+
+  /* The operands of all the commands, as gfloat or gdouble. */
+  GArray *operands;
+
+  guint use_floats : 1;
+};
+
+
+/* The number of operands of each command type. */
+static const guint8 packed_n_operands[] = {
+  2,	/* GOO_CANVAS_PATH_MOVE_TO */
+  0,	/* GOO_CANVAS_PATH_CLOSE_PATH */
+  2,	/* GOO_CANVAS_PATH_LINE_TO */
+  1,	/* GOO_CANVAS_PATH_HORIZONTAL_LINE_TO */
+  1,	/* GOO_CANVAS_PATH_VERTICAL_LINE_TO */
+  6,	/* GOO_CANVAS_PATH_CURVE_TO */
+  4,	/* GOO_CANVAS_PATH_SMOOTH_CURVE_TO */
+  4,	/* GOO_CANVAS_PATH_QUADRATIC_CURVE_TO */
+  2,	/* GOO_CANVAS_PATH_SMOOTH_QUADRATIC_CURVE_TO */
+  5	/* GOO_CANVAS_PATH_ELLIPTICAL_ARC */
+};
+
+
+static inline gdouble
+packed_get_operand (GooCanvasPackedPath *path,
+		    guint                index)
+{
+  if (path->use_floats)
+    return g_array_index (path->operands, gfloat, index);
+  return g_array_index (path->operands, gdouble, index);
+}
+
+
+/* Converts a command into its tag and operands, in the same order as in the
+   SVG path syntax. Returns the number of operands. */
+static guint
+packed_encode_command (const GooCanvasPathCommand *cmd,
+		       guint8                     *tag,
+		       gdouble                    *operands)
+{
+  *tag = cmd->simple.type | (cmd->simple.relative ? PACKED_TAG_RELATIVE : 0);
+
+  switch (cmd->simple.type)
+    {
+    case GOO_CANVAS_PATH_MOVE_TO:
+    case GOO_CANVAS_PATH_LINE_TO:
+      operands[0] = cmd->simple.x;
+      operands[1] = cmd->simple.y;
+      break;
+    case GOO_CANVAS_PATH_CLOSE_PATH:
+      break;
+    case GOO_CANVAS_PATH_HORIZONTAL_LINE_TO:
+      operands[0] = cmd->simple.x;
+      break;
+    case GOO_CANVAS_PATH_VERTICAL_LINE_TO:
+      operands[0] = cmd->simple.y;
+      break;
+    case GOO_CANVAS_PATH_CURVE_TO:
+      operands[0] = cmd->curve.x1;
+      operands[1] = cmd->curve.y1;
+      operands[2] = cmd->curve.x2;
+      operands[3] = cmd->curve.y2;
+      operands[4] = cmd->curve.x;
+      operands[5] = cmd->curve.y;
+      break;
+    case GOO_CANVAS_PATH_SMOOTH_CURVE_TO:
+      operands[0] = cmd->curve.x2;
+      operands[1] = cmd->curve.y2;
+      operands[2] = cmd->curve.x;
+      operands[3] = cmd->curve.y;
+      break;
+    case GOO_CANVAS_PATH_QUADRATIC_CURVE_TO:
+      operands[0] = cmd->curve.x1;
+      operands[1] = cmd->curve.y1;
+      operands[2] = cmd->curve.x;
+      operands[3] = cmd->curve.y;
+      break;
+    case GOO_CANVAS_PATH_SMOOTH_QUADRATIC_CURVE_TO:
+      operands[0] = cmd->curve.x;
+      operands[1] = cmd->curve.y;
+      break;
+    case GOO_CANVAS_PATH_ELLIPTICAL_ARC:
+      if (cmd->arc.large_arc_flag)
+	*tag |= PACKED_TAG_LARGE_ARC;
+      if (cmd->arc.sweep_flag)
+	*tag |= PACKED_TAG_SWEEP;
+      operands[0] = cmd->arc.rx;
+      operands[1] = cmd->arc.ry;
+      operands[2] = cmd->arc.x_axis_rotation;
+      operands[3] = cmd->arc.x;
+      operands[4] = cmd->arc.y;
+      break;
+    }
+
+  return packed_n_operands[cmd->simple.type];
+}
+
+
+/* Converts a tag and its operands back into a command. */
+static void
+packed_decode_command (GooCanvasPackedPath  *path,
+		       guint8                tag,
+		       guint                 operand_index,
+		       GooCanvasPathCommand *cmd)
+{
+  gdouble operands[PACKED_MAX_OPERANDS];
+  guint type = tag & PACKED_TAG_TYPE_MASK, i;
+
+  for (i = 0; i < packed_n_operands[type]; i++)
+    operands[i] = packed_get_operand (path, operand_index + i);
+
+  cmd->simple.type = type;
+  cmd->simple.relative = (tag & PACKED_TAG_RELATIVE) ? 1 : 0;
+
+  switch (type)
+    {
+    case GOO_CANVAS_PATH_MOVE_TO:
+    case GOO_CANVAS_PATH_LINE_TO:
+      cmd->simple.x = operands[0];
+      cmd->simple.y = operands[1];
+      break;
+    case GOO_CANVAS_PATH_CLOSE_PATH:
+      cmd->simple.x = cmd->simple.y = 0.0;
+      break;
+    case GOO_CANVAS_PATH_HORIZONTAL_LINE_TO:
+      cmd->simple.x = operands[0];
+      cmd->simple.y = 0.0;
+      break;
+    case GOO_CANVAS_PATH_VERTICAL_LINE_TO:
+      cmd->simple.x = 0.0;
+      cmd->simple.y = operands[0];
+      break;
+    case GOO_CANVAS_PATH_CURVE_TO:
+      cmd->curve.x1 = operands[0];
+      cmd->curve.y1 = operands[1];
+      cmd->curve.x2 = operands[2];
+      cmd->curve.y2 = operands[3];
+      cmd->curve.x = operands[4];
+      cmd->curve.y = operands[5];
+      break;
+    case GOO_CANVAS_PATH_SMOOTH_CURVE_TO:
+      cmd->curve.x1 = cmd->curve.y1 = 0.0;
+      cmd->curve.x2 = operands[0];
+      cmd->curve.y2 = operands[1];
+      cmd->curve.x = operands[2];
+      cmd->curve.y = operands[3];
+      break;
+    case GOO_CANVAS_PATH_QUADRATIC_CURVE_TO:
+      cmd->curve.x1 = operands[0];
+      cmd->curve.y1 = operands[1];
+      cmd->curve.x2 = cmd->curve.y2 = 0.0;
+      cmd->curve.x = operands[2];
+      cmd->curve.y = operands[3];
+      break;
+    case GOO_CANVAS_PATH_SMOOTH_QUADRATIC_CURVE_TO:
+      cmd->curve.x1 = cmd->curve.y1 = 0.0;
+      cmd->curve.x2 = cmd->curve.y2 = 0.0;
+      cmd->curve.x = operands[0];
+      cmd->curve.y = operands[1];
+      break;
+    case GOO_CANVAS_PATH_ELLIPTICAL_ARC:
+      cmd->arc.large_arc_flag = (tag & PACKED_TAG_LARGE_ARC) ? 1 : 0;
+      cmd->arc.sweep_flag = (tag & PACKED_TAG_SWEEP) ? 1 : 0;
+      cmd->arc.rx = operands[0];
+      cmd->arc.ry = operands[1];
+      cmd->arc.x_axis_rotation = operands[2];
+      cmd->arc.x = operands[3];
+      cmd->arc.y = operands[4];
+      break;
+    }
+}
+
+
+static void
+packed_append (GooCanvasPackedPath *path,
+	       guint8               tag,
+	       const gdouble       *operands,
+	       guint                n_operands)
+{
+  gfloat float_operands[PACKED_MAX_OPERANDS];
+  guint i;
+
+  g_byte_array_append (path->tags, &tag, 1);
+
+  if (n_operands == 0)
+    return;
+
+  if (path->use_floats)
+    {
+      for (i = 0; i < n_operands; i++)
+	float_operands[i] = operands[i];
+      g_array_append_vals (path->operands, float_operands, n_operands);
+    }
+  else
+    {
+      g_array_append_vals (path->operands, operands, n_operands);
+    }
+}
+
+
+/**
+ * goo_canvas_packed_path_new:
+ * @use_floats: if the operands are stored as floats rather than doubles.
+ *  This halves the memory used, but the coordinates only have a precision
+ *  of about 7 significant digits.
+ * @n_commands: the number of commands to reserve space for, or 0.
+ * @n_operands: the number of operands to reserve space for, or 0. Lines and
+ *  moves have 2 operands each.
+ *
+ * Creates a new, empty packed path. If the size of the path is known in
+ * advance it should be passed in, so that no space is wasted.
+ *
+ * Returns: (transfer full): a new packed path.
+ *
+ * Since: 3.0
+ **/
+GooCanvasPackedPath*
+goo_canvas_packed_path_new (gboolean use_floats,
+			    guint    n_commands,
+			    guint    n_operands)
+{
+  GooCanvasPackedPath *path;
+
+  path = g_slice_new (GooCanvasPackedPath);
+  path->ref_count = 1;
+  path->use_floats = use_floats ? TRUE : FALSE;
+  path->tags = g_byte_array_sized_new (n_commands);
+  path->operands = g_array_sized_new (FALSE, FALSE, use_floats
+				      ? sizeof (gfloat) : sizeof (gdouble),
+				      n_operands);
+
+  return path;
+}
+
+
+/**
+ * goo_canvas_packed_path_new_from_commands:
+ * @commands: (element-type GooCanvasPathCommand): an array of
+ *  #GooCanvasPathCommand, as returned by goo_canvas_parse_path_data().
+ * @use_floats: if the operands are stored as floats rather than doubles.
+ *
+ * Creates a new packed path containing the given commands.
+ *
+ * Returns: (transfer full): a new packed path.
+ *
+ * Since: 3.0
+ **/
+GooCanvasPackedPath*
+goo_canvas_packed_path_new_from_commands (GArray   *commands,
+					  gboolean  use_floats)
+{
+  GooCanvasPackedPath *path;
+  GooCanvasPathCommand *cmd;
+  guint i, n_operands = 0;
+
+  g_return_val_if_fail (commands != NULL, NULL);
+
+  for (i = 0; i < commands->len; i++)
+    {
+      cmd = &g_array_index (commands, GooCanvasPathCommand, i);
+      g_return_val_if_fail (cmd->simple.type <= GOO_CANVAS_PATH_ELLIPTICAL_ARC,
+			    NULL);
+      n_operands += packed_n_operands[cmd->simple.type];
+    }
+
+  path = goo_canvas_packed_path_new (use_floats, commands->len, n_operands);
+  for (i = 0; i < commands->len; i++)
+    {
+      cmd = &g_array_index (commands, GooCanvasPathCommand, i);
+      goo_canvas_packed_path_add_command (path, cmd);
+    }
+
+  return path;
+}
+
+
+/**
+ * goo_canvas_packed_path_copy:
+ * @path: a #GooCanvasPackedPath.
+ *
+ * Creates a copy of a packed path.
+ *
+ * Returns: (transfer full): a new packed path.
+ *
+ * Since: 3.0
+ **/
+GooCanvasPackedPath*
+goo_canvas_packed_path_copy (GooCanvasPackedPath *path)
+{
+  GooCanvasPackedPath *copy;
+
+  g_return_val_if_fail (path != NULL, NULL);
+
+  copy = goo_canvas_packed_path_new (path->use_floats, path->tags->len,
+				     path->operands->len);
+  g_byte_array_append (copy->tags, path->tags->data, path->tags->len);
+  g_array_append_vals (copy->operands, path->operands->data,
+		       path->operands->len);
+
+  return copy;
+}
+
+
+/**
+ * goo_canvas_packed_path_ref:
+ * @path: a #GooCanvasPackedPath.
+ *
+ * Increments the reference count of the packed path.
+ *
+ * Returns: the packed path.
+ *
+ * Since: 3.0
+ **/
+GooCanvasPackedPath*
+goo_canvas_packed_path_ref (GooCanvasPackedPath *path)
+{
+  if (path)
+    path->ref_count++;
+  return path;
+}
+
+
+/**
+ * goo_canvas_packed_path_unref:
+ * @path: a #GooCanvasPackedPath.
+ *
+ * Decrements the reference count of the packed path. If it falls to 0
+ * it is freed.
+ *
+ * Since: 3.0
+ **/
+void
+goo_canvas_packed_path_unref (GooCanvasPackedPath *path)
+{
+  if (path && --path->ref_count == 0)
+    {
+      g_byte_array_free (path->tags, TRUE);
+      g_array_free (path->operands, TRUE);
+      g_slice_free (GooCanvasPackedPath, path);
+    }
+}
+
+
+GType
+goo_canvas_packed_path_get_type (void)
+{
+  static GType packed_path_type = 0;
+
+  if (packed_path_type == 0)
+    packed_path_type = g_boxed_type_register_static
+      ("GooCanvasPackedPath",
+       (GBoxedCopyFunc) goo_canvas_packed_path_ref,
+       (GBoxedFreeFunc) goo_canvas_packed_path_unref);
+
+  return packed_path_type;
+}
+
+
+/**
+ * goo_canvas_packed_path_add_command:
+ * @path: a #GooCanvasPackedPath.
+ * @cmd: the command to add.
+ *
+ * Adds a command to the end of the packed path.
+ *
+ * Since: 3.0
+ **/
+void
+goo_canvas_packed_path_add_command (GooCanvasPackedPath        *path,
+				    const GooCanvasPathCommand *cmd)
+{
+  gdouble operands[PACKED_MAX_OPERANDS];
+  guint n_operands;
+  guint8 tag;
+
+  g_return_if_fail (path != NULL);
+  g_return_if_fail (cmd != NULL);
+  g_return_if_fail (cmd->simple.type <= GOO_CANVAS_PATH_ELLIPTICAL_ARC);
+
+  n_operands = packed_encode_command (cmd, &tag, operands);
+  packed_append (path, tag, operands, n_operands);
+}
+
+
+/**
+ * goo_canvas_packed_path_move_to:
+ * @path: a #GooCanvasPackedPath.
+ * @relative: if the coordinates are relative to the current point.
+ * @x: the x coordinate.
+ * @y: the y coordinate.
+ *
+ * Adds a command to start a new subpath at the given point.
+ *
+ * Since: 3.0
+ **/
+void
+goo_canvas_packed_path_move_to (GooCanvasPackedPath *path,
+				gboolean             relative,
+				gdouble              x,
+				gdouble              y)
+{
+  gdouble operands[2] = { x, y };
+
+  g_return_if_fail (path != NULL);
+
+  packed_append (path, GOO_CANVAS_PATH_MOVE_TO
+		 | (relative ? PACKED_TAG_RELATIVE : 0), operands, 2);
+}
+
+
+/**
+ * goo_canvas_packed_path_line_to:
+ * @path: a #GooCanvasPackedPath.
+ * @relative: if the coordinates are relative to the current point.
+ * @x: the x coordinate.
+ * @y: the y coordinate.
+ *
+ * Adds a command to draw a line to the given point.
+ *
+ * Since: 3.0
+ **/
+void
+goo_canvas_packed_path_line_to (GooCanvasPackedPath *path,
+				gboolean             relative,
+				gdouble              x,
+				gdouble              y)
+{
+  gdouble operands[2] = { x, y };
+
+  g_return_if_fail (path != NULL);
+
+  packed_append (path, GOO_CANVAS_PATH_LINE_TO
+		 | (relative ? PACKED_TAG_RELATIVE : 0), operands, 2);
+}
+
+
+/**
+ * goo_canvas_packed_path_close_path:
+ * @path: a #GooCanvasPackedPath.
+ *
+ * Adds a command to close the current subpath.
+ *
+ * Since: 3.0
+ **/
+void
+goo_canvas_packed_path_close_path (GooCanvasPackedPath *path)
+{
+  g_return_if_fail (path != NULL);
+
+  packed_append (path, GOO_CANVAS_PATH_CLOSE_PATH, NULL, 0);
+}
+
+
+/**
+ * goo_canvas_packed_path_add_polyline:
+ * @path: a #GooCanvasPackedPath.
+ * @coords: (array): the x and y coordinates of each point.
+ * @n_points: the number of points.
+ * @close_path: if the polyline is closed.
+ *
+ * Adds a subpath made of straight lines joining the given points, as a
+ * move to the first point followed by a line to each of the other points.
+ * This is the fastest way to add a large number of lines.
+ *
+ * Since: 3.0
+ **/
+void
+goo_canvas_packed_path_add_polyline (GooCanvasPackedPath *path,
+				     const gdouble       *coords,
+				     guint                n_points,
+				     gboolean             close_path)
+{
+  guint old_len, i;
+  gfloat *float_operands;
+
+  g_return_if_fail (path != NULL);
+  g_return_if_fail (coords != NULL || n_points == 0);
+
+  if (n_points == 0)
+    return;
+
+  old_len = path->tags->len;
+  g_byte_array_set_size (path->tags, old_len + n_points + (close_path ? 1 : 0));
+  path->tags->data[old_len] = GOO_CANVAS_PATH_MOVE_TO;
+  memset (path->tags->data + old_len + 1, GOO_CANVAS_PATH_LINE_TO,
+	  n_points - 1);
+  if (close_path)
+    path->tags->data[old_len + n_points] = GOO_CANVAS_PATH_CLOSE_PATH;
+
+  if (path->use_floats)
+    {
+      old_len = path->operands->len;
+      g_array_set_size (path->operands, old_len + n_points * 2);
+      float_operands = &g_array_index (path->operands, gfloat, old_len);
+      for (i = 0; i < n_points * 2; i++)
+	float_operands[i] = coords[i];
+    }
+  else
+    {
+      g_array_append_vals (path->operands, coords, n_points * 2);
+    }
+}
+
+
+/**
+ * goo_canvas_packed_path_get_n_commands:
+ * @path: a #GooCanvasPackedPath.
+ *
+ * Gets the number of commands in the packed path.
+ *
+ * Returns: the number of commands.
+ *
+ * Since: 3.0
+ **/
+guint
+goo_canvas_packed_path_get_n_commands (GooCanvasPackedPath *path)
+{
+  g_return_val_if_fail (path != NULL, 0);
+
+  return path->tags->len;
+}
+
+
+/**
+ * goo_canvas_packed_path_get_size:
+ * @path: a #GooCanvasPackedPath.
+ *
+ * Gets the number of bytes used to store the commands of the packed path,
+ * not including any space reserved for more commands.
+ *
+ * Returns: the size of the packed commands, in bytes.
+ *
+ * Since: 3.0
+ **/
+gsize
+goo_canvas_packed_path_get_size (GooCanvasPackedPath *path)
+{
+  g_return_val_if_fail (path != NULL, 0);
+
+  return path->tags->len + path->operands->len
+    * (path->use_floats ? sizeof (gfloat) : sizeof (gdouble));
+}
+
+
+/**
+ * goo_canvas_packed_path_to_commands:
+ * @path: a #GooCanvasPackedPath.
+ *
+ * Converts the packed path to an array of #GooCanvasPathCommand.
+ *
+ * Returns: (element-type GooCanvasPathCommand) (transfer full): a new #GArray
+ *  of #GooCanvasPathCommand elements.
+ *
+ * Since: 3.0
+ **/
+GArray*
+goo_canvas_packed_path_to_commands (GooCanvasPackedPath *path)
+{
+  GooCanvasPathCommand cmd;
+  GArray *commands;
+  guint i, operand_index = 0;
+  guint8 tag;
+
+  g_return_val_if_fail (path != NULL, NULL);
+
+  commands = g_array_sized_new (FALSE, FALSE, sizeof (GooCanvasPathCommand),
+				path->tags->len);
+  for (i = 0; i < path->tags->len; i++)
+    {
+      tag = path->tags->data[i];
+      packed_decode_command (path, tag, operand_index, &cmd);
+      operand_index += packed_n_operands[tag & PACKED_TAG_TYPE_MASK];
+      g_array_append_val (commands, cmd);
+    }
+
+  return commands;
+}
+
+
+/* Calls the function for each command in the packed path, and stores the
+   command back in the path afterwards, so the function can change its
+   coordinates. */
+void
+goo_canvas_packed_path_foreach (GooCanvasPackedPath      *path,
+				GooCanvasPathCommandFunc  func,
+				gpointer                  data)
+{
+  gdouble operands[PACKED_MAX_OPERANDS];
+  GooCanvasPathCommand cmd;
+  guint i, j, n_operands, operand_index = 0;
+  guint8 tag;
+
+  for (i = 0; i < path->tags->len; i++)
+    {
+      tag = path->tags->data[i];
+      packed_decode_command (path, tag, operand_index, &cmd);
+      func (&cmd, data);
+
+      n_operands = packed_encode_command (&cmd, &tag, operands);
+      for (j = 0; j < n_operands; j++)
+	{
+	  if (path->use_floats)
+	    g_array_index (path->operands, gfloat, operand_index + j) = operands[j];
+	  else
+	    g_array_index (path->operands, gdouble, operand_index + j) = operands[j];
+	}
+      operand_index += n_operands;
+    }
+}
+
+
+/**
+ * goo_canvas_create_packed_path:
+ * @path: a #GooCanvasPackedPath, or %NULL.
+ * @cr: a cairo context.
+ *
+ * Creates the path specified by the given #GooCanvasPackedPath. This is
+ * the equivalent of goo_canvas_create_path() for packed paths.
+ *
+ * Since: 3.0
+ **/
+void
+goo_canvas_create_packed_path (GooCanvasPackedPath *path,
+			       cairo_t             *cr)
+{
+  GooCanvasPathState state;
+  GooCanvasPathCommand cmd;
+  guint i, type, operand_index = 0;
+  guint8 tag;
+
+  cairo_new_path (cr);
+
+  if (!path || path->tags->len == 0)
+    return;
+
+  goo_canvas_path_state_init (&state);
+  for (i = 0; i < path->tags->len; i++)
+    {
+      tag = path->tags->data[i];
+      type = tag & PACKED_TAG_TYPE_MASK;
+
+      /* Absolute moves and lines are by far the most common commands, so
+	 we handle them without decoding the command. */
+      if (tag == GOO_CANVAS_PATH_LINE_TO)
+	{
+	  state.x = packed_get_operand (path, operand_index);
+	  state.y = packed_get_operand (path, operand_index + 1);
+	  cairo_line_to (cr, state.x, state.y);
+	  state.prev_cmd_type = GOO_CANVAS_PATH_LINE_TO;
+	}
+      else if (tag == GOO_CANVAS_PATH_MOVE_TO)
+	{
+	  state.x = state.path_start_x = packed_get_operand (path, operand_index);
+	  state.y = state.path_start_y = packed_get_operand (path, operand_index + 1);
+	  cairo_move_to (cr, state.x, state.y);
+	  state.prev_cmd_type = GOO_CANVAS_PATH_MOVE_TO;
+	}
+      else
+	{
+	  packed_decode_command (path, tag, operand_index, &cmd);
+	  do_path_command (&cmd, cr, &state);
 	}
 
-      prev_cmd_type = cmd->simple.type;
+      operand_index += packed_n_operands[type];
     }
 }
 
@@ -1335,13 +3053,10 @@ cairo_pattern_t*
 goo_canvas_create_pattern_from_pixbuf_value (const GValue *value)
 {
   GdkPixbuf *pixbuf;
-  cairo_surface_t *surface;
   cairo_pattern_t *pattern;
 
   pixbuf = g_value_get_object (value);
-  surface = goo_canvas_cairo_surface_from_pixbuf (pixbuf);
-  pattern = cairo_pattern_create_for_surface (surface);
-  cairo_surface_destroy (surface);
+  pattern = goo_canvas_cairo_pattern_from_pixbuf (pixbuf);
   cairo_pattern_set_extend (pattern, CAIRO_EXTEND_REPEAT);
   return pattern;
 }
@@ -225,10 +225,63 @@ union _GooCanvasPathCommand
 
 
 GArray*	goo_canvas_parse_path_data	(const gchar       *path_data);
+GArray*	goo_canvas_parse_path_data_full	(const gchar       *path_data,
+					 gssize             length,
+					 gssize            *error_offset);
+GArray*	goo_canvas_parse_path_stream	(GInputStream      *stream,
+					 GCancellable      *cancellable,
+					 gssize            *error_offset,
+					 GError           **error);
 void	goo_canvas_create_path		(GArray		   *commands,
 					 cairo_t           *cr);
 
 
+typedef struct _GooCanvasPackedPath  GooCanvasPackedPath;
+
+#define GOO_TYPE_CANVAS_PACKED_PATH  (goo_canvas_packed_path_get_type ())
+GType                goo_canvas_packed_path_get_type (void) G_GNUC_CONST;
+GooCanvasPackedPath* goo_canvas_packed_path_new      (gboolean             use_floats,
+						      guint                n_commands,
+						      guint                n_operands);
+GooCanvasPackedPath* goo_canvas_packed_path_new_from_commands (GArray     *commands,
+							       gboolean    use_floats);
+GooCanvasPackedPath* goo_canvas_packed_path_copy     (GooCanvasPackedPath *path);
+GooCanvasPackedPath* goo_canvas_packed_path_ref      (GooCanvasPackedPath *path);
+void                 goo_canvas_packed_path_unref    (GooCanvasPackedPath *path);
+
+void     goo_canvas_packed_path_add_command   (GooCanvasPackedPath        *path,
+					       const GooCanvasPathCommand *cmd);
+void     goo_canvas_packed_path_move_to       (GooCanvasPackedPath        *path,
+					       gboolean                    relative,
+					       gdouble                     x,
+					       gdouble                     y);
+void     goo_canvas_packed_path_line_to       (GooCanvasPackedPath        *path,
+					       gboolean                    relative,
+					       gdouble                     x,
+					       gdouble                     y);
+void     goo_canvas_packed_path_close_path    (GooCanvasPackedPath        *path);
+void     goo_canvas_packed_path_add_polyline  (GooCanvasPackedPath        *path,
+					       const gdouble              *coords,
+					       guint                       n_points,
+					       gboolean                    close_path);
+guint    goo_canvas_packed_path_get_n_commands (GooCanvasPackedPath       *path);
+gsize    goo_canvas_packed_path_get_size      (GooCanvasPackedPath        *path);
+GArray*  goo_canvas_packed_path_to_commands   (GooCanvasPackedPath        *path);
+
+void	goo_canvas_create_packed_path	(GooCanvasPackedPath *path,
+					 cairo_t             *cr);
+
+
+typedef struct _GooCanvasPathParser  GooCanvasPathParser;
+
+GooCanvasPathParser* goo_canvas_path_parser_new    (GooCanvasPackedPath *packed_path);
+gboolean             goo_canvas_path_parser_feed   (GooCanvasPathParser *parser,
+						    const gchar         *data,
+						    gsize                length);
+GArray*              goo_canvas_path_parser_finish (GooCanvasPathParser *parser,
+						    gssize              *error_offset);
+
+
 /*
  * Cairo utilities.
  */
@@ -376,6 +429,34 @@ GType		   goo_cairo_line_join_get_type (void) G_GNUC_CONST;
 GType		   goo_cairo_hint_metrics_get_type (void) G_GNUC_CONST;
 
 
+/**
+ * GooCanvasImageCacheStats:
+ * @n_entries: the number of pixbufs that currently have a shared surface.
+ * @bytes_cached: the total size of the shared surfaces, in bytes.
+ * @hits: the number of times an existing surface was reused.
+ * @misses: the number of times a pixbuf had to be converted.
+ * @bytes_saved: the total number of bytes that would have been allocated
+ *  for surfaces if they were not shared.
+ *
+ * #GooCanvasImageCacheStats contains statistics about the shared image
+ * surface cache, as returned by goo_canvas_image_cache_get_stats().
+ *
+ * Since: 3.0
+ */
+typedef struct _GooCanvasImageCacheStats GooCanvasImageCacheStats;
+struct _GooCanvasImageCacheStats
+{
+  guint n_entries;
+  gsize bytes_cached;
+  guint64 hits;
+  guint64 misses;
+  guint64 bytes_saved;
+};
+
+void		   goo_canvas_image_cache_get_stats  (GooCanvasImageCacheStats *stats);
+void		   goo_canvas_image_cache_invalidate (GdkPixbuf                *pixbuf);
+
+
 G_END_DECLS
 
 #endif /* __GOO_CANVAS_UTILS_H__ */
@@ -0,0 +1,1607 @@
+/*
+ * GooCanvas. Copyright (C) 2005 Damon Chaplin.
+ * Released under the GNU LGPL license. See COPYING for details.
+ *
+ * goocanvasvirtualtable.c - table item which only creates the visible cells.
+ */
+
+/**
+ * SECTION:goocanvasvirtualtable
+ * @Title: GooCanvasVirtualTable
+ * @Short_Description: a table with millions of rows.
+ *
+ * #GooCanvasVirtualTable displays a grid of cells like #GooCanvasTable, but
+ * its cells are supplied by an object implementing the
+ * #GooCanvasVirtualTableSource interface instead of being added as children.
+ * It is intended for tables with a huge number of rows, such as a log
+ * viewer showing millions of lines.
+ *
+ * Cell items are only created for the rows that are visible in the canvas,
+ * plus #GooCanvasVirtualTable:overscan-rows rows above and below them, so
+ * scrolling a short distance doesn't need new cells. When rows scroll out of
+ * view their cell items are kept and reused for the rows that scroll into
+ * view, by calling the source's bind_cell() method again.
+ *
+ * All rows are #GooCanvasVirtualTable:row-height high unless the source
+ * implements get_row_height(), and all columns are
+ * #GooCanvasVirtualTable:column-width wide unless the source implements
+ * get_column_width(). Using a uniform row height is best for huge tables,
+ * as the position of each row can then be calculated directly, rather than
+ * from the heights of all the rows above it.
+ *
+ * The grid lines and spacing are drawn in the same way as #GooCanvasTable,
+ * using the "stroke-color" style property for the grid lines and the
+ * "fill-color" style property for the background.
+ *
+ * If the source's data changes call goo_canvas_virtual_table_rows_changed()
+ * or goo_canvas_virtual_table_reload() to update the table.
+ *
+ * The cells are children of the table while they are displayed, but
+ * children must not be added to the table in any other way.
+ *
+ * Note that #GooCanvasVirtualTable doesn't have a model/view variant like
+ * the other standard items, so it can only be used in a simple canvas
+ * without a model.
+ *
+ * To create a #GooCanvasVirtualTable use goo_canvas_virtual_table_new().
+ *
+ * To get or set the properties of an existing #GooCanvasVirtualTable, use
+ * g_object_get() and g_object_set().
+ */
+#include <config.h>
+#include <math.h>
+#include <glib/gi18n-lib.h>
+#include <gtk/gtk.h>
+#include "goocanvasprivate.h"
+#include "goocanvasvirtualtable.h"
+#include "goocanvas.h"
+
+
+#define GOO_CANVAS_VIRTUAL_TABLE_DEFAULT_ROW_HEIGHT     20.0
+#define GOO_CANVAS_VIRTUAL_TABLE_DEFAULT_COLUMN_WIDTH   100.0
+#define GOO_CANVAS_VIRTUAL_TABLE_DEFAULT_OVERSCAN_ROWS  16
+
+enum {
+  HORZ = 0,
+  VERT = 1
+};
+
+
+/* The row and column displayed by each cell item. This is kept in an array
+   parallel to the group's items array. */
+typedef struct _GooCanvasVirtualTableCell GooCanvasVirtualTableCell;
+struct _GooCanvasVirtualTableCell
+{
+  gint row, column;
+};
+
+
+typedef struct _GooCanvasVirtualTablePrivate GooCanvasVirtualTablePrivate;
+struct _GooCanvasVirtualTablePrivate {
+  GooCanvasVirtualTableSource *source;
+
+  /* The size of the table, read from the source when geometry_valid is
+     FALSE. */
+  gboolean geometry_valid;
+  gint n_rows, n_columns;
+
+  /* The offset of the start of each column from the start of the first
+     column, with an extra element at the end for the total. */
+  gdouble *column_offsets;
+
+  /* The same for rows, only used if the source has variable row heights.
+     Only the first n_valid_row_offsets elements are up to date. */
+  gdouble *row_offsets;
+  gint n_valid_row_offsets;
+
+  /* The cells which are currently displayed, and the range of rows they
+     cover. last_row is less than first_row if there are no cells. */
+  GArray *cells;
+  gint first_row, last_row;
+
+  /* The range of rows which need to be bound again, since their data has
+     changed. changed_last_row is less than changed_first_row if none. */
+  gint changed_first_row, changed_last_row;
+
+  /* Unused cell items for each column, ready to be bound again. */
+  GPtrArray **pools;
+  gint n_pools;
+};
+
+#define GOO_CANVAS_VIRTUAL_TABLE_GET_PRIVATE(table)  \
+   (G_TYPE_INSTANCE_GET_PRIVATE ((table), GOO_TYPE_CANVAS_VIRTUAL_TABLE, GooCanvasVirtualTablePrivate))
+
+
+enum {
+  PROP_0,
+
+  PROP_X,
+  PROP_Y,
+  PROP_WIDTH,
+  PROP_HEIGHT,
+  PROP_SOURCE,
+  PROP_ROW_HEIGHT,
+  PROP_COLUMN_WIDTH,
+  PROP_ROW_SPACING,
+  PROP_COLUMN_SPACING,
+  PROP_X_BORDER_SPACING,
+  PROP_Y_BORDER_SPACING,
+  PROP_HORZ_GRID_LINE_WIDTH,
+  PROP_VERT_GRID_LINE_WIDTH,
+  PROP_OVERSCAN_ROWS
+};
+
+static void item_interface_init                   (GooCanvasItemIface *iface);
+static void goo_canvas_virtual_table_dispose      (GObject            *object);
+static void goo_canvas_virtual_table_finalize     (GObject            *object);
+static void goo_canvas_virtual_table_get_property (GObject            *object,
+						   guint               param_id,
+						   GValue             *value,
+						   GParamSpec         *pspec);
+static void goo_canvas_virtual_table_set_property (GObject            *object,
+						   guint               param_id,
+						   const GValue       *value,
+						   GParamSpec         *pspec);
+
+G_DEFINE_TYPE_WITH_CODE (GooCanvasVirtualTable, goo_canvas_virtual_table,
+			 GOO_TYPE_CANVAS_GROUP,
+			 G_IMPLEMENT_INTERFACE (GOO_TYPE_CANVAS_ITEM,
+						item_interface_init))
+
+
+GType
+goo_canvas_virtual_table_source_get_type (void)
+{
+  static GType source_type = 0;
+
+  if (!source_type)
+    {
+      static const GTypeInfo source_info =
+      {
+        sizeof (GooCanvasVirtualTableSourceIface), /* class_size */
+	NULL,					   /* base_init */
+	NULL,					   /* base_finalize */
+      };
+
+      source_type = g_type_register_static (G_TYPE_INTERFACE,
+					    "GooCanvasVirtualTableSource",
+					    &source_info, 0);
+
+      g_type_interface_add_prerequisite (source_type, G_TYPE_OBJECT);
+    }
+
+  return source_type;
+}
+
+
+static void
+goo_canvas_virtual_table_class_init (GooCanvasVirtualTableClass *klass)
+{
+  GObjectClass *gobject_class = (GObjectClass*) klass;
+
+  g_type_class_add_private (gobject_class, sizeof (GooCanvasVirtualTablePrivate));
+
+  gobject_class->dispose  = goo_canvas_virtual_table_dispose;
+  gobject_class->finalize = goo_canvas_virtual_table_finalize;
+
+  gobject_class->get_property = goo_canvas_virtual_table_get_property;
+  gobject_class->set_property = goo_canvas_virtual_table_set_property;
+
+  /* Override from GooCanvasGroup */
+  g_object_class_override_property (gobject_class, PROP_X, "x");
+  g_object_class_override_property (gobject_class, PROP_Y, "y");
+  g_object_class_override_property (gobject_class, PROP_WIDTH, "width");
+  g_object_class_override_property (gobject_class, PROP_HEIGHT, "height");
+
+  g_object_class_install_property (gobject_class, PROP_SOURCE,
+				   g_param_spec_object ("source",
+							_("Source"),
+							_("The object which supplies the rows and cells of the table"),
+							GOO_TYPE_CANVAS_VIRTUAL_TABLE_SOURCE,
+							G_PARAM_READWRITE));
+
+  g_object_class_install_property (gobject_class, PROP_ROW_HEIGHT,
+				   g_param_spec_double ("row-height",
+							_("Row Height"),
+							_("The height of each row, if the source doesn't specify row heights"),
+							0.0, G_MAXDOUBLE,
+							GOO_CANVAS_VIRTUAL_TABLE_DEFAULT_ROW_HEIGHT,
+							G_PARAM_READWRITE));
+
+  g_object_class_install_property (gobject_class, PROP_COLUMN_WIDTH,
+				   g_param_spec_double ("column-width",
+							_("Column Width"),
+							_("The width of each column, if the source doesn't specify column widths"),
+							0.0, G_MAXDOUBLE,
+							GOO_CANVAS_VIRTUAL_TABLE_DEFAULT_COLUMN_WIDTH,
+							G_PARAM_READWRITE));
+
+  g_object_class_install_property (gobject_class, PROP_ROW_SPACING,
+				   g_param_spec_double ("row-spacing",
+							_("Row Spacing"),
+							_("The space between rows"),
+							0.0, G_MAXDOUBLE, 0.0,
+							G_PARAM_READWRITE));
+
+  g_object_class_install_property (gobject_class, PROP_COLUMN_SPACING,
+				   g_param_spec_double ("column-spacing",
+							_("Column Spacing"),
+							_("The space between columns"),
+							0.0, G_MAXDOUBLE, 0.0,
+							G_PARAM_READWRITE));
+
+  g_object_class_install_property (gobject_class, PROP_X_BORDER_SPACING,
+				   g_param_spec_double ("x-border-spacing",
+							_("X Border Spacing"),
+							_("The amount of spacing between the leftmost and rightmost cells and the border grid line"),
+							0.0, G_MAXDOUBLE, 0.0,
+							G_PARAM_READWRITE));
+
+  g_object_class_install_property (gobject_class, PROP_Y_BORDER_SPACING,
+				   g_param_spec_double ("y-border-spacing",
+							_("Y Border Spacing"),
+							_("The amount of spacing between the topmost and bottommost cells and the border grid line"),
+							0.0, G_MAXDOUBLE, 0.0,
+							G_PARAM_READWRITE));
+
+  g_object_class_install_property (gobject_class, PROP_HORZ_GRID_LINE_WIDTH,
+				   g_param_spec_double ("horz-grid-line-width",
+							_("Horizontal Grid Line Width"),
+							_("The width of the grid line to draw between rows"),
+							0.0, G_MAXDOUBLE, 0.0,
+							G_PARAM_READWRITE));
+
+  g_object_class_install_property (gobject_class, PROP_VERT_GRID_LINE_WIDTH,
+				   g_param_spec_double ("vert-grid-line-width",
+							_("Vertical Grid Line Width"),
+							_("The width of the grid line to draw between columns"),
+							0.0, G_MAXDOUBLE, 0.0,
+							G_PARAM_READWRITE));
+
+  g_object_class_install_property (gobject_class, PROP_OVERSCAN_ROWS,
+				   g_param_spec_int ("overscan-rows",
+						     _("Overscan Rows"),
+						     _("The number of rows to create cells for above and below the visible rows"),
+						     0, G_MAXINT,
+						     GOO_CANVAS_VIRTUAL_TABLE_DEFAULT_OVERSCAN_ROWS,
+						     G_PARAM_READWRITE));
+}
+
+
+static void
+goo_canvas_virtual_table_init (GooCanvasVirtualTable *table)
+{
+  GooCanvasVirtualTablePrivate *priv = GOO_CANVAS_VIRTUAL_TABLE_GET_PRIVATE (table);
+
+  table->row_height = GOO_CANVAS_VIRTUAL_TABLE_DEFAULT_ROW_HEIGHT;
+  table->column_width = GOO_CANVAS_VIRTUAL_TABLE_DEFAULT_COLUMN_WIDTH;
+  table->overscan_rows = GOO_CANVAS_VIRTUAL_TABLE_DEFAULT_OVERSCAN_ROWS;
+
+  priv->cells = g_array_new (FALSE, FALSE, sizeof (GooCanvasVirtualTableCell));
+  priv->first_row = 0;
+  priv->last_row = -1;
+  priv->changed_first_row = 0;
+  priv->changed_last_row = -1;
+}
+
+
+/**
+ * goo_canvas_virtual_table_new:
+ * @parent: (skip): the parent item, or %NULL. If a parent is specified, it will assume
+ *  ownership of the item, and the item will automatically be freed when it is
+ *  removed from the parent. Otherwise call g_object_unref() to free it.
+ * @source: (allow-none): the object which supplies the rows and cells of the
+ *  table, or %NULL.
+ * @...: optional pairs of property names and values, and a terminating %NULL.
+ *
+ * Creates a new virtual table item.
+ *
+ * Here's an example showing how to create a table with uniform row heights
+ * and a grid between the cells:
+ *
+ * <informalexample><programlisting>
+ *  GooCanvasItem *table = goo_canvas_virtual_table_new (mygroup, mysource,
+ *                                                       "row-height", 18.0,
+ *                                                       "row-spacing", 2.0,
+ *                                                       "column-spacing", 4.0,
+ *                                                       "horz-grid-line-width", 1.0,
+ *                                                       "vert-grid-line-width", 1.0,
+ *                                                       NULL);
+ * </programlisting></informalexample>
+ *
+ * Returns: (transfer full): a new virtual table item.
+ *
+ * Since: 3.0
+ **/
+GooCanvasItem*
+goo_canvas_virtual_table_new (GooCanvasItem               *parent,
+			      GooCanvasVirtualTableSource *source,
+			      ...)
+{
+  GooCanvasItem *item;
+  const char *first_property;
+  va_list var_args;
+
+  item = g_object_new (GOO_TYPE_CANVAS_VIRTUAL_TABLE, NULL);
+
+  if (source)
+    goo_canvas_virtual_table_set_source ((GooCanvasVirtualTable*) item, source);
+
+  va_start (var_args, source);
+  first_property = va_arg (var_args, char*);
+  if (first_property)
+    g_object_set_valist ((GObject*) item, first_property, var_args);
+  va_end (var_args);
+
+  if (parent)
+    {
+      goo_canvas_item_add_child (parent, item, -1);
+      g_object_unref (item);
+    }
+
+  return item;
+}
+
+
+/* Removes the cell at the given index in the items array, unbinding it and
+   keeping it to be reused if reuse is TRUE. */
+static void
+goo_canvas_virtual_table_release_cell (GooCanvasVirtualTable *table,
+				       gint                   cell_num,
+				       gboolean               reuse)
+{
+  GooCanvasVirtualTablePrivate *priv = GOO_CANVAS_VIRTUAL_TABLE_GET_PRIVATE (table);
+  GooCanvasVirtualTableSourceIface *iface;
+  GooCanvasItemSimple *simple = (GooCanvasItemSimple*) table;
+  GooCanvasGroup *group = (GooCanvasGroup*) table;
+  GooCanvasVirtualTableCell *cell;
+  GooCanvasItem *child;
+  GooCanvasBounds bounds;
+
+  cell = &g_array_index (priv->cells, GooCanvasVirtualTableCell, cell_num);
+  child = group->items->pdata[cell_num];
+
+  /* Request a redraw of the cell's bounds, in case no other cell is drawn
+     there. */
+  if (simple->canvas)
+    {
+      goo_canvas_item_get_bounds (child, &bounds);
+      goo_canvas_request_item_redraw (simple->canvas, &bounds,
+				      simple->simple_data->is_static);
+    }
+
+  iface = GOO_CANVAS_VIRTUAL_TABLE_SOURCE_GET_IFACE (priv->source);
+  if (iface->unbind_cell)
+    iface->unbind_cell (priv->source, child, cell->row, cell->column);
+
+  if (reuse && cell->column < priv->n_pools)
+    {
+      g_ptr_array_add (priv->pools[cell->column], child);
+    }
+  else
+    {
+      goo_canvas_item_set_parent (child, NULL);
+      g_object_unref (child);
+    }
+
+  g_array_remove_index_fast (priv->cells, cell_num);
+  g_ptr_array_remove_index_fast (group->items, cell_num);
+}
+
+
+/* Releases all the cells and frees all the unused cell items. */
+static void
+goo_canvas_virtual_table_clear (GooCanvasVirtualTable *table)
+{
+  GooCanvasVirtualTablePrivate *priv = GOO_CANVAS_VIRTUAL_TABLE_GET_PRIVATE (table);
+  GooCanvasItem *child;
+  gint i, j;
+
+  for (i = priv->cells->len - 1; i >= 0; i--)
+    goo_canvas_virtual_table_release_cell (table, i, TRUE);
+
+  for (i = 0; i < priv->n_pools; i++)
+    {
+      for (j = 0; j < priv->pools[i]->len; j++)
+	{
+	  child = priv->pools[i]->pdata[j];
+	  goo_canvas_item_set_parent (child, NULL);
+	  g_object_unref (child);
+	}
+      g_ptr_array_free (priv->pools[i], TRUE);
+    }
+  g_free (priv->pools);
+  priv->pools = NULL;
+  priv->n_pools = 0;
+
+  priv->first_row = 0;
+  priv->last_row = -1;
+  priv->changed_first_row = 0;
+  priv->changed_last_row = -1;
+  priv->geometry_valid = FALSE;
+  priv->n_valid_row_offsets = 0;
+}
+
+
+static void
+goo_canvas_virtual_table_dispose (GObject *object)
+{
+  GooCanvasVirtualTable *table = (GooCanvasVirtualTable*) object;
+  GooCanvasVirtualTablePrivate *priv = GOO_CANVAS_VIRTUAL_TABLE_GET_PRIVATE (table);
+
+  if (priv->source)
+    {
+      goo_canvas_virtual_table_clear (table);
+      g_object_unref (priv->source);
+      priv->source = NULL;
+    }
+
+  G_OBJECT_CLASS (goo_canvas_virtual_table_parent_class)->dispose (object);
+}
+
+
+static void
+goo_canvas_virtual_table_finalize (GObject *object)
+{
+  GooCanvasVirtualTablePrivate *priv = GOO_CANVAS_VIRTUAL_TABLE_GET_PRIVATE (object);
+
+  g_array_free (priv->cells, TRUE);
+  g_free (priv->column_offsets);
+  g_free (priv->row_offsets);
+
+  G_OBJECT_CLASS (goo_canvas_virtual_table_parent_class)->finalize (object);
+}
+
+
+static void
+goo_canvas_virtual_table_get_property (GObject              *object,
+				       guint                 prop_id,
+				       GValue               *value,
+				       GParamSpec           *pspec)
+{
+  GooCanvasVirtualTablePrivate *priv = GOO_CANVAS_VIRTUAL_TABLE_GET_PRIVATE (object);
+  GooCanvasVirtualTable *table = (GooCanvasVirtualTable*) object;
+
+  switch (prop_id)
+    {
+    case PROP_X:
+      g_value_set_double (value, table->x);
+      break;
+    case PROP_Y:
+      g_value_set_double (value, table->y);
+      break;
+    case PROP_WIDTH:
+      g_value_set_double (value, table->width);
+      break;
+    case PROP_HEIGHT:
+      g_value_set_double (value, table->height);
+      break;
+    case PROP_SOURCE:
+      g_value_set_object (value, priv->source);
+      break;
+    case PROP_ROW_HEIGHT:
+      g_value_set_double (value, table->row_height);
+      break;
+    case PROP_COLUMN_WIDTH:
+      g_value_set_double (value, table->column_width);
+      break;
+    case PROP_ROW_SPACING:
+      g_value_set_double (value, table->row_spacing);
+      break;
+    case PROP_COLUMN_SPACING:
+      g_value_set_double (value, table->column_spacing);
+      break;
+    case PROP_X_BORDER_SPACING:
+      g_value_set_double (value, table->x_border_spacing);
+      break;
+    case PROP_Y_BORDER_SPACING:
+      g_value_set_double (value, table->y_border_spacing);
+      break;
+    case PROP_HORZ_GRID_LINE_WIDTH:
+      g_value_set_double (value, table->horz_grid_line_width);
+      break;
+    case PROP_VERT_GRID_LINE_WIDTH:
+      g_value_set_double (value, table->vert_grid_line_width);
+      break;
+    case PROP_OVERSCAN_ROWS:
+      g_value_set_int (value, table->overscan_rows);
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+    }
+}
+
+
+static void
+goo_canvas_virtual_table_set_property (GObject              *object,
+				       guint                 prop_id,
+				       const GValue         *value,
+				       GParamSpec           *pspec)
+{
+  GooCanvasVirtualTablePrivate *priv = GOO_CANVAS_VIRTUAL_TABLE_GET_PRIVATE (object);
+  GooCanvasItemSimple *simple = (GooCanvasItemSimple*) object;
+  GooCanvasVirtualTable *table = (GooCanvasVirtualTable*) object;
+  gboolean geometry_changed = TRUE, rebind = FALSE;
+
+  switch (prop_id)
+    {
+    case PROP_X:
+      table->x = g_value_get_double (value);
+      geometry_changed = FALSE;
+      break;
+    case PROP_Y:
+      table->y = g_value_get_double (value);
+      geometry_changed = FALSE;
+      break;
+    case PROP_WIDTH:
+      table->width = g_value_get_double (value);
+      geometry_changed = FALSE;
+      break;
+    case PROP_HEIGHT:
+      table->height = g_value_get_double (value);
+      geometry_changed = FALSE;
+      break;
+    case PROP_SOURCE:
+      goo_canvas_virtual_table_set_source (table, g_value_get_object (value));
+      return;
+    case PROP_ROW_HEIGHT:
+      table->row_height = g_value_get_double (value);
+      rebind = TRUE;
+      break;
+    case PROP_COLUMN_WIDTH:
+      table->column_width = g_value_get_double (value);
+      rebind = TRUE;
+      break;
+    case PROP_ROW_SPACING:
+      table->row_spacing = g_value_get_double (value);
+      break;
+    case PROP_COLUMN_SPACING:
+      table->column_spacing = g_value_get_double (value);
+      break;
+    case PROP_X_BORDER_SPACING:
+      table->x_border_spacing = g_value_get_double (value);
+      break;
+    case PROP_Y_BORDER_SPACING:
+      table->y_border_spacing = g_value_get_double (value);
+      break;
+    case PROP_HORZ_GRID_LINE_WIDTH:
+      table->horz_grid_line_width = g_value_get_double (value);
+      break;
+    case PROP_VERT_GRID_LINE_WIDTH:
+      table->vert_grid_line_width = g_value_get_double (value);
+      break;
+    case PROP_OVERSCAN_ROWS:
+      table->overscan_rows = g_value_get_int (value);
+      geometry_changed = FALSE;
+      break;
+    default:
+      G_OBJECT_WARN_INVALID_PROPERTY_ID (object, prop_id, pspec);
+      break;
+    }
+
+  /* The spacing is included in the row and column offsets, so they must
+     all be calculated again. */
+  if (geometry_changed)
+    {
+      priv->geometry_valid = FALSE;
+      priv->n_valid_row_offsets = 0;
+    }
+
+  /* The cells are passed their size when they are bound, so they must be
+     bound again if the default size changes. */
+  if (rebind)
+    goo_canvas_virtual_table_rows_changed (table, 0, G_MAXINT);
+  else
+    goo_canvas_item_simple_changed (simple, TRUE);
+}
+
+
+/**
+ * goo_canvas_virtual_table_set_source:
+ * @table: a #GooCanvasVirtualTable.
+ * @source: (allow-none): the object which supplies the rows and cells of the
+ *  table, or %NULL.
+ *
+ * Sets the object which supplies the rows and cells of the table. All the
+ * existing cell items are freed, and new cell items are created by @source.
+ *
+ * Since: 3.0
+ **/
+void
+goo_canvas_virtual_table_set_source (GooCanvasVirtualTable       *table,
+				     GooCanvasVirtualTableSource *source)
+{
+  GooCanvasVirtualTablePrivate *priv;
+
+  g_return_if_fail (GOO_IS_CANVAS_VIRTUAL_TABLE (table));
+  g_return_if_fail (source == NULL || GOO_IS_CANVAS_VIRTUAL_TABLE_SOURCE (source));
+
+  priv = GOO_CANVAS_VIRTUAL_TABLE_GET_PRIVATE (table);
+
+  if (priv->source == source)
+    return;
+
+  if (source)
+    g_object_ref (source);
+
+  if (priv->source)
+    {
+      goo_canvas_virtual_table_clear (table);
+      g_object_unref (priv->source);
+    }
+
+  priv->source = source;
+  priv->geometry_valid = FALSE;
+
+  goo_canvas_item_simple_changed ((GooCanvasItemSimple*) table, TRUE);
+  g_object_notify ((GObject*) table, "source");
+}
+
+
+/**
+ * goo_canvas_virtual_table_get_source:
+ * @table: a #GooCanvasVirtualTable.
+ *
+ * Gets the object which supplies the rows and cells of the table.
+ *
+ * Returns: (transfer none): the source of the table, or %NULL.
+ *
+ * Since: 3.0
+ **/
+GooCanvasVirtualTableSource*
+goo_canvas_virtual_table_get_source (GooCanvasVirtualTable *table)
+{
+  g_return_val_if_fail (GOO_IS_CANVAS_VIRTUAL_TABLE (table), NULL);
+
+  return GOO_CANVAS_VIRTUAL_TABLE_GET_PRIVATE (table)->source;
+}
+
+
+/**
+ * goo_canvas_virtual_table_rows_changed:
+ * @table: a #GooCanvasVirtualTable.
+ * @first_row: the first row which has changed.
+ * @n_rows: the number of rows which have changed, or -1 for all the rows
+ *  from @first_row to the end of the table.
+ *
+ * Notifies the table that the data or heights of some rows have changed, or
+ * that rows have been added or removed from @first_row onwards. The number
+ * of rows is read from the source again, and any cells displaying the
+ * changed rows are bound again.
+ *
+ * When rows are appended to the table, @first_row should be the old number
+ * of rows and @n_rows should be the number of rows added, so that the
+ * existing cells don't need to be bound again.
+ *
+ * Since: 3.0
+ **/
+void
+goo_canvas_virtual_table_rows_changed (GooCanvasVirtualTable *table,
+				       gint                   first_row,
+				       gint                   n_rows)
+{
+  GooCanvasVirtualTablePrivate *priv;
+  gint last_row;
+
+  g_return_if_fail (GOO_IS_CANVAS_VIRTUAL_TABLE (table));
+  g_return_if_fail (first_row >= 0);
+
+  priv = GOO_CANVAS_VIRTUAL_TABLE_GET_PRIVATE (table);
+
+  if (n_rows < 0 || n_rows > G_MAXINT - first_row)
+    last_row = G_MAXINT;
+  else
+    last_row = first_row + n_rows - 1;
+
+  /* The offsets of rows up to and including first_row are still valid. */
+  priv->n_valid_row_offsets = MIN (priv->n_valid_row_offsets, first_row + 1);
+
+  if (priv->changed_first_row > priv->changed_last_row)
+    {
+      priv->changed_first_row = first_row;
+      priv->changed_last_row = last_row;
+    }
+  else
+    {
+      priv->changed_first_row = MIN (priv->changed_first_row, first_row);
+      priv->changed_last_row = MAX (priv->changed_last_row, last_row);
+    }
+
+  priv->geometry_valid = FALSE;
+  goo_canvas_item_simple_changed ((GooCanvasItemSimple*) table, TRUE);
+}
+
+
+/**
+ * goo_canvas_virtual_table_reload:
+ * @table: a #GooCanvasVirtualTable.
+ *
+ * Frees all the cell items and reads the number of rows and columns from the
+ * source again. This should be called if the columns of the table change.
+ *
+ * Since: 3.0
+ **/
+void
+goo_canvas_virtual_table_reload (GooCanvasVirtualTable *table)
+{
+  GooCanvasVirtualTablePrivate *priv;
+
+  g_return_if_fail (GOO_IS_CANVAS_VIRTUAL_TABLE (table));
+
+  priv = GOO_CANVAS_VIRTUAL_TABLE_GET_PRIVATE (table);
+
+  if (priv->source)
+    goo_canvas_virtual_table_clear (table);
+  priv->geometry_valid = FALSE;
+
+  goo_canvas_item_simple_changed ((GooCanvasItemSimple*) table, TRUE);
+}
+
+
+/* Reads the number of rows and columns from the source, and calculates the
+   column offsets and any row offsets which aren't up to date. */
+static void
+goo_canvas_virtual_table_ensure_geometry (GooCanvasVirtualTable *table)
+{
+  GooCanvasVirtualTablePrivate *priv = GOO_CANVAS_VIRTUAL_TABLE_GET_PRIVATE (table);
+  GooCanvasVirtualTableSourceIface *iface;
+  gdouble row_spacing, column_spacing, pos;
+  gint n_columns, i;
+
+  if (priv->geometry_valid)
+    return;
+  priv->geometry_valid = TRUE;
+
+  if (!priv->source)
+    {
+      priv->n_rows = priv->n_columns = 0;
+      return;
+    }
+
+  iface = GOO_CANVAS_VIRTUAL_TABLE_SOURCE_GET_IFACE (priv->source);
+
+  /* If the number of columns changes the existing cells can't be reused. */
+  n_columns = MAX (iface->get_n_columns (priv->source), 0);
+  if (n_columns != priv->n_columns)
+    {
+      goo_canvas_virtual_table_clear (table);
+      priv->geometry_valid = TRUE;
+    }
+
+  priv->n_rows = MAX (iface->get_n_rows (priv->source), 0);
+  priv->n_columns = n_columns;
+
+  if (!priv->pools)
+    {
+      priv->n_pools = n_columns;
+      priv->pools = g_new (GPtrArray*, n_columns);
+      for (i = 0; i < n_columns; i++)
+	priv->pools[i] = g_ptr_array_new ();
+    }
+
+  /* The grid lines are drawn in the spacing, as in GooCanvasTable. */
+  row_spacing = table->row_spacing + table->horz_grid_line_width;
+  column_spacing = table->column_spacing + table->vert_grid_line_width;
+
+  priv->column_offsets = g_renew (gdouble, priv->column_offsets,
+				  n_columns + 1);
+  pos = 0.0;
+  for (i = 0; i < n_columns; i++)
+    {
+      priv->column_offsets[i] = pos;
+      if (iface->get_column_width)
+	pos += iface->get_column_width (priv->source, i);
+      else
+	pos += table->column_width;
+      pos += column_spacing;
+    }
+  priv->column_offsets[n_columns] = pos;
+
+  if (iface->get_row_height)
+    {
+      /* Only the offsets of rows after the changed rows are calculated. */
+      priv->row_offsets = g_renew (gdouble, priv->row_offsets,
+				   priv->n_rows + 1);
+      if (priv->n_valid_row_offsets == 0)
+	{
+	  priv->row_offsets[0] = 0.0;
+	  priv->n_valid_row_offsets = 1;
+	}
+
+      pos = priv->row_offsets[priv->n_valid_row_offsets - 1];
+      for (i = priv->n_valid_row_offsets - 1; i < priv->n_rows; i++)
+	{
+	  pos += iface->get_row_height (priv->source, i) + row_spacing;
+	  priv->row_offsets[i + 1] = pos;
+	}
+      priv->n_valid_row_offsets = priv->n_rows + 1;
+    }
+  else
+    {
+      g_free (priv->row_offsets);
+      priv->row_offsets = NULL;
+      priv->n_valid_row_offsets = 0;
+    }
+}
+
+
+/* Returns the start position of the given row or column and its size,
+   relative to the table's origin. */
+static gdouble
+goo_canvas_virtual_table_get_start (GooCanvasVirtualTable *table,
+				    gint                   d,
+				    gint                   index,
+				    gdouble               *size)
+{
+  GooCanvasVirtualTablePrivate *priv = GOO_CANVAS_VIRTUAL_TABLE_GET_PRIVATE (table);
+  gdouble start, pitch;
+
+  if (d == HORZ)
+    {
+      start = table->x_border_spacing + table->vert_grid_line_width;
+      *size = priv->column_offsets[index + 1] - priv->column_offsets[index]
+	- table->column_spacing - table->vert_grid_line_width;
+      return start + priv->column_offsets[index];
+    }
+
+  start = table->y_border_spacing + table->horz_grid_line_width;
+  if (priv->row_offsets)
+    {
+      *size = priv->row_offsets[index + 1] - priv->row_offsets[index]
+	- table->row_spacing - table->horz_grid_line_width;
+      return start + priv->row_offsets[index];
+    }
+
+  pitch = table->row_height + table->row_spacing + table->horz_grid_line_width;
+  *size = table->row_height;
+  return start + index * pitch;
+}
+
+
+/* Returns the row or column at the given position, relative to the table's
+   origin, clamped to the rows or columns in the table. It returns -1 if the
+   table has no rows or columns. */
+static gint
+goo_canvas_virtual_table_find (GooCanvasVirtualTable *table,
+			       gint                   d,
+			       gdouble                pos)
+{
+  GooCanvasVirtualTablePrivate *priv = GOO_CANVAS_VIRTUAL_TABLE_GET_PRIVATE (table);
+  gdouble *offsets, pitch;
+  gint n, low, high, mid;
+
+  if (d == HORZ)
+    {
+      n = priv->n_columns;
+      offsets = priv->column_offsets;
+      pos -= table->x_border_spacing + table->vert_grid_line_width;
+    }
+  else
+    {
+      n = priv->n_rows;
+      offsets = priv->row_offsets;
+      pos -= table->y_border_spacing + table->horz_grid_line_width;
+    }
+
+  if (n == 0)
+    return -1;
+  if (pos <= 0.0)
+    return 0;
+
+  if (!offsets)
+    {
+      pitch = table->row_height + table->row_spacing + table->horz_grid_line_width;
+      if (pitch <= 0.0)
+	return 0;
+      return (gint) MIN (floor (pos / pitch), n - 1);
+    }
+
+  /* Find the last row or column which starts at or before pos. */
+  low = 0;
+  high = n - 1;
+  while (low < high)
+    {
+      mid = low + (high - low + 1) / 2;
+      if (offsets[mid] <= pos)
+	low = mid;
+      else
+	high = mid - 1;
+    }
+
+  return low;
+}
+
+
+static void
+goo_canvas_virtual_table_get_size (GooCanvasVirtualTable *table,
+				   gdouble               *width,
+				   gdouble               *height)
+{
+  GooCanvasVirtualTablePrivate *priv = GOO_CANVAS_VIRTUAL_TABLE_GET_PRIVATE (table);
+  gdouble size;
+
+  if (table->width > 0.0)
+    {
+      *width = table->width;
+    }
+  else
+    {
+      *width = (table->x_border_spacing + table->vert_grid_line_width) * 2.0;
+      if (priv->n_columns > 0)
+	*width += goo_canvas_virtual_table_get_start (table, HORZ, priv->n_columns - 1, &size) + size - (table->x_border_spacing + table->vert_grid_line_width);
+    }
+
+  if (table->height > 0.0)
+    {
+      *height = table->height;
+    }
+  else
+    {
+      *height = (table->y_border_spacing + table->horz_grid_line_width) * 2.0;
+      if (priv->n_rows > 0)
+	*height += goo_canvas_virtual_table_get_start (table, VERT, priv->n_rows - 1, &size) + size - (table->y_border_spacing + table->horz_grid_line_width);
+    }
+}
+
+
+/**
+ * goo_canvas_virtual_table_get_cell_bounds:
+ * @table: a #GooCanvasVirtualTable.
+ * @row: the row of the cell.
+ * @column: the column of the cell, or -1 to get the bounds of the entire row.
+ * @bounds: (out): returns the bounds of the cell, in the table's coordinate
+ *  space.
+ *
+ * Gets the area of a cell, whether or not it is currently displayed. This
+ * can be used with goo_canvas_scroll_to() to show a particular row.
+ *
+ * Returns: %TRUE if the cell is in the table.
+ *
+ * Since: 3.0
+ **/
+gboolean
+goo_canvas_virtual_table_get_cell_bounds (GooCanvasVirtualTable *table,
+					  gint                   row,
+					  gint                   column,
+					  GooCanvasBounds       *bounds)
+{
+  GooCanvasVirtualTablePrivate *priv;
+  gdouble width, height, size;
+
+  g_return_val_if_fail (GOO_IS_CANVAS_VIRTUAL_TABLE (table), FALSE);
+  g_return_val_if_fail (bounds != NULL, FALSE);
+
+  priv = GOO_CANVAS_VIRTUAL_TABLE_GET_PRIVATE (table);
+
+  goo_canvas_virtual_table_ensure_geometry (table);
+
+  if (row < 0 || row >= priv->n_rows || column >= priv->n_columns)
+    return FALSE;
+
+  bounds->y1 = table->y + goo_canvas_virtual_table_get_start (table, VERT,
+							      row, &size);
+  bounds->y2 = bounds->y1 + size;
+
+  if (column < 0)
+    {
+      goo_canvas_virtual_table_get_size (table, &width, &height);
+      bounds->x1 = table->x;
+      bounds->x2 = table->x + width;
+    }
+  else
+    {
+      bounds->x1 = table->x + goo_canvas_virtual_table_get_start (table, HORZ,
+								  column, &size);
+      bounds->x2 = bounds->x1 + size;
+    }
+
+  return TRUE;
+}
+
+
+/* Gets the rows which are visible in the canvas window. The cairo context
+   must be set up for the table's coordinate space. */
+static void
+goo_canvas_virtual_table_get_visible_rows (GooCanvasVirtualTable *table,
+					   cairo_t               *cr,
+					   gint                  *first_row,
+					   gint                  *last_row)
+{
+  GooCanvasItemSimple *simple = (GooCanvasItemSimple*) table;
+  GooCanvas *canvas = simple->canvas;
+  gdouble x[4], y[4], top, bottom;
+  gint i;
+
+  *first_row = 0;
+  *last_row = -1;
+
+  if (!canvas)
+    return;
+
+  /* Find the visible area in pixels, and convert it to canvas units. Static
+     items are positioned in pixels from the top-left of the window. */
+  x[0] = x[2] = y[0] = y[1] = 0.0;
+  x[1] = x[3] = gtk_widget_get_allocated_width (GTK_WIDGET (canvas));
+  y[2] = y[3] = gtk_widget_get_allocated_height (GTK_WIDGET (canvas));
+
+  for (i = 0; i < 4; i++)
+    {
+      if (!simple->simple_data->is_static)
+	{
+	  if (canvas->hadjustment)
+	    x[i] += gtk_adjustment_get_value (canvas->hadjustment);
+	  if (canvas->vadjustment)
+	    y[i] += gtk_adjustment_get_value (canvas->vadjustment);
+	  goo_canvas_convert_from_pixels (canvas, &x[i], &y[i]);
+	}
+      cairo_device_to_user (cr, &x[i], &y[i]);
+    }
+
+  top = MIN (MIN (y[0], y[1]), MIN (y[2], y[3]));
+  bottom = MAX (MAX (y[0], y[1]), MAX (y[2], y[3]));
+
+  *first_row = goo_canvas_virtual_table_find (table, VERT, top);
+  *last_row = goo_canvas_virtual_table_find (table, VERT, bottom);
+}
+
+
+/* Makes sure cells exist for all the rows from first_row to last_row, and
+   for no other rows, reusing the cells of rows that are no longer needed. */
+static void
+goo_canvas_virtual_table_sync_cells (GooCanvasVirtualTable *table,
+				     gint                   first_row,
+				     gint                   last_row)
+{
+  GooCanvasVirtualTablePrivate *priv = GOO_CANVAS_VIRTUAL_TABLE_GET_PRIVATE (table);
+  GooCanvasVirtualTableSourceIface *iface;
+  GooCanvasItem *item = (GooCanvasItem*) table;
+  GooCanvasItemSimple *simple = (GooCanvasItemSimple*) table;
+  GooCanvasGroup *group = (GooCanvasGroup*) table;
+  GooCanvasVirtualTableCell *cell, new_cell;
+  GooCanvasItem *child;
+  GPtrArray *pool;
+  gdouble width, height;
+  gint i, row, column;
+
+  /* Release the cells of rows which aren't needed any more. */
+  for (i = priv->cells->len - 1; i >= 0; i--)
+    {
+      cell = &g_array_index (priv->cells, GooCanvasVirtualTableCell, i);
+      if (cell->row < first_row || cell->row > last_row)
+	goo_canvas_virtual_table_release_cell (table, i, TRUE);
+    }
+
+  if (!priv->source)
+    return;
+
+  iface = GOO_CANVAS_VIRTUAL_TABLE_SOURCE_GET_IFACE (priv->source);
+
+  /* Bind any cells of rows that have changed again. */
+  if (priv->changed_first_row <= priv->changed_last_row)
+    {
+      for (i = 0; i < priv->cells->len; i++)
+	{
+	  cell = &g_array_index (priv->cells, GooCanvasVirtualTableCell, i);
+	  if (cell->row < priv->changed_first_row
+	      || cell->row > priv->changed_last_row)
+	    continue;
+
+	  child = group->items->pdata[i];
+	  if (iface->unbind_cell)
+	    iface->unbind_cell (priv->source, child, cell->row, cell->column);
+	  goo_canvas_virtual_table_get_start (table, HORZ, cell->column,
+					      &width);
+	  goo_canvas_virtual_table_get_start (table, VERT, cell->row,
+					      &height);
+	  iface->bind_cell (priv->source, child, cell->row, cell->column,
+			    width, height);
+	}
+
+      priv->changed_first_row = 0;
+      priv->changed_last_row = -1;
+    }
+
+  /* Create the cells for the new rows. */
+  for (row = first_row; row <= last_row; row++)
+    {
+      /* Skip rows we already have cells for. */
+      if (row >= priv->first_row && row <= priv->last_row)
+	{
+	  row = priv->last_row;
+	  continue;
+	}
+
+      goo_canvas_virtual_table_get_start (table, VERT, row, &height);
+
+      for (column = 0; column < priv->n_columns; column++)
+	{
+	  pool = priv->pools[column];
+	  if (pool->len > 0)
+	    {
+	      child = g_ptr_array_remove_index_fast (pool, pool->len - 1);
+	    }
+	  else
+	    {
+	      child = iface->create_cell (priv->source, column);
+	      if (!child)
+		continue;
+	    }
+
+	  new_cell.row = row;
+	  new_cell.column = column;
+	  g_array_append_val (priv->cells, new_cell);
+	  g_ptr_array_add (group->items, child);
+
+	  goo_canvas_item_set_parent (child, item);
+	  goo_canvas_item_set_is_static (child, simple->simple_data->is_static);
+
+	  goo_canvas_virtual_table_get_start (table, HORZ, column, &width);
+	  iface->bind_cell (priv->source, child, row, column, width, height);
+	}
+    }
+
+  priv->first_row = first_row;
+  priv->last_row = last_row;
+}
+
+
+static void
+goo_canvas_virtual_table_update  (GooCanvasItem   *item,
+				  gboolean         entire_tree,
+				  cairo_t         *cr,
+				  GooCanvasBounds *bounds)
+{
+  GooCanvasItemSimple *simple = (GooCanvasItemSimple*) item;
+  GooCanvasItemSimpleData *simple_data = simple->simple_data;
+  GooCanvasGroup *group = (GooCanvasGroup*) item;
+  GooCanvasVirtualTable *table = (GooCanvasVirtualTable*) item;
+  GooCanvasVirtualTablePrivate *priv = GOO_CANVAS_VIRTUAL_TABLE_GET_PRIVATE (table);
+  GooCanvasVirtualTableCell *cell;
+  GooCanvasBounds child_bounds, old_bounds;
+  gdouble width, height, x, y, size;
+  gint first_row, last_row, i;
+
+  if (entire_tree || simple->need_update)
+    {
+      if (simple->need_entire_subtree_update)
+	entire_tree = TRUE;
+
+      goo_canvas_item_simple_check_style (simple);
+
+      cairo_save (cr);
+      if (simple_data->transform)
+	cairo_transform (cr, simple_data->transform);
+      cairo_translate (cr, table->x, table->y);
+
+      goo_canvas_virtual_table_ensure_geometry (table);
+
+      /* Work out which rows need cells, and bind them before we reset our
+	 flags, so that the update requests from the cells are ignored. */
+      goo_canvas_virtual_table_get_visible_rows (table, cr, &first_row,
+						 &last_row);
+      if (last_row >= first_row)
+	{
+	  first_row = MAX (first_row - table->overscan_rows, 0);
+	  last_row = MIN ((gint64) last_row + table->overscan_rows,
+			  priv->n_rows - 1);
+	}
+      goo_canvas_virtual_table_sync_cells (table, first_row, last_row);
+
+      simple->need_update = FALSE;
+      simple->need_entire_subtree_update = FALSE;
+      GOO_CANVAS_COUNT (items_updated);
+
+      for (i = 0; i < group->items->len; i++)
+	{
+	  cell = &g_array_index (priv->cells, GooCanvasVirtualTableCell, i);
+	  x = goo_canvas_virtual_table_get_start (table, HORZ, cell->column,
+						  &size);
+	  y = goo_canvas_virtual_table_get_start (table, VERT, cell->row,
+						  &size);
+
+	  cairo_translate (cr, x, y);
+	  goo_canvas_item_update (group->items->pdata[i], entire_tree, cr,
+				  &child_bounds);
+	  cairo_translate (cr, -x, -y);
+	}
+
+      /* The bounds cover the entire table, not just the cells that exist. */
+      old_bounds = simple->bounds;
+      goo_canvas_virtual_table_get_size (table, &width, &height);
+      simple->bounds.x1 = simple->bounds.y1 = 0.0;
+      simple->bounds.x2 = width;
+      simple->bounds.y2 = height;
+      goo_canvas_item_simple_user_bounds_to_device (simple, cr,
+						    &simple->bounds);
+
+      cairo_restore (cr);
+
+      /* The grid may have changed, so redraw the entire table. */
+      if (entire_tree && simple->canvas)
+	{
+	  goo_canvas_request_item_redraw (simple->canvas, &old_bounds,
+					  simple_data->is_static);
+	  goo_canvas_request_item_redraw (simple->canvas, &simple->bounds,
+					  simple_data->is_static);
+	}
+    }
+
+  *bounds = simple->bounds;
+}
+
+
+static void
+goo_canvas_virtual_table_paint (GooCanvasItem         *item,
+				cairo_t               *cr,
+				const GooCanvasBounds *bounds,
+				gdouble                scale)
+{
+  GooCanvasItemSimple *simple = (GooCanvasItemSimple*) item;
+  GooCanvasItemSimpleData *simple_data = simple->simple_data;
+  GooCanvasStyle *style = simple_data->style;
+  GooCanvasGroup *group = (GooCanvasGroup*) item;
+  GooCanvasVirtualTable *table = (GooCanvasVirtualTable*) item;
+  GooCanvasVirtualTablePrivate *priv = GOO_CANVAS_VIRTUAL_TABLE_GET_PRIVATE (table);
+  gdouble horz_grid_line_width = table->horz_grid_line_width;
+  gdouble vert_grid_line_width = table->vert_grid_line_width;
+  GooCanvasVirtualTableCell *cell;
+  gdouble width, height, x1, y1, x2, y2, x, y, size;
+  gdouble line_start, line_end, half_spacing;
+  gint first_row, last_row, column, row, i;
+
+  /* Skip the item if the bounds don't intersect the expose rectangle. */
+  if (simple->bounds.x1 > bounds->x2 || simple->bounds.x2 < bounds->x1
+      || simple->bounds.y1 > bounds->y2 || simple->bounds.y2 < bounds->y1)
+    {
+      GOO_CANVAS_COUNT (items_culled);
+      return;
+    }
+
+  /* Check if the item should be visible. */
+  if (simple_data->visibility <= GOO_CANVAS_ITEM_INVISIBLE
+      || (simple_data->visibility == GOO_CANVAS_ITEM_VISIBLE_ABOVE_THRESHOLD
+	  && scale < simple_data->visibility_threshold))
+    return;
+
+  GOO_CANVAS_COUNT (items_painted);
+
+  cairo_save (cr);
+  if (simple_data->transform)
+    cairo_transform (cr, simple_data->transform);
+  cairo_translate (cr, table->x, table->y);
+
+  /* Clip with the table's clip path, if it is set. */
+  if (simple_data->clip_path_commands)
+    goo_canvas_item_simple_data_clip (simple_data, cr);
+
+  /* Find the part of the table that needs painting. We only draw that part,
+     since the coordinates of the entire table could be too large for cairo
+     to handle. */
+  goo_canvas_virtual_table_get_size (table, &width, &height);
+  cairo_clip_extents (cr, &x1, &y1, &x2, &y2);
+  x1 = MAX (x1, 0.0);
+  y1 = MAX (y1, 0.0);
+  x2 = MIN (x2, width);
+  y2 = MIN (y2, height);
+  if (x1 >= x2 || y1 >= y2)
+    {
+      cairo_restore (cr);
+      return;
+    }
+
+  first_row = goo_canvas_virtual_table_find (table, VERT, y1);
+  last_row = goo_canvas_virtual_table_find (table, VERT, y2);
+
+  /* If we are getting close to rows which don't have cells yet, request an
+     update so they are created. */
+  if (last_row >= 0
+      && (MAX (first_row - table->overscan_rows / 2, 0) < priv->first_row
+	  || MIN ((gint64) last_row + table->overscan_rows / 2, priv->n_rows - 1) > priv->last_row))
+    goo_canvas_item_request_update (item);
+
+  /* Save current line width, line cap etc. for drawing items after having
+     drawn grid lines */
+  cairo_save (cr);
+
+  /* Fill the table, if desired. */
+  if (goo_canvas_style_set_fill_options (style, cr))
+    {
+      cairo_rectangle (cr, MAX (x1, vert_grid_line_width),
+		       MAX (y1, horz_grid_line_width),
+		       MIN (x2, width - vert_grid_line_width) - MAX (x1, vert_grid_line_width),
+		       MIN (y2, height - horz_grid_line_width) - MAX (y1, horz_grid_line_width));
+      cairo_fill (cr);
+    }
+
+  /* We use the style for the stroke color, but the line cap style and line
+     width are overridden here. */
+  goo_canvas_style_set_stroke_options (style, cr);
+
+  cairo_set_line_cap (cr, CAIRO_LINE_CAP_BUTT);
+
+  /* Horizontal grid lines */
+  if (horz_grid_line_width > 0.0)
+    {
+      cairo_set_line_width (cr, horz_grid_line_width);
+
+      /* Outer lines */
+      line_start = x1;
+      line_end = x2;
+
+      if (y1 < horz_grid_line_width)
+	{
+	  cairo_move_to (cr, line_start, horz_grid_line_width / 2);
+	  cairo_line_to (cr, line_end, horz_grid_line_width / 2);
+	}
+
+      if (y2 > height - horz_grid_line_width)
+	{
+	  cairo_move_to (cr, line_start, height - horz_grid_line_width / 2);
+	  cairo_line_to (cr, line_end, height - horz_grid_line_width / 2);
+	}
+
+      /* Inner lines, between each row and the next. */
+      line_start = MAX (line_start, vert_grid_line_width);
+      line_end = MIN (line_end, width - vert_grid_line_width);
+      for (row = MAX (first_row - 1, 0); row <= last_row && row + 1 < priv->n_rows; row++)
+	{
+	  y = goo_canvas_virtual_table_get_start (table, VERT, row, &size) + size;
+	  y += (table->row_spacing + horz_grid_line_width) / 2.0;
+
+	  cairo_move_to (cr, line_start, y);
+	  cairo_line_to (cr, line_end, y);
+	}
+
+      cairo_stroke (cr);
+    }
+
+  /* Vertical grid lines */
+  if (vert_grid_line_width > 0.0)
+    {
+      cairo_set_line_width (cr, vert_grid_line_width);
+
+      /* Outer lines */
+      line_start = MAX (y1, horz_grid_line_width);
+      line_end = MIN (y2, height - horz_grid_line_width);
+
+      cairo_move_to (cr, vert_grid_line_width / 2, line_start);
+      cairo_line_to (cr, vert_grid_line_width / 2, line_end);
+
+      cairo_move_to (cr, width - vert_grid_line_width / 2, line_start);
+      cairo_line_to (cr, width - vert_grid_line_width / 2, line_end);
+
+      /* Inner lines. As in GooCanvasTable, they stop at the horizontal grid
+	 lines so we don't do overlapping drawing operations, and alpha
+	 transparent grid lines look right. */
+      half_spacing = table->row_spacing / 2.0;
+      for (column = 0; column + 1 < priv->n_columns; column++)
+	{
+	  x = goo_canvas_virtual_table_get_start (table, HORZ, column, &size) + size;
+	  x += (table->column_spacing + vert_grid_line_width) / 2.0;
+	  if (x < x1 - vert_grid_line_width || x > x2 + vert_grid_line_width)
+	    continue;
+
+	  for (row = first_row; row <= last_row && row >= 0; row++)
+	    {
+	      y = goo_canvas_virtual_table_get_start (table, VERT, row, &size);
+
+	      if (row == 0)
+		line_start = horz_grid_line_width;
+	      else
+		line_start = y - half_spacing;
+
+	      if (row == priv->n_rows - 1)
+		line_end = height - horz_grid_line_width;
+	      else
+		line_end = y + size + half_spacing;
+
+	      cairo_move_to (cr, x, line_start);
+	      cairo_line_to (cr, x, line_end);
+	    }
+	}
+
+      cairo_stroke (cr);
+    }
+
+  cairo_restore (cr);
+
+  /* Paint the cells in the rows that need painting. */
+  for (i = 0; i < group->items->len; i++)
+    {
+      cell = &g_array_index (priv->cells, GooCanvasVirtualTableCell, i);
+      if (cell->row < first_row || cell->row > last_row)
+	continue;
+
+      x = goo_canvas_virtual_table_get_start (table, HORZ, cell->column,
+					      &size);
+      y = goo_canvas_virtual_table_get_start (table, VERT, cell->row, &size);
+
+      cairo_translate (cr, x, y);
+      goo_canvas_item_paint (group->items->pdata[i], cr, bounds, scale);
+      cairo_translate (cr, -x, -y);
+    }
+
+  cairo_restore (cr);
+}
+
+
+static GList*
+goo_canvas_virtual_table_get_items_at (GooCanvasItem  *item,
+				       gdouble         x,
+				       gdouble         y,
+				       cairo_t        *cr,
+				       gboolean        is_pointer_event,
+				       gboolean        parent_visible,
+				       GList          *found_items)
+{
+  GooCanvasItemSimple *simple = (GooCanvasItemSimple*) item;
+  GooCanvasItemSimpleData *simple_data = simple->simple_data;
+  GooCanvasGroup *group = (GooCanvasGroup*) item;
+  GooCanvasVirtualTable *table = (GooCanvasVirtualTable*) item;
+  GooCanvasVirtualTablePrivate *priv = GOO_CANVAS_VIRTUAL_TABLE_GET_PRIVATE (table);
+  GooCanvasVirtualTableCell *cell;
+  gboolean visible = parent_visible;
+  gdouble user_x = x, user_y = y, cell_x, cell_y, size;
+  gint row, column, i;
+
+  if (simple->need_update)
+    goo_canvas_item_ensure_updated (item);
+
+  /* Skip the item if the point isn't in the item's bounds. */
+  if (simple->bounds.x1 > x || simple->bounds.x2 < x
+      || simple->bounds.y1 > y || simple->bounds.y2 < y)
+    return found_items;
+
+  if (simple_data->visibility <= GOO_CANVAS_ITEM_INVISIBLE
+      || (simple_data->visibility == GOO_CANVAS_ITEM_VISIBLE_ABOVE_THRESHOLD
+	  && goo_canvas_get_hit_test_scale (simple->canvas, cr) < simple_data->visibility_threshold))
+    visible = FALSE;
+
+  /* Check if the table should receive events. */
+  if (is_pointer_event
+      && (simple_data->pointer_events == GOO_CANVAS_EVENTS_NONE
+	  || ((simple_data->pointer_events & GOO_CANVAS_EVENTS_VISIBLE_MASK)
+	      && !visible)))
+    return found_items;
+
+  cairo_save (cr);
+  if (simple_data->transform)
+    cairo_transform (cr, simple_data->transform);
+  cairo_translate (cr, table->x, table->y);
+
+  cairo_device_to_user (cr, &user_x, &user_y);
+
+  /* If the table has a clip path, check if the point is inside it. */
+  if (simple_data->clip_path_commands)
+    {
+      if (!goo_canvas_item_simple_data_in_clip (simple_data, cr,
+						user_x, user_y))
+	{
+	  cairo_restore (cr);
+	  return found_items;
+	}
+    }
+
+  /* Only the cells of the row and column under the point are checked. */
+  row = goo_canvas_virtual_table_find (table, VERT, user_y);
+  column = goo_canvas_virtual_table_find (table, HORZ, user_x);
+
+  for (i = 0; row >= 0 && column >= 0 && i < group->items->len; i++)
+    {
+      cell = &g_array_index (priv->cells, GooCanvasVirtualTableCell, i);
+      if (cell->row != row || cell->column != column)
+	continue;
+
+      cell_x = goo_canvas_virtual_table_get_start (table, HORZ, column, &size);
+      cell_y = goo_canvas_virtual_table_get_start (table, VERT, row, &size);
+
+      cairo_translate (cr, cell_x, cell_y);
+      found_items = goo_canvas_item_get_items_at (group->items->pdata[i],
+						  x, y, cr,
+						  is_pointer_event, visible,
+						  found_items);
+      cairo_translate (cr, -cell_x, -cell_y);
+    }
+
+  cairo_restore (cr);
+
+  return found_items;
+}
+
+
+static gboolean
+goo_canvas_virtual_table_get_transform_for_child  (GooCanvasItem  *item,
+						   GooCanvasItem  *child,
+						   cairo_matrix_t *transform)
+{
+  GooCanvasItemSimple *simple = (GooCanvasItemSimple*) item;
+  GooCanvasGroup *group = (GooCanvasGroup*) item;
+  GooCanvasVirtualTable *table = (GooCanvasVirtualTable*) item;
+  GooCanvasVirtualTablePrivate *priv = GOO_CANVAS_VIRTUAL_TABLE_GET_PRIVATE (table);
+  GooCanvasVirtualTableCell *cell;
+  gdouble x, y, size;
+  gint child_num;
+
+  if (simple->simple_data->transform)
+    *transform = *simple->simple_data->transform;
+  else
+    cairo_matrix_init_identity (transform);
+
+  cairo_matrix_translate (transform, table->x, table->y);
+
+  for (child_num = 0; child_num < group->items->len; child_num++)
+    {
+      if (group->items->pdata[child_num] == child)
+	{
+	  cell = &g_array_index (priv->cells, GooCanvasVirtualTableCell,
+				 child_num);
+	  x = goo_canvas_virtual_table_get_start (table, HORZ, cell->column,
+						  &size);
+	  y = goo_canvas_virtual_table_get_start (table, VERT, cell->row,
+						  &size);
+	  cairo_matrix_translate (transform, x, y);
+	  break;
+	}
+    }
+
+  return TRUE;
+}
+
+
+static void
+goo_canvas_virtual_table_add_child (GooCanvasItem  *item,
+				    GooCanvasItem  *child,
+				    gint            position)
+{
+  g_warning ("%s: children can't be added to a GooCanvasVirtualTable",
+	     G_STRFUNC);
+}
+
+
+static void
+goo_canvas_virtual_table_move_child (GooCanvasItem  *item,
+				     gint            old_position,
+				     gint            new_position)
+{
+  /* The order of the cells doesn't matter, as they don't overlap. */
+}
+
+
+static void
+goo_canvas_virtual_table_remove_child (GooCanvasItem  *item,
+				       gint            child_num)
+{
+  GooCanvasVirtualTable *table = (GooCanvasVirtualTable*) item;
+  GooCanvasVirtualTablePrivate *priv = GOO_CANVAS_VIRTUAL_TABLE_GET_PRIVATE (table);
+  gint i;
+
+  g_return_if_fail (child_num < priv->cells->len);
+
+  /* Free the cell item rather than reusing it. Its row is now incomplete,
+     so we release all the other cells too and bind them again in the next
+     update. */
+  goo_canvas_virtual_table_release_cell (table, child_num, FALSE);
+  for (i = priv->cells->len - 1; i >= 0; i--)
+    goo_canvas_virtual_table_release_cell (table, i, TRUE);
+
+  priv->first_row = 0;
+  priv->last_row = -1;
+  goo_canvas_item_request_update (item);
+}
+
+
+static void
+item_interface_init (GooCanvasItemIface *iface)
+{
+  iface->add_child               = goo_canvas_virtual_table_add_child;
+  iface->add_children            = NULL;
+  iface->find_child              = NULL;
+  iface->move_child              = goo_canvas_virtual_table_move_child;
+  iface->remove_child            = goo_canvas_virtual_table_remove_child;
+  iface->get_transform_for_child = goo_canvas_virtual_table_get_transform_for_child;
+
+  iface->update                  = goo_canvas_virtual_table_update;
+  iface->paint                   = goo_canvas_virtual_table_paint;
+  iface->get_items_at            = goo_canvas_virtual_table_get_items_at;
+}
@@ -0,0 +1,166 @@
+/*
+ * GooCanvas. Copyright (C) 2005 Damon Chaplin.
+ * Released under the GNU LGPL license. See COPYING for details.
+ *
+ * goocanvasvirtualtable.h - table item which only creates the visible cells.
+ */
+#ifndef __GOO_CANVAS_VIRTUAL_TABLE_H__
+#define __GOO_CANVAS_VIRTUAL_TABLE_H__
+
+#include <gtk/gtk.h>
+#include "goocanvasgroup.h"
+
+G_BEGIN_DECLS
+
+
+#define GOO_TYPE_CANVAS_VIRTUAL_TABLE_SOURCE            (goo_canvas_virtual_table_source_get_type ())
+#define GOO_CANVAS_VIRTUAL_TABLE_SOURCE(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), GOO_TYPE_CANVAS_VIRTUAL_TABLE_SOURCE, GooCanvasVirtualTableSource))
+#define GOO_IS_CANVAS_VIRTUAL_TABLE_SOURCE(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), GOO_TYPE_CANVAS_VIRTUAL_TABLE_SOURCE))
+#define GOO_CANVAS_VIRTUAL_TABLE_SOURCE_GET_IFACE(obj)  (G_TYPE_INSTANCE_GET_INTERFACE ((obj), GOO_TYPE_CANVAS_VIRTUAL_TABLE_SOURCE, GooCanvasVirtualTableSourceIface))
+
+
+/**
+ * GooCanvasVirtualTableSource:
+ *
+ * #GooCanvasVirtualTableSource is a typedef used for objects that implement
+ * the #GooCanvasVirtualTableSource interface.
+ *
+ * (There is no actual #GooCanvasVirtualTableSource struct, since it is only
+ * an interface. But using '#GooCanvasVirtualTableSource' is more helpful
+ * than using '#GObject'.)
+ *
+ * Since: 3.0
+ */
+typedef struct _GooCanvasVirtualTableSource       GooCanvasVirtualTableSource;
+typedef struct _GooCanvasVirtualTableSourceIface  GooCanvasVirtualTableSourceIface;
+
+/**
+ * GooCanvasVirtualTableSourceIface:
+ * @get_n_rows: returns the number of rows in the table.
+ * @get_n_columns: returns the number of columns in the table.
+ * @get_row_height: returns the height of the given row. If this is %NULL all
+ *  rows use the #GooCanvasVirtualTable:row-height property.
+ * @get_column_width: returns the width of the given column. If this is %NULL
+ *  all columns use the #GooCanvasVirtualTable:column-width property.
+ * @create_cell: creates a new item to display cells in the given column. The
+ *  item should be created without a parent, and the table takes ownership of
+ *  it.
+ * @bind_cell: sets up an item created by @create_cell to display the cell at
+ *  the given row and column. The item is translated to the top-left of the
+ *  cell, and the width and height of the cell are passed in.
+ * @unbind_cell: called when a cell item is no longer displaying the given row
+ *  and column, before it is kept for reuse. This may be %NULL.
+ *
+ * #GooCanvasVirtualTableSourceIface holds the virtual methods that make up
+ * the #GooCanvasVirtualTableSource interface.
+ *
+ * The get_n_rows(), get_n_columns(), create_cell() and bind_cell() methods
+ * must be implemented.
+ *
+ * Since: 3.0
+ */
+struct _GooCanvasVirtualTableSourceIface
+{
+  /*< private >*/
+  GTypeInterface base_iface;
+
+  /*< public >*/
+  gint           (* get_n_rows)        (GooCanvasVirtualTableSource *source);
+  gint           (* get_n_columns)     (GooCanvasVirtualTableSource *source);
+  gdouble        (* get_row_height)    (GooCanvasVirtualTableSource *source,
+					gint                         row);
+  gdouble        (* get_column_width)  (GooCanvasVirtualTableSource *source,
+					gint                         column);
+  GooCanvasItem* (* create_cell)       (GooCanvasVirtualTableSource *source,
+					gint                         column);
+  void           (* bind_cell)         (GooCanvasVirtualTableSource *source,
+					GooCanvasItem               *cell,
+					gint                         row,
+					gint                         column,
+					gdouble                      width,
+					gdouble                      height);
+  void           (* unbind_cell)       (GooCanvasVirtualTableSource *source,
+					GooCanvasItem               *cell,
+					gint                         row,
+					gint                         column);
+
+  /*< private >*/
+
+  /* Padding for future expansion */
+  void (*_goo_canvas_reserved1) (void);
+  void (*_goo_canvas_reserved2) (void);
+  void (*_goo_canvas_reserved3) (void);
+  void (*_goo_canvas_reserved4) (void);
+};
+
+
+GType          goo_canvas_virtual_table_source_get_type (void) G_GNUC_CONST;
+
+
+
+#define GOO_TYPE_CANVAS_VIRTUAL_TABLE            (goo_canvas_virtual_table_get_type ())
+#define GOO_CANVAS_VIRTUAL_TABLE(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), GOO_TYPE_CANVAS_VIRTUAL_TABLE, GooCanvasVirtualTable))
+#define GOO_CANVAS_VIRTUAL_TABLE_CLASS(klass)    (G_TYPE_CHECK_CLASS_CAST ((klass), GOO_TYPE_CANVAS_VIRTUAL_TABLE, GooCanvasVirtualTableClass))
+#define GOO_IS_CANVAS_VIRTUAL_TABLE(obj)         (G_TYPE_CHECK_INSTANCE_TYPE ((obj), GOO_TYPE_CANVAS_VIRTUAL_TABLE))
+#define GOO_IS_CANVAS_VIRTUAL_TABLE_CLASS(klass) (G_TYPE_CHECK_CLASS_TYPE ((klass), GOO_TYPE_CANVAS_VIRTUAL_TABLE))
+#define GOO_CANVAS_VIRTUAL_TABLE_GET_CLASS(obj)  (G_TYPE_INSTANCE_GET_CLASS ((obj), GOO_TYPE_CANVAS_VIRTUAL_TABLE, GooCanvasVirtualTableClass))
+
+
+typedef struct _GooCanvasVirtualTable       GooCanvasVirtualTable;
+typedef struct _GooCanvasVirtualTableClass  GooCanvasVirtualTableClass;
+
+/**
+ * GooCanvasVirtualTable:
+ *
+ * The #GooCanvasVirtualTable-struct struct contains private data only.
+ *
+ * Since: 3.0
+ */
+struct _GooCanvasVirtualTable
+{
+  GooCanvasGroup parent_object;
+
+  gdouble x, y, width, height;
+  gdouble row_height, column_width;
+  gdouble row_spacing, column_spacing;
+  gdouble x_border_spacing, y_border_spacing;
+  gdouble horz_grid_line_width, vert_grid_line_width;
+  gint overscan_rows;
+};
+
+struct _GooCanvasVirtualTableClass
+{
+  GooCanvasGroupClass parent_class;
+
+  /*< private >*/
+
+  /* Padding for future expansion */
+  void (*_goo_canvas_reserved1) (void);
+  void (*_goo_canvas_reserved2) (void);
+  void (*_goo_canvas_reserved3) (void);
+  void (*_goo_canvas_reserved4) (void);
+};
+
+
+GType          goo_canvas_virtual_table_get_type     (void) G_GNUC_CONST;
+GooCanvasItem* goo_canvas_virtual_table_new          (GooCanvasItem               *parent,
+						      GooCanvasVirtualTableSource *source,
+						      ...);
+
+void           goo_canvas_virtual_table_set_source   (GooCanvasVirtualTable       *table,
+						      GooCanvasVirtualTableSource *source);
+GooCanvasVirtualTableSource* goo_canvas_virtual_table_get_source (GooCanvasVirtualTable *table);
+
+void           goo_canvas_virtual_table_rows_changed (GooCanvasVirtualTable       *table,
+						      gint                         first_row,
+						      gint                         n_rows);
+void           goo_canvas_virtual_table_reload       (GooCanvasVirtualTable       *table);
+gboolean       goo_canvas_virtual_table_get_cell_bounds (GooCanvasVirtualTable    *table,
+							 gint                      row,
+							 gint                      column,
+							 GooCanvasBounds          *bounds);
+
+
+G_END_DECLS
+
+#endif /* __GOO_CANVAS_VIRTUAL_TABLE_H__ */